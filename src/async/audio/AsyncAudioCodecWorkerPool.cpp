@@ -0,0 +1,406 @@
+/**
+@file	 AsyncAudioCodecWorkerPool.cpp
+@brief   A pool of threads running audio codecs outside of the main loop
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-29
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncFdWatch.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioCodecWorkerPool.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+AudioCodecWorkerPool *AudioCodecWorkerPool::the_pool = 0;
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioCodecWorkerPool::Strand::Strand(void)
+  : m_state(STATE_IDLE), m_released(false)
+{
+} /* AudioCodecWorkerPool::Strand::Strand */
+
+
+AudioCodecWorkerPool::Strand::~Strand(void)
+{
+} /* AudioCodecWorkerPool::Strand::~Strand */
+
+
+AudioCodecWorkerPool *AudioCodecWorkerPool::instance(void)
+{
+  if (the_pool == 0)
+  {
+    unsigned thread_cnt = DEFAULT_THREAD_COUNT;
+    const char *thread_cnt_str = getenv("ASYNC_CODEC_THREADS");
+    if (thread_cnt_str != 0)
+    {
+      int cnt = atoi(thread_cnt_str);
+      if (cnt < 1)
+      {
+        cerr << "*** WARNING: Illegal value (" << thread_cnt_str
+             << ") for the ASYNC_CODEC_THREADS environment variable. "
+             << "Using one codec thread." << endl;
+        cnt = 1;
+      }
+      thread_cnt = cnt;
+    }
+    the_pool = new AudioCodecWorkerPool(thread_cnt);
+    atexit(stopThreads);
+  }
+  return the_pool;
+} /* AudioCodecWorkerPool::instance */
+
+
+void AudioCodecWorkerPool::add(Strand *strand)
+{
+  m_strands.insert(strand);
+} /* AudioCodecWorkerPool::add */
+
+
+void AudioCodecWorkerPool::release(Strand *strand)
+{
+  m_strands.erase(strand);
+  if (strand == m_completing)
+  {
+      // The strand is still in use by notificationReceived, which will
+      // finish the release when the complete function returns
+    m_completing_released = true;
+    return;
+  }
+
+    // Let a worker thread delete the strand when it is not running
+  strand->m_released = true;
+  strand->schedule();
+} /* AudioCodecWorkerPool::release */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void AudioCodecWorkerPool::Strand::schedule(void)
+{
+  int state = m_state.load();
+  for (;;)
+  {
+    if ((state == STATE_QUEUED) || (state == STATE_RUNNING_AGAIN))
+    {
+      return;
+    }
+    int new_state =
+        (state == STATE_IDLE) ? STATE_QUEUED : STATE_RUNNING_AGAIN;
+    if (m_state.compare_exchange_weak(state, new_state))
+    {
+      if (new_state == STATE_QUEUED)
+      {
+        the_pool->enqueue(this);
+      }
+      return;
+    }
+  }
+} /* AudioCodecWorkerPool::Strand::schedule */
+
+
+void AudioCodecWorkerPool::Strand::notifyMainThread(void)
+{
+  the_pool->notifyMainThread();
+} /* AudioCodecWorkerPool::Strand::notifyMainThread */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+AudioCodecWorkerPool::AudioCodecWorkerPool(unsigned thread_cnt)
+  : m_stopping(false), m_completing(0), m_completing_released(false),
+    m_notify_rd(-1),
+    m_notify_wr(-1), m_notify_pending(false), m_notify_watch(0)
+{
+  pthread_mutex_init(&m_mutex, NULL);
+  pthread_cond_init(&m_cond, NULL);
+
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    cerr << "*** ERROR: Could not create pipe for the codec threads: "
+         << strerror(errno) << endl;
+    exit(1);
+  }
+  m_notify_rd = fds[0];
+  m_notify_wr = fds[1];
+  fcntl(m_notify_rd, F_SETFL, O_NONBLOCK);
+  fcntl(m_notify_wr, F_SETFL, O_NONBLOCK);
+  m_notify_watch = new FdWatch(m_notify_rd, FdWatch::FD_WATCH_RD);
+  m_notify_watch->activity.connect(
+      mem_fun(*this, &AudioCodecWorkerPool::notificationReceived));
+
+  for (unsigned i=0; i<thread_cnt; ++i)
+  {
+    pthread_t thread;
+    int ret = pthread_create(&thread, NULL, threadFunc, this);
+    if (ret != 0)
+    {
+      cerr << "*** WARNING: Could not create codec thread: "
+           << strerror(ret) << endl;
+      break;
+    }
+    m_threads.push_back(thread);
+  }
+  if (m_threads.empty())
+  {
+    cerr << "*** WARNING: No codec threads available. The threaded audio "
+            "codecs will run in the main thread." << endl;
+  }
+} /* AudioCodecWorkerPool::AudioCodecWorkerPool */
+
+
+void AudioCodecWorkerPool::enqueue(Strand *strand)
+{
+  if (m_threads.empty())
+  {
+    run(strand);
+    return;
+  }
+
+  pthread_mutex_lock(&m_mutex);
+  m_run_queue.push_back(strand);
+  pthread_cond_signal(&m_cond);
+  pthread_mutex_unlock(&m_mutex);
+} /* AudioCodecWorkerPool::enqueue */
+
+
+void AudioCodecWorkerPool::notifyMainThread(void)
+{
+  if (!m_notify_pending.exchange(true))
+  {
+    if ((::write(m_notify_wr, "N", 1) != 1) && (errno != EAGAIN))
+    {
+      m_notify_pending = false;
+    }
+  }
+} /* AudioCodecWorkerPool::notifyMainThread */
+
+
+void AudioCodecWorkerPool::notificationReceived(FdWatch *watch)
+{
+  char buf[64];
+  while (::read(m_notify_rd, buf, sizeof(buf)) > 0) {}
+  m_notify_pending = false;
+
+    // A strand may be released, or new ones added, by the complete function
+    // of another strand so iterate over a copy
+  vector<Strand*> strands(m_strands.begin(), m_strands.end());
+  for (vector<Strand*>::iterator it=strands.begin(); it!=strands.end(); ++it)
+  {
+    Strand *strand = *it;
+    if (m_strands.find(strand) == m_strands.end())
+    {
+      continue;
+    }
+    m_completing = strand;
+    m_completing_released = false;
+    strand->complete();
+    m_completing = 0;
+    if (m_completing_released)
+    {
+      strand->m_released = true;
+      strand->schedule();
+    }
+  }
+} /* AudioCodecWorkerPool::notificationReceived */
+
+
+void AudioCodecWorkerPool::stopThreads(void)
+{
+    // Let the threads finish the strands already queued, which include
+    // deleting released strands, before they exit. Strands scheduled after
+    // this will run in the main thread.
+  AudioCodecWorkerPool *pool = the_pool;
+  pthread_mutex_lock(&pool->m_mutex);
+  pool->m_stopping = true;
+  pthread_cond_broadcast(&pool->m_cond);
+  pthread_mutex_unlock(&pool->m_mutex);
+
+  for (vector<pthread_t>::iterator it=pool->m_threads.begin();
+       it!=pool->m_threads.end(); ++it)
+  {
+    pthread_join(*it, NULL);
+  }
+  pool->m_threads.clear();
+} /* AudioCodecWorkerPool::stopThreads */
+
+
+void *AudioCodecWorkerPool::threadFunc(void *data)
+{
+  AudioCodecWorkerPool *pool = reinterpret_cast<AudioCodecWorkerPool *>(data);
+  pool->threadLoop();
+  return NULL;
+} /* AudioCodecWorkerPool::threadFunc */
+
+
+void AudioCodecWorkerPool::threadLoop(void)
+{
+  for (;;)
+  {
+    pthread_mutex_lock(&m_mutex);
+    while (m_run_queue.empty() && !m_stopping)
+    {
+      pthread_cond_wait(&m_cond, &m_mutex);
+    }
+    if (m_run_queue.empty())
+    {
+      pthread_mutex_unlock(&m_mutex);
+      return;
+    }
+    Strand *strand = m_run_queue.front();
+    m_run_queue.pop_front();
+    pthread_mutex_unlock(&m_mutex);
+
+    run(strand);
+  }
+} /* AudioCodecWorkerPool::threadLoop */
+
+
+void AudioCodecWorkerPool::run(Strand *strand)
+{
+  strand->m_state = Strand::STATE_RUNNING;
+  for (;;)
+  {
+    if (strand->m_released)
+    {
+      delete strand;
+      return;
+    }
+
+    strand->process();
+
+      // The strand must not be touched after it has been set to idle since
+      // the main thread may then queue it for deletion. If it was scheduled
+      // while running, process it again.
+    int state = Strand::STATE_RUNNING;
+    if (strand->m_state.compare_exchange_strong(state, Strand::STATE_IDLE))
+    {
+      return;
+    }
+    assert(state == Strand::STATE_RUNNING_AGAIN);
+    strand->m_state = Strand::STATE_RUNNING;
+  }
+} /* AudioCodecWorkerPool::run */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,269 @@
+/**
+@file	 AsyncAudioCodecWorkerPool.h
+@brief   A pool of threads running audio codecs outside of the main loop
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-29
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_CODEC_WORKER_POOL_INCLUDED
+#define ASYNC_AUDIO_CODEC_WORKER_POOL_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <pthread.h>
+#include <sigc++/sigc++.h>
+
+#include <atomic>
+#include <deque>
+#include <set>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class FdWatch;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A pool of threads running audio codecs outside of the main loop
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-29
+
+This class is used by the AudioEncoderThreaded and AudioDecoderThreaded classes
+to run audio codecs in a small number of worker threads. Each codec instance
+is represented by a Strand. Work for a strand is always processed in order by
+one thread at a time, but different strands may run in parallel. The results
+are handed back to the main thread by the strand itself, normally through lock
+free queues. When a strand has produced results, the main thread is woken up
+through a pipe and the complete function of all strands are called.
+
+The pool is created on first use, which must be done from the main thread,
+and is never destroyed. The worker threads are stopped and joined when the
+application exit. The number of threads is taken from the ASYNC_CODEC_THREADS
+environment variable. The default is two threads.
+*/
+class AudioCodecWorkerPool : public sigc::trackable
+{
+  public:
+    /**
+     * @brief   A sequence of work that is processed in order
+     *
+     * All functions, except process and notifyMainThread, must only be
+     * called from the main thread.
+     */
+    class Strand
+    {
+      public:
+        /**
+         * @brief   Default constructor
+         */
+        Strand(void);
+
+        /**
+         * @brief   Destructor
+         *
+         * Never delete a strand that has been added to the pool. Use
+         * AudioCodecWorkerPool::release instead.
+         */
+        virtual ~Strand(void);
+
+      protected:
+        /**
+         * @brief   Tell the pool that the strand has work to do
+         *
+         * The strand will be queued for processing by a worker thread if
+         * it is not already queued or running.
+         */
+        void schedule(void);
+
+        /**
+         * @brief   Wake up the main thread, called from a worker thread
+         */
+        void notifyMainThread(void);
+
+        /**
+         * @brief   Process queued work, called from a worker thread
+         *
+         * Process as much work as possible. Return when there is no more
+         * work or when there is no room for more results. If schedule is
+         * called while processing, this function is called again.
+         */
+        virtual void process(void) = 0;
+
+        /**
+         * @brief   Handle produced results in the main thread
+         *
+         * Called from the main thread after any strand has called
+         * notifyMainThread.
+         */
+        virtual void complete(void) = 0;
+
+      private:
+        friend class AudioCodecWorkerPool;
+
+        enum State
+        {
+          STATE_IDLE, STATE_QUEUED, STATE_RUNNING, STATE_RUNNING_AGAIN
+        };
+
+        std::atomic<int>      m_state;
+        std::atomic<bool>     m_released;
+
+        Strand(const Strand&);
+        Strand& operator=(const Strand&);
+
+    };  /* class Strand */
+
+    /**
+     * @brief   Get the pool, creating it if it does not exist
+     * @return  Returns the pool
+     */
+    static AudioCodecWorkerPool *instance(void);
+
+    /**
+     * @brief   Get the number of worker threads
+     * @return  Returns the number of threads in the pool
+     */
+    unsigned threadCount(void) const { return m_threads.size(); }
+
+    /**
+     * @brief   Add a strand to the pool
+     * @param   strand The strand to add
+     */
+    void add(Strand *strand);
+
+    /**
+     * @brief   Remove a strand from the pool and delete it
+     * @param   strand The strand to release
+     *
+     * The strand is deleted by a worker thread as soon as it is not
+     * running, so the codec is never deleted while in use. No functions in
+     * the strand will be called from the main thread after this call.
+     */
+    void release(Strand *strand);
+
+  private:
+    static const unsigned DEFAULT_THREAD_COUNT = 2;
+
+    static AudioCodecWorkerPool*  the_pool;
+
+    std::vector<pthread_t>        m_threads;
+    pthread_mutex_t               m_mutex;
+    pthread_cond_t                m_cond;
+    std::deque<Strand*>           m_run_queue;
+    bool                          m_stopping;
+    std::set<Strand*>             m_strands;
+    Strand*                       m_completing;
+    bool                          m_completing_released;
+    int                           m_notify_rd;
+    int                           m_notify_wr;
+    std::atomic<bool>             m_notify_pending;
+    FdWatch*                      m_notify_watch;
+
+    explicit AudioCodecWorkerPool(unsigned thread_cnt);
+    AudioCodecWorkerPool(const AudioCodecWorkerPool&);
+    AudioCodecWorkerPool& operator=(const AudioCodecWorkerPool&);
+    void enqueue(Strand *strand);
+    void notifyMainThread(void);
+    void notificationReceived(FdWatch *watch);
+    static void stopThreads(void);
+    static void *threadFunc(void *data);
+    void threadLoop(void);
+    void run(Strand *strand);
+
+};  /* class AudioCodecWorkerPool */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_CODEC_WORKER_POOL_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -108,17 +108,15 @@ using namespace Async;
 
 AudioDecimator::AudioDecimator(int decimation_factor,
       	      	      	       const float *filter_coeff, int taps)
-  : factor_M(decimation_factor), H_size(taps), p_H(filter_coeff)
+  : factor_M(decimation_factor)
 {
   setInputOutputSampleRate(factor_M, 1);
-  p_Z = new float[H_size];
-  memset(p_Z, 0, H_size * sizeof(*p_Z));
+  fir.setDecimator(factor_M, filter_coeff, taps);
 } /* AudioDecimator::AudioDecimator */
 
 
 AudioDecimator::~AudioDecimator(void)
 {
-  delete [] p_Z;
 } /* AudioDecimator::~AudioDecimator */
 
 
@@ -132,39 +130,12 @@ AudioDecimator::~AudioDecimator(void)
 
 void AudioDecimator::processSamples(float *dest, const float *src, int count)
 {
-  int orig_count = count;
-  
-  //printf("count=%d\n", count);
-  
     // this implementation assumes num_inp is a multiple of factor_M
   assert(count % factor_M == 0);
 
-  int num_out = 0;
-  while (count >= factor_M)
-  {
-      // shift Z delay line up to make room for next samples
-    memmove(p_Z + factor_M, p_Z, (H_size - factor_M) * sizeof(float));
-
-      // copy next samples from input buffer to bottom of Z delay line
-    for (int tap = factor_M - 1; tap >= 0; tap--)
-    {
-      p_Z[tap] = *src++;
-    }
-    count -= factor_M;
-
-      // calculate FIR sum
-    float sum = 0.0;
-    for (int tap = 0; tap < H_size; tap++)
-    {
-      sum += p_H[tap] * p_Z[tap];
-    }
-    *dest++ = sum;     /* store sum and point to next output */
-    num_out++;
-  }
-
-  //printf("num_out=%d  count=%d  factor_M=%d\n", num_out, count, factor_M);
-  assert(num_out == orig_count / factor_M);
-  
+  int num_out = fir.process(dest, src, count);
+  assert(num_out == count / factor_M);
+  (void)num_out;
 } /* AudioDecimator::processSamples */
 
 
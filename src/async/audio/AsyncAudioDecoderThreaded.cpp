@@ -0,0 +1,448 @@
+/**
+@file	 AsyncAudioDecoderThreaded.cpp
+@brief   An audio decoder that run another decoder in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-29
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncSpscRingBuffer.h>
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioDecoderThreaded.h"
+#include "AsyncAudioCodecWorkerPool.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+class AudioDecoderThreaded::Worker
+  : public AudioCodecWorkerPool::Strand, public AudioSink
+{
+  public:
+    Worker(AudioDecoderThreaded *owner, AudioDecoder *dec)
+      : m_owner(owner), m_dec(dec), m_started(false), m_overflow(false),
+        m_jobs(JOB_QUEUE_SIZE), m_results(RESULT_QUEUE_SIZE),
+        m_jobs_deferred(false), m_dropped(0)
+    {
+      m_dec->registerSink(this);
+    }
+
+    ~Worker(void)
+    {
+      delete m_dec;
+    }
+
+    void detach(void)
+    {
+      m_owner = 0;
+      AudioCodecWorkerPool::instance()->release(this);
+    }
+
+    void writeEncodedSamples(const void *buf, int size)
+    {
+        // Leave some room for flushes and options
+      if (!m_deferred.empty() || (m_jobs.writeAvailable() <= CTRL_RESERVE))
+      {
+        if (!m_overflow)
+        {
+          cerr << "*** WARNING: The job queue for the threaded "
+               << m_owner->name() << " audio decoder is full. "
+               << "Throwing away encoded audio." << endl;
+          m_overflow = true;
+        }
+        return;
+      }
+      m_overflow = false;
+      const uint8_t *data = reinterpret_cast<const uint8_t *>(buf);
+      m_job.type = Job::ENCODED;
+      m_job.data.assign(data, data + size);
+      queueJob();
+    }
+
+    void flushEncodedSamples(void)
+    {
+      m_job.type = Job::FLUSH;
+      queueJob();
+    }
+
+    void allSamplesFlushed(void)
+    {
+      m_job.type = Job::ALL_FLUSHED;
+      queueJob();
+    }
+
+    void setOption(const std::string &name, const std::string &value)
+    {
+      if (!m_started)
+      {
+        m_dec->setOption(name, value);
+        return;
+      }
+      m_job.type = Job::OPTION;
+      m_job.name = name;
+      m_job.value = value;
+      queueJob();
+    }
+
+    void printCodecParams(void)
+    {
+      if (!m_started)
+      {
+        m_dec->printCodecParams();
+        return;
+      }
+      m_job.type = Job::PRINT_PARAMS;
+      queueJob();
+    }
+
+      // The AudioSink interface, called by the wrapped decoder in the
+      // worker thread
+    virtual int writeSamples(const float *samples, int count)
+    {
+      m_proc_result.type = Result::SAMPLES;
+      m_proc_result.samples.assign(samples, samples + count);
+      queueResult();
+      return count;
+    }
+
+    virtual void flushSamples(void)
+    {
+      m_proc_result.type = Result::FLUSHED;
+      m_proc_result.samples.clear();
+      queueResult();
+    }
+
+  protected:
+    virtual void process(void)
+    {
+      bool notify = false;
+      while ((m_results.writeAvailable() >= MIN_RESULT_ROOM) &&
+             (m_jobs.read(&m_proc_job, 1) == 1))
+      {
+          // Make sure that the read position is visible to the main thread
+          // before the flag is loaded. Otherwise both threads may see the
+          // old value of what the other thread stored.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        notify = notify || m_jobs_deferred;
+        switch (m_proc_job.type)
+        {
+          case Job::ENCODED:
+            m_dec->writeEncodedSamples(&m_proc_job.data[0],
+                                       m_proc_job.data.size());
+            break;
+          case Job::FLUSH:
+            m_dec->flushEncodedSamples();
+            break;
+          case Job::ALL_FLUSHED:
+            sourceAllSamplesFlushed();
+            break;
+          case Job::OPTION:
+            m_dec->setOption(m_proc_job.name, m_proc_job.value);
+            break;
+          case Job::PRINT_PARAMS:
+            m_dec->printCodecParams();
+            break;
+        }
+      }
+      if (notify || (m_results.readAvailable() > 0))
+      {
+        notifyMainThread();
+      }
+    }
+
+    virtual void complete(void)
+    {
+      while ((m_owner != 0) && (m_results.read(&m_result, 1) == 1))
+      {
+        if (m_result.type == Result::SAMPLES)
+        {
+          m_owner->sinkWriteSamples(&m_result.samples[0],
+                                    m_result.samples.size());
+        }
+        else
+        {
+          m_owner->sinkFlushSamples();
+        }
+      }
+      if (m_owner == 0)
+      {
+        return;
+      }
+
+      unsigned dropped = m_dropped.exchange(0);
+      if (dropped > 0)
+      {
+        cerr << "*** WARNING: " << dropped << " blocks of decoded "
+             << m_owner->name() << " audio lost since the main thread did "
+                "not handle them in time" << endl;
+      }
+
+      if (!m_deferred.empty())
+      {
+        queueDeferredJobs();
+      }
+
+      if (m_jobs.readAvailable() > 0)
+      {
+        schedule();
+      }
+    }
+
+  private:
+    static const size_t JOB_QUEUE_SIZE = 64;
+    static const size_t RESULT_QUEUE_SIZE = 256;
+    static const size_t CTRL_RESERVE = 8;
+    static const size_t MIN_RESULT_ROOM = 16;
+
+    struct Job
+    {
+      enum Type { ENCODED, FLUSH, ALL_FLUSHED, OPTION, PRINT_PARAMS };
+      Type                  type;
+      std::vector<uint8_t>  data;
+      std::string           name;
+      std::string           value;
+      Job(void) : type(ENCODED) {}
+    };
+
+    struct Result
+    {
+      enum Type { SAMPLES, FLUSHED };
+      Type                type;
+      std::vector<float>  samples;
+      Result(void) : type(SAMPLES) {}
+    };
+
+    AudioDecoderThreaded*   m_owner;
+    AudioDecoder*           m_dec;
+    bool                    m_started;
+    bool                    m_overflow;
+    Job                     m_job;
+    Job                     m_proc_job;
+    SpscRingBuffer<Job>     m_jobs;
+    Result                  m_proc_result;
+    Result                  m_result;
+    SpscRingBuffer<Result>  m_results;
+    std::deque<Job>         m_deferred;
+    std::atomic<bool>       m_jobs_deferred;
+    std::atomic<unsigned>   m_dropped;
+
+    void queueJob(void)
+    {
+      m_started = true;
+      if (m_deferred.empty() && (m_jobs.write(&m_job, 1) == 1))
+      {
+        schedule();
+        return;
+      }
+
+        // The job queue is full. Keep the job until the worker has made room
+        // for it so that no flush or option is lost. The flag is set before
+        // trying again so that the worker cannot empty the queue without
+        // waking up the main thread.
+      m_deferred.push_back(m_job);
+      m_jobs_deferred = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      queueDeferredJobs();
+    }
+
+    void queueDeferredJobs(void)
+    {
+      bool queued = false;
+      while (!m_deferred.empty() &&
+             (m_jobs.write(&m_deferred.front(), 1) == 1))
+      {
+        m_deferred.pop_front();
+        queued = true;
+      }
+      m_jobs_deferred = !m_deferred.empty();
+      if (queued)
+      {
+        schedule();
+      }
+    }
+
+    void queueResult(void)
+    {
+      if (m_results.write(&m_proc_result, 1) != 1)
+      {
+        ++m_dropped;
+      }
+    }
+
+};  /* class AudioDecoderThreaded::Worker */
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioDecoderThreaded::AudioDecoderThreaded(AudioDecoder *dec)
+  : m_name(dec->name()), m_worker(0)
+{
+  m_worker = new Worker(this, dec);
+  AudioCodecWorkerPool::instance()->add(m_worker);
+} /* AudioDecoderThreaded::AudioDecoderThreaded */
+
+
+AudioDecoderThreaded::~AudioDecoderThreaded(void)
+{
+  m_worker->detach();
+} /* AudioDecoderThreaded::~AudioDecoderThreaded */
+
+
+void AudioDecoderThreaded::setOption(const std::string &name,
+                                     const std::string &value)
+{
+  m_worker->setOption(name, value);
+} /* AudioDecoderThreaded::setOption */
+
+
+void AudioDecoderThreaded::printCodecParams(void) const
+{
+  m_worker->printCodecParams();
+} /* AudioDecoderThreaded::printCodecParams */
+
+
+void AudioDecoderThreaded::writeEncodedSamples(void *buf, int size)
+{
+  if (size <= 0)
+  {
+    return;
+  }
+  m_worker->writeEncodedSamples(buf, size);
+} /* AudioDecoderThreaded::writeEncodedSamples */
+
+
+void AudioDecoderThreaded::flushEncodedSamples(void)
+{
+  m_worker->flushEncodedSamples();
+} /* AudioDecoderThreaded::flushEncodedSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void AudioDecoderThreaded::allSamplesFlushed(void)
+{
+    // Let the wrapped decoder know too, in case it keep any state
+  m_worker->allSamplesFlushed();
+  allEncodedSamplesFlushed();
+} /* AudioDecoderThreaded::allSamplesFlushed */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
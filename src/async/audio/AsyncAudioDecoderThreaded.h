@@ -0,0 +1,205 @@
+/**
+@file	 AsyncAudioDecoderThreaded.h
+@brief   An audio decoder that run another decoder in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-29
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_DECODER_THREADED_INCLUDED
+#define ASYNC_AUDIO_DECODER_THREADED_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioDecoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	An audio decoder that run another decoder in a worker thread
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-29
+
+This class wrap an ordinary audio decoder and run it in one of the threads of
+the AudioCodecWorkerPool, so that the decoding does not delay the main loop.
+Encoded samples written to this decoder are queued to the worker thread and
+the decoded samples are written to the registered sink from the main thread,
+in the same order as the wrapped decoder produced them. A flush is passed on
+to the sink once all encoded samples written before it have been decoded.
+
+The decoder cannot push back on the writer of the encoded samples so if the
+queue to the worker thread is full, the encoded samples are thrown away and a
+warning is printed.
+
+Options set and parameter printouts requested before the first encoded
+samples are written are handled directly by the wrapped decoder. After that
+they are queued so that they are applied in order with the encoded samples.
+*/
+class AudioDecoderThreaded : public AudioDecoder
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param 	dec The decoder to run in a worker thread
+     *
+     * The wrapped decoder is owned by this object and must not be used
+     * directly after this call.
+     */
+    explicit AudioDecoderThreaded(AudioDecoder *dec);
+
+    /**
+     * @brief 	Destructor
+     *
+     * The wrapped decoder is deleted by the worker thread when it has
+     * finished any ongoing decoding.
+     */
+    virtual ~AudioDecoderThreaded(void);
+
+    /**
+     * @brief   Get the name of the codec
+     * @returns Return the name of the wrapped codec
+     */
+    virtual const char *name(void) const { return m_name.c_str(); }
+
+    /**
+     * @brief 	Set an option for the decoder
+     * @param 	name The name of the option
+     * @param 	value The value of the option
+     */
+    virtual void setOption(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Print codec parameter settings
+     */
+    virtual void printCodecParams(void) const;
+
+    /**
+     * @brief 	Write encoded samples into the decoder
+     * @param 	buf  Buffer containing encoded samples
+     * @param 	size The size of the buffer
+     */
+    virtual void writeEncodedSamples(void *buf, int size);
+
+    /**
+     * @brief Call this function when all encoded samples have been received
+     */
+    virtual void flushEncodedSamples(void);
+
+  protected:
+    /**
+     * @brief The registered sink has flushed all samples
+     *
+     * This function will be called when all samples have been flushed in the
+     * registered sink.
+     * This function is normally only called from a connected sink object.
+     */
+    virtual void allSamplesFlushed(void);
+
+  private:
+    class Worker;
+
+    std::string   m_name;
+    Worker*       m_worker;
+
+    AudioDecoderThreaded(const AudioDecoderThreaded&);
+    AudioDecoderThreaded& operator=(const AudioDecoderThreaded&);
+
+};  /* class AudioDecoderThreaded */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_DECODER_THREADED_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -59,6 +59,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "AsyncAudioIO.h"
 #include "AsyncAudioDevice.h"
 #include "AsyncAudioDeviceFactory.h"
+#include "AsyncAudioSampleConv.h"
 
 
 /****************************************************************************
@@ -253,7 +254,8 @@ void AudioDevice::close(void)
 
 
 AudioDevice::AudioDevice(const string& dev_name)
-  : dev_name(dev_name), current_mode(MODE_NONE), use_count(0)
+  : dev_name(dev_name), current_mode(MODE_NONE), use_count(0),
+    get_blocks_depth(0)
 {
 } /* AudioDevice::AudioDevice */
 
@@ -266,20 +268,16 @@ AudioDevice::~AudioDevice(void)
 void AudioDevice::putBlocks(int16_t *buf, int frame_cnt)
 {
   //printf("putBlocks: frame_cnt=%d\n", frame_cnt);
-  float samples[frame_cnt];
+  setupChannelBuffers(read_buf, read_chans, frame_cnt);
+  AudioSampleConv::s16ToFloat(&read_chans[0], buf, channels, frame_cnt);
   for (int ch=0; ch<channels; ch++)
   {
-    for (int i=0; i<frame_cnt; i++)
-    {
-        // no divisions in index calculation (embedded system performance !!!)
-      samples[i] = static_cast<float>(buf[i * channels + ch]) / 32768.0;
-    }
     list<AudioIO*>::iterator it;
     for (it=aios.begin(); it!=aios.end(); ++it)
     {
       if ((*it)->channel() == ch)
       {
-        (*it)->audioRead(samples, frame_cnt);
+        (*it)->audioRead(read_chans[ch], frame_cnt);
       }
     }
   }
@@ -345,34 +343,60 @@ int AudioDevice::getBlocks(int16_t *buf, int block_cnt)
     return 0;
   }
   
-    // Fill the sample buffer with samples from the non-idle AudioIO objects.
+    // Fill the channel buffers with samples from the non-idle AudioIO
+    // objects. The first AudioIO object on a channel read directly into the
+    // channel buffer while the samples from any other AudioIO objects on the
+    // same channel are added to it, saturating after each AudioIO object
+    // like when mixing directly into the 16 bit sample buffer. The channel
+    // buffers are then converted to interleaved samples in one go.
+    // Reading samples from an AudioIO object may cause this function to be
+    // called again, e.g. through AudioDeviceUDP::audioWriteHandler. Only the
+    // outermost call use the member buffers. A nested call use buffers of
+    // its own so that it does not overwrite the samples of the outer call.
+  vector<float> nested_buf;
+  vector<float*> nested_chans;
+  vector<bool> nested_chan_used;
+  vector<float> nested_mix_buf;
+  const bool nested = (get_blocks_depth > 0);
+  vector<float>& chan_bufs = nested ? nested_buf : write_buf;
+  vector<float*>& chans = nested ? nested_chans : write_chans;
+  vector<bool>& chan_used = nested ? nested_chan_used : write_chan_used;
+  vector<float>& mix = nested ? nested_mix_buf : mix_buf;
+  setupChannelBuffers(chan_bufs, chans, frames_to_write);
+  mix.resize(max(mix.size(), static_cast<size_t>(frames_to_write)));
+  chan_used.assign(channels, false);
+  ++get_blocks_depth;
   for (it=aios.begin(); it!=aios.end(); ++it)
   {
-    if (!(*it)->isIdle())
+    int channel = (*it)->channel();
+    if (!(*it)->isIdle() && (channel >= 0) && (channel < channels))
     {
-      int channel = (*it)->channel();
-      float tmp[frames_to_write];
-      int samples_read = (*it)->readSamples(tmp, frames_to_write);
-      for (int i=0; i<samples_read; ++i)
+      float *chan_buf = chans[channel];
+      if (!chan_used[channel])
       {
-	int buf_pos = i * channels + channel;
-	float sample = 32767.0 * tmp[i] + buf[buf_pos];
-	if (sample > 32767)
-	{
-	  buf[buf_pos] = 32767;
-	}
-	else if (sample < -32767)
-	{
-	  buf[buf_pos] = -32767;
-	}
-	else
-	{
-	  buf[buf_pos] = static_cast<int16_t>(sample);
-	}
+        int samples_read = (*it)->readSamples(chan_buf, frames_to_write);
+        fill(chan_buf + max(samples_read, 0), chan_buf + frames_to_write,
+             0.0f);
+        chan_used[channel] = true;
+      }
+      else
+      {
+        int samples_read = (*it)->readSamples(&mix[0], frames_to_write);
+        AudioSampleConv::addSaturated(chan_buf, &mix[0],
+                                      max(samples_read, 0));
       }
     }
-  }  
-      
+  }
+  --get_blocks_depth;
+  for (int ch=0; ch<channels; ++ch)
+  {
+    if (!chan_used[ch])
+    {
+      fill(chans[ch], chans[ch] + frames_to_write, 0.0f);
+    }
+  }
+  AudioSampleConv::floatToS16(buf, &chans[0], channels, frames_to_write);
+
     // If flushing and the number of frames to write is not an even
     // multiple of the frag size, round the number of frags to write
     // up. The end of the buffer is already zeroed out.
@@ -394,6 +418,22 @@ int AudioDevice::getBlocks(int16_t *buf, int block_cnt)
  *
  ****************************************************************************/
 
+void AudioDevice::setupChannelBuffers(vector<float>& buf,
+                                      vector<float*>& chans, unsigned frames)
+{
+  size_t stride = chans.empty() ? 0 : buf.size() / chans.size();
+  if ((chans.size() != static_cast<size_t>(channels)) || (stride < frames))
+  {
+    stride = max(stride, static_cast<size_t>(frames));
+    buf.assign(channels * stride, 0.0f);
+    chans.resize(channels);
+    for (int ch=0; ch<channels; ++ch)
+    {
+      chans[ch] = &buf[ch * stride];
+    }
+  }
+} /* AudioDevice::setupChannelBuffers */
+
 
 /*
  * This file has not been truncated
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 
 
 /****************************************************************************
@@ -336,6 +337,16 @@ class AudioDevice : public sigc::trackable
     Mode      	      	current_mode;
     int       	      	use_count;
     std::list<AudioIO*> aios;
+    std::vector<float>  read_buf;
+    std::vector<float*> read_chans;
+    std::vector<float>  write_buf;
+    std::vector<float*> write_chans;
+    std::vector<bool>   write_chan_used;
+    std::vector<float>  mix_buf;
+    int                 get_blocks_depth;
+
+    void setupChannelBuffers(std::vector<float>& buf,
+                             std::vector<float*>& chans, unsigned frames);
 
 };  /* class AudioDevice */
 
@@ -36,10 +36,15 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <sigc++/sigc++.h>
 #include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <cstring>
+#include <cerrno>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -194,7 +199,11 @@ AudioDeviceAlsa::AudioDeviceAlsa(const std::string& dev_name)
   : AudioDevice(dev_name), play_block_size(0), play_block_count(0),
     rec_block_size(0), rec_block_count(0), play_handle(0), 
     rec_handle(0), play_watch(0), rec_watch(0), duplex(false),
-    zerofill_on_underflow(true)
+    zerofill_on_underflow(true), rt_prio(0), rt_thread_running(false),
+    rt_thread_stop(false), rt_wakeup_rd(-1), rt_wakeup_wr(-1),
+    rt_notify_rd(-1), rt_notify_wr(-1), rt_notify_pending(false),
+    rt_notify_watch(0), play_hw_frames(0), rec_lost_frames(0),
+    play_ring_filling(false), play_ring_refill(false)
 {
   assert(AudioDeviceAlsa_creator_registered);
 
@@ -204,6 +213,12 @@ AudioDeviceAlsa::AudioDeviceAlsa(const std::string& dev_name)
     istringstream(zerofill_str) >> zerofill_on_underflow;
   }
 
+  char *rt_prio_str = getenv("ASYNC_AUDIO_ALSA_RT_PRIO");
+  if (rt_prio_str != 0)
+  {
+    istringstream(rt_prio_str) >> rt_prio;
+  }
+
   snd_pcm_t *play, *capture;
 
     // Open the device to check its duplex capability
@@ -255,6 +270,10 @@ void AudioDeviceAlsa::audioToWriteAvailable(void)
   {
     play_watch->setEnabled(true);
   }
+  else if (rt_thread_running && (play_handle != 0))
+  {
+    fillPlayRing();
+  }
 } /* AudioDeviceAlsa::audioToWriteAvailable */
 
 
@@ -264,6 +283,10 @@ void AudioDeviceAlsa::flushSamples(void)
   {
     play_watch->setEnabled(true);
   }  
+  else if (rt_thread_running && (play_handle != 0))
+  {
+    fillPlayRing();
+  }
 } /* AudioDeviceAlsa::flushSamples */
 
 
@@ -274,6 +297,12 @@ int AudioDeviceAlsa::samplesToWrite(void) const
     return 0;
   }
 
+  if (rt_thread_running)
+  {
+    return static_cast<int>(play_ring.readAvailable() / channels) +
+           play_hw_frames.load();
+  }
+
   int space_avail = snd_pcm_avail_update(play_handle);
   if (space_avail < 0)
   {
@@ -324,10 +353,17 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
       return false;
     }
 
-    play_watch = new AlsaWatch(play_handle);
-    play_watch->activity.connect(
-            mem_fun(*this, &AudioDeviceAlsa::writeSpaceAvailable));
-    play_watch->setEnabled(true);
+    if (rt_prio > 0)
+    {
+      play_ring.setCapacity(RT_RING_BLOCKS * play_block_size * channels);
+    }
+    else
+    {
+      play_watch = new AlsaWatch(play_handle);
+      play_watch->activity.connect(
+              mem_fun(*this, &AudioDeviceAlsa::writeSpaceAvailable));
+      play_watch->setEnabled(true);
+    }
 
     if (!startPlayback(play_handle))
     {
@@ -361,9 +397,16 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
       return false;
     }
 
-    rec_watch = new AlsaWatch(rec_handle);
-    rec_watch->activity.connect(
-            mem_fun(*this, &AudioDeviceAlsa::audioReadHandler));
+    if (rt_prio > 0)
+    {
+      rec_ring.setCapacity(RT_RING_BLOCKS * rec_block_size * channels);
+    }
+    else
+    {
+      rec_watch = new AlsaWatch(rec_handle);
+      rec_watch->activity.connect(
+              mem_fun(*this, &AudioDeviceAlsa::audioReadHandler));
+    }
 
     if (!startCapture(rec_handle))
     {
@@ -373,6 +416,12 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
     }
   }
 
+  if ((rt_prio > 0) && !startRtThread())
+  {
+    closeDevice();
+    return false;
+  }
+
   return true;
 
 } /* AudioDeviceAlsa::openDevice */
@@ -380,6 +429,8 @@ bool AudioDeviceAlsa::openDevice(Mode mode)
 
 void AudioDeviceAlsa::closeDevice(void)
 {
+  stopRtThread();
+
   if (play_handle != 0)
   {
     snd_pcm_close(play_handle);
@@ -791,6 +842,377 @@ bool AudioDeviceAlsa::startCapture(snd_pcm_t *pcm_handle)
 } /* AudioDeviceAlsa::startCapture */
 
 
+bool AudioDeviceAlsa::startRtThread(void)
+{
+  int fds[4];
+  if ((pipe(fds) != 0) || (pipe(fds + 2) != 0))
+  {
+    cerr << "*** ERROR: Could not create pipe for the audio thread: "
+         << strerror(errno) << endl;
+    return false;
+  }
+  rt_wakeup_rd = fds[0];
+  rt_wakeup_wr = fds[1];
+  rt_notify_rd = fds[2];
+  rt_notify_wr = fds[3];
+  for (int i=0; i<4; ++i)
+  {
+    fcntl(fds[i], F_SETFL, O_NONBLOCK);
+  }
+
+  rt_notify_watch = new FdWatch(rt_notify_rd, FdWatch::FD_WATCH_RD);
+  rt_notify_watch->activity.connect(
+      mem_fun(*this, &AudioDeviceAlsa::rtNotificationReceived));
+
+  rt_thread_stop = false;
+  rt_notify_pending = false;
+  play_hw_frames = 0;
+  rec_lost_frames = 0;
+  int ret = pthread_create(&rt_thread, NULL, rtThreadFunc, this);
+  if (ret != 0)
+  {
+    cerr << "*** ERROR: Could not create the audio thread: "
+         << strerror(ret) << endl;
+    return false;
+  }
+  rt_thread_running = true;
+
+  struct sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = rt_prio;
+  ret = pthread_setschedparam(rt_thread, SCHED_FIFO, &param);
+  if (ret != 0)
+  {
+    cerr << "*** WARNING: Could not set real time priority " << rt_prio
+         << " for the audio thread of ALSA device \"" << dev_name << "\": "
+         << strerror(ret) << ". The thread will run with normal priority."
+         << endl;
+  }
+
+  return true;
+} /* AudioDeviceAlsa::startRtThread */
+
+
+void AudioDeviceAlsa::stopRtThread(void)
+{
+  if (rt_thread_running)
+  {
+    rt_thread_stop = true;
+    if ((::write(rt_wakeup_wr, "S", 1) != 1) && (errno != EAGAIN))
+    {
+      cerr << "*** WARNING: Could not wake up the audio thread: "
+           << strerror(errno) << endl;
+    }
+    pthread_join(rt_thread, NULL);
+    rt_thread_running = false;
+  }
+
+  delete rt_notify_watch;
+  rt_notify_watch = 0;
+  int *fds[] = { &rt_wakeup_rd, &rt_wakeup_wr, &rt_notify_rd, &rt_notify_wr };
+  for (int i=0; i<4; ++i)
+  {
+    if (*fds[i] != -1)
+    {
+      ::close(*fds[i]);
+      *fds[i] = -1;
+    }
+  }
+  play_ring.clear();
+  rec_ring.clear();
+  play_ring_refill = false;
+} /* AudioDeviceAlsa::stopRtThread */
+
+
+void *AudioDeviceAlsa::rtThreadFunc(void *data)
+{
+  AudioDeviceAlsa *dev = reinterpret_cast<AudioDeviceAlsa *>(data);
+  dev->rtThreadLoop();
+  return NULL;
+} /* AudioDeviceAlsa::rtThreadFunc */
+
+
+void AudioDeviceAlsa::rtThreadLoop(void)
+{
+    // All buffers are allocated before entering the loop so that no memory
+    // allocation is done while running with real time priority
+  int play_nfds = (play_handle != 0)
+    ? snd_pcm_poll_descriptors_count(play_handle) : 0;
+  int rec_nfds = (rec_handle != 0)
+    ? snd_pcm_poll_descriptors_count(rec_handle) : 0;
+  std::vector<struct pollfd> pfds(1 + play_nfds + rec_nfds);
+  std::vector<int16_t> play_buf(RT_RING_BLOCKS * play_block_size * channels);
+  std::vector<int16_t> rec_buf(rec_block_count * rec_block_size * channels);
+  bool play_ok = (play_handle != 0);
+  bool rec_ok = (rec_handle != 0);
+  bool play_active = play_ok;
+
+  while (!rt_thread_stop)
+  {
+    pfds[0].fd = rt_wakeup_rd;
+    pfds[0].events = POLLIN;
+    pfds[0].revents = 0;
+    int nfds = 1;
+    struct pollfd *play_pfds = 0;
+    if (play_ok && play_active)
+    {
+      play_pfds = &pfds[nfds];
+      snd_pcm_poll_descriptors(play_handle, play_pfds, play_nfds);
+      nfds += play_nfds;
+    }
+    struct pollfd *rec_pfds = 0;
+    if (rec_ok)
+    {
+      rec_pfds = &pfds[nfds];
+      snd_pcm_poll_descriptors(rec_handle, rec_pfds, rec_nfds);
+      nfds += rec_nfds;
+    }
+
+    if (poll(&pfds[0], nfds, -1) < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      cerr << "*** ERROR: poll failed in the audio thread: "
+           << strerror(errno) << endl;
+      break;
+    }
+
+    if (pfds[0].revents & POLLIN)
+    {
+      char buf[64];
+      while (::read(rt_wakeup_rd, buf, sizeof(buf)) > 0) {}
+      play_active = play_ok;
+    }
+
+    if (play_pfds != 0)
+    {
+      unsigned short revents = 0;
+      snd_pcm_poll_descriptors_revents(play_handle, play_pfds, play_nfds,
+                                       &revents);
+      if (revents & (POLLOUT | POLLERR))
+      {
+        play_ok = rtPlayback(play_buf, play_active);
+      }
+    }
+
+    if (rec_pfds != 0)
+    {
+      unsigned short revents = 0;
+      snd_pcm_poll_descriptors_revents(rec_handle, rec_pfds, rec_nfds,
+                                       &revents);
+      if (revents & (POLLIN | POLLERR))
+      {
+        rec_ok = rtCapture(rec_buf);
+      }
+    }
+  }
+} /* AudioDeviceAlsa::rtThreadLoop */
+
+
+bool AudioDeviceAlsa::rtPlayback(std::vector<int16_t>& buf, bool& play_active)
+{
+  const size_t block_len = play_block_size * channels;
+  while (1)
+  {
+    snd_pcm_sframes_t space_avail = snd_pcm_avail_update(play_handle);
+    if (space_avail < 0)
+    {
+      if (!startPlayback(play_handle))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    size_t blocks_to_write = std::min(space_avail / play_block_size,
+                                      static_cast<long>(RT_RING_BLOCKS));
+    if (blocks_to_write == 0)
+    {
+      break;
+    }
+
+    size_t blocks_avail = std::min(play_ring.readAvailable() / block_len,
+                                   blocks_to_write);
+    if (blocks_avail > 0)
+    {
+      play_ring.read(&buf[0], blocks_avail * block_len);
+    }
+    else if (zerofill_on_underflow)
+    {
+      blocks_avail = 1;
+      std::fill_n(buf.begin(), block_len, 0);
+    }
+    else
+    {
+      play_active = false;
+      break;
+    }
+
+    snd_pcm_sframes_t frames_to_write = blocks_avail * play_block_size;
+    snd_pcm_sframes_t frames_written =
+      snd_pcm_writei(play_handle, &buf[0], frames_to_write);
+    if (frames_written < 0)
+    {
+      if (!startPlayback(play_handle))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    if ((frames_written != frames_to_write) ||
+        (frames_to_write != space_avail))
+    {
+      break;
+    }
+  }
+
+  snd_pcm_sframes_t space_avail = snd_pcm_avail_update(play_handle);
+  if (space_avail >= 0)
+  {
+    play_hw_frames = std::max(0L,
+        static_cast<long>(play_block_count * play_block_size - space_avail));
+  }
+  rtNotify();
+
+  return true;
+} /* AudioDeviceAlsa::rtPlayback */
+
+
+bool AudioDeviceAlsa::rtCapture(std::vector<int16_t>& buf)
+{
+  snd_pcm_sframes_t frames_avail = snd_pcm_avail_update(rec_handle);
+  if (frames_avail < 0)
+  {
+    return startCapture(rec_handle);
+  }
+
+  if (frames_avail >= rec_block_size)
+  {
+    frames_avail /= rec_block_size;
+    frames_avail *= rec_block_size;
+    frames_avail = std::min(frames_avail,
+        static_cast<snd_pcm_sframes_t>(buf.size() / channels));
+
+    snd_pcm_sframes_t frames_read =
+      snd_pcm_readi(rec_handle, &buf[0], frames_avail);
+    if (frames_read < 0)
+    {
+      return startCapture(rec_handle);
+    }
+
+      // Only whole frames are written to the ring so that the channels
+      // never get out of sync
+    size_t frames_free = rec_ring.writeAvailable() / channels;
+    size_t frames_to_write = std::min(static_cast<size_t>(frames_read),
+                                      frames_free);
+    rec_ring.write(&buf[0], frames_to_write * channels);
+    if (frames_to_write < static_cast<size_t>(frames_read))
+    {
+      rec_lost_frames += frames_read - frames_to_write;
+    }
+    rtNotify();
+  }
+
+  return true;
+} /* AudioDeviceAlsa::rtCapture */
+
+
+void AudioDeviceAlsa::rtNotify(void)
+{
+  if (!rt_notify_pending.exchange(true))
+  {
+    if (::write(rt_notify_wr, "N", 1) != 1)
+    {
+      rt_notify_pending = false;
+    }
+  }
+} /* AudioDeviceAlsa::rtNotify */
+
+
+void AudioDeviceAlsa::rtNotificationReceived(FdWatch *watch)
+{
+  char buf[64];
+  while (::read(rt_notify_rd, buf, sizeof(buf)) > 0) {}
+  rt_notify_pending = false;
+
+  unsigned lost = rec_lost_frames.exchange(0);
+  if (lost > 0)
+  {
+    cerr << "*** WARNING: " << lost << " frames of captured audio from "
+         << "ALSA device \"" << dev_name << "\" was lost since the main "
+         << "loop did not read them in time.\n";
+  }
+
+  if (rec_handle != 0)
+  {
+    drainRecRing();
+  }
+  if (play_handle != 0)
+  {
+    fillPlayRing();
+  }
+} /* AudioDeviceAlsa::rtNotificationReceived */
+
+
+void AudioDeviceAlsa::fillPlayRing(void)
+{
+    // Reading samples from the AudioIO objects may cause more samples to be
+    // written to them, which will call this function again. Just remember
+    // to try again in that case.
+  if (play_ring_filling)
+  {
+    play_ring_refill = true;
+    return;
+  }
+
+  play_ring_filling = true;
+  const size_t block_len = play_block_size * channels;
+  bool written = false;
+  do
+  {
+    play_ring_refill = false;
+    size_t blocks_free = play_ring.writeAvailable() / block_len;
+    if (blocks_free == 0)
+    {
+      break;
+    }
+    int16_t buf[blocks_free * block_len];
+    int blocks = getBlocks(buf, blocks_free);
+    if (blocks > 0)
+    {
+      play_ring.write(buf, blocks * block_len);
+      written = true;
+    }
+  } while (play_ring_refill);
+  play_ring_filling = false;
+
+    // Wake up the audio thread in case it has stopped writing to the sound
+    // card due to lack of audio
+  if (written && (::write(rt_wakeup_wr, "W", 1) != 1) && (errno != EAGAIN))
+  {
+    cerr << "*** WARNING: Could not wake up the audio thread: "
+         << strerror(errno) << endl;
+  }
+} /* AudioDeviceAlsa::fillPlayRing */
+
+
+void AudioDeviceAlsa::drainRecRing(void)
+{
+  const size_t block_len = rec_block_size * channels;
+  size_t blocks = rec_ring.readAvailable() / block_len;
+  if (blocks == 0)
+  {
+    return;
+  }
+  int16_t buf[blocks * block_len];
+  rec_ring.read(buf, blocks * block_len);
+  putBlocks(buf, blocks * rec_block_size);
+} /* AudioDeviceAlsa::drainRecRing */
+
+
 /*
  * This file has not been truncated
  */
@@ -37,6 +37,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <alsa/asoundlib.h>
+#include <pthread.h>
+
+#include <atomic>
+#include <vector>
 
 
 /****************************************************************************
@@ -45,6 +49,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncSpscRingBuffer.h>
 
 
 /****************************************************************************
@@ -113,6 +118,14 @@ This class implements the low level interface to an Alsa audio device. This
 class is not intended to be used by the end user of the Async library. It is
 used by the Async::AudioIO class, which is the Async API frontend for using
 audio in an application.
+
+Normally the sound card is serviced directly from the Async main loop. If the
+ASYNC_AUDIO_ALSA_RT_PRIO environment variable is set to a SCHED_FIFO priority
+(1-99), reading and writing the PCM devices is instead done by a separate real
+time thread. The audio is exchanged with the main loop through lock free
+rings holding RT_RING_BLOCKS blocks each, so the main loop may be busy for up
+to that long without causing an overrun or underrun in the sound card. This
+make it possible to use smaller blocks and a lower block count.
 */
 class AudioDeviceAlsa : public AudioDevice
 {
@@ -186,17 +199,35 @@ class AudioDeviceAlsa : public AudioDevice
 
 
   private:
-    class       AlsaWatch;
-    int         play_block_size;
-    int         play_block_count;
-    int         rec_block_size;
-    int         rec_block_count;
-    snd_pcm_t   *play_handle;
-    snd_pcm_t   *rec_handle;
-    AlsaWatch   *play_watch;
-    AlsaWatch   *rec_watch;
-    bool        duplex;
-    bool        zerofill_on_underflow;
+    static const int RT_RING_BLOCKS = 16;
+
+    class                   AlsaWatch;
+    int                     play_block_size;
+    int                     play_block_count;
+    int                     rec_block_size;
+    int                     rec_block_count;
+    snd_pcm_t               *play_handle;
+    snd_pcm_t               *rec_handle;
+    AlsaWatch               *play_watch;
+    AlsaWatch               *rec_watch;
+    bool                    duplex;
+    bool                    zerofill_on_underflow;
+    int                     rt_prio;
+    pthread_t               rt_thread;
+    bool                    rt_thread_running;
+    std::atomic<bool>       rt_thread_stop;
+    int                     rt_wakeup_rd;
+    int                     rt_wakeup_wr;
+    int                     rt_notify_rd;
+    int                     rt_notify_wr;
+    std::atomic<bool>       rt_notify_pending;
+    FdWatch                 *rt_notify_watch;
+    SpscRingBuffer<int16_t> play_ring;
+    SpscRingBuffer<int16_t> rec_ring;
+    std::atomic<int>        play_hw_frames;
+    std::atomic<unsigned>   rec_lost_frames;
+    bool                    play_ring_filling;
+    bool                    play_ring_refill;
 
     AudioDeviceAlsa(const AudioDeviceAlsa&);
     AudioDeviceAlsa& operator=(const AudioDeviceAlsa&);
@@ -207,6 +238,16 @@ class AudioDeviceAlsa : public AudioDevice
                             int &period_size);
     bool startPlayback(snd_pcm_t *pcm_handle);
     bool startCapture(snd_pcm_t *pcm_handle);
+    bool startRtThread(void);
+    void stopRtThread(void);
+    static void *rtThreadFunc(void *data);
+    void rtThreadLoop(void);
+    bool rtPlayback(std::vector<int16_t>& buf, bool& play_active);
+    bool rtCapture(std::vector<int16_t>& buf);
+    void rtNotify(void);
+    void rtNotificationReceived(FdWatch *watch);
+    void fillPlayRing(void);
+    void drainRecRing(void);
     
 };  /* class AudioDeviceAlsa */
 
@@ -0,0 +1,442 @@
+/**
+@file	 AsyncAudioEncoderThreaded.cpp
+@brief   An audio encoder that run another encoder in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-29
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncSpscRingBuffer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioEncoderThreaded.h"
+#include "AsyncAudioCodecWorkerPool.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+class AudioEncoderThreaded::Worker
+  : public AudioCodecWorkerPool::Strand, public sigc::trackable
+{
+  public:
+    Worker(AudioEncoderThreaded *owner, AudioEncoder *enc)
+      : m_owner(owner), m_enc(enc), m_started(false),
+        m_jobs(JOB_QUEUE_SIZE), m_results(RESULT_QUEUE_SIZE),
+        m_input_blocked(false), m_jobs_deferred(false), m_dropped(0)
+    {
+      m_enc->writeEncodedSamples.connect(
+          mem_fun(*this, &Worker::encodedSamplesWritten));
+      m_enc->flushEncodedSamples.connect(
+          mem_fun(*this, &Worker::encodedSamplesFlushed));
+    }
+
+    ~Worker(void)
+    {
+      delete m_enc;
+    }
+
+    void detach(void)
+    {
+      m_owner = 0;
+      AudioCodecWorkerPool::instance()->release(this);
+    }
+
+    int writeSamples(const float *samples, int count)
+    {
+        // Leave some room for flushes and options. The flag is set before
+        // checking again since the worker may have emptied the queue before
+        // it could see the flag. It would then never wake us up. The fence
+        // pair with the one in process so that the flag store cannot be
+        // reordered after the load of the queue read position.
+      if (!m_deferred.empty() || (m_jobs.writeAvailable() <= CTRL_RESERVE))
+      {
+        m_input_blocked = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_deferred.empty() || (m_jobs.writeAvailable() <= CTRL_RESERVE))
+        {
+          return 0;
+        }
+        m_input_blocked = false;
+      }
+      m_job.type = Job::SAMPLES;
+      m_job.samples.assign(samples, samples + count);
+      queueJob();
+      return count;
+    }
+
+    void flushSamples(void)
+    {
+      m_job.type = Job::FLUSH;
+      queueJob();
+    }
+
+    void setOption(const std::string &name, const std::string &value)
+    {
+      if (!m_started)
+      {
+        m_enc->setOption(name, value);
+        return;
+      }
+      m_job.type = Job::OPTION;
+      m_job.name = name;
+      m_job.value = value;
+      queueJob();
+    }
+
+    void printCodecParams(void)
+    {
+      if (!m_started)
+      {
+        m_enc->printCodecParams();
+        return;
+      }
+      m_job.type = Job::PRINT_PARAMS;
+      queueJob();
+    }
+
+  protected:
+    virtual void process(void)
+    {
+      bool notify = false;
+      while ((m_results.writeAvailable() >= MIN_RESULT_ROOM) &&
+             (m_jobs.read(&m_proc_job, 1) == 1))
+      {
+          // Make sure that the read position is visible to the main thread
+          // before the flags are loaded. Otherwise both threads may see
+          // the old value of what the other thread stored.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        notify = notify || m_input_blocked || m_jobs_deferred;
+        switch (m_proc_job.type)
+        {
+          case Job::SAMPLES:
+            m_enc->writeSamples(&m_proc_job.samples[0],
+                                m_proc_job.samples.size());
+            break;
+          case Job::FLUSH:
+            m_enc->flushSamples();
+            break;
+          case Job::OPTION:
+            m_enc->setOption(m_proc_job.name, m_proc_job.value);
+            break;
+          case Job::PRINT_PARAMS:
+            m_enc->printCodecParams();
+            break;
+        }
+        notify = notify || (m_results.readAvailable() > 0);
+      }
+      if (notify)
+      {
+        notifyMainThread();
+      }
+    }
+
+    virtual void complete(void)
+    {
+      while ((m_owner != 0) && (m_results.read(&m_result, 1) == 1))
+      {
+        if (m_result.type == Result::ENCODED)
+        {
+          m_owner->writeEncodedSamples(&m_result.data[0],
+                                       m_result.data.size());
+        }
+        else
+        {
+          m_owner->flushEncodedSamples();
+        }
+      }
+      if (m_owner == 0)
+      {
+        return;
+      }
+
+      unsigned dropped = m_dropped.exchange(0);
+      if (dropped > 0)
+      {
+        cerr << "*** WARNING: " << dropped << " encoded " << m_owner->name()
+             << " audio packets lost since the main thread did not handle "
+                "them in time" << endl;
+      }
+
+      if (!m_deferred.empty())
+      {
+        queueDeferredJobs();
+      }
+
+      if (m_jobs.readAvailable() > 0)
+      {
+        schedule();
+      }
+
+      if (m_input_blocked && m_deferred.empty() &&
+          (m_jobs.writeAvailable() > CTRL_RESERVE))
+      {
+        m_input_blocked = false;
+        m_owner->sourceResumeOutput();
+      }
+    }
+
+  private:
+    static const size_t JOB_QUEUE_SIZE = 64;
+    static const size_t RESULT_QUEUE_SIZE = 256;
+    static const size_t CTRL_RESERVE = 8;
+    static const size_t MIN_RESULT_ROOM = 16;
+
+    struct Job
+    {
+      enum Type { SAMPLES, FLUSH, OPTION, PRINT_PARAMS };
+      Type                type;
+      std::vector<float>  samples;
+      std::string         name;
+      std::string         value;
+      Job(void) : type(SAMPLES) {}
+    };
+
+    struct Result
+    {
+      enum Type { ENCODED, FLUSHED };
+      Type                  type;
+      std::vector<uint8_t>  data;
+      Result(void) : type(ENCODED) {}
+    };
+
+    AudioEncoderThreaded*   m_owner;
+    AudioEncoder*           m_enc;
+    bool                    m_started;
+    Job                     m_job;
+    Job                     m_proc_job;
+    SpscRingBuffer<Job>     m_jobs;
+    Result                  m_proc_result;
+    Result                  m_result;
+    SpscRingBuffer<Result>  m_results;
+    std::atomic<bool>       m_input_blocked;
+    std::deque<Job>         m_deferred;
+    std::atomic<bool>       m_jobs_deferred;
+    std::atomic<unsigned>   m_dropped;
+
+    void queueJob(void)
+    {
+      m_started = true;
+      if (m_deferred.empty() && (m_jobs.write(&m_job, 1) == 1))
+      {
+        schedule();
+        return;
+      }
+
+        // The job queue is full. Keep the job until the worker has made room
+        // for it so that no flush or option is lost. The flag is set before
+        // trying again so that the worker cannot empty the queue without
+        // waking up the main thread.
+      m_deferred.push_back(m_job);
+      m_jobs_deferred = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      queueDeferredJobs();
+    }
+
+    void queueDeferredJobs(void)
+    {
+      bool queued = false;
+      while (!m_deferred.empty() &&
+             (m_jobs.write(&m_deferred.front(), 1) == 1))
+      {
+        m_deferred.pop_front();
+        queued = true;
+      }
+      m_jobs_deferred = !m_deferred.empty();
+      if (queued)
+      {
+        schedule();
+      }
+    }
+
+    void queueResult(void)
+    {
+      if (m_results.write(&m_proc_result, 1) != 1)
+      {
+        ++m_dropped;
+      }
+    }
+
+    void encodedSamplesWritten(const void *buf, int size)
+    {
+      const uint8_t *data = reinterpret_cast<const uint8_t *>(buf);
+      m_proc_result.type = Result::ENCODED;
+      m_proc_result.data.assign(data, data + size);
+      queueResult();
+    }
+
+    void encodedSamplesFlushed(void)
+    {
+      m_proc_result.type = Result::FLUSHED;
+      m_proc_result.data.clear();
+      queueResult();
+    }
+
+};  /* class AudioEncoderThreaded::Worker */
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+AudioEncoderThreaded::AudioEncoderThreaded(AudioEncoder *enc)
+  : m_name(enc->name()), m_worker(0)
+{
+  m_worker = new Worker(this, enc);
+  AudioCodecWorkerPool::instance()->add(m_worker);
+} /* AudioEncoderThreaded::AudioEncoderThreaded */
+
+
+AudioEncoderThreaded::~AudioEncoderThreaded(void)
+{
+  m_worker->detach();
+} /* AudioEncoderThreaded::~AudioEncoderThreaded */
+
+
+void AudioEncoderThreaded::setOption(const std::string &name,
+                                     const std::string &value)
+{
+  m_worker->setOption(name, value);
+} /* AudioEncoderThreaded::setOption */
+
+
+void AudioEncoderThreaded::printCodecParams(void)
+{
+  m_worker->printCodecParams();
+} /* AudioEncoderThreaded::printCodecParams */
+
+
+int AudioEncoderThreaded::writeSamples(const float *samples, int count)
+{
+  if (count <= 0)
+  {
+    return 0;
+  }
+  return m_worker->writeSamples(samples, count);
+} /* AudioEncoderThreaded::writeSamples */
+
+
+void AudioEncoderThreaded::flushSamples(void)
+{
+  m_worker->flushSamples();
+} /* AudioEncoderThreaded::flushSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,196 @@
+/**
+@file	 AsyncAudioEncoderThreaded.h
+@brief   An audio encoder that run another encoder in a worker thread
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-29
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_ENCODER_THREADED_INCLUDED
+#define ASYNC_AUDIO_ENCODER_THREADED_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioEncoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	An audio encoder that run another encoder in a worker thread
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-29
+
+This class wrap an ordinary audio encoder and run it in one of the threads of
+the AudioCodecWorkerPool, so that the encoding does not delay the main loop.
+Samples written to this encoder are queued to the worker thread and the
+encoded samples are emitted through the writeEncodedSamples signal from the
+main thread, in the same order as the wrapped encoder produced them. A flush
+is emitted through the flushEncodedSamples signal once all samples written
+before it have been encoded.
+
+If the queue to the worker thread is full, writeSamples returns zero and the
+source is asked to resume when there is room again.
+
+Options set and parameter printouts requested before the first samples are
+written are handled directly by the wrapped encoder. After that they are
+queued so that they are applied in order with the samples.
+*/
+class AudioEncoderThreaded : public AudioEncoder
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param 	enc The encoder to run in a worker thread
+     *
+     * The wrapped encoder is owned by this object and must not be used
+     * directly after this call.
+     */
+    explicit AudioEncoderThreaded(AudioEncoder *enc);
+
+    /**
+     * @brief 	Destructor
+     *
+     * The wrapped encoder is deleted by the worker thread when it has
+     * finished any ongoing encoding.
+     */
+    virtual ~AudioEncoderThreaded(void);
+
+    /**
+     * @brief   Get the name of the codec
+     * @returns Return the name of the wrapped codec
+     */
+    virtual const char *name(void) const { return m_name.c_str(); }
+
+    /**
+     * @brief 	Set an option for the encoder
+     * @param 	name The name of the option
+     * @param 	value The value of the option
+     */
+    virtual void setOption(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Print codec parameter settings
+     */
+    virtual void printCodecParams(void);
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the sink to flush the previously written samples
+     */
+    virtual void flushSamples(void);
+
+  private:
+    class Worker;
+
+    std::string   m_name;
+    Worker*       m_worker;
+
+    AudioEncoderThreaded(const AudioEncoderThreaded&);
+    AudioEncoderThreaded& operator=(const AudioEncoderThreaded&);
+
+};  /* class AudioEncoderThreaded */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_ENCODER_THREADED_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
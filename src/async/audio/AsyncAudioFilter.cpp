@@ -108,6 +108,7 @@ namespace Async
  *
  ****************************************************************************/
 
+static bool buildCascade(FidFilter *ff, BiquadCascade<double> &cascade);
 
 
 /****************************************************************************
@@ -134,14 +135,14 @@ namespace Async
  ****************************************************************************/
 
 AudioFilter::AudioFilter(int sample_rate)
-  : sample_rate(sample_rate), fv(0), output_gain(1.0f)
+  : sample_rate(sample_rate), fv(0), output_gain(1.0f), use_cascade(false)
 {
 
 } /* AudioFilter::AudioFilter */
 
 
 AudioFilter::AudioFilter(const string &filter_spec, int sample_rate)
-  : sample_rate(sample_rate), fv(0), output_gain(1.0f)
+  : sample_rate(sample_rate), fv(0), output_gain(1.0f), use_cascade(false)
 {
   if (!parseFilterSpec(filter_spec))
   {
@@ -179,6 +180,7 @@ bool AudioFilter::parseFilterSpec(const std::string &filter_spec)
   }
   fv->run = fid_run_new(fv->ff, &fv->func);
   fv->buf = fid_run_newbuf(fv->run);
+  use_cascade = buildCascade(fv->ff, cascade);
   return true;
 } /* AudioFilter::parseFilterSpec */
 
@@ -192,6 +194,7 @@ void AudioFilter::setOutputGain(float gain_db)
 void AudioFilter::reset(void)
 {
   fid_run_zapbuf(fv->buf);
+  cascade.reset();
 } /* AudioFilter::reset */
 
 
@@ -206,7 +209,20 @@ void AudioFilter::reset(void)
 void AudioFilter::processSamples(float *dest, const float *src, int count)
 {
   //cout << "AudioFilter::processSamples: len=" << len << endl;
-  
+
+  if (use_cascade)
+  {
+    cascade.process(dest, src, count);
+    if (output_gain != 1.0f)
+    {
+      for (int i=0; i<count; ++i)
+      {
+        dest[i] *= output_gain;
+      }
+    }
+    return;
+  }
+
   for (int i=0; i<count; ++i)
   {
     dest[i] = output_gain * fv->func(fv->buf, src[i]);
@@ -235,10 +251,100 @@ void AudioFilter::deleteFilter(void)
     delete fv;
     fv = 0;
   }
+  use_cascade = false;
+  cascade.clear();
 } /* AudioFilter::deleteFilter */
 
 
 
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+/*
+ * Convert a parsed fidlib filter into a cascade of second order sections.
+ * The elements are paired up in the same way as fid_run_new do it: an IIR
+ * element is combined with a directly following FIR element and single
+ * coefficient FIR elements are merged into the overall gain. Returns false
+ * if some element is longer than three coefficients, like the long FIR
+ * filters used by the AFSK code. The fidlib interpreter is then used instead.
+ */
+static bool buildCascade(FidFilter *ff, BiquadCascade<double> &cascade)
+{
+  cascade.clear();
+  double gain = 1.0;
+  while (ff->len != 0)
+  {
+    if ((ff->typ == 'F') && (ff->len == 1))
+    {
+      gain *= ff->val[0];
+      ff = FFNEXT(ff);
+      continue;
+    }
+
+    const double *iir = 0;
+    const double *fir = 0;
+    int n_iir = 0;
+    int n_fir = 0;
+    if (ff->typ == 'I')
+    {
+      iir = ff->val;
+      n_iir = ff->len;
+      ff = FFNEXT(ff);
+      while ((ff->typ == 'F') && (ff->len == 1))
+      {
+        gain *= ff->val[0];
+        ff = FFNEXT(ff);
+      }
+    }
+    if (ff->typ == 'F')
+    {
+      fir = ff->val;
+      n_fir = ff->len;
+      ff = FFNEXT(ff);
+    }
+    if ((n_iir == 0) && (n_fir == 0))
+    {
+      return false;
+    }
+    if ((n_iir > 3) || (n_fir > 3))
+    {
+      return false;
+    }
+
+    double b[3] = { 1.0, 0.0, 0.0 };
+    double a[3] = { 1.0, 0.0, 0.0 };
+    if (n_fir > 0)
+    {
+      b[0] = 0.0;
+      std::copy(fir, fir + n_fir, b);
+    }
+    if (n_iir > 0)
+    {
+      double adj = 1.0 / iir[0];
+      gain *= adj;
+      for (int i=1; i<n_iir; ++i)
+      {
+        a[i] = iir[i] * adj;
+      }
+        // fid_run_new only normalize the first feedback coefficient when
+        // both halves of the section are of second order, or when there is
+        // no FIR half. Do the same to get the same frequency response.
+      if ((n_iir > 1) && !((n_iir == 3) && ((n_fir == 3) || (n_fir == 0))))
+      {
+        a[1] = iir[1];
+      }
+    }
+    cascade.addSection(b[0], b[1], b[2], a[1], a[2]);
+  }
+  cascade.setGain(gain);
+  return true;
+} /* buildCascade */
+
+
+
 /*
  * This file has not been truncated
  */
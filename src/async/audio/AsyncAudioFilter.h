@@ -53,6 +53,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncBiquadCascade.h>
 
 
 
@@ -193,6 +194,8 @@ class AudioFilter : public AudioProcessor
     FidVars   	*fv;
     float     	output_gain;
     std::string error_str;
+    BiquadCascade<double> cascade;
+    bool        use_cascade;
     
     AudioFilter(const AudioFilter&);
     AudioFilter& operator=(const AudioFilter&);
@@ -38,6 +38,7 @@ ANY KIND. See http://www.dspguru.com/wol.htm for more information.
  ****************************************************************************/
 
 #include <AsyncAudioProcessor.h>
+#include <AsyncPolyphaseFir.h>
 
 
 
@@ -148,10 +149,8 @@ class AudioInterpolator : public Async::AudioProcessor
 
     
   private:
-    const int 	factor_L;
-    float     	*p_Z;
-    int       	L_size;
-    const float *p_H;
+    const int           factor_L;
+    PolyphaseFir<float> fir;
 
     AudioInterpolator(const AudioInterpolator&);
     AudioInterpolator& operator=(const AudioInterpolator&);
@@ -0,0 +1,278 @@
+/**
+@file	 AsyncAudioSampleConv.cpp
+@brief   Conversion between interleaved 16 bit and per channel float samples
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-09
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "AsyncAudioSampleConv.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // Build an AVX2 and a baseline version of a function and select one of
+  // them when the program is loaded. This require GCC and the ifunc support
+  // in glibc. If the whole build already target AVX2 there is nothing to gain.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && \
+    defined(__GLIBC__) && !defined(__AVX2__)
+#define MULTI_TARGET __attribute__((target_clones("avx2", "default")))
+#else
+#define MULTI_TARGET
+#endif
+
+  // Make sure that the helper templates are inlined into the function
+  // versions above so that they are compiled for the same target
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+namespace {
+  const float S16_TO_FLOAT = 1.0f / 32768.0f;
+  const float FLOAT_TO_S16 = 32767.0f;
+
+  ALWAYS_INLINE int16_t toS16(float sample)
+  {
+    sample *= FLOAT_TO_S16;
+    sample = (sample > 32767.0f) ? 32767.0f : sample;
+    sample = (sample < -32767.0f) ? -32767.0f : sample;
+    return static_cast<int16_t>(static_cast<int32_t>(sample));
+  }
+
+  template <int N>
+  ALWAYS_INLINE void s16ToFloatN(float *const *dst, const int16_t *src,
+                                 size_t frames)
+  {
+    for (int ch=0; ch<N; ++ch)
+    {
+      float *out = dst[ch];
+      const int16_t *in = src + ch;
+      for (size_t i=0; i<frames; ++i)
+      {
+        out[i] = in[i * N] * S16_TO_FLOAT;
+      }
+    }
+  }
+
+  template <int N>
+  ALWAYS_INLINE void floatToS16N(int16_t *dst, const float *const *src,
+                                 size_t frames)
+  {
+      // Writing whole frames give contiguous stores, which vectorize better
+      // than one strided pass per channel
+    const float *in[N];
+    for (int ch=0; ch<N; ++ch)
+    {
+      in[ch] = src[ch];
+    }
+    for (size_t i=0; i<frames; ++i)
+    {
+      for (int ch=0; ch<N; ++ch)
+      {
+        dst[i * N + ch] = toS16(in[ch][i]);
+      }
+    }
+  }
+};
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+MULTI_TARGET
+void AudioSampleConv::s16ToFloat(float *const *dst, const int16_t *src,
+                                 int channels, size_t frames)
+{
+  switch (channels)
+  {
+    case 1:
+      s16ToFloatN<1>(dst, src, frames);
+      break;
+    case 2:
+      s16ToFloatN<2>(dst, src, frames);
+      break;
+    case 4:
+      s16ToFloatN<4>(dst, src, frames);
+      break;
+    case 8:
+      s16ToFloatN<8>(dst, src, frames);
+      break;
+    default:
+      for (int ch=0; ch<channels; ++ch)
+      {
+        float *out = dst[ch];
+        const int16_t *in = src + ch;
+        for (size_t i=0; i<frames; ++i)
+        {
+          out[i] = in[i * channels] * S16_TO_FLOAT;
+        }
+      }
+      break;
+  }
+} /* AudioSampleConv::s16ToFloat */
+
+
+MULTI_TARGET
+void AudioSampleConv::floatToS16(int16_t *dst, const float *const *src,
+                                 int channels, size_t frames)
+{
+  switch (channels)
+  {
+    case 1:
+      floatToS16N<1>(dst, src, frames);
+      break;
+    case 2:
+      floatToS16N<2>(dst, src, frames);
+      break;
+    case 4:
+      floatToS16N<4>(dst, src, frames);
+      break;
+    case 8:
+      floatToS16N<8>(dst, src, frames);
+      break;
+    default:
+      for (int ch=0; ch<channels; ++ch)
+      {
+        const float *in = src[ch];
+        int16_t *out = dst + ch;
+        for (size_t i=0; i<frames; ++i)
+        {
+          out[i * channels] = toS16(in[i]);
+        }
+      }
+      break;
+  }
+} /* AudioSampleConv::floatToS16 */
+
+
+MULTI_TARGET
+void AudioSampleConv::addSaturated(float *dst, const float *src, size_t count)
+{
+  for (size_t i=0; i<count; ++i)
+  {
+      // Mix the same way as when adding directly to a 16 bit sample. The
+      // sum is calculated in double precision, rounded to float, saturated
+      // and truncated. The 16 bit value is then stored as a float that
+      // convert back to exactly the same value in floatToS16.
+    float sample = static_cast<float>(
+        FLOAT_TO_S16 * static_cast<double>(src[i]) + toS16(dst[i]));
+    sample = (sample > 32767.0f) ? 32767.0f : sample;
+    sample = (sample < -32767.0f) ? -32767.0f : sample;
+    dst[i] = static_cast<int32_t>(sample) / FLOAT_TO_S16;
+  }
+} /* AudioSampleConv::addSaturated */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,177 @@
+/**
+@file	 AsyncAudioSampleConv.h
+@brief   Conversion between interleaved 16 bit and per channel float samples
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-09
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_AUDIO_SAMPLE_CONV_INCLUDED
+#define ASYNC_AUDIO_SAMPLE_CONV_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <cstddef>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Conversion between interleaved 16 bit and per channel float samples
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-09
+
+This class contain the sample format conversions used by the audio device
+classes. A sound card deliver and expect interleaved signed 16 bit samples
+while the rest of the audio pipe use one float buffer per channel.
+
+Each conversion is done in one pass over the interleaved buffer for all
+channels. The loops are written so that the compiler can vectorize them and
+there are special cases for one, two, four and eight channels where the
+distance between the samples of a channel is known at compile time. On x86_64,
+when compiling with GCC, an AVX2 version of each conversion is also built. The
+version to use is chosen at runtime depending on the CPU.
+*/
+class AudioSampleConv
+{
+  public:
+    /**
+     * @brief   Convert interleaved 16 bit samples to per channel floats
+     * @param   dst       One destination buffer per channel
+     * @param   src       The interleaved samples
+     * @param   channels  The number of channels
+     * @param   frames    The number of samples per channel to convert
+     *
+     * The float samples are in the range [-1.0, 1.0).
+     */
+    static void s16ToFloat(float *const *dst, const int16_t *src,
+                           int channels, size_t frames);
+
+    /**
+     * @brief   Convert per channel float samples to interleaved 16 bit
+     * @param   dst       The interleaved destination buffer
+     * @param   src       One source buffer per channel
+     * @param   channels  The number of channels
+     * @param   frames    The number of samples per channel to convert
+     *
+     * The float samples are scaled by 32767 and the result is truncated
+     * towards zero and saturated to the range [-32767, 32767].
+     */
+    static void floatToS16(int16_t *dst, const float *const *src,
+                           int channels, size_t frames);
+
+    /**
+     * @brief   Add samples to a buffer and saturate the sum
+     * @param   dst   The buffer to add the samples to
+     * @param   src   The samples to add
+     * @param   count The number of samples
+     *
+     * The sum is calculated in the same way as when adding the samples
+     * directly to a 16 bit sample buffer, saturated and truncated to 16 bit
+     * after each addition. When mixing several sources into dst, the result
+     * of floatToS16 is then exactly the same as for such a buffer.
+     */
+    static void addSaturated(float *dst, const float *src, size_t count);
+
+  private:
+    AudioSampleConv(void);
+
+};  /* class AudioSampleConv */
+
+
+} /* namespace */
+
+#endif /* ASYNC_AUDIO_SAMPLE_CONV_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
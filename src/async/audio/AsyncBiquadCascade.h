@@ -0,0 +1,332 @@
+/**
+@file	 AsyncBiquadCascade.h
+@brief   A cascade of second order IIR filter sections
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-06-27
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_BIQUAD_CASCADE_INCLUDED
+#define ASYNC_BIQUAD_CASCADE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A cascade of second order IIR filter sections
+@author Tobias Blomberg / SM0SVX
+@date   2020-06-27
+
+This class implement a filter made up of a number of second order sections
+(biquads) connected in series. Each section is calculated in transposed direct
+form II, which only need two state variables per section. The filter
+calculations are done using the type given as template argument, double or
+float, while the samples are read and written using any type that can be
+converted to and from it.
+
+The filter can be setup to process a number of channels at the same time. The
+samples for the channels are then interleaved in the buffers given to the
+process function. All channels use the same filter coefficients. Groups of
+four channels are filtered at the same time using the GCC vector extensions,
+so the compiler will use SSE, AVX or NEON instructions depending on the
+target.
+
+All sections are applied to one sample before moving on to the next sample.
+The sections for consecutive samples then do not depend on each other so the
+CPU can overlap their calculations. The filter state is stored in a single
+contiguous array.
+*/
+template <typename T=double>
+class BiquadCascade
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     * @param   channels The number of interleaved channels to filter
+     */
+    explicit BiquadCascade(unsigned channels=1)
+      : m_channels(channels), m_gain(1)
+    {
+    }
+
+    /**
+     * @brief   Remove all filter sections
+     *
+     * After calling this function the filter will just multiply the
+     * incoming samples with the gain, which is reset to one.
+     */
+    void clear(void)
+    {
+      m_sections.clear();
+      m_state.clear();
+      m_gain = 1;
+    }
+
+    /**
+     * @brief   Add a filter section
+     * @param   b0 Feed forward coefficient for the current sample
+     * @param   b1 Feed forward coefficient for the previous sample
+     * @param   b2 Feed forward coefficient for the sample before that
+     * @param   a1 Feedback coefficient for the previous output sample
+     * @param   a2 Feedback coefficient for the output sample before that
+     *
+     * The section transfer function is
+     * H(z) = (b0 + b1*z^-1 + b2*z^-2) / (1 + a1*z^-1 + a2*z^-2).
+     * The new section is added last in the cascade. A first order section is
+     * created by setting b2 and a2 to zero.
+     */
+    void addSection(double b0, double b1, double b2, double a1, double a2)
+    {
+      Section s = { T(b0), T(b1), T(b2), T(a1), T(a2) };
+      m_sections.push_back(s);
+      m_state.resize(2 * m_sections.size() * stateChannels(), T(0));
+    }
+
+    /**
+     * @brief   Set the gain applied to the filter output
+     * @param   gain The linear gain factor
+     */
+    void setGain(double gain) { m_gain = T(gain); }
+
+    /**
+     * @brief   Set the number of interleaved channels to filter
+     * @param   channels The number of channels
+     *
+     * The filter state is cleared.
+     */
+    void setChannels(unsigned channels)
+    {
+      m_channels = channels;
+      m_state.assign(2 * m_sections.size() * stateChannels(), T(0));
+    }
+
+    /**
+     * @brief   Get the number of interleaved channels
+     * @return  Returns the number of channels
+     */
+    unsigned channels(void) const { return m_channels; }
+
+    /**
+     * @brief   Get the number of filter sections
+     * @return  Returns the number of sections in the cascade
+     */
+    size_t sections(void) const { return m_sections.size(); }
+
+    /**
+     * @brief   Clear the filter state
+     */
+    void reset(void)
+    {
+      std::fill(m_state.begin(), m_state.end(), T(0));
+    }
+
+    /**
+     * @brief   Filter a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples per channel in the source buffer
+     *
+     * The buffers hold count * channels interleaved samples. The source and
+     * destination may be the same buffer.
+     */
+    template <typename S>
+    void process(S *dest, const S *src, size_t count)
+    {
+      if (m_channels == 1)
+      {
+        processMono(dest, src, count);
+        return;
+      }
+
+      for (unsigned ch=0; ch<m_channels; ch+=LANES)
+      {
+        processGroup(dest + ch, src + ch, count, ch);
+      }
+    }
+
+  private:
+    static const unsigned LANES = 4;
+    typedef T Vec __attribute__((vector_size(LANES * sizeof(T))));
+
+    struct Section
+    {
+      T b0, b1, b2, a1, a2;
+    };
+
+    std::vector<Section>  m_sections;
+    std::vector<T>        m_state;
+    unsigned              m_channels;
+    T                     m_gain;
+
+    template <typename S>
+    void processMono(S *dest, const S *src, size_t count)
+    {
+      const size_t num_sections = m_sections.size();
+      const Section *sections = num_sections ? &m_sections[0] : 0;
+      T *state = num_sections ? &m_state[0] : 0;
+      for (size_t i=0; i<count; ++i)
+      {
+        T x = T(src[i]);
+        T *z = state;
+        for (size_t sec=0; sec<num_sections; ++sec)
+        {
+          const Section& s = sections[sec];
+          T y = s.b0 * x + z[0];
+          z[0] = s.b1 * x - s.a1 * y + z[1];
+          z[1] = s.b2 * x - s.a2 * y;
+          x = y;
+          z += 2;
+        }
+        dest[i] = S(m_gain * x);
+      }
+    }
+
+      // The state is stored in groups of LANES channels when filtering
+      // more than one channel
+    size_t stateChannels(void) const
+    {
+      return (m_channels == 1) ? 1 : (m_channels + LANES - 1) / LANES * LANES;
+    }
+
+      // Filter LANES channels, starting with channel first, at the same time
+      // using vector operations. The last group may be partially filled.
+    template <typename S>
+    void processGroup(S *dest, const S *src, size_t count, unsigned first)
+    {
+      const unsigned lanes = std::min(LANES, m_channels - first);
+      const size_t num_sections = m_sections.size();
+      T *state = num_sections ? &m_state[2 * num_sections * first] : 0;
+      for (size_t i=0; i<count; ++i)
+      {
+        Vec x = Vec();
+        for (unsigned ch=0; ch<lanes; ++ch)
+        {
+          x[ch] = T(src[ch]);
+        }
+        T *z = state;
+        for (size_t sec=0; sec<num_sections; ++sec)
+        {
+          const Section& s = m_sections[sec];
+          Vec z1, z2;
+          std::memcpy(&z1, z, sizeof(Vec));
+          std::memcpy(&z2, z + LANES, sizeof(Vec));
+          Vec y = s.b0 * x + z1;
+          z1 = s.b1 * x - s.a1 * y + z2;
+          z2 = s.b2 * x - s.a2 * y;
+          std::memcpy(z, &z1, sizeof(Vec));
+          std::memcpy(z + LANES, &z2, sizeof(Vec));
+          x = y;
+          z += 2 * LANES;
+        }
+        for (unsigned ch=0; ch<lanes; ++ch)
+        {
+          dest[ch] = S(m_gain * x[ch]);
+        }
+        src += m_channels;
+        dest += m_channels;
+      }
+    }
+
+};  /* class BiquadCascade */
+
+
+} /* namespace */
+
+#endif /* ASYNC_BIQUAD_CASCADE_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,408 @@
+/**
+@file	 AsyncPolyphaseFir.h
+@brief   A polyphase FIR filter engine for decimation and interpolation
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-06-20
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_POLYPHASE_FIR_INCLUDED
+#define ASYNC_POLYPHASE_FIR_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A polyphase FIR filter engine for decimation and interpolation
+@author Tobias Blomberg / SM0SVX
+@date   2020-06-20
+
+This class implement the FIR filtering used when decimating or interpolating
+a sample stream by an integer factor. The sample type may be float or
+std::complex<float>. The filter coefficients are given in the same way as
+for the AudioDecimator and AudioInterpolator classes.
+
+The incoming samples are split into one stream per decimation phase and each
+stream is stored in a circular buffer of double length where every sample is
+written twice. The filter history is then always available in contiguous
+memory so no samples have to be moved when new samples arrive.
+
+Several consecutive output samples are calculated at the same time, one per
+SIMD vector lane. Each lane sum up the filter taps in the same order as a
+plain FIR loop would, so the output is bit identical to a straightforward
+scalar implementation. This hold as long as the compiler is not allowed to
+fuse multiplications and additions since it may do that differently for
+scalar and vector code. GCC do that by default on targets with FMA
+instructions, e.g. aarch64, so source files using this class should be
+compiled with -ffp-contract=off. The vector operations use the GCC vector
+extensions so the compiler will choose SSE, AVX or NEON instructions
+depending on the target.
+*/
+template <typename T>
+class PolyphaseFir
+{
+  public:
+    /**
+     * @brief 	Default constructor
+     */
+    PolyphaseFir(void)
+      : m_phases(1), m_filters(0), m_taps(0), m_cap(0), m_region(0),
+        m_wpos(0), m_phase(0), m_pending(0), m_out_scale(1.0f)
+    {
+    }
+
+    /**
+     * @brief   Setup the filter for decimation
+     * @param   dec_fact  The decimation factor
+     * @param   coeff     The filter coefficients
+     * @param   taps      The number of filter coefficients
+     *
+     * For each dec_fact incoming samples one output sample is produced.
+     * The filter history is cleared.
+     */
+    void setDecimator(int dec_fact, const float *coeff, int taps)
+    {
+      assert((dec_fact > 0) && (taps > 0));
+      m_set_coeff.assign(coeff, coeff + taps);
+      m_phases = dec_fact;
+      m_filters = 1;
+      m_taps = taps;
+      m_out_scale = 1.0f;
+      int max_back = 0;
+      for (int tap=0; tap<m_taps; ++tap)
+      {
+        max_back = std::max(max_back, -decBlock(tap));
+      }
+      setupBuffer(max_back);
+      m_offset.resize(m_taps);
+      for (int tap=0; tap<m_taps; ++tap)
+      {
+          // Tap number tap use input sample (k + blk) * dec_fact + phase
+          // when calculating output sample k
+        int blk = decBlock(tap);
+        int phase = m_phases - 1 - tap - blk * m_phases;
+        m_offset[tap] = phase * m_region + blk * static_cast<int>(C);
+      }
+      setGain(1.0);
+    }
+
+    /**
+     * @brief   Setup the filter for interpolation
+     * @param   interp_fact The interpolation factor
+     * @param   coeff       The filter coefficients
+     * @param   taps        The number of filter coefficients
+     *
+     * For each incoming sample, interp_fact output samples are produced.
+     * The number of taps should be a multiple of the interpolation factor.
+     * The filter history is cleared.
+     */
+    void setInterpolator(int interp_fact, const float *coeff, int taps)
+    {
+      assert((interp_fact > 0) && (taps >= interp_fact));
+      m_set_coeff.assign(coeff, coeff + taps);
+      m_phases = 1;
+      m_filters = interp_fact;
+      m_taps = taps / interp_fact;
+      m_out_scale = interp_fact;
+      m_offset.resize(m_taps);
+      for (int tap=0; tap<m_taps; ++tap)
+      {
+        m_offset[tap] = -tap * static_cast<int>(C);
+      }
+      setupBuffer(m_taps - 1);
+      setGain(1.0);
+    }
+
+    /**
+     * @brief   Set the gain of the filter
+     * @param   gain The linear gain factor
+     *
+     * The filter coefficients given in the setup functions are multiplied
+     * by the given factor. The filter history is not affected.
+     */
+    void setGain(double gain)
+    {
+      m_coeff.resize(m_filters * m_taps);
+      for (int filter=0; filter<m_filters; ++filter)
+      {
+        for (int tap=0; tap<m_taps; ++tap)
+        {
+          float c = m_set_coeff[filter + tap * m_filters];
+          c *= gain;
+          m_coeff[filter * m_taps + tap] = c;
+        }
+      }
+    }
+
+    /**
+     * @brief   Clear the filter history
+     */
+    void reset(void)
+    {
+      std::fill(m_buf.begin(), m_buf.end(), 0.0f);
+      m_wpos = 0;
+      m_phase = 0;
+      m_pending = 0;
+    }
+
+    /**
+     * @brief   Filter a block of samples
+     * @param   dest  The destination buffer
+     * @param   src   The source buffer
+     * @param   count The number of samples in the source buffer
+     * @return  Returns the number of samples written to the destination
+     *
+     * The destination buffer must be large enough to hold all output
+     * samples, that is count / dec_fact samples when decimating and
+     * count * interp_fact samples when interpolating. Incoming samples
+     * that do not make up a full decimation block are saved until the next
+     * call.
+     */
+    size_t process(T *dest, const T *src, size_t count)
+    {
+      assert(m_filters > 0);
+      const float *in = reinterpret_cast<const float*>(src);
+      float *out = reinterpret_cast<float*>(dest);
+      float *out_start = out;
+      for (size_t i=0; i<count; ++i)
+      {
+        float *slot = &m_buf[m_phase * m_region + m_wpos * C];
+        for (size_t c=0; c<C; ++c)
+        {
+          slot[c] = in[c];
+          slot[m_cap * C + c] = in[c];
+        }
+        in += C;
+        if (++m_phase < m_phases)
+        {
+          continue;
+        }
+        m_phase = 0;
+        if (++m_wpos == m_cap)
+        {
+          m_wpos = 0;
+        }
+        if (++m_pending == LANES)
+        {
+          calcLanes(out);
+          out += LANES * m_filters * C;
+          m_pending = 0;
+        }
+      }
+      while (m_pending > 0)
+      {
+        calcSingle(out, --m_pending);
+        out += m_filters * C;
+      }
+      return (out - out_start) / C;
+    }
+
+  private:
+#ifdef __AVX__
+    typedef float Vec __attribute__((vector_size(32)));
+#else
+    typedef float Vec __attribute__((vector_size(16)));
+#endif
+
+      // Number of floats per sample, number of vectors used to calculate
+      // a group of output samples and the number of output samples per group.
+      // Using more than one vector hides the latency of the additions.
+    static const size_t C = sizeof(T) / sizeof(float);
+    static const size_t NVEC = 64 / sizeof(Vec);
+    static const size_t LANES = NVEC * sizeof(Vec) / sizeof(T);
+
+    std::vector<float>  m_set_coeff;
+    std::vector<float>  m_coeff;
+    std::vector<int>    m_offset;
+    std::vector<float>  m_buf;
+    int                 m_phases;
+    int                 m_filters;
+    int                 m_taps;
+    size_t              m_cap;
+    size_t              m_region;
+    size_t              m_wpos;
+    int                 m_phase;
+    size_t              m_pending;
+    float               m_out_scale;
+
+      // Return floor((dec_fact - 1 - tap) / dec_fact)
+    int decBlock(int tap) const
+    {
+      int s = m_phases - 1 - tap;
+      return (s >= 0) ? (s / m_phases) : -((m_phases - 1 - s) / m_phases);
+    }
+
+    void setupBuffer(int max_back)
+    {
+        // Each phase stream must hold the history needed by the oldest tap
+        // plus one sample for each lane
+      m_cap = max_back + LANES;
+      m_region = 2 * m_cap * C;
+      m_buf.assign(m_phases * m_region, 0.0f);
+      m_wpos = 0;
+      m_phase = 0;
+      m_pending = 0;
+    }
+
+      // Calculate LANES output samples ending with the newest sample
+    void calcLanes(float *out)
+    {
+      const float *base = &m_buf[(m_wpos + m_cap - LANES) * C];
+      const size_t vec_len = sizeof(Vec) / sizeof(float);
+      for (int filter=0; filter<m_filters; ++filter)
+      {
+        const float *coeff = &m_coeff[filter * m_taps];
+        Vec sum[NVEC];
+        for (size_t v=0; v<NVEC; ++v)
+        {
+          sum[v] = Vec();
+        }
+        for (int tap=0; tap<m_taps; ++tap)
+        {
+          const float c = coeff[tap];
+          const float *z = base + m_offset[tap];
+          for (size_t v=0; v<NVEC; ++v)
+          {
+            Vec zv;
+            std::memcpy(&zv, z + v * vec_len, sizeof(zv));
+            sum[v] += c * zv;
+          }
+        }
+        for (size_t v=0; v<NVEC; ++v)
+        {
+          sum[v] *= m_out_scale;
+        }
+        const float *res = reinterpret_cast<const float*>(sum);
+        for (size_t lane=0; lane<LANES; ++lane)
+        {
+          for (size_t c=0; c<C; ++c)
+          {
+            out[(lane * m_filters + filter) * C + c] = res[lane * C + c];
+          }
+        }
+      }
+    }
+
+      // Calculate the output sample for a block that is age blocks old
+    void calcSingle(float *out, size_t age)
+    {
+      const float *base = &m_buf[(m_wpos + m_cap - 1 - age) * C];
+      for (int filter=0; filter<m_filters; ++filter)
+      {
+        const float *coeff = &m_coeff[filter * m_taps];
+        for (size_t c=0; c<C; ++c)
+        {
+          float sum = 0.0f;
+          for (int tap=0; tap<m_taps; ++tap)
+          {
+            sum += coeff[tap] * base[m_offset[tap] + c];
+          }
+          *out++ = sum * m_out_scale;
+        }
+      }
+    }
+
+};  /* class PolyphaseFir */
+
+
+} /* namespace */
+
+#endif /* ASYNC_POLYPHASE_FIR_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
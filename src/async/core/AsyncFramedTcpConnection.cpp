@@ -32,6 +32,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <sys/uio.h>
+
 #include <cstring>
 #include <cerrno>
 
@@ -112,12 +114,28 @@ using namespace Async;
  *
  ****************************************************************************/
 
+FramedTcpConnection::FramePtr FramedTcpConnection::createFrame(
+    const void *buf, int count)
+{
+  std::shared_ptr<std::vector<uint8_t> > frame =
+    std::make_shared<std::vector<uint8_t> >(4 + count);
+  uint8_t *ptr = &(*frame)[0];
+  *ptr++ = static_cast<uint32_t>(count) >> 24;
+  *ptr++ = (static_cast<uint32_t>(count) >> 16) & 0xff;
+  *ptr++ = (static_cast<uint32_t>(count) >> 8) & 0xff;
+  *ptr++ = (static_cast<uint32_t>(count)) & 0xff;
+  if (count > 0)
+  {
+    std::memcpy(ptr, buf, count);
+  }
+  return frame;
+} /* FramedTcpConnection::createFrame */
+
+
 FramedTcpConnection::FramedTcpConnection(size_t recv_buf_len)
   : TcpConnection(recv_buf_len), m_max_frame_size(DEFAULT_MAX_FRAME_SIZE),
     m_size_received(false)
 {
-  TcpConnection::sendBufferFull.connect(
-      sigc::mem_fun(*this, &FramedTcpConnection::onSendBufferFull));
 } /* FramedTcpConnection::FramedTcpConnection */
 
 
@@ -156,35 +174,36 @@ int FramedTcpConnection::write(const void *buf, int count)
     return -1;
   }
 
-  QueueItem *qi = new QueueItem(buf, count);
-  if (m_txq.empty())
+  uint8_t size_buf[4];
+  size_buf[0] = static_cast<uint32_t>(count) >> 24;
+  size_buf[1] = (static_cast<uint32_t>(count) >> 16) & 0xff;
+  size_buf[2] = (static_cast<uint32_t>(count) >> 8) & 0xff;
+  size_buf[3] = (static_cast<uint32_t>(count)) & 0xff;
+  struct iovec iov[2];
+  iov[0].iov_base = size_buf;
+  iov[0].iov_len = sizeof(size_buf);
+  iov[1].iov_base = const_cast<void *>(buf);
+  iov[1].iov_len = count;
+  if (TcpConnection::writev(iov, 2) < 0)
   {
-    int ret = TcpConnection::write(qi->m_buf, qi->m_size);
-    //cout << "###   count=" << (qi->m_size-qi->m_pos) << " ret=" << ret << endl;
-    if (ret < 0)
-    {
-      delete qi;
-      qi = 0;
-      return -1;
-    }
-    if (ret >= qi->m_size)
-    {
-      delete qi;
-      qi = 0;
-    }
-    else
-    {
-      //cout << "### Not all bytes were sent: count=" << count
-      //     << " ret=" << ret << endl;
-      qi->m_pos += ret;
-    }
+    return -1;
   }
+  return count;
+} /* FramedTcpConnection::write */
+
 
-  if (qi != 0)
+int FramedTcpConnection::write(const FramePtr& frame)
+{
+  int count = frame->size() - 4;
+  if (static_cast<uint32_t>(count) > m_max_frame_size)
+  {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  if (TcpConnection::write(frame) < 0)
   {
-    m_txq.push_back(qi);
+    return -1;
   }
-
   return count;
 } /* FramedTcpConnection::write */
 
@@ -258,41 +277,10 @@ int FramedTcpConnection::onDataReceived(void *buf, int count)
  *
  ****************************************************************************/
 
-void FramedTcpConnection::onSendBufferFull(bool is_full)
-{
-  //cout << "### FramedTcpConnection::onSendBufferFull: is_full="
-  //     << is_full << "\n";
-  if (!is_full)
-  {
-    while (!m_txq.empty())
-    {
-      QueueItem *qi = m_txq.front();
-      int ret = TcpConnection::write(qi->m_buf+qi->m_pos, qi->m_size-qi->m_pos);
-      //cout << "###   count=" << (qi->m_size-qi->m_pos) << " ret=" << ret << endl;
-      if (ret <= 0)
-      {
-        return;
-      }
-      qi->m_pos += ret;
-      if (qi->m_pos < qi->m_size)
-      {
-        break;
-      }
-      m_txq.pop_front();
-      delete qi;
-      qi = 0;
-    }
-  }
-} /* FramedTcpConnection::onSendBufferFull */
-
-
 void FramedTcpConnection::disconnectCleanup(void)
 {
-  for (TxQueue::iterator it = m_txq.begin(); it != m_txq.end(); ++it)
-  {
-    delete *it;
-  }
-  m_txq.clear();
+  m_size_received = false;
+  m_frame.clear();
 } /* FramedTcpConnection::disconnectCleanup */
 
 
@@ -45,8 +45,7 @@ An example of how to use the FramedTcpConnection class in a server
 
 #include <stdint.h>
 #include <vector>
-#include <deque>
-#include <cstring>
+#include <memory>
 
 
 /****************************************************************************
@@ -131,6 +130,24 @@ that only want to see completely transfered messages at the other end.
 class FramedTcpConnection : public TcpConnection
 {
   public:
+    /**
+     * @brief   A reference counted frame, including the frame header
+     *
+     * A frame is created once, using the createFrame function, and can then
+     * be written to any number of connections. The connections keep a
+     * reference to the frame until it has been sent so the frame data is
+     * never copied.
+     */
+    typedef SharedBuffer FramePtr;
+
+    /**
+     * @brief   Create a frame that can be written to many connections
+     * @param   buf The buffer containing the frame data
+     * @param   count The number of bytes in the frame
+     * @return  Returns the new frame
+     */
+    static FramePtr createFrame(const void *buf, int count);
+
     /**
      * @brief 	Constructor
      * @param 	recv_buf_len  The length of the receiver buffer to use
@@ -185,6 +202,17 @@ class FramedTcpConnection : public TcpConnection
      */
     virtual int write(const void *buf, int count);
 
+    /**
+     * @brief 	Send a previously created frame on the TCP connection
+     * @param 	frame The frame to send (@see createFrame)
+     * @return	Return the frame data size or -1 on failure
+     *
+     * This function works like the write function above but if the frame
+     * cannot be sent directly, it is queued by reference instead of being
+     * copied.
+     */
+    int write(const FramePtr& frame);
+
     /**
      * @brief 	A signal that is emitted when a connection has been terminated
      * @param 	con   	The connection object
@@ -205,7 +233,6 @@ class FramedTcpConnection : public TcpConnection
 
   protected:
     sigc::signal<int, FramedTcpConnection *, void *, int> dataReceived;
-    sigc::signal<void, bool> sendBufferFull;
 
     /**
      * @brief 	Called when a connection has been terminated
@@ -235,36 +262,13 @@ class FramedTcpConnection : public TcpConnection
   private:
     static const uint32_t DEFAULT_MAX_FRAME_SIZE = 1024 * 1024; // 1MB
 
-    struct QueueItem
-    {
-      char* m_buf;
-      int   m_size;
-      int   m_pos;
-
-      QueueItem(const void* buf, int count)
-        : m_buf(0), m_size(4+count), m_pos(0)
-      {
-        m_buf = new char[4+count];
-        char *ptr = m_buf;
-        *ptr++ = static_cast<uint32_t>(count) >> 24;
-        *ptr++ = (static_cast<uint32_t>(count) >> 16) & 0xff;
-        *ptr++ = (static_cast<uint32_t>(count) >> 8) & 0xff;
-        *ptr++ = (static_cast<uint32_t>(count)) & 0xff;
-        std::memcpy(ptr, buf, count);
-      }
-      ~QueueItem(void) { delete [] m_buf; }
-    };
-    typedef std::deque<QueueItem*> TxQueue;
-
     uint32_t              m_max_frame_size;
     bool                  m_size_received;
     uint32_t              m_frame_size;
     std::vector<uint8_t>  m_frame;
-    TxQueue               m_txq;
 
     FramedTcpConnection(const FramedTcpConnection&);
     FramedTcpConnection& operator=(const FramedTcpConnection&);
-    void onSendBufferFull(bool is_full);
     void disconnectCleanup(void);
 
 };  /* class FramedTcpConnection */
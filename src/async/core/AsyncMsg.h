@@ -86,6 +86,27 @@ MsgDerived d2;
 d2.unpack(ss);
 \endcode
 
+Packing to and from iostreams is convenient but slow since every field is
+written using a stream operation. For performance critical code the message
+can instead be packed to a contiguous memory buffer using the MsgWriter class
+and unpacked using the MsgReader class. The packed data is exactly the same
+as when using a stream.
+
+\code{.cpp}
+std::vector<uint8_t> buf;
+Async::MsgWriter w(buf);
+d1.pack(w);
+
+MsgDerived d3;
+Async::MsgReader r(&buf[0], buf.size());
+d3.unpack(r);
+\endcode
+
+If a MsgPacker is implemented for a new type, as in the std::pair example
+above, pack and unpack functions taking a MsgWriter and a MsgReader
+respectively should also be implemented if the type is to be used with the
+buffer based functions.
+
 For a working example, have a look at the demo application,
 \ref AsyncMsg_demo.cpp.
 
@@ -130,6 +151,8 @@ An example of how to use the AsyncMsg class
 #include <set>
 #include <map>
 #include <limits>
+#include <algorithm>
+#include <cstring>
 #include <endian.h>
 #include <stdint.h>
 
@@ -201,6 +224,14 @@ namespace Async
     bool unpackParent(std::istream& is) \
     { \
       return BASE_CLASS::unpack(is); \
+    } \
+    bool packParent(Async::MsgWriter& w) const \
+    { \
+      return BASE_CLASS::pack(w); \
+    } \
+    bool unpackParent(Async::MsgReader& r) \
+    { \
+      return BASE_CLASS::unpack(r); \
     }
 
 /**
@@ -222,6 +253,14 @@ namespace Async
     bool unpack(std::istream& is) \
     { \
       return unpackParent(is) && Msg::unpack(is, __VA_ARGS__); \
+    } \
+    bool pack(Async::MsgWriter& w) const \
+    { \
+      return packParent(w) && Msg::pack(w, __VA_ARGS__); \
+    } \
+    bool unpack(Async::MsgReader& r) \
+    { \
+      return unpackParent(r) && Msg::unpack(r, __VA_ARGS__); \
     }
 
 /**
@@ -238,6 +277,14 @@ namespace Async
     bool unpack(std::istream& is) \
     { \
       return unpackParent(is); \
+    } \
+    bool pack(Async::MsgWriter& w) const \
+    { \
+      return packParent(w); \
+    } \
+    bool unpack(Async::MsgReader& r) \
+    { \
+      return unpackParent(r); \
     }
 
 
@@ -255,6 +302,211 @@ namespace Async
  *
  ****************************************************************************/
 
+/**
+@brief  Write packed messages to a contiguous memory buffer
+@author Tobias Blomberg / SM0SVX
+@date   2020-06-14
+
+This class is used as the destination when packing a message without using
+an iostream. The packed data is either written to a caller provided buffer of
+fixed size or appended to a std::vector that grow as needed. The vector can
+be reused between messages to avoid memory allocations. Packing to a
+MsgWriter produce exactly the same bytes as packing to a std::ostream.
+
+\code{.cpp}
+std::vector<uint8_t> buf;
+Async::MsgWriter w(buf);
+if (msg.pack(w))
+{
+  sock.write(&buf[0], buf.size());
+}
+\endcode
+*/
+class MsgWriter
+{
+  public:
+    /**
+     * @brief   Constructor for writing to a fixed size buffer
+     * @param   buf   The buffer to write to
+     * @param   size  The size of the buffer
+     */
+    MsgWriter(void *buf, size_t size)
+      : m_arena(0), m_buf(reinterpret_cast<uint8_t*>(buf)), m_size(size),
+        m_pos(0), m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Constructor for writing to a growable buffer
+     * @param   arena The vector to append the packed data to
+     */
+    explicit MsgWriter(std::vector<uint8_t>& arena)
+      : m_arena(&arena), m_buf(0), m_size(0), m_pos(0), m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Write raw bytes to the buffer
+     * @param   data  The data to write
+     * @param   len   The number of bytes to write
+     * @return  Returns \em true on success or \em false if the data do not
+     *          fit in the buffer
+     *
+     * When a write fail, the writer is put into an error state and all
+     * following writes will also fail.
+     */
+    bool write(const void *data, size_t len)
+    {
+      if (!m_good)
+      {
+        return false;
+      }
+      const uint8_t *bdata = reinterpret_cast<const uint8_t*>(data);
+      if (m_arena != 0)
+      {
+        m_arena->insert(m_arena->end(), bdata, bdata + len);
+        return true;
+      }
+      if (len > m_size - m_pos)
+      {
+        m_good = false;
+        return false;
+      }
+      std::memcpy(m_buf + m_pos, bdata, len);
+      m_pos += len;
+      return true;
+    }
+
+    /**
+     * @brief   Get the packed data
+     * @return  Returns a pointer to the start of the buffer
+     */
+    const uint8_t *data(void) const
+    {
+      if (m_arena != 0)
+      {
+        return m_arena->empty() ? 0 : &(*m_arena)[0];
+      }
+      return m_buf;
+    }
+
+    /**
+     * @brief   Get the number of bytes in the buffer
+     * @return  Returns the number of bytes written to the buffer
+     */
+    size_t size(void) const
+    {
+      return (m_arena != 0) ? m_arena->size() : m_pos;
+    }
+
+    /**
+     * @brief   Check if all writes so far have been successful
+     * @return  Returns \em true if no write has failed
+     */
+    bool good(void) const { return m_good; }
+
+  private:
+    std::vector<uint8_t>* m_arena;
+    uint8_t*              m_buf;
+    size_t                m_size;
+    size_t                m_pos;
+    bool                  m_good;
+
+};  /* class MsgWriter */
+
+
+/**
+@brief  Read packed messages from a contiguous memory buffer
+@author Tobias Blomberg / SM0SVX
+@date   2020-06-14
+
+This class is used as the source when unpacking a message without using an
+iostream. The buffer is not copied so it must be valid as long as the
+reader is used.
+
+\code{.cpp}
+Async::MsgReader r(buf, len);
+MsgDerived d;
+if (d.unpack(r))
+{
+  // Use d
+}
+\endcode
+*/
+class MsgReader
+{
+  public:
+    /**
+     * @brief   Constructor
+     * @param   buf   The buffer to read from
+     * @param   len   The number of bytes in the buffer
+     */
+    MsgReader(const void *buf, size_t len)
+      : m_buf(reinterpret_cast<const uint8_t*>(buf)), m_len(len), m_pos(0),
+        m_good(true)
+    {
+    }
+
+    /**
+     * @brief   Read raw bytes from the buffer
+     * @param   data  The destination buffer
+     * @param   len   The number of bytes to read
+     * @return  Returns \em true on success or \em false if there is not
+     *          enough data left in the buffer
+     */
+    bool read(void *data, size_t len)
+    {
+      const uint8_t *src = consume(len);
+      if (src == 0)
+      {
+        return false;
+      }
+      std::memcpy(data, src, len);
+      return true;
+    }
+
+    /**
+     * @brief   Step past bytes in the buffer without copying them
+     * @param   len   The number of bytes to consume
+     * @return  Returns a pointer to the consumed bytes or 0 if there is not
+     *          enough data left in the buffer
+     *
+     * When a read fail, the reader is put into an error state and all
+     * following reads will also fail.
+     */
+    const uint8_t *consume(size_t len)
+    {
+      if (!m_good || (len > m_len - m_pos))
+      {
+        m_good = false;
+        return 0;
+      }
+      const uint8_t *ptr = m_buf + m_pos;
+      m_pos += len;
+      return ptr;
+    }
+
+    /**
+     * @brief   Get the number of unread bytes
+     * @return  Returns the number of bytes left in the buffer
+     */
+    size_t remaining(void) const { return m_len - m_pos; }
+
+    /**
+     * @brief   Check if all reads so far have been successful
+     * @return  Returns \em true if no read has failed
+     */
+    bool good(void) const { return m_good; }
+
+  private:
+    const uint8_t*  m_buf;
+    size_t          m_len;
+    size_t          m_pos;
+    bool            m_good;
+
+};  /* class MsgReader */
+
+
 template <typename T>
 class MsgPacker
 {
@@ -262,6 +514,8 @@ class MsgPacker
     static bool pack(std::ostream& os, const T& val) { return val.pack(os); }
     static size_t packedSize(const T& val) { return val.packedSize(); }
     static bool unpack(std::istream& is, T& val) { return val.unpack(is); }
+    static bool pack(MsgWriter& w, const T& val) { return val.pack(w); }
+    static bool unpack(MsgReader& r, T& val) { return val.unpack(r); }
 };
 
 template <>
@@ -280,6 +534,8 @@ class MsgPacker<char>
       //std::cout << "unpack<char>(" << int(val) << ")" << std::endl;
       return is.good();
     }
+    static bool pack(MsgWriter& w, char val) { return w.write(&val, 1); }
+    static bool unpack(MsgReader& r, char& val) { return r.read(&val, 1); }
 };
 
 template <typename T>
@@ -304,6 +560,24 @@ class Packer64
       //std::cout << "unpack<64>(" << val << ")" << std::endl;
       return is.good();
     }
+    static bool pack(MsgWriter& w, const T& val)
+    {
+      Overlay o;
+      o.val = val;
+      o.uval = htobe64(o.uval);
+      return w.write(o.buf, sizeof(T));
+    }
+    static bool unpack(MsgReader& r, T& val)
+    {
+      Overlay o;
+      if (!r.read(o.buf, sizeof(T)))
+      {
+        return false;
+      }
+      o.uval = be64toh(o.uval);
+      val = o.val;
+      return true;
+    }
   private:
     union Overlay
     {
@@ -338,6 +612,24 @@ class Packer32
       //std::cout << "unpack<32>(" << val << ")" << std::endl;
       return is.good();
     }
+    static bool pack(MsgWriter& w, const T& val)
+    {
+      Overlay o;
+      o.val = val;
+      o.uval = htobe32(o.uval);
+      return w.write(o.buf, sizeof(T));
+    }
+    static bool unpack(MsgReader& r, T& val)
+    {
+      Overlay o;
+      if (!r.read(o.buf, sizeof(T)))
+      {
+        return false;
+      }
+      o.uval = be32toh(o.uval);
+      val = o.val;
+      return true;
+    }
   private:
     union Overlay
     {
@@ -372,6 +664,24 @@ class Packer16
       //std::cout << "unpack<16>(" << val << ")" << std::endl;
       return is.good();
     }
+    static bool pack(MsgWriter& w, const T& val)
+    {
+      Overlay o;
+      o.val = val;
+      o.uval = htobe16(o.uval);
+      return w.write(o.buf, sizeof(T));
+    }
+    static bool unpack(MsgReader& r, T& val)
+    {
+      Overlay o;
+      if (!r.read(o.buf, sizeof(T)))
+      {
+        return false;
+      }
+      o.uval = be16toh(o.uval);
+      val = o.val;
+      return true;
+    }
   private:
     union Overlay
     {
@@ -399,6 +709,14 @@ class Packer8
       //std::cout << "unpack<8>(" << int(val) << ")" << std::endl;
       return is.good();
     }
+    static bool pack(MsgWriter& w, const T& val)
+    {
+      return w.write(&val, sizeof(T));
+    }
+    static bool unpack(MsgReader& r, T& val)
+    {
+      return r.read(&val, sizeof(T));
+    }
 };
 template <> class MsgPacker<uint8_t> : public Packer8<uint8_t> {};
 template <> class MsgPacker<int8_t> : public Packer8<int8_t> {};
@@ -441,6 +759,31 @@ class MsgPacker<std::string>
       }
       return false;
     }
+    static bool pack(MsgWriter& w, const std::string& val)
+    {
+      if (val.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      uint16_t str_len(val.size());
+      return MsgPacker<uint16_t>::pack(w, str_len) &&
+             w.write(val.data(), val.size());
+    }
+    static bool unpack(MsgReader& r, std::string& val)
+    {
+      uint16_t str_len;
+      if (!MsgPacker<uint16_t>::unpack(r, str_len))
+      {
+        return false;
+      }
+      const uint8_t *str = r.consume(str_len);
+      if (str == 0)
+      {
+        return false;
+      }
+      val.assign(reinterpret_cast<const char*>(str), str_len);
+      return true;
+    }
 };
 
 template <typename I>
@@ -492,6 +835,70 @@ class MsgPacker<std::vector<I> >
       }
       return true;
     }
+    static bool pack(MsgWriter& w, const std::vector<I>& vec)
+    {
+      if (vec.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      return MsgPacker<uint16_t>::pack(w, vec.size()) && packItems(w, vec);
+    }
+    static bool unpack(MsgReader& r, std::vector<I>& vec)
+    {
+      uint16_t vec_size;
+      if (!MsgPacker<uint16_t>::unpack(r, vec_size))
+      {
+        return false;
+      }
+      return unpackItems(r, vec, vec_size);
+    }
+
+  private:
+    template <typename V>
+    static bool packItems(MsgWriter& w, const std::vector<V>& vec)
+    {
+      for (typename std::vector<V>::const_iterator it = vec.begin();
+           it != vec.end();
+           ++it)
+      {
+        if (!MsgPacker<V>::pack(w, *it))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    static bool packItems(MsgWriter& w, const std::vector<uint8_t>& vec)
+    {
+      return vec.empty() || w.write(&vec[0], vec.size());
+    }
+    template <typename V>
+    static bool unpackItems(MsgReader& r, std::vector<V>& vec, size_t cnt)
+    {
+      vec.clear();
+      vec.reserve(std::min(cnt, r.remaining()));
+      for (size_t i=0; i<cnt; ++i)
+      {
+        V val;
+        if (!MsgPacker<V>::unpack(r, val))
+        {
+          return false;
+        }
+        vec.push_back(val);
+      }
+      return true;
+    }
+    static bool unpackItems(MsgReader& r, std::vector<uint8_t>& vec,
+                            size_t cnt)
+    {
+      const uint8_t *items = r.consume(cnt);
+      if (items == 0)
+      {
+        return false;
+      }
+      vec.assign(items, items + cnt);
+      return true;
+    }
 };
 
 template <typename I>
@@ -542,6 +949,46 @@ class MsgPacker<std::set<I> >
       }
       return true;
     }
+    static bool pack(MsgWriter& w, const std::set<I>& s)
+    {
+      if (s.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      if (!MsgPacker<uint16_t>::pack(w, s.size()))
+      {
+        return false;
+      }
+      for (typename std::set<I>::const_iterator it = s.begin();
+           it != s.end();
+           ++it)
+      {
+        if (!MsgPacker<I>::pack(w, *it))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    static bool unpack(MsgReader& r, std::set<I>& s)
+    {
+      uint16_t set_size;
+      if (!MsgPacker<uint16_t>::unpack(r, set_size))
+      {
+        return false;
+      }
+      s.clear();
+      for (int i=0; i<set_size; ++i)
+      {
+        I val;
+        if (!MsgPacker<I>::unpack(r, val))
+        {
+          return false;
+        }
+        s.insert(val);
+      }
+      return true;
+    }
 };
 
 template <typename Tag, typename Value>
@@ -596,6 +1043,49 @@ class MsgPacker<std::map<Tag,Value> >
       }
       return true;
     }
+    static bool pack(MsgWriter& w, const std::map<Tag, Value>& m)
+    {
+      if (m.size() > std::numeric_limits<uint16_t>::max())
+      {
+        return false;
+      }
+      if (!MsgPacker<uint16_t>::pack(w, m.size()))
+      {
+        return false;
+      }
+      for (typename std::map<Tag,Value>::const_iterator it = m.begin();
+           it != m.end();
+           ++it)
+      {
+        if (!MsgPacker<Tag>::pack(w, (*it).first) ||
+            !MsgPacker<Value>::pack(w, (*it).second))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    static bool unpack(MsgReader& r, std::map<Tag,Value>& m)
+    {
+      uint16_t map_size;
+      if (!MsgPacker<uint16_t>::unpack(r, map_size))
+      {
+        return false;
+      }
+      m.clear();
+      for (int i=0; i<map_size; ++i)
+      {
+        Tag tag;
+        Value val;
+        if (!MsgPacker<Tag>::unpack(r, tag) ||
+            !MsgPacker<Value>::unpack(r, val))
+        {
+          return false;
+        }
+        m[tag] = val;
+      }
+      return true;
+    }
 };
 
 
@@ -613,12 +1103,17 @@ class Msg
     size_t packedSizeParent(void) const { return 0; }
     bool unpackParent(std::istream&) const { return true; }
 
+    bool packParent(MsgWriter&) const { return true; }
+    bool unpackParent(MsgReader&) const { return true; }
+
     virtual bool pack(std::ostream&) const { return true; }
     virtual size_t packedSize(void) const { return 0; }
     virtual bool unpack(std::istream&) const { return true; }
+    virtual bool pack(MsgWriter&) const { return true; }
+    virtual bool unpack(MsgReader&) { return true; }
 
-    template <typename T>
-    bool pack(std::ostream& os, const T& val) const
+    template <typename OS, typename T>
+    bool pack(OS& os, const T& val) const
     {
       return MsgPacker<T>::pack(os, val);
     }
@@ -627,14 +1122,14 @@ class Msg
     {
       return MsgPacker<T>::packedSize(val);
     }
-    template <typename T>
-    bool unpack(std::istream& is, T& val) const
+    template <typename IS, typename T>
+    bool unpack(IS& is, T& val) const
     {
       return MsgPacker<T>::unpack(is, val);
     }
 
-    template <typename T1, typename T2>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2) const
+    template <typename OS, typename T1, typename T2>
+    bool pack(OS& os, const T1& v1, const T2& v2) const
     {
       return pack(os, v1) && pack(os, v2);
     }
@@ -643,14 +1138,14 @@ class Msg
     {
       return packedSize(v1) + packedSize(v2);
     }
-    template <typename T1, typename T2>
-    bool unpack(std::istream& is, T1& v1, T2& v2)
+    template <typename IS, typename T1, typename T2>
+    bool unpack(IS& is, T1& v1, T2& v2)
     {
       return unpack(is, v1) && unpack(is, v2);
     }
 
-    template <typename T1, typename T2, typename T3>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3) const
+    template <typename OS, typename T1, typename T2, typename T3>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3) const
     {
       return pack(os, v1) && pack(os, v2) && pack(os, v3);
     }
@@ -659,14 +1154,14 @@ class Msg
     {
       return packedSize(v1) + packedSize(v2) + packedSize(v3);
     }
-    template <typename T1, typename T2, typename T3>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3)
+    template <typename IS, typename T1, typename T2, typename T3>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4) const
     {
       return pack(os, v1) && pack(os, v2) && pack(os, v3) && pack(os, v4);
@@ -677,15 +1172,16 @@ class Msg
     {
       return packedSize(v1) + packedSize(v2) + packedSize(v3) + packedSize(v4);
     }
-    template <typename T1, typename T2, typename T3, typename T4>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4)
+    template <typename IS, typename T1, typename T2, typename T3, typename T4>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
              unpack(is, v4);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4, typename T5>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4,
+              typename T5>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4, const T5& v5) const
     {
       return pack(os, v1) && pack(os, v2) && pack(os, v3) && pack(os, v4) &&
@@ -698,16 +1194,17 @@ class Msg
       return packedSize(v1) + packedSize(v2) + packedSize(v3) + packedSize(v4) +
              packedSize(v5);
     }
-    template <typename T1, typename T2, typename T3, typename T4, typename T5>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5)
+    template <typename IS, typename T1, typename T2, typename T3, typename T4,
+              typename T5>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
              unpack(is, v4) && unpack(is, v5);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4, const T5& v5, const T6& v6) const
     {
       return pack(os, v1) && pack(os, v2) && pack(os, v3) && pack(os, v4) &&
@@ -721,18 +1218,18 @@ class Msg
       return packedSize(v1) + packedSize(v2) + packedSize(v3) + packedSize(v4) +
              packedSize(v5) + packedSize(v6);
     }
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
+    template <typename IS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
                T6& v6)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
              unpack(is, v4) && unpack(is, v5) && unpack(is, v6);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4, const T5& v5, const T6& v6, const T7& v7) const
     {
       return pack(os, v1) && pack(os, v2) && pack(os, v3) && pack(os, v4) &&
@@ -747,9 +1244,9 @@ class Msg
       return packedSize(v1) + packedSize(v2) + packedSize(v3) + packedSize(v4) +
              packedSize(v5) + packedSize(v6) + packedSize(v7);
     }
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
+    template <typename IS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
                T6& v6, T7& v7)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
@@ -757,9 +1254,9 @@ class Msg
              unpack(is, v7);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7, typename T8>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7, typename T8>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4, const T5& v5, const T6& v6, const T7& v7,
               const T8& v8) const
     {
@@ -775,9 +1272,9 @@ class Msg
       return packedSize(v1) + packedSize(v2) + packedSize(v3) + packedSize(v4) +
              packedSize(v5) + packedSize(v6) + packedSize(v7) + packedSize(v8);
     }
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7, typename T8>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
+    template <typename IS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7, typename T8>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
                T6& v6, T7& v7, T8& v8)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
@@ -785,9 +1282,9 @@ class Msg
              unpack(is, v7) && unpack(is, v8);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7, typename T8, typename T9>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7, typename T8, typename T9>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4, const T5& v5, const T6& v6, const T7& v7,
               const T8& v8, const T9& v9) const
     {
@@ -805,9 +1302,9 @@ class Msg
              packedSize(v5) + packedSize(v6) + packedSize(v7) + packedSize(v8) +
              packedSize(v9);
     }
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7, typename T8, typename T9>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
+    template <typename IS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7, typename T8, typename T9>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
                T6& v6, T7& v7, T8& v8, T9& v9)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
@@ -815,9 +1312,10 @@ class Msg
              unpack(is, v7) && unpack(is, v8) && unpack(is, v9);
     }
 
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7, typename T8, typename T9, typename T10>
-    bool pack(std::ostream& os, const T1& v1, const T2& v2, const T3& v3,
+    template <typename OS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7, typename T8, typename T9,
+              typename T10>
+    bool pack(OS& os, const T1& v1, const T2& v2, const T3& v3,
               const T4& v4, const T5& v5, const T6& v6, const T7& v7,
               const T8& v8, const T9& v9, const T10& v10) const
     {
@@ -836,9 +1334,10 @@ class Msg
              packedSize(v5) + packedSize(v6) + packedSize(v7) + packedSize(v8) +
              packedSize(v9) + packedSize(v10);
     }
-    template <typename T1, typename T2, typename T3, typename T4, typename T5,
-              typename T6, typename T7, typename T8, typename T9, typename T10>
-    bool unpack(std::istream& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
+    template <typename IS, typename T1, typename T2, typename T3, typename T4,
+              typename T5, typename T6, typename T7, typename T8, typename T9,
+              typename T10>
+    bool unpack(IS& is, T1& v1, T2& v2, T3& v3, T4& v4, T5& v5,
                T6& v6, T7& v7, T8& v8, T9& v9, T10& v10)
     {
       return unpack(is, v1) && unpack(is, v2) && unpack(is, v3) &&
@@ -0,0 +1,262 @@
+/**
+@file	 AsyncSpscRingBuffer.h
+@brief   A lock free single producer, single consumer ring buffer
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-02
+
+\verbatim
+Async - A library for programming event driven applications
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ASYNC_SPSC_RING_BUFFER_INCLUDED
+#define ASYNC_SPSC_RING_BUFFER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A lock free single producer, single consumer ring buffer
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-02
+
+This class implement a fixed size ring buffer that one thread can write to
+while another thread read from it, without using any locks. There must never
+be more than one thread writing and one thread reading at the same time.
+
+The read and write positions are free running counters that are only updated
+by the consumer and the producer respectively, using acquire/release memory
+ordering so that the elements are visible to the other thread before the
+position is. The capacity is rounded up to a power of two so that a position
+is mapped to an index using a mask. The two positions are kept on separate
+cache lines to avoid false sharing between the threads.
+
+Neither reading nor writing ever allocate memory, block or make system calls
+so the buffer can be used from a real time thread.
+*/
+template <typename T>
+class SpscRingBuffer
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   capacity The minimum number of elements the buffer can hold
+     */
+    explicit SpscRingBuffer(size_t capacity=0)
+      : m_mask(0), m_read_pos(0), m_write_pos(0)
+    {
+      setCapacity(capacity);
+    }
+
+    /**
+     * @brief   Set the capacity of the buffer
+     * @param   capacity The minimum number of elements the buffer can hold
+     *
+     * The buffer is emptied. This function must not be called while another
+     * thread is using the buffer.
+     */
+    void setCapacity(size_t capacity)
+    {
+      size_t size = 1;
+      while (size < capacity)
+      {
+        size <<= 1;
+      }
+      m_buf.assign(size, T());
+      m_mask = size - 1;
+      clear();
+    }
+
+    /**
+     * @brief   Get the capacity of the buffer
+     * @return  Returns the maximum number of elements the buffer can hold
+     */
+    size_t capacity(void) const { return m_buf.size(); }
+
+    /**
+     * @brief   Empty the buffer
+     *
+     * This function must not be called while another thread is using the
+     * buffer.
+     */
+    void clear(void)
+    {
+      m_read_pos.store(0, std::memory_order_relaxed);
+      m_write_pos.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief   Get the number of elements that can be read
+     * @return  Returns the number of elements in the buffer
+     *
+     * When called by the producer, the returned value may be larger than the
+     * actual number of elements. When called by the consumer, the returned
+     * value may be smaller than the actual number of elements.
+     */
+    size_t readAvailable(void) const
+    {
+      return m_write_pos.load(std::memory_order_acquire) -
+             m_read_pos.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief   Get the number of elements that can be written
+     * @return  Returns the free space in the buffer
+     */
+    size_t writeAvailable(void) const
+    {
+      return m_buf.size() - readAvailable();
+    }
+
+    /**
+     * @brief   Write elements to the buffer, only called by the producer
+     * @param   buf   The elements to write
+     * @param   count The number of elements to write
+     * @return  Returns the number of elements written
+     *
+     * As many elements as there is room for are written.
+     */
+    size_t write(const T *buf, size_t count)
+    {
+      size_t wpos = m_write_pos.load(std::memory_order_relaxed);
+      size_t rpos = m_read_pos.load(std::memory_order_acquire);
+      count = std::min(count, m_buf.size() - (wpos - rpos));
+      size_t idx = wpos & m_mask;
+      size_t first = std::min(count, m_buf.size() - idx);
+      std::copy(buf, buf + first, m_buf.begin() + idx);
+      std::copy(buf + first, buf + count, m_buf.begin());
+      m_write_pos.store(wpos + count, std::memory_order_release);
+      return count;
+    }
+
+    /**
+     * @brief   Read elements from the buffer, only called by the consumer
+     * @param   buf   The buffer to read the elements into
+     * @param   count The maximum number of elements to read
+     * @return  Returns the number of elements read
+     */
+    size_t read(T *buf, size_t count)
+    {
+      size_t rpos = m_read_pos.load(std::memory_order_relaxed);
+      size_t wpos = m_write_pos.load(std::memory_order_acquire);
+      count = std::min(count, wpos - rpos);
+      size_t idx = rpos & m_mask;
+      size_t first = std::min(count, m_buf.size() - idx);
+      std::copy(m_buf.begin() + idx, m_buf.begin() + idx + first, buf);
+      std::copy(m_buf.begin(), m_buf.begin() + (count - first), buf + first);
+      m_read_pos.store(rpos + count, std::memory_order_release);
+      return count;
+    }
+
+  private:
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    std::vector<T>                            m_buf;
+    size_t                                    m_mask;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>  m_read_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t>  m_write_pos;
+
+    SpscRingBuffer(const SpscRingBuffer&);
+    SpscRingBuffer& operator=(const SpscRingBuffer&);
+
+};  /* class SpscRingBuffer */
+
+
+} /* namespace */
+
+#endif /* ASYNC_SPSC_RING_BUFFER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
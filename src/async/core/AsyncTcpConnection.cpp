@@ -35,6 +35,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <assert.h>
@@ -42,6 +45,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -164,7 +168,10 @@ const char *TcpConnection::disconnectReasonStr(DisconnectReason reason)
  */
 TcpConnection::TcpConnection(size_t recv_buf_len)
   : remote_port(0), recv_buf_len(recv_buf_len), sock(-1), rd_watch(0),
-    wr_watch(0), recv_buf(0), recv_buf_cnt(0)
+    wr_watch(0), recv_buf(0), recv_buf_cnt(0),
+    txq_size(0), max_txq_size(DEFAULT_MAX_TX_QUEUE_SIZE),
+    txq_low_watermark(0), txq_high_watermark(0), send_buf_full(false),
+    tcp_nodelay(false), tcp_cork(false)
 {
   recv_buf = new char[recv_buf_len];
   rd_watch = new FdWatch;
@@ -178,7 +185,10 @@ TcpConnection::TcpConnection(int sock, const IpAddress& remote_addr,
       	      	      	     uint16_t remote_port, size_t recv_buf_len)
   : remote_addr(remote_addr), remote_port(remote_port),
     recv_buf_len(recv_buf_len), sock(sock), rd_watch(0), wr_watch(0),
-    recv_buf(0), recv_buf_cnt(0)
+    recv_buf(0), recv_buf_cnt(0),
+    txq_size(0), max_txq_size(DEFAULT_MAX_TX_QUEUE_SIZE),
+    txq_low_watermark(0), txq_high_watermark(0), send_buf_full(false),
+    tcp_nodelay(false), tcp_cork(false)
 {
   recv_buf = new char[recv_buf_len];
   rd_watch = new FdWatch;
@@ -195,6 +205,11 @@ TcpConnection::~TcpConnection(void)
   delete [] recv_buf;
   delete rd_watch;
   delete wr_watch;
+  for (std::vector<uint8_t *>::iterator it = free_tx_chunks.begin();
+       it != free_tx_chunks.end(); ++it)
+  {
+    delete [] *it;
+  }
 } /* TcpConnection::~TcpConnection */
 
 
@@ -213,9 +228,41 @@ void TcpConnection::setRecvBufLen(size_t recv_buf_len)
 } /* TcpConnection::setRecvBufLen */
 
 
+void TcpConnection::setTxQueueWatermarks(size_t low, size_t high)
+{
+  txq_high_watermark = high;
+  txq_low_watermark = std::min(low, high);
+} /* TcpConnection::setTxQueueWatermarks */
+
+
+bool TcpConnection::setTcpNoDelay(bool enable)
+{
+  tcp_nodelay = enable;
+  return applySocketOption(IPPROTO_TCP, TCP_NODELAY, enable);
+} /* TcpConnection::setTcpNoDelay */
+
+
+bool TcpConnection::setTcpCork(bool enable)
+{
+#ifdef TCP_CORK
+  tcp_cork = enable;
+  return applySocketOption(IPPROTO_TCP, TCP_CORK, enable);
+#else
+  if (enable)
+  {
+    errno = ENOTSUP;
+    return false;
+  }
+  return true;
+#endif
+} /* TcpConnection::setTcpCork */
+
+
 void TcpConnection::disconnect(void)
 {
   recv_buf_cnt = 0;
+  clearTxQueue();
+  send_buf_full = false;
   
   wr_watch->setEnabled(false);
   rd_watch->setEnabled(false);
@@ -230,28 +277,32 @@ void TcpConnection::disconnect(void)
 
 int TcpConnection::write(const void *buf, int count)
 {
-  assert(sock != -1);
-  int cnt = ::send(sock, buf, count, MSG_NOSIGNAL);
-  if (cnt < 0)
-  {
-    if (errno != EAGAIN)
-    {
-      return -1;
-    }
-    cnt = 0;
-  }
+  struct iovec iov;
+  iov.iov_base = const_cast<void *>(buf);
+  iov.iov_len = count;
+  return sendOrQueue(&iov, 1, 0);
+} /* TcpConnection::write */
 
-  if (cnt < count)
+
+int TcpConnection::write(const SharedBuffer& buf)
+{
+  if (buf->empty())
   {
-    sendBufferFull(true);
-    wr_watch->setEnabled(true);
+    return 0;
   }
-  
-  return cnt;
-  
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t *>(&buf->front());
+  iov.iov_len = buf->size();
+  return sendOrQueue(&iov, 1, &buf);
 } /* TcpConnection::write */
 
 
+int TcpConnection::writev(const struct iovec *iov, int iovcnt)
+{
+  return sendOrQueue(iov, iovcnt, 0);
+} /* TcpConnection::writev */
+
+
 
 /****************************************************************************
  *
@@ -279,6 +330,16 @@ void TcpConnection::setSocket(int sock)
   rd_watch->setEnabled(true);
   wr_watch->setEnabled(false);
   wr_watch->setFd(sock, FdWatch::FD_WATCH_WR);
+  if (tcp_nodelay)
+  {
+    applySocketOption(IPPROTO_TCP, TCP_NODELAY, true);
+  }
+#ifdef TCP_CORK
+  if (tcp_cork)
+  {
+    applySocketOption(IPPROTO_TCP, TCP_CORK, true);
+  }
+#endif
 } /* TcpConnection::setSocket */
 
 
@@ -387,11 +448,237 @@ void TcpConnection::recvHandler(FdWatch *watch)
 
 void TcpConnection::writeHandler(FdWatch *watch)
 {
-  watch->setEnabled(false);
-  sendBufferFull(false);
+    // Send as much of the transmit queue as possible using one system call
+    // for up to MAX_IOV_CNT queued items
+  while (!txq.empty())
+  {
+    struct iovec iov[MAX_IOV_CNT];
+    int iovcnt = 0;
+    size_t count = 0;
+    for (TxQueue::const_iterator it = txq.begin();
+         (it != txq.end()) && (iovcnt < MAX_IOV_CNT); ++it)
+    {
+      const TxItem& item = *it;
+      iov[iovcnt].iov_base = const_cast<uint8_t *>(item.data()) + item.pos;
+      iov[iovcnt].iov_len = item.end - item.pos;
+      count += iov[iovcnt].iov_len;
+      ++iovcnt;
+    }
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    ssize_t cnt = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+    if (cnt < 0)
+    {
+      if (errno == EAGAIN)
+      {
+        return;
+      }
+      int errno_tmp = errno;
+      disconnect();
+      errno = errno_tmp;
+      onDisconnected(DR_SYSTEM_ERROR);
+      return;
+    }
+    txq_size -= cnt;
+
+    size_t sent = cnt;
+    while (sent > 0)
+    {
+      TxItem& item = txq.front();
+      size_t remaining = item.end - item.pos;
+      if (sent < remaining)
+      {
+        item.pos += sent;
+        break;
+      }
+      sent -= remaining;
+      releaseTxChunk(item.chunk);
+      txq.pop_front();
+    }
+
+    if (static_cast<size_t>(cnt) < count)
+    {
+      break;
+    }
+  }
+
+  if (txq.empty())
+  {
+    watch->setEnabled(false);
+  }
+
+  if (send_buf_full && (txq_size <= txq_low_watermark))
+  {
+    send_buf_full = false;
+    sendBufferFull(false);
+  }
 } /* TcpConnection::writeHandler */
 
 
+int TcpConnection::sendOrQueue(const struct iovec *iov, int iovcnt,
+                               const SharedBuffer *shared)
+{
+  assert(sock != -1);
+
+  size_t count = 0;
+  for (int i=0; i<iovcnt; ++i)
+  {
+    count += iov[i].iov_len;
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  size_t sent = 0;
+  if (txq.empty())
+  {
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = const_cast<struct iovec *>(iov);
+    msg.msg_iovlen = iovcnt;
+    ssize_t cnt = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+    if (cnt < 0)
+    {
+      if (errno != EAGAIN)
+      {
+        return -1;
+      }
+      cnt = 0;
+    }
+    sent = cnt;
+    if (sent >= count)
+    {
+      return count;
+    }
+  }
+  else if ((max_txq_size > 0) && (txq_size + count > max_txq_size))
+  {
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  if (shared != 0)
+  {
+    queueShared(*shared, sent);
+  }
+  else
+  {
+    for (int i=0; i<iovcnt; ++i)
+    {
+      if (sent >= iov[i].iov_len)
+      {
+        sent -= iov[i].iov_len;
+        continue;
+      }
+      queueCopy(reinterpret_cast<const uint8_t *>(iov[i].iov_base) + sent,
+                iov[i].iov_len - sent);
+      sent = 0;
+    }
+  }
+  wr_watch->setEnabled(true);
+  checkTxQueueHigh();
+
+  return count;
+} /* TcpConnection::sendOrQueue */
+
+
+void TcpConnection::queueCopy(const void *buf, size_t count)
+{
+  const uint8_t *ptr = reinterpret_cast<const uint8_t *>(buf);
+  while (count > 0)
+  {
+    if (txq.empty() || (txq.back().chunk == 0) ||
+        (txq.back().end == TX_CHUNK_SIZE))
+    {
+      TxItem item;
+      if (free_tx_chunks.empty())
+      {
+        item.chunk = new uint8_t[TX_CHUNK_SIZE];
+      }
+      else
+      {
+        item.chunk = free_tx_chunks.back();
+        free_tx_chunks.pop_back();
+      }
+      item.pos = item.end = 0;
+      txq.push_back(item);
+    }
+    TxItem& item = txq.back();
+    size_t copy_cnt = std::min(count, TX_CHUNK_SIZE - item.end);
+    std::memcpy(item.chunk + item.end, ptr, copy_cnt);
+    item.end += copy_cnt;
+    txq_size += copy_cnt;
+    ptr += copy_cnt;
+    count -= copy_cnt;
+  }
+} /* TcpConnection::queueCopy */
+
+
+void TcpConnection::queueShared(const SharedBuffer& buf, size_t pos)
+{
+  TxItem item;
+  item.buf = buf;
+  item.chunk = 0;
+  item.pos = pos;
+  item.end = buf->size();
+  txq.push_back(item);
+  txq_size += item.end - item.pos;
+} /* TcpConnection::queueShared */
+
+
+void TcpConnection::releaseTxChunk(uint8_t *chunk)
+{
+  if (chunk == 0)
+  {
+    return;
+  }
+  if (free_tx_chunks.size() < MAX_FREE_TX_CHUNKS)
+  {
+    free_tx_chunks.push_back(chunk);
+  }
+  else
+  {
+    delete [] chunk;
+  }
+} /* TcpConnection::releaseTxChunk */
+
+
+void TcpConnection::clearTxQueue(void)
+{
+  for (TxQueue::iterator it = txq.begin(); it != txq.end(); ++it)
+  {
+    releaseTxChunk((*it).chunk);
+  }
+  txq.clear();
+  txq_size = 0;
+} /* TcpConnection::clearTxQueue */
+
+
+void TcpConnection::checkTxQueueHigh(void)
+{
+  if (!send_buf_full && (txq_size > txq_high_watermark))
+  {
+    send_buf_full = true;
+    sendBufferFull(true);
+  }
+} /* TcpConnection::checkTxQueueHigh */
+
+
+bool TcpConnection::applySocketOption(int level, int optname, bool enable)
+{
+  if (sock == -1)
+  {
+    return true;
+  }
+  int val = enable ? 1 : 0;
+  return setsockopt(sock, level, optname, &val, sizeof(val)) == 0;
+} /* TcpConnection::applySocketOption */
+
+
 
 /*
  * This file has not been truncated
@@ -43,6 +43,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <stdint.h>
 
 #include <string>
+#include <deque>
+#include <vector>
+#include <memory>
 
 
 /****************************************************************************
@@ -68,6 +71,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+struct iovec;
 
 
 /****************************************************************************
@@ -119,6 +123,15 @@ class IpAddress;
 This class is used to handle an existing TCP connection. It is not meant to
 be used directly but could be. It it mainly created to handle connections
 for Async::TcpClient and Async::TcpServer.
+
+Data that cannot be sent directly, because the operating system send buffer
+is full, is kept in a transmit queue and is sent as soon as the remote end
+is ready to receive more data. Copied data is stored in pooled fixed size
+chunks and shared buffers are queued by reference so queueing does not
+allocate memory for each write. The queue is flushed using as few system
+calls as possible. The size of the queue is limited (see setMaxTxQueueSize)
+and the sendBufferFull signal is used to tell the user when to pause and
+resume writing (see setTxQueueWatermarks).
 */
 class TcpConnection : public sigc::trackable
 {
@@ -140,6 +153,17 @@ class TcpConnection : public sigc::trackable
      * @brief The default length of the reception buffer
      */
     static const int DEFAULT_RECV_BUF_LEN = 1024;
+
+    /**
+     * @brief The default maximum size of the transmit queue
+     */
+    static const size_t DEFAULT_MAX_TX_QUEUE_SIZE = 1024 * 1024;
+
+    /**
+     * @brief   A reference counted buffer that can be written to many
+     *          connections without being copied
+     */
+    typedef std::shared_ptr<const std::vector<uint8_t> > SharedBuffer;
     
     /**
      * @brief Translate disconnect reason to a string
@@ -179,6 +203,59 @@ class TcpConnection : public sigc::trackable
      */
     void setRecvBufLen(size_t recv_buf_len);
 
+    /**
+     * @brief   Set the maximum size of the transmit queue
+     * @param   size The maximum number of queued bytes
+     *
+     * Use this function to limit the amount of data that may be waiting in
+     * the transmit queue. A write that would make the queue grow beyond the
+     * limit fail with errno set to ENOBUFS. A write to an empty queue is
+     * always accepted. Shared buffers count in full toward the limit. The
+     * default is DEFAULT_MAX_TX_QUEUE_SIZE and 0 means that there is no limit.
+     */
+    void setMaxTxQueueSize(size_t size) { max_txq_size = size; }
+
+    /**
+     * @brief   Get the number of bytes waiting in the transmit queue
+     * @return  Returns the number of queued bytes
+     */
+    size_t txQueueSize(void) const { return txq_size; }
+
+    /**
+     * @brief   Set the transmit queue watermarks
+     * @param   low   The low watermark in bytes
+     * @param   high  The high watermark in bytes
+     *
+     * The sendBufferFull signal is emitted with \em true when the number of
+     * queued bytes grow above the high watermark and with \em false when it
+     * has dropped to the low watermark. The default for both is 0 so that
+     * the signal is emitted as soon as anything is queued and when the queue
+     * is empty again.
+     */
+    void setTxQueueWatermarks(size_t low, size_t high);
+
+    /**
+     * @brief   Enable or disable the TCP_NODELAY socket option
+     * @param   enable Set to \em true to disable the Nagle algorithm
+     * @return  Returns \em true on success or else \em false
+     *
+     * The setting is remembered and applied to sockets set up later.
+     */
+    bool setTcpNoDelay(bool enable);
+
+    /**
+     * @brief   Enable or disable the TCP_CORK socket option
+     * @param   enable Set to \em true to only send full segments
+     * @return  Returns \em true on success or else \em false
+     *
+     * While corked, partial segments are held back by the operating system.
+     * Cork the connection before writing a burst of small messages and
+     * uncork it afterwards to send them in as few segments as possible.
+     * The setting is remembered and applied to sockets set up later. This
+     * option is only supported on Linux.
+     */
+    bool setTcpCork(bool enable);
+
     /**
      * @brief 	Disconnect from the remote host
      *
@@ -193,8 +270,34 @@ class TcpConnection : public sigc::trackable
      * @param 	buf   The buffer containing the data to send
      * @param 	count The number of bytes to send from the buffer
      * @return	Returns the number of bytes written or -1 on failure
+     *
+     * The data that cannot be sent directly is copied to the transmit queue
+     * so on success, the returned value is always equal to count. If the
+     * transmit queue is full, -1 is returned and errno is set to ENOBUFS.
      */
     virtual int write(const void *buf, int count);
+
+    /**
+     * @brief 	Write a shared buffer to the TCP connection
+     * @param 	buf   The buffer to send
+     * @return	Returns the number of bytes written or -1 on failure
+     *
+     * This function works like the write function above but if the data
+     * cannot be sent directly, the buffer is queued by reference instead of
+     * being copied.
+     */
+    int write(const SharedBuffer& buf);
+
+    /**
+     * @brief 	Write data from several buffers to the TCP connection
+     * @param 	iov     The buffers containing the data to send
+     * @param 	iovcnt  The number of buffers
+     * @return	Returns the number of bytes written or -1 on failure
+     *
+     * This function work like the write function but the data is gathered
+     * from several buffers so that it can be sent using one system call.
+     */
+    int writev(const struct iovec *iov, int iovcnt);
     
     /**
      * @brief 	Return the IP-address of the remote host
@@ -253,6 +356,10 @@ class TcpConnection : public sigc::trackable
      * @brief 	A signal that is emitted when the send buffer status changes
      * @param 	is_full Set to \em true if the buffer is full or \em false
      *	      	      	if a buffer full condition has been cleared
+     *
+     * The buffer is considered full when the transmit queue has grown above
+     * the high watermark and the condition is cleared when the queue has
+     * dropped to the low watermark (see setTxQueueWatermarks).
      */
     sigc::signal<void, bool> sendBufferFull;
 
@@ -325,17 +432,54 @@ class TcpConnection : public sigc::trackable
   private:
     friend class TcpClientBase;
 
-    IpAddress remote_addr;
-    uint16_t  remote_port;
-    size_t    recv_buf_len;
-    int       sock;
-    FdWatch * rd_watch;
-    FdWatch * wr_watch;
-    char *    recv_buf;
-    size_t    recv_buf_cnt;
+    static const size_t TX_CHUNK_SIZE = 4096;
+    static const size_t MAX_FREE_TX_CHUNKS = 16;
+    static const int    MAX_IOV_CNT = 64;
+
+    struct TxItem
+    {
+      SharedBuffer  buf;
+      uint8_t *     chunk;
+      size_t        pos;
+      size_t        end;
+
+      const uint8_t *data(void) const
+      {
+        return (chunk != 0) ? chunk : &buf->front();
+      }
+    };
+    typedef std::deque<TxItem> TxQueue;
+
+    IpAddress               remote_addr;
+    uint16_t                remote_port;
+    size_t                  recv_buf_len;
+    int                     sock;
+    FdWatch *               rd_watch;
+    FdWatch *               wr_watch;
+    char *                  recv_buf;
+    size_t                  recv_buf_cnt;
+    TxQueue                 txq;
+    size_t                  txq_size;
+    size_t                  max_txq_size;
+    size_t                  txq_low_watermark;
+    size_t                  txq_high_watermark;
+    bool                    send_buf_full;
+    std::vector<uint8_t *>  free_tx_chunks;
+    bool                    tcp_nodelay;
+    bool                    tcp_cork;
     
+    TcpConnection(const TcpConnection&);
+    TcpConnection& operator=(const TcpConnection&);
     void recvHandler(FdWatch *watch);
     void writeHandler(FdWatch *watch);
+    int sendOrQueue(const struct iovec *iov, int iovcnt,
+                    const SharedBuffer *shared);
+    void queueCopy(const void *buf, size_t count);
+    void queueShared(const SharedBuffer& buf, size_t pos);
+    void releaseTxChunk(uint8_t *chunk);
+    void clearTxQueue(void);
+    void checkTxQueueHigh(void);
+    bool applySocketOption(int level, int optname, bool enable);
 
 };  /* class TcpConnection */
 
@@ -119,7 +119,8 @@ using namespace Async;
 
 
 Timer::Timer(int timeout_ms, Type type, bool enabled)
-  : m_type(type), m_timeout_ms(timeout_ms), m_is_enabled(false)
+  : m_type(type), m_timeout_ms(timeout_ms), m_is_enabled(false),
+    m_queue_pos(static_cast<size_t>(-1))
 {
   setEnable(enabled && (timeout_ms >= 0));
 } /* Timer::Timer */
@@ -46,6 +46,8 @@ An example of how to use the Async::Timer class
 
 #include <sigc++/sigc++.h>
 
+#include <cstddef>
+
 
 
 /****************************************************************************
@@ -213,9 +215,12 @@ class Timer : public sigc::trackable
   protected:
     
   private:
-    Type  m_type;
-    int   m_timeout_ms;
-    bool  m_is_enabled;
+    friend class CppApplication;
+
+    Type    m_type;
+    int     m_timeout_ms;
+    bool    m_is_enabled;
+    size_t  m_queue_pos;  // Position in the main loop timer queue, if any
   
 };  /* class Timer */
 
@@ -97,14 +97,26 @@ class UdpPacket
   public:
     const IpAddress ip;
     int       	    port;
-    char    	    buf[65535];
+    char    	    *buf;
     int       	    len;
     
     UdpPacket(const IpAddress& ip, int port, const void *buf, int len)
-      : ip(ip), port(port), len(len)
+      : ip(ip), port(port), buf(new char[len > 0 ? len : 1]), len(len)
     {
-      memcpy(this->buf, buf, len);
+      if (buf != 0)
+      {
+        memcpy(this->buf, buf, len);
+      }
     }
+
+    ~UdpPacket(void)
+    {
+      delete [] buf;
+    }
+
+  private:
+    UdpPacket(const UdpPacket&);
+    UdpPacket& operator=(const UdpPacket&);
   
 };
 
@@ -153,7 +165,8 @@ class UdpPacket
  * Bugs:      
  *------------------------------------------------------------------------
  */
-UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
+UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip,
+                     bool reuse_port)
   : sock(-1), rd_watch(0), wr_watch(0), send_buf(0)
 {
   struct sockaddr_in addr;
@@ -175,6 +188,27 @@ UdpSocket::UdpSocket(uint16_t local_port, const IpAddress &bind_ip)
     return;
   }
   
+#ifdef SO_REUSEPORT
+  if (reuse_port)
+  {
+    int on = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
+    {
+      perror("setsockopt(SO_REUSEPORT)");
+      cleanup();
+      return;
+    }
+  }
+#else
+  if (reuse_port)
+  {
+    fprintf(stderr, "*** ERROR: SO_REUSEPORT is not supported on this "
+                    "platform\n");
+    cleanup();
+    return;
+  }
+#endif
+
     // Bind the socket to a local port if one was specified
   if (local_port > 0)
   {
@@ -254,6 +288,86 @@ bool UdpSocket::write(const IpAddress& remote_ip, int remote_port,
 } /* UdpSocket::write */
 
 
+size_t UdpSocket::writeBatch(const Datagram *dgrams, size_t count)
+{
+  if ((send_buf != 0) || (count == 0))
+  {
+    return 0;
+  }
+
+  if (batch_msgs.size() < count)
+  {
+    batch_msgs.resize(count);
+    batch_iov.resize(2 * count);
+    batch_addrs.resize(count);
+  }
+  for (size_t i=0; i<count; ++i)
+  {
+    const Datagram& dgram = dgrams[i];
+    struct sockaddr_in& addr = batch_addrs[i];
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(dgram.remote_port);
+    addr.sin_addr = dgram.remote_ip.ip4Addr();
+
+    struct iovec *iov = &batch_iov[2 * i];
+    size_t iovlen = 0;
+    if (dgram.header_len > 0)
+    {
+      iov[iovlen].iov_base = const_cast<void*>(dgram.header);
+      iov[iovlen++].iov_len = dgram.header_len;
+    }
+    iov[iovlen].iov_base = const_cast<void*>(dgram.payload);
+    iov[iovlen++].iov_len = dgram.payload_len;
+
+    struct msghdr& hdr = batch_msgs[i].msg_hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_name = &addr;
+    hdr.msg_namelen = sizeof(addr);
+    hdr.msg_iov = iov;
+    hdr.msg_iovlen = iovlen;
+    batch_msgs[i].msg_len = 0;
+  }
+
+  size_t sent = 0;
+  size_t pos = 0;
+  while (pos < count)
+  {
+    int ret = sendmmsg(sock, &batch_msgs[pos], count - pos, 0);
+    if (ret == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      const Datagram& dgram = dgrams[pos];
+      if (errno == EAGAIN)
+      {
+          // Buffer the first datagram that did not fit and drop the rest
+        send_buf = new UdpPacket(dgram.remote_ip, dgram.remote_port, 0,
+                                 dgram.header_len + dgram.payload_len);
+        if (dgram.header_len > 0)
+        {
+          memcpy(send_buf->buf, dgram.header, dgram.header_len);
+        }
+        memcpy(send_buf->buf + dgram.header_len, dgram.payload,
+               dgram.payload_len);
+        wr_watch->setEnabled(true);
+        sendBufferFull(true);
+        return sent + 1;
+      }
+      perror("sendmmsg in UdpSocket::writeBatch");
+      ++pos;
+      continue;
+    }
+    pos += ret;
+    sent += ret;
+  }
+
+  return sent;
+} /* UdpSocket::writeBatch */
+
+
 
 /****************************************************************************
  *
@@ -323,6 +437,12 @@ void UdpSocket::cleanup(void)
 
 void UdpSocket::handleInput(FdWatch *watch)
 {
+  if (!dataReceivedBatch.empty())
+  {
+    handleBatchInput();
+    return;
+  }
+
   char buf[65536];
   struct sockaddr_in addr;
   socklen_t addr_len = sizeof(addr);
@@ -340,6 +460,60 @@ void UdpSocket::handleInput(FdWatch *watch)
 } /* UdpSocket::handleInput */
 
 
+void UdpSocket::handleBatchInput(void)
+{
+  static const size_t RECV_BUF_SIZE = 65536;
+
+    // The buffer ring is allocated the first time it is needed so that
+    // sockets only using the dataReceived signal do not pay for it
+  if (recv_msgs.empty())
+  {
+    recv_bufs.resize(RECV_BATCH_SIZE * RECV_BUF_SIZE);
+    recv_msgs.resize(RECV_BATCH_SIZE);
+    recv_iov.resize(RECV_BATCH_SIZE);
+    recv_addrs.resize(RECV_BATCH_SIZE);
+    recv_dgrams.resize(RECV_BATCH_SIZE);
+  }
+
+  for (size_t i=0; i<RECV_BATCH_SIZE; ++i)
+  {
+    recv_iov[i].iov_base = &recv_bufs[i * RECV_BUF_SIZE];
+    recv_iov[i].iov_len = RECV_BUF_SIZE;
+    struct msghdr& hdr = recv_msgs[i].msg_hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_name = &recv_addrs[i];
+    hdr.msg_namelen = sizeof(recv_addrs[i]);
+    hdr.msg_iov = &recv_iov[i];
+    hdr.msg_iovlen = 1;
+    recv_msgs[i].msg_len = 0;
+  }
+
+  int cnt = recvmmsg(sock, &recv_msgs[0], RECV_BATCH_SIZE, MSG_DONTWAIT, 0);
+  if (cnt == -1)
+  {
+    if ((errno != EAGAIN) && (errno != EINTR))
+    {
+      perror("recvmmsg in UdpSocket::handleBatchInput");
+    }
+    return;
+  }
+
+  for (int i=0; i<cnt; ++i)
+  {
+    RecvDatagram& dgram = recv_dgrams[i];
+    dgram.remote_ip = IpAddress(recv_addrs[i].sin_addr);
+    dgram.remote_port = ntohs(recv_addrs[i].sin_port);
+    dgram.buf = recv_iov[i].iov_base;
+    dgram.len = recv_msgs[i].msg_len;
+  }
+
+    // The socket may be deleted by a slot so nothing may be touched after
+    // the signal has been emitted
+  dataReceivedBatch(&recv_dgrams[0], cnt);
+
+} /* UdpSocket::handleBatchInput */
+
+
 void UdpSocket::sendRest(FdWatch *watch)
 {
   struct sockaddr_in addr;
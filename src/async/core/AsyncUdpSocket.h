@@ -41,9 +41,14 @@ An example of how to use the Async::UdpSocket class
  *
  ****************************************************************************/
 
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
 #include <sigc++/sigc++.h>
 #include <stdint.h>
 
+#include <vector>
+
 
 /****************************************************************************
  *
@@ -124,14 +129,61 @@ This class is used to work with UDP sockets. An example usage is shown below.
 class UdpSocket : public sigc::trackable
 {
   public:
+    /**
+     * @brief A datagram to send using the writeBatch function
+     *
+     * A datagram consist of an optional header followed by a payload. The
+     * header and payload are gathered when sending so the same payload may
+     * be used for many datagrams without copying it.
+     */
+    struct Datagram
+    {
+      IpAddress   remote_ip;    ///< The IP address of the remote host
+      uint16_t    remote_port;  ///< The remote port to use
+      const void  *header;      ///< Header data, may be 0
+      size_t      header_len;   ///< The length of the header
+      const void  *payload;     ///< The datagram payload
+      size_t      payload_len;  ///< The length of the payload
+
+      Datagram(void)
+        : remote_port(0), header(0), header_len(0), payload(0),
+          payload_len(0) {}
+    };
+
+    /**
+     * @brief A datagram received by the dataReceivedBatch signal
+     *
+     * The buffer belong to the socket and is reused for the next batch so the
+     * data must be copied if it is needed after the signal handler returns.
+     */
+    struct RecvDatagram
+    {
+      IpAddress   remote_ip;    ///< The IP address of the remote host
+      uint16_t    remote_port;  ///< The remote port number
+      void        *buf;         ///< The buffer containing the datagram
+      int         len;          ///< The length of the datagram
+
+      RecvDatagram(void) : remote_port(0), buf(0), len(0) {}
+    };
+
+    /**
+     * @brief The maximum number of datagrams received in one batch
+     */
+    static const unsigned RECV_BATCH_SIZE = 16;
+
     /**
      * @brief 	Constructor
      * @param 	local_port  The local port to use. If not specified, a random
      *	      	      	    local port will be used.
      * @param  	bind_ip     Bind to the interface with the given IP address.
      *	      	            If left empty, bind to all interfaces.
+     * @param   reuse_port  Set the SO_REUSEPORT socket option before binding
+     *                      so that other sockets can bind to the same port.
+     *                      Incoming datagrams are then distributed between
+     *                      the sockets by the kernel.
      */
-    UdpSocket(uint16_t local_port=0, const IpAddress &bind_ip=IpAddress());
+    UdpSocket(uint16_t local_port=0, const IpAddress &bind_ip=IpAddress(),
+              bool reuse_port=false);
   
     /**
      * @brief 	Destructor
@@ -159,6 +211,20 @@ class UdpSocket : public sigc::trackable
     bool write(const IpAddress& remote_ip, int remote_port, const void *buf,
 	int count);
 
+    /**
+     * @brief 	Write many datagrams using as few system calls as possible
+     * @param 	dgrams  The datagrams to write
+     * @param 	count   The number of datagrams in the dgrams array
+     * @return	Returns the number of datagrams that were successfully sent
+     *
+     * This function will send all datagrams using the sendmmsg system call.
+     * If the send buffer becomes full, the first datagram that could not be
+     * sent is buffered, just like for the write function, and the rest are
+     * dropped. If a datagram cannot be sent due to some other error it is
+     * skipped and the rest of the datagrams are still sent.
+     */
+    size_t writeBatch(const Datagram *dgrams, size_t count);
+
     /**
      * @brief   Get the file descriptor for the UDP socket
      * @return  Returns the file descriptor associated with the socket or
@@ -174,6 +240,22 @@ class UdpSocket : public sigc::trackable
      * @param 	count The number of bytes read
      */
     sigc::signal<void, const IpAddress&, uint16_t, void*, int> dataReceived;
+
+    /**
+     * @brief 	A signal that is emitted when a batch of datagrams has been
+     *          received
+     * @param 	dgrams  The received datagrams
+     * @param 	count   The number of datagrams in the dgrams array
+     *
+     * When at least one slot is connected to this signal, up to
+     * RECV_BATCH_SIZE datagrams are read using one recvmmsg system call each
+     * time the socket becomes readable and they are all delivered by one
+     * emission of this signal. The dataReceived signal is then not emitted.
+     * The datagram buffers are owned by the socket and are reused for the
+     * next batch. They are freed if the socket is deleted by a slot, so the
+     * datagrams must not be accessed after that.
+     */
+    sigc::signal<void, const RecvDatagram*, size_t> dataReceivedBatch;
     
     /**
      * @brief 	A signal that is emitted when the send buffer is full
@@ -189,9 +271,18 @@ class UdpSocket : public sigc::trackable
     FdWatch * 	rd_watch;
     FdWatch * 	wr_watch;
     UdpPacket * send_buf;
+    std::vector<struct mmsghdr>       batch_msgs;
+    std::vector<struct iovec>         batch_iov;
+    std::vector<struct sockaddr_in>   batch_addrs;
+    std::vector<char>                 recv_bufs;
+    std::vector<struct mmsghdr>       recv_msgs;
+    std::vector<struct iovec>         recv_iov;
+    std::vector<struct sockaddr_in>   recv_addrs;
+    std::vector<RecvDatagram>         recv_dgrams;
     
     void cleanup(void);
     void handleInput(FdWatch *watch);
+    void handleBatchInput(void);
     void sendRest(FdWatch *watch);
 
 };  /* class UdpSocket */
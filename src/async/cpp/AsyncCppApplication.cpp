@@ -37,6 +37,8 @@
  ****************************************************************************/
 
 #include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <signal.h>
 #include <unistd.h>
 
@@ -44,7 +46,9 @@
 #include <cstdio>
 #include <cerrno>
 #include <cassert>
+#include <cstring>
 #include <algorithm>
+#include <iostream>
 
 
 /****************************************************************************
@@ -162,17 +166,34 @@ int CppApplication::sighandler_pipe[2];
  *------------------------------------------------------------------------
  */
 CppApplication::CppApplication(void)
-  : do_quit(false), max_desc(0), unix_signal_recv(-1), unix_signal_recv_cnt(0)
+  : m_backend(BACKEND_SELECT), do_quit(false), max_desc(0), timer_seq(0),
+    expiring_timer(0), timer_fd(-1), timer_fd_armed(false),
+    unix_signal_recv(-1), unix_signal_recv_cnt(0), epoll_fd(-1)
 {
-  FD_ZERO(&rd_set);
-  FD_ZERO(&wr_set);
-  sighandler_pipe[0] = sighandler_pipe[1] = -1;
+  init(BACKEND_SELECT);
+} /* CppApplication::CppApplication */
+
+
+CppApplication::CppApplication(Backend backend)
+  : m_backend(BACKEND_SELECT), do_quit(false), max_desc(0), timer_seq(0),
+    expiring_timer(0), timer_fd(-1), timer_fd_armed(false),
+    unix_signal_recv(-1), unix_signal_recv_cnt(0), epoll_fd(-1)
+{
+  init(backend);
 } /* CppApplication::CppApplication */
 
 
 CppApplication::~CppApplication(void)
 {
   clearTasks();
+  if (timer_fd != -1)
+  {
+    close(timer_fd);
+  }
+  if (epoll_fd != -1)
+  {
+    close(epoll_fd);
+  }
 } /* CppApplication::~CppApplication */
 
 
@@ -207,106 +228,45 @@ void CppApplication::exec(void)
   {
     struct timespec *timeout_ptr = 0;
     struct timespec timeout;
-    TimerMap::iterator titer = timer_map.begin();
-    while (titer != timer_map.end())
+    if (!timer_queue.empty())
     {
-      if (titer->second != 0)
-      {
-	struct timespec ts;
-	clock_gettime(CLOCK_MONOTONIC, &ts);
-	clock_timersub(&titer->first, &ts, &timeout);
-	if (timeout.tv_sec < 0)
-	{
-	  timeout.tv_sec = 0;
-	  timeout.tv_nsec = 0;
-	}
-	timeout_ptr = &timeout;
-	break;
-      }
-      else
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      clock_timersub(&timer_queue.front().expiration, &ts, &timeout);
+      if (timeout.tv_sec < 0)
       {
-	timer_map.erase(titer);
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = 0;
       }
-      titer = timer_map.begin();
+      timeout_ptr = &timeout;
     }
     
-    fd_set local_rd_set = rd_set;
-    fd_set local_wr_set = wr_set;
-    int dcnt = pselect(max_desc, &local_rd_set, &local_wr_set, NULL,
-	timeout_ptr, NULL);
-    if (dcnt == -1)
+    fd_set local_rd_set;
+    fd_set local_wr_set;
+    int dcnt;
+    if (m_backend == BACKEND_SELECT)
     {
-      if ((errno == EINTR) || (errno == EAGAIN))
-      {
-      	continue;
-      }
-      else
-      {
-        perror("pselect");
-        exit(1);
-      }
+      dcnt = selectWait(timeout_ptr, &local_rd_set, &local_wr_set);
     }
-    
-    if ((timeout_ptr != 0)
-        && ((dcnt == 0)
-            || ((timeout_ptr->tv_sec == 0) && (timeout_ptr->tv_nsec == 0))
-           )
-       )
-    {
-      titer->second->expired(titer->second);
-      if ((titer->second != 0) &&
-	  (titer->second->type() == Timer::TYPE_PERIODIC))
-      {
-	addTimerP(titer->second, titer->first);
-      }
-      timer_map.erase(titer);
+    else
+    {
+      dcnt = epollWait(timeout_ptr);
+    }
+    if (dcnt == -1)
+    {
+      continue;
     }
     
-    WatchMap::iterator witer, next_witer;
+    expireTimers();
     
-      /* Check for activity on the read watch file descriptors */
-    witer=rd_watch_map.begin();
-    while ((dcnt > 0) && (witer != rd_watch_map.end()))
+    if (m_backend == BACKEND_SELECT)
     {
-      next_witer = witer;
-      ++next_witer;
-      if (FD_ISSET(witer->first, &local_rd_set))
-      {
-	if (witer->second != 0)
-	{
-	  witer->second->activity(witer->second);
-	}
-	else
-	{
-	  rd_watch_map.erase(witer);
-	}
-	--dcnt;
-      }
-      witer = next_witer;
+      selectDispatch(dcnt, &local_rd_set, &local_wr_set);
     }
-    
-      /* Check for activity on the write watch file descriptors */
-    witer=wr_watch_map.begin();
-    while ((dcnt > 0) && (witer != wr_watch_map.end()))
+    else
     {
-      next_witer = witer;
-      ++next_witer;
-      if (FD_ISSET(witer->first, &local_wr_set))
-      {
-	if (witer->second != 0)
-	{
-	  witer->second->activity(witer->second);
-	}
-	else
-	{
-	  wr_watch_map.erase(witer);
-	}
-	--dcnt;
-      }
-      witer = next_witer;
+      epollDispatch(dcnt);
     }
-    
-    assert(dcnt == 0);
   }
 
   for (UnixSignalMap::const_iterator it = unix_signals.begin();
@@ -410,6 +370,308 @@ void CppApplication::uncatchUnixSignal(int signum)
  *
  ****************************************************************************/
 
+void CppApplication::init(Backend backend)
+{
+  FD_ZERO(&rd_set);
+  FD_ZERO(&wr_set);
+  sighandler_pipe[0] = sighandler_pipe[1] = -1;
+
+  const char *backend_str = getenv("ASYNC_CPP_APP_BACKEND");
+  if (backend_str != 0)
+  {
+    if (strcmp(backend_str, "select") == 0)
+    {
+      backend = BACKEND_SELECT;
+    }
+    else if (strcmp(backend_str, "epoll") == 0)
+    {
+      backend = BACKEND_EPOLL;
+    }
+    else if (strcmp(backend_str, "epoll-et") == 0)
+    {
+      backend = BACKEND_EPOLL_ET;
+    }
+    else
+    {
+      cerr << "*** WARNING: Unknown ASYNC_CPP_APP_BACKEND \""
+           << backend_str << "\". Valid values are: select, epoll, epoll-et"
+           << endl;
+    }
+  }
+
+  if (backend != BACKEND_SELECT)
+  {
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd == -1)
+    {
+      perror("epoll_create1");
+      exit(1);
+    }
+    epoll_events.resize(256);
+
+      // A timerfd is used to get better than millisecond resolution on timer
+      // timeouts, which is all that epoll_wait can offer
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+      perror("timerfd_create");
+      exit(1);
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = timer_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) == -1)
+    {
+      perror("epoll_ctl");
+      exit(1);
+    }
+  }
+  m_backend = backend;
+} /* CppApplication::init */
+
+
+int CppApplication::selectWait(struct timespec *timeout, fd_set *rd,
+                               fd_set *wr)
+{
+  *rd = rd_set;
+  *wr = wr_set;
+  int dcnt = pselect(max_desc, rd, wr, NULL, timeout, NULL);
+  if ((dcnt == -1) && (errno != EINTR) && (errno != EAGAIN))
+  {
+    perror("pselect");
+    exit(1);
+  }
+  return dcnt;
+} /* CppApplication::selectWait */
+
+
+void CppApplication::selectDispatch(int dcnt, fd_set *rd, fd_set *wr)
+{
+  WatchMap::iterator witer, next_witer;
+
+    /* Check for activity on the read watch file descriptors */
+  witer=rd_watch_map.begin();
+  while ((dcnt > 0) && (witer != rd_watch_map.end()))
+  {
+    next_witer = witer;
+    ++next_witer;
+    if (FD_ISSET(witer->first, rd))
+    {
+      if (witer->second != 0)
+      {
+        witer->second->activity(witer->second);
+      }
+      else
+      {
+        rd_watch_map.erase(witer);
+      }
+      --dcnt;
+    }
+    witer = next_witer;
+  }
+
+    /* Check for activity on the write watch file descriptors */
+  witer=wr_watch_map.begin();
+  while ((dcnt > 0) && (witer != wr_watch_map.end()))
+  {
+    next_witer = witer;
+    ++next_witer;
+    if (FD_ISSET(witer->first, wr))
+    {
+      if (witer->second != 0)
+      {
+        witer->second->activity(witer->second);
+      }
+      else
+      {
+        wr_watch_map.erase(witer);
+      }
+      --dcnt;
+    }
+    witer = next_witer;
+  }
+
+  assert(dcnt == 0);
+} /* CppApplication::selectDispatch */
+
+
+int CppApplication::epollWait(struct timespec *timeout)
+{
+  int timeout_ms = -1;
+  if (timeout == 0)
+  {
+    timerFdDisarm();
+  }
+  else if ((timeout->tv_sec == 0) && (timeout->tv_nsec == 0))
+  {
+    timeout_ms = 0;
+  }
+  else
+  {
+    timerFdArm();
+  }
+
+    // File descriptors that cannot be handled by epoll, like regular files,
+    // are always ready so we must not block if there are any such watches
+  if (!epoll_always_ready.empty())
+  {
+    timeout_ms = 0;
+  }
+
+  int dcnt = epoll_wait(epoll_fd, &epoll_events[0], epoll_events.size(),
+                        timeout_ms);
+  if (dcnt == -1)
+  {
+    if (errno != EINTR)
+    {
+      perror("epoll_wait");
+      exit(1);
+    }
+    return -1;
+  }
+
+    // The always ready descriptors are counted as active. The timer handling
+    // code in exec will then only expire timers that are actually due.
+  dcnt += epoll_always_ready.size();
+
+  return dcnt;
+} /* CppApplication::epollWait */
+
+
+void CppApplication::epollDispatch(int dcnt)
+{
+  if (dcnt <= 0)
+  {
+    return;
+  }
+
+  int epoll_cnt = dcnt - epoll_always_ready.size();
+  for (int i=0; i<epoll_cnt; ++i)
+  {
+    int fd = epoll_events[i].data.fd;
+    uint32_t events = epoll_events[i].events;
+    if (fd == timer_fd)
+    {
+      uint64_t expirations;
+      if ((read(timer_fd, &expirations, sizeof(expirations)) == -1) &&
+          (errno != EAGAIN))
+      {
+        perror("read(timerfd)");
+        exit(1);
+      }
+      timer_fd_armed = false;
+      continue;
+    }
+    FdWatch *watch = epoll_fds[fd].rd;
+    if ((watch != 0) && (events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+    {
+      watch->activity(watch);
+    }
+
+      // Look up the write watch after calling the read watch handler since
+      // the handler may have removed or replaced the watch
+    watch = epoll_fds[fd].wr;
+    if ((watch != 0) && (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)))
+    {
+      watch->activity(watch);
+    }
+  }
+
+  if ((epoll_cnt == static_cast<int>(epoll_events.size())) &&
+      (epoll_events.size() < epoll_fds.size()))
+  {
+    epoll_events.resize(2 * epoll_events.size());
+  }
+
+  if (!epoll_always_ready.empty())
+  {
+      // Copy the set since handlers may add or remove watches
+    std::vector<int> fds(epoll_always_ready.begin(), epoll_always_ready.end());
+    for (std::vector<int>::const_iterator it = fds.begin(); it != fds.end();
+         ++it)
+    {
+      FdWatch *watch = epoll_fds[*it].rd;
+      if (watch != 0)
+      {
+        watch->activity(watch);
+      }
+      watch = epoll_fds[*it].wr;
+      if (watch != 0)
+      {
+        watch->activity(watch);
+      }
+    }
+  }
+} /* CppApplication::epollDispatch */
+
+
+void CppApplication::epollUpdate(int fd)
+{
+  EpollFd &entry = epoll_fds[fd];
+
+  if ((entry.rd == 0) && (entry.wr == 0))
+  {
+    if (entry.registered)
+    {
+        // The file descriptor may already have been closed, in which case
+        // the kernel have already removed it from the epoll set
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+      entry.registered = false;
+    }
+    epoll_always_ready.erase(fd);
+    return;
+  }
+
+  if (epoll_always_ready.count(fd) > 0)
+  {
+    return;
+  }
+
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.data.fd = fd;
+  if (entry.rd != 0)
+  {
+    ev.events |= EPOLLIN;
+  }
+  if (entry.wr != 0)
+  {
+    ev.events |= EPOLLOUT;
+  }
+  if (m_backend == BACKEND_EPOLL_ET)
+  {
+    ev.events |= EPOLLET;
+  }
+
+  int op = entry.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  int ret = epoll_ctl(epoll_fd, op, fd, &ev);
+  if ((ret == -1) && (errno == ENOENT))
+  {
+      // The file descriptor have been closed and reopened behind our back
+    ret = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  }
+  else if ((ret == -1) && (errno == EEXIST))
+  {
+    ret = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+  }
+  if (ret == -1)
+  {
+    if (errno == EPERM)
+    {
+        // Regular files and directories are not supported by epoll. They are
+        // always ready for reading and writing, just like pselect report them.
+      epoll_always_ready.insert(fd);
+      entry.registered = false;
+      return;
+    }
+    perror("epoll_ctl");
+    exit(1);
+  }
+  entry.registered = true;
+} /* CppApplication::epollUpdate */
+
+
 void CppApplication::unixSignalHandler(int signum)
 {
   int cnt = write(sighandler_pipe[1], &signum, sizeof(signum));
@@ -421,6 +683,29 @@ void CppApplication::addFdWatch(FdWatch *fd_watch)
 {
   int fd = fd_watch->fd();
   //printf("Adding watch for fd=%d (max_desc=%d)\n", fd, max_desc);
+
+  if (m_backend != BACKEND_SELECT)
+  {
+    if (fd >= static_cast<int>(epoll_fds.size()))
+    {
+      epoll_fds.resize(std::max(static_cast<size_t>(fd + 1),
+                                2 * epoll_fds.size()));
+    }
+    FdWatch **watch = (fd_watch->type() == FdWatch::FD_WATCH_RD)
+      ? &epoll_fds[fd].rd : &epoll_fds[fd].wr;
+    assert(*watch == 0);
+    *watch = fd_watch;
+    epollUpdate(fd);
+    return;
+  }
+
+  if (fd >= FD_SETSIZE)
+  {
+    cerr << "*** ERROR: File descriptor " << fd << " is too large for the "
+            "pselect main loop backend. Use the epoll backend instead."
+         << endl;
+    exit(1);
+  }
   
   WatchMap *watch_map = 0;
   switch (fd_watch->type())
@@ -453,6 +738,18 @@ void CppApplication::addFdWatch(FdWatch *fd_watch)
 void CppApplication::delFdWatch(FdWatch *fd_watch)
 {
   int fd = fd_watch->fd();
+
+  if (m_backend != BACKEND_SELECT)
+  {
+    assert(fd < static_cast<int>(epoll_fds.size()));
+    FdWatch **watch = (fd_watch->type() == FdWatch::FD_WATCH_RD)
+      ? &epoll_fds[fd].rd : &epoll_fds[fd].wr;
+    assert(*watch == fd_watch);
+    *watch = 0;
+    epollUpdate(fd);
+    return;
+  }
+
   WatchMap *watch_map = 0;
   switch (fd_watch->type())
   {
@@ -510,6 +807,8 @@ void CppApplication::addTimer(Timer *timer)
 
 void CppApplication::addTimerP(Timer *timer, const struct timespec& current)
 {
+  assert(timer->m_queue_pos == static_cast<size_t>(-1));
+
   struct timespec add;
   struct timespec expiration;
   int timeout = timer->timeout();
@@ -518,23 +817,184 @@ void CppApplication::addTimerP(Timer *timer, const struct timespec& current)
   add.tv_nsec = timeout * 1000000;
   clock_timeradd(&current, &add, &expiration);
   
-  timer_map.insert(pair<struct timespec, Timer *>(expiration, timer));
+  TimerQueueItem item;
+  item.expiration = expiration;
+  item.seq = timer_seq++;
+  item.timer = timer;
+  timer->m_queue_pos = timer_queue.size();
+  timer_queue.push_back(item);
+  timerQueueSiftUp(timer_queue.size() - 1);
 } /* CppApplication::addTimerP */
 
 
 void CppApplication::delTimer(Timer *timer)
 {
-  TimerMap::iterator iter;
-  for (iter=timer_map.begin(); iter!=timer_map.end(); ++iter)
+  if (timer == expiring_timer)
+  {
+    expiring_timer = 0;
+  }
+  if (timer->m_queue_pos != static_cast<size_t>(-1))
+  {
+    timerQueueRemove(timer->m_queue_pos);
+  }
+} /* CppApplication::delTimer */
+
+
+void CppApplication::expireTimers(void)
+{
+  if (timer_queue.empty())
+  {
+    return;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // Expire all timers that are due. Timers that are added while handling
+    // the expired timers, including restarted periodic timers, are left for
+    // the next main loop iteration so that file descriptors are not starved.
+  unsigned long seq_limit = timer_seq;
+  while (!timer_queue.empty())
   {
-    if (iter->second == timer)
+    const TimerQueueItem& first = timer_queue.front();
+    if ((first.seq >= seq_limit) ||
+        (first.expiration.tv_sec > now.tv_sec) ||
+        ((first.expiration.tv_sec == now.tv_sec) &&
+         (first.expiration.tv_nsec > now.tv_nsec)))
     {
-      //timer_map.erase(iter);
-      iter->second = 0;
       break;
     }
+
+    Timer *timer = first.timer;
+    struct timespec expiration = first.expiration;
+    timerQueueRemove(0);
+
+      // The expiring_timer variable will be cleared if the timer is deleted
+      // or disabled by the expired signal handler
+    expiring_timer = timer;
+    timer->expired(timer);
+    if ((expiring_timer != 0) &&
+        (timer->type() == Timer::TYPE_PERIODIC) &&
+        (timer->m_queue_pos == static_cast<size_t>(-1)))
+    {
+      addTimerP(timer, expiration);
+    }
+    expiring_timer = 0;
   }
-} /* CppApplication::delTimer */
+} /* CppApplication::expireTimers */
+
+
+void CppApplication::timerQueueRemove(size_t pos)
+{
+  assert(pos < timer_queue.size());
+  timer_queue[pos].timer->m_queue_pos = static_cast<size_t>(-1);
+  if (pos + 1 < timer_queue.size())
+  {
+    timer_queue[pos] = timer_queue.back();
+    timer_queue[pos].timer->m_queue_pos = pos;
+    timer_queue.pop_back();
+    if ((pos > 0) && (timer_queue[pos] < timer_queue[(pos - 1) / 2]))
+    {
+      timerQueueSiftUp(pos);
+    }
+    else
+    {
+      timerQueueSiftDown(pos);
+    }
+  }
+  else
+  {
+    timer_queue.pop_back();
+  }
+} /* CppApplication::timerQueueRemove */
+
+
+void CppApplication::timerQueueSiftUp(size_t pos)
+{
+  TimerQueueItem item = timer_queue[pos];
+  while (pos > 0)
+  {
+    size_t parent = (pos - 1) / 2;
+    if (!(item < timer_queue[parent]))
+    {
+      break;
+    }
+    timer_queue[pos] = timer_queue[parent];
+    timer_queue[pos].timer->m_queue_pos = pos;
+    pos = parent;
+  }
+  timer_queue[pos] = item;
+  item.timer->m_queue_pos = pos;
+} /* CppApplication::timerQueueSiftUp */
+
+
+void CppApplication::timerQueueSiftDown(size_t pos)
+{
+  TimerQueueItem item = timer_queue[pos];
+  size_t size = timer_queue.size();
+  for (;;)
+  {
+    size_t child = 2 * pos + 1;
+    if (child >= size)
+    {
+      break;
+    }
+    if ((child + 1 < size) && (timer_queue[child + 1] < timer_queue[child]))
+    {
+      ++child;
+    }
+    if (!(timer_queue[child] < item))
+    {
+      break;
+    }
+    timer_queue[pos] = timer_queue[child];
+    timer_queue[pos].timer->m_queue_pos = pos;
+    pos = child;
+  }
+  timer_queue[pos] = item;
+  item.timer->m_queue_pos = pos;
+} /* CppApplication::timerQueueSiftDown */
+
+
+void CppApplication::timerFdArm(void)
+{
+  const struct timespec& expiration = timer_queue.front().expiration;
+  if (timer_fd_armed &&
+      (expiration.tv_sec == timer_fd_expiration.tv_sec) &&
+      (expiration.tv_nsec == timer_fd_expiration.tv_nsec))
+  {
+    return;
+  }
+
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  its.it_value = expiration;
+  if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+  {
+    perror("timerfd_settime");
+    exit(1);
+  }
+  timer_fd_armed = true;
+  timer_fd_expiration = expiration;
+} /* CppApplication::timerFdArm */
+
+
+void CppApplication::timerFdDisarm(void)
+{
+  if (!timer_fd_armed)
+  {
+    return;
+  }
+
+  struct itimerspec its;
+  memset(&its, 0, sizeof(its));
+  if (timerfd_settime(timer_fd, 0, &its, NULL) == -1)
+  {
+    perror("timerfd_settime");
+    exit(1);
+  }
+  timer_fd_armed = false;
+} /* CppApplication::timerFdDisarm */
 
 
 DnsLookupWorker *CppApplication::newDnsLookupWorker(const string& label)
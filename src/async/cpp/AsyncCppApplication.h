@@ -41,10 +41,13 @@
 #include <sys/types.h>
 #include <sys/select.h>
 #include <sys/time.h>
+#include <sys/epoll.h>
 #include <signal.h>
 #include <sigc++/sigc++.h>
 
 #include <map>
+#include <set>
+#include <vector>
 #include <utility>
 
 
@@ -132,15 +135,54 @@ namespace Async
 
 /**
 * @brief An application class for writing non GUI applications.
+*
+* The main loop can use one of two mechanisms to wait for file descriptor
+* activity. The classic pselect backend is limited to file descriptors below
+* FD_SETSIZE (normally 1024) and have to scan all watched file descriptors on
+* every wakeup. The epoll backend have no such limit and only visit the file
+* descriptors that actually are active so it scales much better for
+* applications with many connections, like the SvxReflector.
+*
+* The backend is selected when constructing the application object. It is
+* also possible to override the selection using the ASYNC_CPP_APP_BACKEND
+* environment variable which may be set to "select", "epoll" or "epoll-et".
 */
 class CppApplication : public Application
 {
   public:
+    /**
+     * @brief The type of backend to use for waiting on file descriptors
+     */
+    typedef enum
+    {
+      BACKEND_SELECT,   ///< Use pselect, limited to FD_SETSIZE descriptors
+      BACKEND_EPOLL,    ///< Use level triggered epoll
+      BACKEND_EPOLL_ET  ///< Use edge triggered epoll
+    } Backend;
+
     /**
      * @brief Constructor
+     *
+     * Create an application object using the pselect backend, unless
+     * overridden by the ASYNC_CPP_APP_BACKEND environment variable.
      */
     CppApplication(void);
 
+    /**
+     * @brief Constructor
+     * @param backend The file descriptor backend to use
+     *
+     * Create an application object using the given backend. The
+     * ASYNC_CPP_APP_BACKEND environment variable will override the selection.
+     *
+     * NOTE: The edge triggered epoll backend (BACKEND_EPOLL_ET) will only
+     * report activity once for each change in state on a file descriptor.
+     * All FdWatch handlers in the application must then read/write until the
+     * operation would block, or else events will be lost. Most applications
+     * should use the level triggered variant (BACKEND_EPOLL).
+     */
+    explicit CppApplication(Backend backend);
+
     /**
      * @brief Destructor
      */
@@ -174,6 +216,12 @@ class CppApplication : public Application
      */
     void quit(void);
 
+    /**
+     * @brief   Get the file descriptor backend in use
+     * @return  Returns the backend used by the main loop
+     */
+    Backend backend(void) const { return m_backend; }
+
     /**
      * @brief   A signal that is emitted when a monitored UNIX signal is caught
      * @param   signum The signal number that was caught
@@ -187,34 +235,75 @@ class CppApplication : public Application
   protected:
     
   private:
-    struct lttimespec
+    struct TimerQueueItem
     {
-      bool operator()(const struct timespec& t1, const struct timespec& t2) const
+      struct timespec expiration;
+      unsigned long   seq;
+      Timer           *timer;
+      bool operator<(const TimerQueueItem& rhs) const
       {
-        return ((t1.tv_sec == t2.tv_sec)
-                ? (t1.tv_nsec < t2.tv_nsec)
-                : (t1.tv_sec < t2.tv_sec));
+        if (expiration.tv_sec != rhs.expiration.tv_sec)
+        {
+          return expiration.tv_sec < rhs.expiration.tv_sec;
+        }
+        if (expiration.tv_nsec != rhs.expiration.tv_nsec)
+        {
+          return expiration.tv_nsec < rhs.expiration.tv_nsec;
+        }
+        return seq < rhs.seq;
       }
     };
     typedef std::map<int, FdWatch*>   	      	      	        WatchMap;
-    typedef std::multimap<struct timespec, Timer *, lttimespec> TimerMap;
+    typedef std::vector<TimerQueueItem>                         TimerQueue;
     typedef std::map<int, struct sigaction>                     UnixSignalMap;
+    struct EpollFd
+    {
+      FdWatch *rd;
+      FdWatch *wr;
+      bool    registered;
+      EpollFd(void) : rd(0), wr(0), registered(false) {}
+    };
+    typedef std::vector<EpollFd>                                EpollFdTable;
+    typedef std::set<int>                                       FdSet;
     
     static int          sighandler_pipe[2];
 
+    Backend             m_backend;
     bool      	      	do_quit;
     int       	      	max_desc;
     fd_set    	      	rd_set;
     fd_set    	      	wr_set;
     WatchMap  	      	rd_watch_map;
     WatchMap  	      	wr_watch_map;
-    TimerMap  	      	timer_map;
+    TimerQueue          timer_queue;
+    unsigned long       timer_seq;
+    Timer               *expiring_timer;
+    int                 timer_fd;
+    bool                timer_fd_armed;
+    struct timespec     timer_fd_expiration;
     UnixSignalMap       unix_signals;
     int                 unix_signal_recv;
     size_t              unix_signal_recv_cnt;
+    int                 epoll_fd;
+    EpollFdTable        epoll_fds;
+    FdSet               epoll_always_ready;
+    std::vector<struct epoll_event> epoll_events;
     
     static void unixSignalHandler(int signum);
 
+    void init(Backend backend);
+    int selectWait(struct timespec *timeout, fd_set *rd, fd_set *wr);
+    void selectDispatch(int dcnt, fd_set *rd, fd_set *wr);
+    int epollWait(struct timespec *timeout);
+    void epollDispatch(int dcnt);
+    void epollUpdate(int fd);
+    void expireTimers(void);
+    void timerQueueRemove(size_t pos);
+    void timerQueueSiftUp(size_t pos);
+    void timerQueueSiftDown(size_t pos);
+    void timerFdArm(void);
+    void timerFdDisarm(void);
+
     void addFdWatch(FdWatch *fd_watch);
     void delFdWatch(FdWatch *fd_watch);
     void addTimer(Timer *timer);
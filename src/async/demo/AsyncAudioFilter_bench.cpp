@@ -0,0 +1,198 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include "../audio/fidlib.h"
+};
+
+#include <AsyncAudioFilter.h>
+#include <AsyncBiquadCascade.h>
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the AudioFilter class, which run fidlib filter designs as a
+  // cascade of second order sections, against running the same filters
+  // through the fidlib interpreter. The largest difference between the
+  // output of the two is printed for each filter as a sanity check. The
+  // throughput of a four channel cascade is also measured, counting the
+  // samples for all channels.
+  //
+  // Usage: AsyncAudioFilter_bench [seconds of audio]
+
+namespace {
+  const int RATE = 16000;
+  const int BLOCKSIZE = 256;
+
+    // Filter specifications used in the SvxLink tree
+  const char *specs[] = {
+    "BpCh12/-0.1/300-5000", "BpCh12/-0.1/300-3500", "LpCh9/-0.05/5000",
+    "LpCh9/-0.05/3500", "LpBu1/3000 x HpBu1/3000", "LpBu3/5500 x HpBu1/3000",
+    "LpCh9/-0.05/5500", "LpBu20/3500", "LpCh9/-0.05/5500 x HpCh12/-0.05/300",
+    "LpBu20/3500 x HpCh12/-0.05/300", "LpCh10/-0.5/4500", "BpBu8/5400-6500",
+    "BpBu4/5000-5500", "HpBu4/3500", "BpBu8/60-260", "BpCh10/-0.1/300-5000",
+    "BpBu4/300-4300 x 17.0777 -15.1778 / 1 0.9",
+    "0.0585559 0.0527003 / 1 -0.888744",
+    0
+  };
+
+  class BenchFilter : public AudioFilter
+  {
+    public:
+      BenchFilter(const string &spec) : AudioFilter(spec, RATE) {}
+      using AudioFilter::processSamples;
+  };
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+
+  double fidlibRun(const char *spec_str, const vector<float>& in,
+                   vector<float>& out)
+  {
+    char spec_buf[256];
+    snprintf(spec_buf, sizeof(spec_buf), "%s", spec_str);
+    char *spec = spec_buf;
+    FidFilter *ff;
+    char *err = fid_parse(RATE, &spec, &ff);
+    if (err != 0)
+    {
+      cerr << "*** ERROR: " << err << endl;
+      exit(1);
+    }
+    FidFunc *func;
+    FidRun *run = fid_run_new(ff, &func);
+    void *buf = fid_run_newbuf(run);
+    double start = now();
+    for (size_t i=0; i<in.size(); ++i)
+    {
+      out[i] = func(buf, in[i]);
+    }
+    double elapsed = now() - start;
+    fid_run_freebuf(buf);
+    fid_run_free(run);
+    free(ff);
+    return elapsed;
+  }
+
+  bool buildMultiChannel(const char *spec_str, BiquadCascade<double>& cascade)
+  {
+    char spec_buf[256];
+    snprintf(spec_buf, sizeof(spec_buf), "%s", spec_str);
+    char *spec = spec_buf;
+    FidFilter *ff;
+    free(fid_parse(RATE, &spec, &ff));
+    double gain = 1.0;
+    bool ok = true;
+    for (FidFilter *f=ff; ok && (f->len!=0); f=FFNEXT(f))
+    {
+      FidFilter *next = FFNEXT(f);
+      if ((f->typ == 'F') && (f->len == 1))
+      {
+        gain *= f->val[0];
+      }
+      else if ((f->typ == 'I') && (f->len == 3) && (next->typ == 'F') &&
+               (next->len == 3))
+      {
+        cascade.addSection(next->val[0], next->val[1], next->val[2],
+                           f->val[1] / f->val[0], f->val[2] / f->val[0]);
+        gain /= f->val[0];
+        f = next;
+      }
+      else
+      {
+        ok = false;
+      }
+    }
+    free(ff);
+    cascade.setGain(gain);
+    return ok;
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  double seconds = (argc > 1) ? atof(argv[1]) : 60.0;
+  if (seconds <= 0.0)
+  {
+    cerr << "Usage: " << argv[0] << " [seconds of audio]\n";
+    exit(1);
+  }
+
+  size_t count = static_cast<size_t>(RATE * seconds);
+  count -= count % BLOCKSIZE;
+  vector<float> in(count);
+  for (size_t i=0; i<count; ++i)
+  {
+    in[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+  }
+  vector<float> ref_out(count);
+  vector<float> out(count);
+  vector<float> multi(4 * count);
+
+  printf("%-42s %10s %10s %10s %9s\n", "Filter", "fidlib", "cascade",
+         "4 chan", "max diff");
+  for (const char **spec=specs; *spec!=0; ++spec)
+  {
+    double ref_time = fidlibRun(*spec, in, ref_out);
+
+    BenchFilter filter(*spec);
+    double start = now();
+    for (size_t pos=0; pos<count; pos+=BLOCKSIZE)
+    {
+      filter.processSamples(&out[pos], &in[pos], BLOCKSIZE);
+    }
+    double time = now() - start;
+
+    float max_diff = 0.0f;
+    for (size_t i=0; i<count; ++i)
+    {
+      max_diff = max(max_diff, fabsf(out[i] - ref_out[i]));
+    }
+
+      // Run a four channel version of the same cascade, if it consist of
+      // second order sections only. The channels get time shifted copies of
+      // the same signal.
+    double multi_time = 0.0;
+    BiquadCascade<double> cascade(4);
+    if (buildMultiChannel(*spec, cascade))
+    {
+      for (size_t i=0; i<count; ++i)
+      {
+        for (size_t ch=0; ch<4; ++ch)
+        {
+          multi[4 * i + ch] = in[(i + ch) % count];
+        }
+      }
+      start = now();
+      for (size_t pos=0; pos<count; pos+=BLOCKSIZE)
+      {
+        cascade.process(&multi[4 * pos], &multi[4 * pos], BLOCKSIZE);
+      }
+      multi_time = now() - start;
+    }
+
+    printf("%-42s %7.1f Ms %7.1f Ms ", *spec, count / ref_time / 1.0e6,
+           count / time / 1.0e6);
+    if (multi_time > 0.0)
+    {
+      printf("%7.1f Ms ", 4 * count / multi_time / 1.0e6);
+    }
+    else
+    {
+      printf("%10s ", "-");
+    }
+    printf("%9.2g\n", max_diff);
+  }
+
+  return 0;
+}
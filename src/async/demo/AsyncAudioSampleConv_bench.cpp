@@ -0,0 +1,166 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <AsyncAudioSampleConv.h>
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the sample conversions used by the audio devices against the
+  // plain per sample loops that the audio device previously used. Blocks of
+  // interleaved 16 bit samples are converted to per channel float buffers
+  // (capture) and back again (playback) for one, two and eight channel
+  // layouts. The throughput is given in million frames per second. The
+  // number of samples that differ from the plain loops is printed as a
+  // sanity check.
+  //
+  // Usage: AsyncAudioSampleConv_bench [seconds of audio]
+
+namespace {
+  const int RATE = 16000;
+  const int BLOCKSIZE = 256;
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+
+  void refS16ToFloat(float *const *dst, const int16_t *src, int channels,
+                     int frames)
+  {
+    for (int ch=0; ch<channels; ch++)
+    {
+      for (int i=0; i<frames; i++)
+      {
+        dst[ch][i] = static_cast<float>(src[i * channels + ch]) / 32768.0;
+      }
+    }
+  }
+
+  void refFloatToS16(int16_t *dst, const float *const *src, int channels,
+                     int frames)
+  {
+    for (int ch=0; ch<channels; ch++)
+    {
+      for (int i=0; i<frames; ++i)
+      {
+        int buf_pos = i * channels + ch;
+        float sample = 32767.0 * src[ch][i];
+        if (sample > 32767)
+        {
+          dst[buf_pos] = 32767;
+        }
+        else if (sample < -32767)
+        {
+          dst[buf_pos] = -32767;
+        }
+        else
+        {
+          dst[buf_pos] = static_cast<int16_t>(sample);
+        }
+      }
+    }
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  double seconds = (argc > 1) ? atof(argv[1]) : 600.0;
+  if (seconds <= 0.0)
+  {
+    cerr << "Usage: " << argv[0] << " [seconds of audio]\n";
+    exit(1);
+  }
+  size_t blocks = static_cast<size_t>(RATE * seconds / BLOCKSIZE);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+  printf("CPU support AVX2: %s\n\n",
+         __builtin_cpu_supports("avx2") ? "yes" : "no");
+#endif
+
+  printf("%-9s %12s %12s %12s %12s %6s\n", "Channels", "s16->f ref",
+         "s16->f", "f->s16 ref", "f->s16", "diffs");
+  const int layouts[] = { 1, 2, 8 };
+  for (size_t l=0; l<sizeof(layouts)/sizeof(*layouts); ++l)
+  {
+    int channels = layouts[l];
+    vector<int16_t> in(channels * BLOCKSIZE);
+    for (size_t i=0; i<in.size(); ++i)
+    {
+      in[i] = rand() % 65536 - 32768;
+    }
+    vector<float> planar(channels * BLOCKSIZE);
+    vector<float*> chan(channels);
+    for (int ch=0; ch<channels; ++ch)
+    {
+      chan[ch] = &planar[ch * BLOCKSIZE];
+    }
+    vector<int16_t> out(channels * BLOCKSIZE);
+    vector<int16_t> ref_out(channels * BLOCKSIZE);
+
+      // Check that the result is the same as for the plain loops. Samples
+      // outside of the [-1.0, 1.0] range are used to check the saturation.
+    int diffs = 0;
+    vector<float> ref_planar(planar.size());
+    vector<float*> ref_chan(channels);
+    for (int ch=0; ch<channels; ++ch)
+    {
+      ref_chan[ch] = &ref_planar[ch * BLOCKSIZE];
+    }
+    refS16ToFloat(&ref_chan[0], &in[0], channels, BLOCKSIZE);
+    AudioSampleConv::s16ToFloat(&chan[0], &in[0], channels, BLOCKSIZE);
+    for (size_t i=0; i<planar.size(); ++i)
+    {
+      diffs += (planar[i] != ref_planar[i]);
+      planar[i] *= 1.5f;
+    }
+    refFloatToS16(&ref_out[0], &chan[0], channels, BLOCKSIZE);
+    AudioSampleConv::floatToS16(&out[0], &chan[0], channels, BLOCKSIZE);
+    for (size_t i=0; i<out.size(); ++i)
+    {
+      diffs += (out[i] != ref_out[i]);
+    }
+
+    double start = now();
+    for (size_t b=0; b<blocks; ++b)
+    {
+      refS16ToFloat(&chan[0], &in[0], channels, BLOCKSIZE);
+    }
+    double ref_to_float = now() - start;
+
+    start = now();
+    for (size_t b=0; b<blocks; ++b)
+    {
+      AudioSampleConv::s16ToFloat(&chan[0], &in[0], channels, BLOCKSIZE);
+    }
+    double to_float = now() - start;
+
+    start = now();
+    for (size_t b=0; b<blocks; ++b)
+    {
+      refFloatToS16(&out[0], &chan[0], channels, BLOCKSIZE);
+    }
+    double ref_to_s16 = now() - start;
+
+    start = now();
+    for (size_t b=0; b<blocks; ++b)
+    {
+      AudioSampleConv::floatToS16(&out[0], &chan[0], channels, BLOCKSIZE);
+    }
+    double to_s16 = now() - start;
+
+    double frames = static_cast<double>(blocks) * BLOCKSIZE / 1.0e6;
+    printf("%-9d %9.1f Mf %9.1f Mf %9.1f Mf %9.1f Mf %6d\n", channels,
+           frames / ref_to_float, frames / to_float, frames / ref_to_s16,
+           frames / to_s16, diffs);
+  }
+
+  return 0;
+}
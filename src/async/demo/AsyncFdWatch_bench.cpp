@@ -0,0 +1,220 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <AsyncCppApplication.h>
+#include <AsyncFdWatch.h>
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the file descriptor handling in the CppApplication main loop.
+  // A number of UDP sockets are bound to the loopback interface and watched
+  // for incoming data. In each round a datagram is sent to a subset of the
+  // sockets and the round is finished when all of them have been handled.
+  //
+  // Usage: AsyncFdWatch_bench <select|epoll|epoll-et> [watches] [active]
+  //                           [rounds]
+class FdWatchBench : public sigc::trackable
+{
+  public:
+    FdWatchBench(int num_watches, int active, int rounds)
+      : active(active), rounds(rounds), round(0), pending(0), next_idx(0),
+        wakeups(0)
+    {
+      tx_sock = socket(AF_INET, SOCK_DGRAM, 0);
+      if (tx_sock == -1)
+      {
+        perror("socket");
+        exit(1);
+      }
+
+      for (int i=0; i<num_watches; ++i)
+      {
+        int sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock == -1)
+        {
+          perror("socket");
+          exit(1);
+        }
+        fcntl(sock, F_SETFL, O_NONBLOCK);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        socklen_t addrlen = sizeof(addr);
+        if ((bind(sock, reinterpret_cast<struct sockaddr*>(&addr),
+                  sizeof(addr)) == -1) ||
+            (getsockname(sock, reinterpret_cast<struct sockaddr*>(&addr),
+                         &addrlen) == -1))
+        {
+          perror("bind");
+          exit(1);
+        }
+        socks.push_back(sock);
+        addrs.push_back(addr);
+        FdWatch *watch = new FdWatch(sock, FdWatch::FD_WATCH_RD);
+        watch->activity.connect(mem_fun(*this, &FdWatchBench::onActivity));
+        watches.push_back(watch);
+      }
+    }
+
+    ~FdWatchBench(void)
+    {
+      for (size_t i=0; i<watches.size(); ++i)
+      {
+        delete watches[i];
+        close(socks[i]);
+      }
+      close(tx_sock);
+    }
+
+    void start(void)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start_time);
+      getrusage(RUSAGE_SELF, &start_usage);
+      sendRound();
+    }
+
+    void report(const char *backend)
+    {
+      struct timespec end_time;
+      clock_gettime(CLOCK_MONOTONIC, &end_time);
+      struct rusage end_usage;
+      getrusage(RUSAGE_SELF, &end_usage);
+
+      double wall = (end_time.tv_sec - start_time.tv_sec) +
+                    (end_time.tv_nsec - start_time.tv_nsec) / 1.0e9;
+      double cpu =
+        (end_usage.ru_utime.tv_sec - start_usage.ru_utime.tv_sec) +
+        (end_usage.ru_stime.tv_sec - start_usage.ru_stime.tv_sec) +
+        ((end_usage.ru_utime.tv_usec - start_usage.ru_utime.tv_usec) +
+         (end_usage.ru_stime.tv_usec - start_usage.ru_stime.tv_usec)) / 1.0e6;
+      printf("%-8s watches=%-6zu active=%-5d rounds=%-6d wall=%.3fs "
+             "cpu=%.3fs rounds/s=%.0f us/event=%.2f\n",
+             backend, watches.size(), active, rounds, wall, cpu,
+             rounds / wall, 1.0e6 * wall / wakeups);
+    }
+
+  private:
+    int                         tx_sock;
+    std::vector<int>            socks;
+    std::vector<sockaddr_in>    addrs;
+    std::vector<FdWatch*>       watches;
+    int                         active;
+    int                         rounds;
+    int                         round;
+    int                         pending;
+    size_t                      next_idx;
+    unsigned long               wakeups;
+    struct timespec             start_time;
+    struct rusage               start_usage;
+
+    void sendRound(void)
+    {
+      if (round++ == rounds)
+      {
+        Application::app().quit();
+        return;
+      }
+
+        // Spread the active sockets over the whole set of watches
+      for (int i=0; i<active; ++i)
+      {
+        next_idx = (next_idx + 7919) % socks.size();
+        char byte = 0;
+        if (sendto(tx_sock, &byte, sizeof(byte), 0,
+                   reinterpret_cast<struct sockaddr*>(&addrs[next_idx]),
+                   sizeof(addrs[next_idx])) == -1)
+        {
+          perror("sendto");
+          exit(1);
+        }
+        ++pending;
+      }
+    }
+
+    void onActivity(FdWatch *watch)
+    {
+      char buf[16];
+      while (recv(watch->fd(), buf, sizeof(buf), 0) > 0)
+      {
+        ++wakeups;
+        if (--pending == 0)
+        {
+          sendRound();
+        }
+      }
+    }
+};
+
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    cerr << "Usage: " << argv[0]
+         << " <select|epoll|epoll-et> [watches] [active] [rounds]\n";
+    exit(1);
+  }
+
+  CppApplication::Backend backend = CppApplication::BACKEND_SELECT;
+  if (strcmp(argv[1], "epoll") == 0)
+  {
+    backend = CppApplication::BACKEND_EPOLL;
+  }
+  else if (strcmp(argv[1], "epoll-et") == 0)
+  {
+    backend = CppApplication::BACKEND_EPOLL_ET;
+  }
+  else if (strcmp(argv[1], "select") != 0)
+  {
+    cerr << "*** ERROR: Unknown backend " << argv[1] << endl;
+    exit(1);
+  }
+  int num_watches = (argc > 2) ? atoi(argv[2]) : 1000;
+  int active = (argc > 3) ? atoi(argv[3]) : 10;
+  int rounds = (argc > 4) ? atoi(argv[4]) : 10000;
+  if ((num_watches <= 0) || (active <= 0) || (active > num_watches))
+  {
+    cerr << "*** ERROR: Bad number of watches or active watches\n";
+    exit(1);
+  }
+
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0)
+  {
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+  }
+  if ((backend == CppApplication::BACKEND_SELECT) &&
+      (num_watches + 10 > FD_SETSIZE))
+  {
+    cerr << "*** ERROR: The select backend can handle at most "
+         << FD_SETSIZE << " file descriptors\n";
+    exit(1);
+  }
+
+  CppApplication app(backend);
+  FdWatchBench bench(num_watches, active, rounds);
+  bench.start();
+  app.exec();
+  bench.report((app.backend() == CppApplication::BACKEND_SELECT) ? "select" :
+               (app.backend() == CppApplication::BACKEND_EPOLL) ? "epoll" :
+               "epoll-et");
+
+  return 0;
+}
+
@@ -0,0 +1,143 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <AsyncCppApplication.h>
+#include <AsyncTimer.h>
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the timer handling in the CppApplication main loop. A large
+  // number of timers are armed, restarted and cancelled and then a batch of
+  // timers are left to expire through the main loop.
+  //
+  // Usage: AsyncTimer_bench [select|epoll] [timers]
+class TimerBench : public sigc::trackable
+{
+  public:
+    TimerBench(size_t num_timers)
+      : expire_cnt(0), rnd(1)
+    {
+      timers.reserve(num_timers);
+      for (size_t i=0; i<num_timers; ++i)
+      {
+        Timer *timer = new Timer(0, Timer::TYPE_ONESHOT, false);
+        timer->expired.connect(mem_fun(*this, &TimerBench::onExpired));
+        timers.push_back(timer);
+      }
+    }
+
+    ~TimerBench(void)
+    {
+      for (size_t i=0; i<timers.size(); ++i)
+      {
+        delete timers[i];
+      }
+    }
+
+    void run(void)
+    {
+      size_t n = timers.size();
+
+      startClock();
+      for (size_t i=0; i<n; ++i)
+      {
+        timers[i]->setTimeout(1000 + nextRandom() % 600000);
+        timers[i]->setEnable(true);
+      }
+      stopClock("arm", n);
+
+      startClock();
+      for (size_t i=0; i<n; ++i)
+      {
+        timers[i]->reset();
+      }
+      stopClock("reset", n);
+
+      startClock();
+      for (size_t i=0; i<n; ++i)
+      {
+        timers[i]->setEnable(false);
+      }
+      stopClock("cancel", n);
+
+        // Arm all timers to expire within 100ms and let the main loop handle
+        // the expirations
+      for (size_t i=0; i<n; ++i)
+      {
+        timers[i]->setTimeout(nextRandom() % 100);
+        timers[i]->setEnable(true);
+      }
+      startClock();
+      Application::app().exec();
+      stopClock("expire", n);
+    }
+
+  private:
+    std::vector<Timer*> timers;
+    size_t              expire_cnt;
+    unsigned            rnd;
+    struct timespec     start;
+
+    unsigned nextRandom(void)
+    {
+      rnd = rnd * 1103515245 + 12345;
+      return rnd >> 8;
+    }
+
+    void startClock(void)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
+    void stopClock(const char *what, size_t cnt)
+    {
+      struct timespec end;
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      double elapsed = (end.tv_sec - start.tv_sec) +
+                       (end.tv_nsec - start.tv_nsec) / 1.0e9;
+      printf("%-8s %8zu timers %10.3f ms %10.1f ns/timer\n",
+             what, cnt, 1000.0 * elapsed, 1.0e9 * elapsed / cnt);
+    }
+
+    void onExpired(Timer *timer)
+    {
+      if (++expire_cnt == timers.size())
+      {
+        Application::app().quit();
+      }
+    }
+};
+
+
+int main(int argc, char **argv)
+{
+  CppApplication::Backend backend = CppApplication::BACKEND_SELECT;
+  if ((argc > 1) && (strcmp(argv[1], "epoll") == 0))
+  {
+    backend = CppApplication::BACKEND_EPOLL;
+  }
+  else if ((argc > 1) && (strcmp(argv[1], "select") != 0))
+  {
+    cerr << "Usage: " << argv[0] << " [select|epoll] [timers]\n";
+    exit(1);
+  }
+  size_t num_timers = (argc > 2) ? atol(argv[2]) : 1000000;
+  if (num_timers == 0)
+  {
+    cerr << "*** ERROR: Bad number of timers\n";
+    exit(1);
+  }
+
+  CppApplication app(backend);
+  TimerBench bench(num_timers);
+  bench.run();
+
+  return 0;
+}
+
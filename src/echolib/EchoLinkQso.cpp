@@ -39,6 +39,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <stdint.h>
 
 #ifdef SPEEX_MAJOR
 #include <speex/speex.h>
@@ -51,6 +52,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include <AsyncAudioEncoderThreaded.h>
+#include <AsyncSigCAudioSource.h>
 
 
 /****************************************************************************
@@ -63,6 +66,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "rtpacket.h"
 #include "EchoLinkDispatcher.h"
 #include "EchoLinkQso.h"
+#include "EchoLinkVoicePacketEncoder.h"
 
 
 
@@ -104,17 +108,20 @@ struct Qso::Private
 
   Codec     remote_codec;
 #ifdef SPEEX_MAJOR
-  SpeexBits enc_bits;
   SpeexBits dec_bits;
-  void *    enc_state;
   void *    dec_state;
 #endif
+  bool            threaded_codec;
+  SigCAudioSource enc_feed;
+  AudioEncoder *  enc;
+  VoicePacketEncoder *transcoder;
 
   Private(void)
     : remote_codec(CODEC_GSM)
 #if SPEEX_MAJOR
-      , enc_bits(), dec_bits(), enc_state(0), dec_state(0)
+      , dec_bits(), dec_state(0)
 #endif
+      , threaded_codec(false), enc(0), transcoder(0)
   {}
 };
 
@@ -156,7 +163,7 @@ Qso::Qso(const IpAddress& addr, const string& callsign, const string& name,
   : init_ok(false), sdes_length(0), state(STATE_DISCONNECTED), gsmh(0),
     next_audio_seq(0), keep_alive_timer(0), connect_retry_cnt(0),
     con_timeout_timer(0), callsign(callsign), name(name), local_stn_info(info),
-    send_buffer_cnt(0), remote_ip(addr), rx_indicator_timer(0),
+    remote_ip(addr), rx_indicator_timer(0),
     remote_name("?"), remote_call("?"), is_remote_initiated(false),
     receiving_audio(false), use_gsm_only(false), p(new Private),
     rx_timeout_left(0)
@@ -172,19 +179,15 @@ Qso::Qso(const IpAddress& addr, const string& callsign, const string& name,
   gsmh = gsm_create();
 
 #ifdef SPEEX_MAJOR
-  speex_bits_init(&p->enc_bits);
   speex_bits_init(&p->dec_bits);
-    
-  p->enc_state = speex_encoder_init(&speex_nb_mode);
   p->dec_state = speex_decoder_init(&speex_nb_mode);
-
-  int val = 25000;
-  speex_encoder_ctl(p->enc_state, SPEEX_SET_BITRATE, &val);
-  val = 8;
-  speex_encoder_ctl(p->enc_state, SPEEX_SET_QUALITY, &val);
-  val = 4;
-  speex_encoder_ctl(p->enc_state, SPEEX_SET_COMPLEXITY, &val);
 #endif
+
+  p->enc_feed.sigResumeOutput.connect(
+      mem_fun(*this, &Qso::sourceResumeOutput));
+  p->enc_feed.sigAllSamplesFlushed.connect(
+      mem_fun(*this, &Qso::sourceAllSamplesFlushed));
+  createEncoders();
     
   if (!Dispatcher::instance()->registerConnection(this, &Qso::handleCtrlInput,
       &Qso::handleAudioInput))
@@ -208,13 +211,14 @@ Qso::~Qso(void)
   gsmh = 0;
 
 #ifdef SPEEX_MAJOR
-  speex_bits_destroy(&p->enc_bits);
   speex_bits_destroy(&p->dec_bits);
-
-  speex_encoder_destroy(p->enc_state);
   speex_decoder_destroy(p->dec_state);
 #endif
   
+  p->enc_feed.unregisterSink();
+  delete p->enc;
+  delete p->transcoder;
+
   if (init_ok)
   {
     Dispatcher::instance()->unregisterConnection(this);
@@ -402,28 +406,9 @@ bool Qso::sendAudioRaw(RawPacket *raw_packet)
   if ((raw_packet->voice_packet->header.pt == 0x96) &&
       (p->remote_codec == Private::CODEC_GSM))
   {
-    // transcode SPEEX -> GSM
-    VoicePacket voice_packet;
-    size_t nbytes = 0;
-    
-    for(int i=0; i<FRAME_COUNT; i++)
-    {
-      gsm_encode(gsmh, raw_packet->samples + i*160, voice_packet.data + i*33);
-      nbytes += 33;
-    }
-    voice_packet.header.version = 0xc0;
-    voice_packet.header.pt = 0x03;
-    voice_packet.header.time = htonl(0);
-    voice_packet.header.ssrc = htonl(0);
-    voice_packet.header.seqNum = htons(next_audio_seq++);
-    
-    bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &voice_packet,
-        nbytes + sizeof(voice_packet.header));
-    if (!success)
-    {
-      perror("sendAudioMsg in Qso::sendAudioRaw");
-      return false;
-    }
+      // Transcode SPEEX -> GSM
+    return p->transcoder->writeRawSamples(raw_packet->samples,
+                                          BUFFER_SIZE) == BUFFER_SIZE;
   }
   else
 #endif
@@ -444,6 +429,47 @@ bool Qso::sendAudioRaw(RawPacket *raw_packet)
 } /* Qso::sendAudioRaw */
 
 
+bool Qso::sendEncodedAudio(const void *buf, int size)
+{
+  if (state != STATE_CONNECTED)
+  {
+    return false;
+  }
+
+  VoicePacket voice_packet;
+  if ((size <= static_cast<int>(sizeof(voice_packet.header))) ||
+      (size > static_cast<int>(sizeof(voice_packet))))
+  {
+    return false;
+  }
+  memcpy(&voice_packet, buf, size);
+  voice_packet.header.seqNum = htons(next_audio_seq++);
+
+  bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &voice_packet,
+      size);
+  if (!success)
+  {
+    perror("sendAudioMsg in Qso::sendEncodedAudio");
+    return false;
+  }
+
+  return true;
+
+} /* Qso::sendEncodedAudio */
+
+
+const char *Qso::audioCodec(void) const
+{
+#ifdef SPEEX_MAJOR
+  if (p->remote_codec == Private::CODEC_SPEEX)
+  {
+    return "SPEEX";
+  }
+#endif
+  return "GSM";
+} /* Qso::audioCodec */
+
+
 void Qso::setRemoteParams(const string& priv)
 {
 #ifdef SPEEX_MAJOR  
@@ -453,6 +479,7 @@ void Qso::setRemoteParams(const string& priv)
   {
     cerr << "Switching to SPEEX audio codec for EchoLink Qso." << endl;
     p->remote_codec = Private::CODEC_SPEEX;
+    p->enc->setOption("CODEC", "SPEEX");
   }
 #endif
 } /* Qso::setRemoteParams */
@@ -460,47 +487,12 @@ void Qso::setRemoteParams(const string& priv)
 
 int Qso::writeSamples(const float *samples, int count)
 {
-  int samples_read = 0;
-  
   if (state != STATE_CONNECTED)
   {
     return count;
   }
-  
-  while (samples_read < count)
-  {
-    int read_cnt = min(BUFFER_SIZE - send_buffer_cnt, count-samples_read);
-    for (int i=0; i<read_cnt; ++i)
-    {
-      float sample = samples[samples_read++];
-      if (sample > 1)
-      {
-      	send_buffer[send_buffer_cnt++] = 32767;
-      }
-      else if (sample < -1)
-      {
-      	send_buffer[send_buffer_cnt++] = -32767;
-      }
-      else
-      {
-      	send_buffer[send_buffer_cnt++] = static_cast<int16_t>(32767.0 * sample);
-      }
-    }
-    
-    if (send_buffer_cnt == BUFFER_SIZE)
-    {
-      bool packet_sent = sendVoicePacket();
-      if (!packet_sent)
-      {
-	break;
-      }
-      send_buffer_cnt = 0;
-    }
-  }
-  
-  //printf("Samples read = %d\n", samples_read);
-  
-  return samples_read;
+
+  return p->enc_feed.writeSamples(const_cast<float *>(samples), count);
   
 } /* Qso::writeSamples */
 
@@ -509,14 +501,9 @@ void Qso::flushSamples(void)
 {
   if (state == STATE_CONNECTED)
   {
-    if (send_buffer_cnt > 0)
-    {
-      memset(send_buffer + send_buffer_cnt, 0,
-	  sizeof(send_buffer) - sizeof(*send_buffer) * send_buffer_cnt);
-      send_buffer_cnt = BUFFER_SIZE;
-      sendVoicePacket();
-      send_buffer_cnt = 0;
-    }
+      // Flushed when the encoder has sent all packets
+    p->enc_feed.flushSamples();
+    return;
   }
   
   sourceAllSamplesFlushed();
@@ -535,6 +522,17 @@ void Qso::setUseGsmOnly(void)
 } /* Qso::setGsmCodec */
 
 
+void Qso::setThreadedCodec(bool enable)
+{
+  if (enable == p->threaded_codec)
+  {
+    return;
+  }
+  p->threaded_codec = enable;
+  createEncoders();
+} /* Qso::setThreadedCodec */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -921,7 +919,7 @@ void Qso::connectionTimeout(Timer *timer)
 
 bool Qso::setupConnection(void)
 {
-  send_buffer_cnt = 0;
+  createEncoders();
   
   bool send_sdes_ok = sendSdesPacket();
   if (send_sdes_ok)
@@ -955,60 +953,28 @@ void Qso::cleanupConnection(void)
 } /* Qso::cleanupConnection */
 
 
-bool Qso::sendVoicePacket(void)
+void Qso::createEncoders(void)
 {
-  assert(send_buffer_cnt == BUFFER_SIZE);
-
-  size_t nbytes = 0;
-  VoicePacket voice_packet;
-  voice_packet.header.version = 0xc0;
-  voice_packet.header.time = htonl(0);
-  voice_packet.header.ssrc = htonl(0);
-  voice_packet.header.seqNum = htons(next_audio_seq++);
+  p->enc_feed.unregisterSink();
+  delete p->enc;
+  delete p->transcoder;
 
-#ifdef SPEEX_MAJOR
-  if (p->remote_codec == Private::CODEC_SPEEX)
+  p->enc = new VoicePacketEncoder(audioCodec());
+  p->transcoder = new VoicePacketEncoder("GSM");
+  if (p->threaded_codec)
   {
-    for(int i = 0; i < BUFFER_SIZE; i += 160)
-    {
-      speex_encode_int(p->enc_state, send_buffer + i, &p->enc_bits);
-    }
-    speex_bits_insert_terminator(&p->enc_bits);
-    size_t nsize = speex_bits_nbytes(&p->enc_bits);
-    if (nsize < sizeof(voice_packet.data))
-    {
-      nbytes = speex_bits_write(&p->enc_bits, (char*)voice_packet.data, nsize);
-    }
-    speex_bits_reset(&p->enc_bits);
-    voice_packet.header.pt = 0x96;
-  }
-  else
-#endif
-  {
-    for(int i=0; i<FRAME_COUNT; i++)
-    {
-      gsm_encode(gsmh, send_buffer + i*160, voice_packet.data + i*33);
-      nbytes += 33;
-    }
-    voice_packet.header.pt = 0x03;
-  }
-  if (!nbytes)
-  {
-    perror("audio packet size in Qso::sendVoicePacket");
-    return false;
+    p->enc = new AudioEncoderThreaded(p->enc);
   }
 
-  bool success = Dispatcher::instance()->sendAudioMsg(remote_ip, &voice_packet,
-      nbytes + sizeof(voice_packet.header));
-  if (!success)
-  {
-    perror("sendAudioMsg in Qso::sendVoicePacket");
-    return false;
-  }
-  
-  return true;
-  
-} /* Qso::sendVoicePacket */
+  p->enc->writeEncodedSamples.connect(
+      mem_fun(*this, &Qso::sendEncodedAudio));
+  p->enc->flushEncodedSamples.connect(
+      mem_fun(*p->enc, &AudioEncoder::allEncodedSamplesFlushed));
+  p->enc_feed.registerSink(p->enc);
+
+  p->transcoder->writeEncodedSamples.connect(
+      mem_fun(*this, &Qso::sendEncodedAudio));
+} /* Qso::createEncoders */
 
 
 void Qso::checkRxActivity(Timer *timer)
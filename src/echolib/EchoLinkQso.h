@@ -312,9 +312,32 @@ class Qso
      * audioReceivedRaw signal. The raw_packet contains both the network
      * packet and the decoded samples, which is beneficial when the audio
      * frame has to be transcoded (SPEEX -> GSM) prior re-transmission.
+     *
+     * When the packet is transcoded, the return value only tell if the
+     * audio was handed over to the GSM encoder. An error when sending the
+     * transcoded packet is not reported back to the caller.
      */
     bool sendAudioRaw(RawPacket *raw_packet);
 
+    /**
+     * @brief 	Send an already encoded voice packet to the remote station
+     * @param 	buf A buffer containing a complete voice packet
+     * @param 	size The size of the packet, header included
+     * @return	Returns \em true on success or \em false on failure
+     *
+     * This function is used to send a voice packet produced by an
+     * EchoLink::VoicePacketEncoder. The sequence number is set by this
+     * function so the same packet can be sent to many stations. The codec
+     * used to encode the packet should be the one returned by audioCodec.
+     */
+    bool sendEncodedAudio(const void *buf, int size);
+
+    /**
+     * @brief 	Get the codec used for audio sent to the remote station
+     * @return	Returns the name of the codec, GSM or SPEEX
+     */
+    const char *audioCodec(void) const;
+
     /**
       * @brief Set parameters of the remote station connection
       * @param priv A private string for passing connection parameters
@@ -453,6 +476,22 @@ class Qso
      */
     void setUseGsmOnly(void);
 
+    /**
+     * @brief Run the audio encoder in a worker thread
+     * @param enable Set to \em true to run the encoder in a worker thread
+     *
+     * Outgoing audio is encoded by an EchoLink::VoicePacketEncoder. When
+     * enabled, the GSM or SPEEX encoding of audio written to this object is
+     * done in one of the threads of the Async::AudioCodecWorkerPool instead
+     * of in the main thread. The encoded packets are sent from the main
+     * thread in the same order as the audio was written. Decoding of
+     * received audio, and the SPEEX to GSM transcoding done by sendAudioRaw,
+     * is always done in the main thread. The decoded samples are needed at
+     * once by the audioReceivedRaw signal and the transcoder is fed with the
+     * 16 bit samples which the worker threads cannot carry.
+     */
+    void setThreadedCodec(bool enable);
+
   protected:
     /**
      * @brief The registered sink has flushed all samples
@@ -491,8 +530,6 @@ class Qso
     std::string    	name;
     std::string    	local_stn_info;
     short		receive_buffer[BUFFER_SIZE];
-    short		send_buffer[BUFFER_SIZE];
-    int       	      	send_buffer_cnt;
     Async::IpAddress  	remote_ip;
     Async::Timer *    	rx_indicator_timer;
     std::string       	remote_name;
@@ -519,7 +556,7 @@ class Qso
     void connectionTimeout(Async::Timer *timer);
     bool setupConnection(void);
     void cleanupConnection(void);
-    bool sendVoicePacket(void);
+    void createEncoders(void);
     void checkRxActivity(Async::Timer *timer);
     bool sendByePacket(void);
     
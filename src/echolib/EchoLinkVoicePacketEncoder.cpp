@@ -0,0 +1,304 @@
+/**
+@file	 EchoLinkVoicePacketEncoder.cpp
+@brief   An audio encoder producing EchoLink voice packets
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-09-05
+
+\verbatim
+EchoLib - A library for EchoLink communication
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <cstring>
+
+extern "C" {
+#include <gsm.h>
+}
+
+#ifdef SPEEX_MAJOR
+#include <speex/speex.h>
+#endif
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "EchoLinkVoicePacketEncoder.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace EchoLink;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+struct VoicePacketEncoder::Private
+{
+  gsm       gsmh;
+#ifdef SPEEX_MAJOR
+  SpeexBits enc_bits;
+  void *    enc_state;
+#endif
+
+  Private(void) : gsmh(gsm_create())
+  {
+#ifdef SPEEX_MAJOR
+    speex_bits_init(&enc_bits);
+    enc_state = speex_encoder_init(&speex_nb_mode);
+    int val = 25000;
+    speex_encoder_ctl(enc_state, SPEEX_SET_BITRATE, &val);
+    val = 8;
+    speex_encoder_ctl(enc_state, SPEEX_SET_QUALITY, &val);
+    val = 4;
+    speex_encoder_ctl(enc_state, SPEEX_SET_COMPLEXITY, &val);
+#endif
+  }
+
+  ~Private(void)
+  {
+    gsm_destroy(gsmh);
+#ifdef SPEEX_MAJOR
+    speex_bits_destroy(&enc_bits);
+    speex_encoder_destroy(enc_state);
+#endif
+  }
+};
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+VoicePacketEncoder::VoicePacketEncoder(const string &codec)
+  : p(new Private), use_speex(false), buf_cnt(0)
+{
+  memset(&packet.header, 0, sizeof(packet.header));
+  packet.header.version = 0xc0;
+  setOption("CODEC", codec);
+} /* VoicePacketEncoder::VoicePacketEncoder */
+
+
+VoicePacketEncoder::~VoicePacketEncoder(void)
+{
+  delete p;
+} /* VoicePacketEncoder::~VoicePacketEncoder */
+
+
+const char *VoicePacketEncoder::name(void) const
+{
+  return use_speex ? "SPEEX" : "GSM";
+} /* VoicePacketEncoder::name */
+
+
+void VoicePacketEncoder::setOption(const string &name, const string &value)
+{
+  if (name == "CODEC")
+  {
+#ifdef SPEEX_MAJOR
+    use_speex = (value == "SPEEX");
+#endif
+  }
+} /* VoicePacketEncoder::setOption */
+
+
+int VoicePacketEncoder::writeSamples(const float *samples, int count)
+{
+  for (int i=0; i<count; ++i)
+  {
+    float sample = samples[i];
+    if (sample > 1)
+    {
+      buf[buf_cnt++] = 32767;
+    }
+    else if (sample < -1)
+    {
+      buf[buf_cnt++] = -32767;
+    }
+    else
+    {
+      buf[buf_cnt++] = static_cast<int16_t>(32767.0 * sample);
+    }
+    sampleAdded();
+  }
+
+  return count;
+
+} /* VoicePacketEncoder::writeSamples */
+
+
+int VoicePacketEncoder::writeRawSamples(const short *samples, int count)
+{
+  for (int i=0; i<count; ++i)
+  {
+    buf[buf_cnt++] = samples[i];
+    sampleAdded();
+  }
+
+  return count;
+
+} /* VoicePacketEncoder::writeRawSamples */
+
+
+void VoicePacketEncoder::flushSamples(void)
+{
+  if (buf_cnt > 0)
+  {
+    memset(buf + buf_cnt, 0, sizeof(buf) - sizeof(*buf) * buf_cnt);
+    encodePacket();
+    buf_cnt = 0;
+  }
+  flushEncodedSamples();
+} /* VoicePacketEncoder::flushSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void VoicePacketEncoder::sampleAdded(void)
+{
+  if (buf_cnt == BUFFER_SIZE)
+  {
+    encodePacket();
+    buf_cnt = 0;
+  }
+} /* VoicePacketEncoder::sampleAdded */
+
+
+void VoicePacketEncoder::encodePacket(void)
+{
+  size_t nbytes = 0;
+
+#ifdef SPEEX_MAJOR
+  if (use_speex)
+  {
+    for (int i=0; i<BUFFER_SIZE; i+=FRAME_SIZE)
+    {
+      speex_encode_int(p->enc_state, buf + i, &p->enc_bits);
+    }
+    speex_bits_insert_terminator(&p->enc_bits);
+    size_t nsize = speex_bits_nbytes(&p->enc_bits);
+    if (nsize < sizeof(packet.data))
+    {
+      nbytes = speex_bits_write(&p->enc_bits, (char*)packet.data, nsize);
+    }
+    speex_bits_reset(&p->enc_bits);
+    packet.header.pt = 0x96;
+  }
+  else
+#endif
+  {
+    for (int i=0; i<FRAME_COUNT; i++)
+    {
+      gsm_encode(p->gsmh, buf + i*FRAME_SIZE, packet.data + i*33);
+      nbytes += 33;
+    }
+    packet.header.pt = 0x03;
+  }
+
+  if (nbytes > 0)
+  {
+    writeEncodedSamples(&packet, sizeof(packet.header) + nbytes);
+  }
+} /* VoicePacketEncoder::encodePacket */
+
+
+
+/*
+ * This file has not been truncated
+ */
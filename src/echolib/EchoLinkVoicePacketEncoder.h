@@ -0,0 +1,207 @@
+/**
+@file	 EchoLinkVoicePacketEncoder.h
+@brief   An audio encoder producing EchoLink voice packets
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-09-05
+
+\verbatim
+EchoLib - A library for EchoLink communication
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef ECHOLINK_VOICE_PACKET_ENCODER_INCLUDED
+#define ECHOLINK_VOICE_PACKET_ENCODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioEncoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "EchoLinkQso.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+namespace EchoLink
+{
+
+/****************************************************************************
+ *
+ * Forward declarations inside the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	An audio encoder producing EchoLink voice packets
+@author Tobias Blomberg / SM0SVX
+@date   2020-09-05
+
+This encoder take 8kHz audio and encode it the same way as an EchoLink::Qso
+does for outgoing audio. For every four 20ms frames, a complete voice packet,
+header included, is emitted through the writeEncodedSamples signal. The
+sequence number in the header is left at zero and is filled in by
+Qso::sendEncodedAudio.
+
+The codec is selected using the CODEC option, which may be set to GSM or
+SPEEX. The name of the codecs are the same as returned by Qso::audioCodec.
+This make it possible to encode the audio once and then send it to all
+connected stations using the same codec.
+*/
+class VoicePacketEncoder : public Async::AudioEncoder
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param 	codec The codec to use, GSM or SPEEX
+     */
+    explicit VoicePacketEncoder(const std::string &codec="GSM");
+
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~VoicePacketEncoder(void);
+
+    /**
+     * @brief   Get the name of the codec
+     * @returns Return the name of the currently used codec
+     */
+    virtual const char *name(void) const;
+
+    /**
+     * @brief 	Set an option for the encoder
+     * @param 	name The name of the option
+     * @param 	value The value of the option
+     *
+     * The only option is CODEC which select the codec to use, GSM or SPEEX.
+     */
+    virtual void setOption(const std::string &name, const std::string &value);
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Write 16 bit samples into the encoder
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     *
+     * Use this function when the audio already is in 16 bit format, like the
+     * decoded samples in a Qso::RawPacket. The samples are encoded as they
+     * are, without going through a float conversion.
+     */
+    int writeRawSamples(const short *samples, int count);
+
+    /**
+     * @brief 	Tell the sink to flush the previously written samples
+     *
+     * A partly filled packet is padded with silence and sent before the
+     * flushEncodedSamples signal is emitted.
+     */
+    virtual void flushSamples(void);
+
+  private:
+    static const int  FRAME_COUNT = 4;
+    static const int  FRAME_SIZE  = 160;
+    static const int  BUFFER_SIZE = FRAME_COUNT * FRAME_SIZE;
+
+    struct Private;
+
+    Private *           p;
+    bool                use_speex;
+    short               buf[BUFFER_SIZE];
+    int                 buf_cnt;
+    Qso::VoicePacket    packet;
+
+    VoicePacketEncoder(const VoicePacketEncoder&);
+    VoicePacketEncoder& operator=(const VoicePacketEncoder&);
+    void sampleAdded(void);
+    void encodePacket(void);
+
+};  /* class VoicePacketEncoder */
+
+
+} /* namespace */
+
+#endif /* ECHOLINK_VOICE_PACKET_ENCODER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -40,6 +40,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <signal.h>
 #include <sys/time.h>
 #include <cstring>
+#include <cerrno>
 #include <cstdlib>
 #include <map>
 
@@ -735,7 +736,8 @@ void SvxServer::sendMsg(Async::TcpConnection *con, Msg *msg)
   {
     cout << "*** ERROR: (" << con->remoteHost() << ":"
          << con->remotePort() << ") TCP transmit "
-         << (written == -1 ? "error." : "buffer overflow.")
+         << (((written == -1) && (errno != ENOBUFS)) ?
+             "error." : "buffer overflow.")
          << endl;
     con->disconnect();
     clientDisconnected(con, TcpConnection::DR_ORDERED_DISCONNECT);
@@ -0,0 +1,245 @@
+/**
+@file	 ConferenceEncoder.cpp
+@brief   Encode audio once for all connected EchoLink stations
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-09-05
+
+\verbatim
+A module (plugin) for the multi purpose tranciever frontend system.
+Copyright (C) 2004-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <algorithm>
+#include <sigc++/bind.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSplitter.h>
+#include <AsyncAudioValve.h>
+#include <AsyncAudioDecimator.h>
+#include <AsyncAudioEncoderThreaded.h>
+#include <EchoLinkVoicePacketEncoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ConferenceEncoder.h"
+#include "QsoImpl.h"
+#include "multirate_filter_coeff.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+using namespace EchoLink;
+using namespace sigc;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ConferenceEncoder::ConferenceEncoder(bool threaded)
+  : first_sink(0)
+{
+  AudioSplitter *splitter = new AudioSplitter;
+  first_sink = splitter;
+
+#if INTERNAL_SAMPLE_RATE == 16000
+  AudioDecimator *down_sampler = new AudioDecimator(
+          2, coeff_16_8, coeff_16_8_taps);
+  down_sampler->registerSink(splitter, true);
+  first_sink = down_sampler;
+#endif
+
+  const char *codec_names[] = { "GSM", "SPEEX" };
+  for (size_t i=0; i<sizeof(codec_names)/sizeof(*codec_names); ++i)
+  {
+    Codec codec;
+    codec.name = codec_names[i];
+    codec.valve = new AudioValve;
+    codec.valve->setOpen(false);
+    splitter->addSink(codec.valve, true);
+    codec.enc = new VoicePacketEncoder(codec.name);
+    if (threaded)
+    {
+      codec.enc = new AudioEncoderThreaded(codec.enc);
+    }
+    codec.enc->writeEncodedSamples.connect(
+        sigc::bind(mem_fun(*this, &ConferenceEncoder::sendEncodedAudio),
+             codec.name));
+    codec.enc->flushEncodedSamples.connect(
+        mem_fun(*codec.enc, &AudioEncoder::allEncodedSamplesFlushed));
+    codec.valve->registerSink(codec.enc, true);
+    codecs.push_back(codec);
+  }
+
+  AudioSink::setHandler(first_sink);
+} /* ConferenceEncoder::ConferenceEncoder */
+
+
+ConferenceEncoder::~ConferenceEncoder(void)
+{
+  AudioSink::clearHandler();
+  delete first_sink;
+} /* ConferenceEncoder::~ConferenceEncoder */
+
+
+void ConferenceEncoder::addQso(QsoImpl *qso)
+{
+  if (find(qsos.begin(), qsos.end(), qso) == qsos.end())
+  {
+    qsos.push_back(qso);
+  }
+} /* ConferenceEncoder::addQso */
+
+
+void ConferenceEncoder::removeQso(QsoImpl *qso)
+{
+  vector<QsoImpl*>::iterator it = find(qsos.begin(), qsos.end(), qso);
+  if (it != qsos.end())
+  {
+    qsos.erase(it);
+  }
+} /* ConferenceEncoder::removeQso */
+
+
+int ConferenceEncoder::writeSamples(const float *samples, int count)
+{
+    // The codec used by a station may change when the connection is set up
+    // so check which encoders are needed before each block of audio
+  updateCodecs();
+  return AudioSink::writeSamples(samples, count);
+} /* ConferenceEncoder::writeSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ConferenceEncoder::updateCodecs(void)
+{
+  for (vector<Codec>::iterator cit=codecs.begin(); cit!=codecs.end(); ++cit)
+  {
+    bool in_use = false;
+    vector<QsoImpl*>::const_iterator it;
+    for (it=qsos.begin(); !in_use && (it!=qsos.end()); ++it)
+    {
+      in_use = ((*it)->currentState() == Qso::STATE_CONNECTED) &&
+               ((*cit).name == (*it)->audioCodec());
+    }
+    (*cit).valve->setOpen(in_use);
+  }
+} /* ConferenceEncoder::updateCodecs */
+
+
+void ConferenceEncoder::sendEncodedAudio(const void *buf, int size,
+                                         const string &codec)
+{
+  vector<QsoImpl*>::const_iterator it;
+  for (it=qsos.begin(); it!=qsos.end(); ++it)
+  {
+    if (codec == (*it)->audioCodec())
+    {
+      (*it)->sendEncodedAudio(buf, size);
+    }
+  }
+} /* ConferenceEncoder::sendEncodedAudio */
+
+
+
+/*
+ * This file has not been truncated
+ */
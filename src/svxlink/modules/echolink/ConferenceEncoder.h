@@ -0,0 +1,191 @@
+/**
+@file	 ConferenceEncoder.h
+@brief   Encode audio once for all connected EchoLink stations
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-09-05
+
+\verbatim
+A module (plugin) for the multi purpose tranciever frontend system.
+Copyright (C) 2004-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef CONFERENCE_ENCODER_INCLUDED
+#define CONFERENCE_ENCODER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+#include <vector>
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class AudioValve;
+  class AudioEncoder;
+};
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class QsoImpl;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Encode audio once for all connected EchoLink stations
+@author Tobias Blomberg / SM0SVX
+@date   2020-09-05
+
+Audio sent to the remote EchoLink stations is the same for all stations, so
+instead of letting each QsoImpl resample and encode it, this class resample
+it once and encode it once per codec in use. The encoded voice packets are
+then sent to each connected station using that codec.
+
+An encoder is only fed with audio when at least one connected station use
+its codec. Stations that are playing a message of their own, like the
+greeting, are skipped while the message is being played.
+*/
+class ConferenceEncoder : public Async::AudioSink, public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param 	threaded Set to \em true to run the encoders in a worker thread
+     */
+    explicit ConferenceEncoder(bool threaded=false);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~ConferenceEncoder(void);
+
+    /**
+     * @brief 	Add a station to send the encoded audio to
+     * @param 	qso The QSO object of the station
+     */
+    void addQso(QsoImpl *qso);
+
+    /**
+     * @brief 	Stop sending encoded audio to a station
+     * @param 	qso The QSO object of the station
+     */
+    void removeQso(QsoImpl *qso);
+
+    /**
+     * @brief 	Write samples into this audio sink
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+  protected:
+
+  private:
+    struct Codec
+    {
+      std::string           name;
+      Async::AudioValve     *valve;
+      Async::AudioEncoder   *enc;
+    };
+
+    Async::AudioSink          *first_sink;
+    std::vector<Codec>        codecs;
+    std::vector<QsoImpl*>     qsos;
+
+    ConferenceEncoder(const ConferenceEncoder&);
+    ConferenceEncoder& operator=(const ConferenceEncoder&);
+    void updateCodecs(void);
+    void sendEncodedAudio(const void *buf, int size, const std::string &codec);
+
+};  /* class ConferenceEncoder */
+
+
+//} /* namespace */
+
+#endif /* CONFERENCE_ENCODER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
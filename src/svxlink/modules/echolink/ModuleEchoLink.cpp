@@ -49,7 +49,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncTimer.h>
 #include <AsyncConfig.h>
-#include <AsyncAudioSplitter.h>
 #include <AsyncAudioValve.h>
 #include <AsyncAudioSelector.h>
 #include <EchoLinkDirectory.h>
@@ -71,6 +70,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "version/MODULE_ECHO_LINK.h"
 #include "ModuleEchoLink.h"
 #include "QsoImpl.h"
+#include "ConferenceEncoder.h"
+#include "QsoEventHandler.h"
 
 
 /****************************************************************************
@@ -158,11 +159,11 @@ ModuleEchoLink::ModuleEchoLink(void *dl_handle, Logic *logic,
     max_connections(1), max_qsos(1), talker(0), squelch_is_open(false),
     state(STATE_NORMAL), cbc_timer(0), dbc_timer(0), drop_incoming_regex(0),
     reject_incoming_regex(0), accept_incoming_regex(0),
-    reject_outgoing_regex(0), accept_outgoing_regex(0), splitter(0),
-    listen_only_valve(0), selector(0), num_con_max(0), num_con_ttl(5*60),
-    num_con_block_time(120*60), num_con_update_timer(0), reject_conf(false),
-    autocon_echolink_id(0), autocon_time(DEFAULT_AUTOCON_TIME),
-    autocon_timer(0), proxy(0), pty(0)
+    reject_outgoing_regex(0), accept_outgoing_regex(0), conf_encoder(0),
+    qso_event_handler(0), listen_only_valve(0), selector(0), num_con_max(0),
+    num_con_ttl(5*60), num_con_block_time(120*60), num_con_update_timer(0),
+    reject_conf(false), autocon_echolink_id(0),
+    autocon_time(DEFAULT_AUTOCON_TIME), autocon_timer(0), proxy(0), pty(0)
 {
   cout << "\tModule EchoLink v" MODULE_ECHO_LINK_VERSION " starting...\n";
   
@@ -416,6 +417,36 @@ bool ModuleEchoLink::initialize(void)
     return false;
   }
 
+  string event_handler_script;
+  if (!cfg().getValue(logicName(), "EVENT_HANDLER", event_handler_script))
+  {
+    cerr << "*** ERROR: Config variable " << logicName()
+      	 << "/EVENT_HANDLER not set\n";
+    moduleCleanup();
+    return false;
+  }
+
+    // Load the event script once into an interpreter that is shared by all
+    // QSO objects for the announcements sent to the remote stations.
+    // Workaround: Need to set the ID config variable and "logic_name"
+    // variable to load the TCL script.
+  qso_event_handler = new QsoEventHandler(event_handler_script,
+      logicName() + ", module " + name());
+  qso_event_handler->processEvent("namespace eval EchoLink {}", 0);
+  qso_event_handler->setVariable("EchoLink::CFG_ID", "0");
+  qso_event_handler->setVariable("logic_name", "Default");
+  qso_event_handler->processEvent("namespace eval Logic {}", 0);
+  string default_lang;
+  if (cfg().getValue(cfgName(), "DEFAULT_LANG", default_lang))
+  {
+    qso_event_handler->setVariable("Logic::CFG_DEFAULT_LANG", default_lang);
+  }
+  bool remote_rgr_sound = false;
+  cfg().getValue(cfgName(), "REMOTE_RGR_SOUND", remote_rgr_sound);
+  qso_event_handler->setVariable(name() + "::CFG_REMOTE_RGR_SOUND",
+                                 remote_rgr_sound ? "1" : "0");
+  qso_event_handler->initialize();
+
     // Initialize directory server communication
   dir = new Directory(servers, mycall, password, location, bind_addr);
   dir->statusChanged.connect(mem_fun(*this, &ModuleEchoLink::onStatusChanged));
@@ -442,12 +473,15 @@ bool ModuleEchoLink::initialize(void)
   }
 
     // Create audio pipe chain for audio transmitted to the remote EchoLink
-    // stations: <from core> -> Valve -> Splitter (-> QsoImpl ...)
+    // stations: <from core> -> Valve -> ConferenceEncoder (-> QsoImpl ...)
+    // The audio is encoded once per codec and then sent to all stations.
   listen_only_valve = new AudioValve;
   AudioSink::setHandler(listen_only_valve);
   
-  splitter = new AudioSplitter;
-  listen_only_valve->registerSink(splitter);
+  bool threaded_codec = false;
+  cfg().getValue(cfgName(), "THREADED_CODEC", threaded_codec);
+  conf_encoder = new ConferenceEncoder(threaded_codec);
+  listen_only_valve->registerSink(conf_encoder);
 
     // Create audio pipe chain for audio received from the remove EchoLink
     // stations: (QsoImpl -> ) Selector -> Fifo -> <to core>
@@ -659,10 +693,12 @@ void ModuleEchoLink::moduleCleanup(void)
   autocon_timer = 0;
   
   AudioSink::clearHandler();
-  delete splitter;
-  splitter = 0;
+  delete conf_encoder;
+  conf_encoder = 0;
   delete listen_only_valve;
   listen_only_valve = 0;
+  delete qso_event_handler;
+  qso_event_handler = 0;
   
   AudioSource::clearHandler();
   delete selector;
@@ -1119,7 +1155,7 @@ void ModuleEchoLink::onIncomingConnection(const IpAddress& ip,
       	  mem_fun(*this, &ModuleEchoLink::audioFromRemoteRaw));
   qso->destroyMe.connect(mem_fun(*this, &ModuleEchoLink::destroyQsoObject));
 
-  splitter->addSink(qso);
+  conf_encoder->addQso(qso);
   selector->addSource(qso);
   selector->enableAutoSelect(qso, 0);
 
@@ -1372,7 +1408,7 @@ void ModuleEchoLink::destroyQsoObject(QsoImpl *qso)
   //cout << qso->remoteCallsign() << ": Destroying QSO object" << endl;
   string callsign = qso->remoteCallsign();
 
-  splitter->removeSink(qso);
+  conf_encoder->removeQso(qso);
   selector->removeSource(qso);
       
   vector<QsoImpl*>::iterator it = find(qsos.begin(), qsos.end(), qso);
@@ -1524,7 +1560,7 @@ void ModuleEchoLink::createOutgoingConnection(const StationData &station)
       	    mem_fun(*this, &ModuleEchoLink::audioFromRemoteRaw));
     qso->destroyMe.connect(mem_fun(*this, &ModuleEchoLink::destroyQsoObject));
 
-    splitter->addSink(qso);
+    conf_encoder->addQso(qso);
     selector->addSource(qso);
     selector->enableAutoSelect(qso, 0);
   }
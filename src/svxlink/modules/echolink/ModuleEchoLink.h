@@ -72,7 +72,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 namespace Async
 {
   class Timer;
-  class AudioSplitter;
   class AudioValve;
   class AudioSelector;
   class Pty;
@@ -104,6 +103,8 @@ namespace EchoLink
 class MsgHandler;
 class QsoImpl;
 class LocationInfo;
+class ConferenceEncoder;
+class QsoEventHandler;
   
 
 /****************************************************************************
@@ -141,6 +142,12 @@ class ModuleEchoLink : public Module
     bool initialize(void);
     const char *compiledForVersion(void) const { return SVXLINK_VERSION; }
 
+    /**
+     * @brief   Get the event handler shared by all QSO objects
+     * @return  Returns the event handler used for remote announcements
+     */
+    QsoEventHandler *qsoEventHandler(void) { return qso_event_handler; }
+
     
   protected:
     /**
@@ -198,7 +205,8 @@ class ModuleEchoLink : public Module
     regex_t   	      	  *reject_outgoing_regex;
     regex_t   	      	  *accept_outgoing_regex;
     EchoLink::StationData last_disc_stn;
-    Async::AudioSplitter  *splitter;
+    ConferenceEncoder     *conf_encoder;
+    QsoEventHandler       *qso_event_handler;
     Async::AudioValve 	  *listen_only_valve;
     Async::AudioSelector  *selector;
     unsigned              num_con_max;
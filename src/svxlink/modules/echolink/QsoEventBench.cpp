@@ -0,0 +1,386 @@
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <AsyncCppApplication.h>
+#include <AsyncFdWatch.h>
+#include <EchoLinkDispatcher.h>
+#include <EchoLinkQso.h>
+#include <EventHandler.h>
+#include <MsgHandler.h>
+
+#include "QsoEventHandler.h"
+
+using namespace std;
+using namespace Async;
+using namespace EchoLink;
+
+  // Benchmark the event handling of EchoLink QSOs, comparing one TCL
+  // interpreter per QSO, as QsoImpl used to create, with the interpreter
+  // shared by all QSOs through the QsoEventHandler class.
+  //
+  // A child process act as the remote station on 127.0.0.2 and accept all
+  // incoming connections. The parent, on 127.0.0.1, open and close a number
+  // of QSOs to it one after the other. For each QSO the time from creating
+  // the QSO until it is connected and has handled its first event is
+  // measured. Then the same number of QSOs are kept alive at the same time
+  // to measure the event handling memory used by each live QSO.
+  //
+  // Usage: QsoEventBench <event script> [number of QSOs]
+  //
+  // The event script is normally /usr/share/svxlink/events.tcl
+
+namespace {
+  const char *LOCAL_IP = "127.0.0.1";
+  const char *REMOTE_IP = "127.0.0.2";
+  const char *MODULE_NAME = "EchoLink";
+  const int SAMPLE_RATE = 16000;
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+
+  long residentBytes(void)
+  {
+    long size = 0;
+    long resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f != 0)
+    {
+      if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+      {
+        resident = 0;
+      }
+      fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+  }
+
+    // Set up an event handler like QsoImpl used to do for each QSO
+  EventHandler *createEventHandler(const string &script)
+  {
+    EventHandler *eh = new EventHandler(script, "Bench");
+    eh->processEvent("namespace eval EchoLink {}");
+    eh->setVariable("EchoLink::CFG_ID", "0");
+    eh->setVariable("logic_name", "Default");
+    eh->processEvent("namespace eval Logic {}");
+    eh->setVariable(string(MODULE_NAME) + "::CFG_REMOTE_RGR_SOUND", "0");
+    eh->setVariable(string(MODULE_NAME) + "::listen_only_active", "0");
+    eh->initialize();
+    return eh;
+  }
+
+  QsoEventHandler *createQsoEventHandler(const string &script)
+  {
+    QsoEventHandler *eh = new QsoEventHandler(script, "Bench");
+    eh->processEvent("namespace eval EchoLink {}", 0);
+    eh->setVariable("EchoLink::CFG_ID", "0");
+    eh->setVariable("logic_name", "Default");
+    eh->processEvent("namespace eval Logic {}", 0);
+    eh->setVariable(string(MODULE_NAME) + "::CFG_REMOTE_RGR_SOUND", "0");
+    eh->initialize();
+    return eh;
+  }
+
+    // The remote station, running in the child process
+  class Remote : public sigc::trackable
+  {
+    public:
+      Remote(int ready_fd) : ready_fd(ready_fd), qso(0)
+      {
+        Dispatcher::instance()->incomingConnection.connect(
+            mem_fun(*this, &Remote::onIncomingConnection));
+      }
+
+    private:
+      int   ready_fd;
+      Qso  *qso;
+
+      void onIncomingConnection(const IpAddress& ip, const string& callsign,
+                                const string& name, const string& priv)
+      {
+        qso = new Qso(ip, "BENCH-R", "Remote", "QsoEventBench");
+        qso->stateChange.connect(mem_fun(*this, &Remote::onStateChange));
+        qso->accept();
+      }
+
+      void onStateChange(Qso::State state)
+      {
+        if (state == Qso::STATE_DISCONNECTED)
+        {
+          Application::app().runTask(mem_fun(*this, &Remote::deleteQso));
+        }
+      }
+
+      void deleteQso(void)
+      {
+        delete qso;
+        qso = 0;
+          // Tell the parent that a new connection can be made
+        if (write(ready_fd, "R", 1) != 1)
+        {
+          perror("write");
+        }
+      }
+  };
+
+    // Open and close QSOs to the remote station, running in the parent
+  class Bench : public sigc::trackable
+  {
+    public:
+      Bench(const string &script, unsigned qso_cnt, int ready_fd)
+        : script(script), qso_cnt(qso_cnt), ready_watch(ready_fd,
+          FdWatch::FD_WATCH_RD), shared(false), shared_eh(0), eh(0),
+          msg_handler(0), qso(0), started(false), cnt(0), start(0.0),
+          latency_sum(0.0), latency_max(0.0), shared_setup_time(0.0)
+      {
+        ready_watch.activity.connect(mem_fun(*this, &Bench::remoteReady));
+        printf("%-10s %12s %12s %12s %12s\n", "", "Setup", "Mean conn",
+               "Max conn", "Memory");
+        printf("%-10s %12s %12s %12s %12s\n", "", "ms", "ms", "ms",
+               "kB/QSO");
+      }
+
+      ~Bench(void)
+      {
+        delete qso;
+        delete eh;
+        delete msg_handler;
+        delete shared_eh;
+      }
+
+    private:
+      string            script;
+      unsigned          qso_cnt;
+      FdWatch           ready_watch;
+      bool              shared;
+      QsoEventHandler*  shared_eh;
+      EventHandler*     eh;
+      MsgHandler*       msg_handler;
+      Qso*              qso;
+      bool              started;
+      unsigned          cnt;
+      double            start;
+      double            latency_sum;
+      double            latency_max;
+      double            shared_setup_time;
+
+      void openQso(void)
+      {
+        start = now();
+        msg_handler = new MsgHandler(SAMPLE_RATE);
+        if (!shared)
+        {
+          eh = createEventHandler(script);
+        }
+        qso = new Qso(IpAddress(REMOTE_IP), "BENCH-L", "Local",
+                      "QsoEventBench");
+        if (!qso->initOk())
+        {
+          cerr << "*** ERROR: Could not create the QSO object\n";
+          exit(1);
+        }
+        qso->stateChange.connect(mem_fun(*this, &Bench::onStateChange));
+        qso->connect();
+      }
+
+      void onStateChange(Qso::State state)
+      {
+        if (state != Qso::STATE_CONNECTED)
+        {
+          return;
+        }
+
+        const string event = string(MODULE_NAME) + "::squelch_open 0";
+        if (shared)
+        {
+          shared_eh->setVariable(string(MODULE_NAME) + "::listen_only_active",
+                                 "0");
+          shared_eh->processEvent(event, msg_handler);
+        }
+        else
+        {
+          eh->processEvent(event);
+        }
+        double latency = now() - start;
+        latency_sum += latency;
+        if (latency > latency_max)
+        {
+          latency_max = latency;
+        }
+
+        qso->disconnect();
+        Application::app().runTask(mem_fun(*this, &Bench::closeQso));
+      }
+
+      void closeQso(void)
+      {
+        delete qso;
+        qso = 0;
+        delete eh;
+        eh = 0;
+        delete msg_handler;
+        msg_handler = 0;
+        ready_watch.setEnabled(true);
+      }
+
+      void remoteReady(FdWatch *w)
+      {
+        char buf[1];
+        if (read(w->fd(), buf, sizeof(buf)) != 1)
+        {
+          cerr << "*** ERROR: The remote station process died\n";
+          exit(1);
+        }
+        ready_watch.setEnabled(false);
+
+        if (!started)
+        {
+          started = true;
+          openQso();
+          return;
+        }
+
+        if (++cnt < qso_cnt)
+        {
+          openQso();
+          return;
+        }
+
+        printf("%-10s %12.2f %12.3f %12.3f %12.1f\n",
+               shared ? "Shared" : "Per QSO",
+               1000.0 * (shared ? shared_setup_time : 0.0),
+               1000.0 * latency_sum / qso_cnt, 1000.0 * latency_max,
+               measureMemory() / 1024.0);
+
+        if (shared)
+        {
+          Application::app().quit();
+          return;
+        }
+
+        shared = true;
+        cnt = 0;
+        latency_sum = 0.0;
+        latency_max = 0.0;
+        double setup_start = now();
+        shared_eh = createQsoEventHandler(script);
+        shared_setup_time = now() - setup_start;
+        openQso();
+      }
+
+        // Keep qso_cnt QSOs alive at the same time and return the event
+        // handling memory used for each one of them
+      double measureMemory(void)
+      {
+        vector<MsgHandler*> msg_handlers;
+        vector<EventHandler*> ehs;
+        long rss_start = residentBytes();
+        for (unsigned i=0; i<qso_cnt; ++i)
+        {
+          MsgHandler *mh = new MsgHandler(SAMPLE_RATE);
+          msg_handlers.push_back(mh);
+          if (shared)
+          {
+            shared_eh->processEvent(string(MODULE_NAME) + "::squelch_open 0",
+                                    mh);
+          }
+          else
+          {
+            EventHandler *eh = createEventHandler(script);
+            eh->processEvent(string(MODULE_NAME) + "::squelch_open 0");
+            ehs.push_back(eh);
+          }
+        }
+        long rss_end = residentBytes();
+        for (unsigned i=0; i<qso_cnt; ++i)
+        {
+          delete msg_handlers[i];
+        }
+        for (size_t i=0; i<ehs.size(); ++i)
+        {
+          delete ehs[i];
+        }
+        return static_cast<double>(rss_end - rss_start) / qso_cnt;
+      }
+  };
+};
+
+
+int main(int argc, char **argv)
+{
+  if ((argc < 2) || (argc > 3))
+  {
+    cerr << "Usage: " << argv[0] << " <event script> [number of QSOs]\n";
+    exit(1);
+  }
+  string script(argv[1]);
+  int qso_cnt = (argc > 2) ? atoi(argv[2]) : 200;
+  if (qso_cnt <= 0)
+  {
+    cerr << "*** ERROR: The number of QSOs must be positive\n";
+    exit(1);
+  }
+
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    perror("pipe");
+    exit(1);
+  }
+
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    perror("fork");
+    exit(1);
+  }
+  if (pid == 0)
+  {
+    close(fds[0]);
+    CppApplication app;
+    Dispatcher::setBindAddr(IpAddress(REMOTE_IP));
+    if (Dispatcher::instance() == 0)
+    {
+      cerr << "*** ERROR: Could not bind to " << REMOTE_IP << endl;
+      exit(1);
+    }
+    Remote remote(fds[1]);
+    if (write(fds[1], "R", 1) != 1)
+    {
+      perror("write");
+      exit(1);
+    }
+    app.exec();
+    exit(0);
+  }
+  close(fds[1]);
+
+  CppApplication app;
+  Dispatcher::setBindAddr(IpAddress(LOCAL_IP));
+  if (Dispatcher::instance() == 0)
+  {
+    cerr << "*** ERROR: Could not bind to " << LOCAL_IP << endl;
+    kill(pid, SIGTERM);
+    exit(1);
+  }
+  {
+    Bench bench(script, qso_cnt, fds[0]);
+    app.exec();
+  }
+  Dispatcher::deleteInstance();
+
+  kill(pid, SIGTERM);
+  waitpid(pid, 0, 0);
+
+  return 0;
+}
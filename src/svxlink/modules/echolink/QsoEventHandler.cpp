@@ -0,0 +1,203 @@
+/**
+@file	 QsoEventHandler.cpp
+@brief   Run the TCL events for all EchoLink QSOs in one interpreter
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-09-12
+
+\verbatim
+A module (plugin) for the multi purpose tranciever frontend system.
+Copyright (C) 2004-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <EventHandler.h>
+#include <MsgHandler.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "QsoEventHandler.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace sigc;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+QsoEventHandler::QsoEventHandler(const string& event_script,
+                                 const string& logic_name)
+  : event_handler(0), msg_handler(0)
+{
+  event_handler = new EventHandler(event_script, logic_name);
+  event_handler->playFile.connect(
+      mem_fun(*this, &QsoEventHandler::playFile));
+  event_handler->playSilence.connect(
+      mem_fun(*this, &QsoEventHandler::playSilence));
+  event_handler->playTone.connect(
+      mem_fun(*this, &QsoEventHandler::playTone));
+} /* QsoEventHandler::QsoEventHandler */
+
+
+QsoEventHandler::~QsoEventHandler(void)
+{
+  delete event_handler;
+} /* QsoEventHandler::~QsoEventHandler */
+
+
+bool QsoEventHandler::initialize(void)
+{
+  return event_handler->initialize();
+} /* QsoEventHandler::initialize */
+
+
+void QsoEventHandler::setVariable(const string& name, const string& value)
+{
+  event_handler->setVariable(name, value);
+} /* QsoEventHandler::setVariable */
+
+
+bool QsoEventHandler::processEvent(const string& event, MsgHandler *handler)
+{
+    // Save the previous message handler in case an event is processed
+    // while another one is running
+  MsgHandler *prev_msg_handler = msg_handler;
+  msg_handler = handler;
+  bool success = event_handler->processEvent(event);
+  msg_handler = prev_msg_handler;
+  return success;
+} /* QsoEventHandler::processEvent */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void QsoEventHandler::playFile(const string& path)
+{
+  if (msg_handler != 0)
+  {
+    msg_handler->playFile(path, false);
+  }
+} /* QsoEventHandler::playFile */
+
+
+void QsoEventHandler::playSilence(int length)
+{
+  if (msg_handler != 0)
+  {
+    msg_handler->playSilence(length, false);
+  }
+} /* QsoEventHandler::playSilence */
+
+
+void QsoEventHandler::playTone(int fq, int amp, int length)
+{
+  if (msg_handler != 0)
+  {
+    msg_handler->playTone(fq, amp, length, false);
+  }
+} /* QsoEventHandler::playTone */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,182 @@
+/**
+@file	 QsoEventHandler.h
+@brief   Run the TCL events for all EchoLink QSOs in one interpreter
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-09-12
+
+\verbatim
+A module (plugin) for the multi purpose tranciever frontend system.
+Copyright (C) 2004-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef QSO_EVENT_HANDLER_INCLUDED
+#define QSO_EVENT_HANDLER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <string>
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class EventHandler;
+class MsgHandler;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Run the TCL events for all EchoLink QSOs in one interpreter
+@author Tobias Blomberg / SM0SVX
+@date   2020-09-12
+
+Loading the event handling script into a new TCL interpreter takes quite some
+time and memory, since the whole events.tcl tree is read. Instead of doing
+that for each QSO, the module create one object of this class that all QSO
+objects share.
+
+The sounds played by an event are sent to the message handler given in the
+call to processEvent, so that the announcements reach the remote station that
+caused the event. State that differ between QSOs must be set by the caller
+before each event since the TCL variables are shared.
+*/
+class QsoEventHandler : public sigc::trackable
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param 	event_script The path to the event handling script
+     * @param 	logic_name The name of the logic core, used in printouts
+     */
+    QsoEventHandler(const std::string& event_script,
+                    const std::string& logic_name);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~QsoEventHandler(void);
+
+    /**
+     * @brief 	Load the event handling script
+     * @return	Returns \em true on success or else \em false
+     */
+    bool initialize(void);
+
+    /**
+     * @brief 	Set a TCL variable
+     * @param 	name The name of the variable to set
+     * @param 	value The value to set the given variable to
+     */
+    void setVariable(const std::string& name, const std::string& value);
+
+    /**
+     * @brief 	Process the given event
+     * @param 	event The event must be a valid TCL function call
+     * @param 	msg_handler The message handler to play sounds through
+     * @return	Returns \em true on success or else \em false
+     */
+    bool processEvent(const std::string& event, MsgHandler *msg_handler);
+
+  protected:
+
+  private:
+    EventHandler  *event_handler;
+    MsgHandler    *msg_handler;
+
+    QsoEventHandler(const QsoEventHandler&);
+    QsoEventHandler& operator=(const QsoEventHandler&);
+    void playFile(const std::string& path);
+    void playSilence(int length);
+    void playTone(int fq, int amp, int length);
+
+};  /* class QsoEventHandler */
+
+
+//} /* namespace */
+
+#endif /* QSO_EVENT_HANDLER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
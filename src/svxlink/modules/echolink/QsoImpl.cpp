@@ -57,7 +57,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncAudioDebugger.h>
 
 #include <MsgHandler.h>
-#include <EventHandler.h>
 
 
 /****************************************************************************
@@ -68,6 +67,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ModuleEchoLink.h"
 #include "QsoImpl.h"
+#include "QsoEventHandler.h"
 #include "multirate_filter_coeff.h"
 
 
@@ -137,7 +137,7 @@ QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
     output_sel(0), init_ok(false), reject_qso(false), last_message(""),
     last_info_msg(""), idle_timer(0), disc_when_done(false), idle_timer_cnt(0),
     idle_timeout(0), destroy_timer(0), station(station), sink_handler(0),
-    logic_is_idle(true)
+    logic_is_idle(true), listen_only(false)
 {
   assert(module != 0);
 
@@ -159,6 +159,12 @@ QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
     m_qso.setUseGsmOnly();
   }
 
+  bool threaded_codec = false;
+  if (cfg.getValue(cfg_name, "THREADED_CODEC", threaded_codec))
+  {
+    m_qso.setThreadedCodec(threaded_codec);
+  }
+
   if (!cfg.getValue(cfg_name, "SYSOPNAME", sysop_name))
   {
     cerr << "*** ERROR: Config variable " << cfg_name
@@ -176,14 +182,6 @@ QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
   }
   m_qso.setLocalInfo(description);
   
-  string event_handler_script;
-  if (!cfg.getValue(module->logicName(), "EVENT_HANDLER", event_handler_script))
-  {
-    cerr << "*** ERROR: Config variable " << module->logicName()
-      	 << "/EVENT_HANDLER not set\n";
-    return;
-  }
-  
   string idle_timeout_str;
   if (cfg.getValue(cfg_name, "LINK_IDLE_TIMEOUT", idle_timeout_str))
   {
@@ -221,33 +219,8 @@ QsoImpl::QsoImpl(const StationData &station, ModuleEchoLink *module)
   prev_src->registerSink(&m_qso);
   prev_src = 0;
 
-  event_handler = new EventHandler(event_handler_script,
-      module->logicName() + ", module " + module->name());
-  event_handler->playFile.connect(
-      sigc::bind(mem_fun(*msg_handler, &MsgHandler::playFile), false));
-  event_handler->playSilence.connect(
-      sigc::bind(mem_fun(*msg_handler, &MsgHandler::playSilence), false));
-  event_handler->playTone.connect(
-      sigc::bind(mem_fun(*msg_handler, &MsgHandler::playTone), false));
-
-    // Workaround: Need to set the ID config variable and "logic_name"
-    // variable to load the TCL script.
-  event_handler->processEvent("namespace eval EchoLink {}");
-  event_handler->setVariable("EchoLink::CFG_ID", "0");
-  event_handler->setVariable("logic_name", "Default");
-
-  event_handler->processEvent("namespace eval Logic {}");
-  string default_lang;
-  if (cfg.getValue(cfg_name, "DEFAULT_LANG", default_lang))
-  {
-    event_handler->setVariable("Logic::CFG_DEFAULT_LANG", default_lang);
-  }
-  bool remote_rgr_sound = false;
-  cfg.getValue(cfg_name, "REMOTE_RGR_SOUND", remote_rgr_sound);
-  event_handler->setVariable(module->name() + "::CFG_REMOTE_RGR_SOUND",
-                             remote_rgr_sound ? "1" : "0");
-  
-  event_handler->initialize();
+  event_handler = module->qsoEventHandler();
+  assert(event_handler != 0);
   
   m_qso.infoMsgReceived.connect(mem_fun(*this, &QsoImpl::onInfoMsgReceived));
   m_qso.chatMsgReceived.connect(mem_fun(*this, &QsoImpl::onChatMsgReceived));
@@ -282,7 +255,6 @@ QsoImpl::~QsoImpl(void)
 {
   AudioSink::clearHandler();
   AudioSource::clearHandler();
-  delete event_handler;
   delete output_sel;
   delete msg_handler;
   delete sink_handler;
@@ -322,6 +294,18 @@ bool QsoImpl::sendAudioRaw(Qso::RawPacket *packet)
 } /* QsoImpl::sendAudioRaw */
 
 
+bool QsoImpl::sendEncodedAudio(const void *buf, int size)
+{
+  if (!msg_handler->isWritingMessage())
+  {
+    return m_qso.sendEncodedAudio(buf, size);
+  }
+
+  return true;
+
+} /* QsoImpl::sendEncodedAudio */
+
+
 bool QsoImpl::connect(void)
 {
   if (destroy_timer != 0)
@@ -341,8 +325,8 @@ bool QsoImpl::accept(void)
   if (success)
   {
     msg_handler->begin();
-    event_handler->processEvent(string(module->name()) + "::remote_greeting " +
-                                remoteCallsign());
+    processEvent(string(module->name()) + "::remote_greeting " +
+                 remoteCallsign());
     msg_handler->end();
   }
   
@@ -364,7 +348,7 @@ void QsoImpl::reject(bool perm)
     stringstream ss;
     ss << module->name() << "::reject_remote_connection "
        << (perm ? "1" : "0");
-    event_handler->processEvent(ss.str());
+    processEvent(ss.str());
     msg_handler->end();
   }
 } /* QsoImpl::reject */
@@ -372,8 +356,7 @@ void QsoImpl::reject(bool perm)
 
 void QsoImpl::setListenOnly(bool enable)
 {
-  event_handler->setVariable(string(module->name()) + "::listen_only_active",
-                             enable ? "1" : "0");
+  listen_only = enable;
   if (enable)
   {
     string str("[listen only] ");
@@ -392,8 +375,8 @@ void QsoImpl::squelchOpen(bool is_open)
   if (currentState() == Qso::STATE_CONNECTED)
   {
     msg_handler->begin();
-    event_handler->processEvent(string(module->name()) + "::squelch_open " +
-         (is_open ? "1": "0"));
+    processEvent(string(module->name()) + "::squelch_open " +
+                 (is_open ? "1": "0"));
     msg_handler->end();
   }
 } /* QsoImpl::squelchOpen */
@@ -559,7 +542,7 @@ void QsoImpl::idleTimeoutCheck(Timer *t)
     module->processEvent("link_inactivity_timeout");
     disc_when_done = true;
     msg_handler->begin();
-    event_handler->processEvent(string(module->name()) + "::remote_timeout");
+    processEvent(string(module->name()) + "::remote_timeout");
     msg_handler->end();
     if (!msg_handler->isWritingMessage())
     {
@@ -575,6 +558,16 @@ void QsoImpl::destroyMeNow(Timer *t)
 } /* destroyMeNow */
 
 
+void QsoImpl::processEvent(const string& event)
+{
+    // The TCL interpreter is shared by all QSOs so the variables that are
+    // specific to this QSO must be set before each event
+  event_handler->setVariable(string(module->name()) + "::listen_only_active",
+                             listen_only ? "1" : "0");
+  event_handler->processEvent(event, msg_handler);
+} /* QsoImpl::processEvent */
+
+
 
 /*
  * This file has not been truncated
@@ -72,6 +72,7 @@ namespace Async
   class Config;
   class AudioPacer;
   class AudioPassthrough;
+  class AudioSelector;
 };
 
 
@@ -92,7 +93,7 @@ namespace Async
  ****************************************************************************/
 
 class MsgHandler;
-class EventHandler;
+class QsoEventHandler;
 class AsyncTimer;
 class ModuleEchoLink;
 
@@ -167,6 +168,23 @@ class QsoImpl
      * audioReceivedRaw signal.
      */
     bool sendAudioRaw(EchoLink::Qso::RawPacket *packet);
+
+    /**
+     * @brief 	Send an encoded voice packet to the remote station
+     * @param 	buf A buffer containing a complete voice packet
+     * @param 	size The size of the packet, header included
+     *
+     * This function is used to send audio encoded by the ConferenceEncoder.
+     * The packet is not sent while a message is being played to the remote
+     * station.
+     */
+    bool sendEncodedAudio(const void *buf, int size);
+
+    /**
+     * @brief 	Get the codec used for audio sent to the remote station
+     * @return	Returns the name of the codec, GSM or SPEEX
+     */
+    const char *audioCodec(void) const { return m_qso.audioCodec(); }
     
     /**
      * @brief 	Initiate a connection to the remote station
@@ -319,7 +337,7 @@ class QsoImpl
   private:
     EchoLink::Qso     	    m_qso;
     ModuleEchoLink    	    *module;
-    EventHandler      	    *event_handler;
+    QsoEventHandler   	    *event_handler;
     MsgHandler	      	    *msg_handler;
     Async::AudioSelector    *output_sel;
     bool      	      	    init_ok;
@@ -335,6 +353,7 @@ class QsoImpl
     Async::AudioPassthrough *sink_handler;
     std::string             sysop_name;
     bool                    logic_is_idle;
+    bool                    listen_only;
     
     void allRemoteMsgsWritten(void);
     void onInfoMsgReceived(const std::string& msg);
@@ -342,6 +361,7 @@ class QsoImpl
     void onStateChange(EchoLink::Qso::State state);
     void idleTimeoutCheck(Async::Timer *t);
     void destroyMeNow(Async::Timer *t);
+    void processEvent(const std::string& event);
 
 };  /* class QsoImpl */
 
@@ -31,6 +31,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <cassert>
+#include <list>
+#include <sstream>
 #include <json/json.h>
 
 
@@ -56,6 +58,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "Reflector.h"
 #include "ReflectorClient.h"
 #include "TGHandler.h"
+#include "ReflectorTrunk.h"
 
 
 /****************************************************************************
@@ -123,8 +126,22 @@ namespace {
 
 Reflector::Reflector(void)
   : m_srv(0), m_udp_sock(0), m_tg_for_v1_clients(1), m_random_qsy_lo(0),
-    m_random_qsy_hi(0), m_random_qsy_tg(0), m_http_server(0)
+    m_random_qsy_hi(0), m_random_qsy_tg(0), m_http_server(0),
+    m_routing_update_pending(false), m_trunk_id(0), m_trunk_srv(0),
+    m_trunk_talker_timer(1000, Timer::TYPE_PERIODIC, false),
+    m_status(Json::objectValue), m_status_dirty(true), m_json_writer(0),
+    m_status_patch(Json::objectValue),
+    m_status_push_timer(STATUS_PUSH_DELAY_MS, Timer::TYPE_ONESHOT, false),
+    m_status_keepalive_timer(STATUS_KEEPALIVE_MS, Timer::TYPE_PERIODIC,
+                             false)
 {
+  m_status["nodes"] = Json::Value(Json::objectValue);
+  m_status_push_timer.expired.connect(
+      mem_fun(*this, &Reflector::pushStatusPatch));
+  m_status_keepalive_timer.expired.connect(
+      mem_fun(*this, &Reflector::sendStatusKeepalive));
+  m_trunk_talker_timer.expired.connect(
+      mem_fun(*this, &Reflector::checkTrunkTalkers));
   TGHandler::instance()->talkerUpdated.connect(
       mem_fun(*this, &Reflector::onTalkerUpdated));
   TGHandler::instance()->requestAutoQsy.connect(
@@ -136,6 +153,21 @@ Reflector::~Reflector(void)
 {
   delete m_http_server;
   m_http_server = 0;
+  delete m_json_writer;
+  m_json_writer = 0;
+  for (TrunkList::iterator it = m_trunks.begin(); it != m_trunks.end(); ++it)
+  {
+    delete *it;
+  }
+  m_trunks.clear();
+  delete m_trunk_srv;
+  m_trunk_srv = 0;
+  for (std::vector<ReflectorUdpWorker*>::iterator it = m_udp_workers.begin();
+       it != m_udp_workers.end(); ++it)
+  {
+    delete *it;
+  }
+  m_udp_workers.clear();
   delete m_udp_sock;
   m_udp_sock = 0;
   delete m_srv;
@@ -189,14 +221,38 @@ bool Reflector::initialize(Async::Config &cfg)
 
   uint16_t udp_listen_port = 5300;
   cfg.getValue("GLOBAL", "LISTEN_PORT", udp_listen_port);
-  m_udp_sock = new UdpSocket(udp_listen_port);
+  unsigned udp_workers = 0;
+  cfg.getValue("GLOBAL", "UDP_WORKERS", udp_workers);
+  m_udp_sock = new UdpSocket(udp_listen_port, IpAddress(), udp_workers > 0);
   if ((m_udp_sock == 0) || !m_udp_sock->initOk())
   {
     cerr << "*** ERROR: Could not initialize UDP socket" << endl;
     return false;
   }
-  m_udp_sock->dataReceived.connect(
-      mem_fun(*this, &Reflector::udpDatagramReceived));
+  m_udp_sock->dataReceivedBatch.connect(
+      mem_fun(*this, &Reflector::udpDatagramsReceived));
+
+    // The main thread socket is part of the SO_REUSEPORT group too so it
+    // will get its share of the clients. The datagrams the workers do not
+    // handle themselves are processed just like the ones received here.
+  for (unsigned i=0; i<udp_workers; ++i)
+  {
+    ReflectorUdpWorker *worker = new ReflectorUdpWorker(udp_listen_port);
+    m_udp_workers.push_back(worker);
+    if (!worker->start())
+    {
+      cerr << "*** ERROR: Could not start UDP worker thread" << endl;
+      return false;
+    }
+    worker->datagramPosted.connect(
+        mem_fun(*this, &Reflector::udpDatagramReceived));
+    worker->talkerActive.connect(
+        mem_fun(*this, &Reflector::onWorkerTalkerActive));
+  }
+  if (udp_workers > 0)
+  {
+    cout << "Using " << udp_workers << " UDP worker threads" << endl;
+  }
 
   unsigned sql_timeout = 0;
   cfg.getValue("GLOBAL", "SQL_TIMEOUT", sql_timeout);
@@ -232,6 +288,11 @@ bool Reflector::initialize(Async::Config &cfg)
         sigc::mem_fun(*this, &Reflector::httpClientDisconnected));
   }
 
+  if (!initTrunks())
+  {
+    return false;
+  }
+
   return true;
 } /* Reflector::initialize */
 
@@ -248,12 +309,24 @@ void Reflector::nodeList(std::vector<std::string>& nodes) const
       nodes.push_back(callsign);
     }
   }
+  for (TrunkList::const_iterator it = m_trunks.begin(); it != m_trunks.end();
+       ++it)
+  {
+    const std::set<std::string>& remote_nodes = (*it)->remoteNodes();
+    nodes.insert(nodes.end(), remote_nodes.begin(), remote_nodes.end());
+  }
 } /* Reflector::nodeList */
 
 
 void Reflector::broadcastMsg(const ReflectorMsg& msg,
                              const ReflectorClient::Filter& filter)
 {
+    // Pack the message only once. The frame is shared by all connections.
+  FramedTcpConnection::FramePtr frame = ReflectorClient::packMsg(msg);
+  if (!frame)
+  {
+    return;
+  }
   ReflectorClientMap::const_iterator it = m_client_map.begin();
   for (; it != m_client_map.end(); ++it)
   {
@@ -261,12 +334,51 @@ void Reflector::broadcastMsg(const ReflectorMsg& msg,
     if (filter(client) &&
         (client->conState() == ReflectorClient::STATE_CONNECTED))
     {
-      (*it).second->sendMsg(msg);
+      client->sendFrame(msg.type(), frame);
     }
   }
 } /* Reflector::broadcastMsg */
 
 
+void Reflector::broadcastTgMsg(const ReflectorMsg& msg, uint32_t tg,
+                               bool incl_monitors,
+                               const ReflectorClient::Filter& filter)
+{
+  FramedTcpConnection::FramePtr frame = ReflectorClient::packMsg(msg);
+  if (!frame)
+  {
+    return;
+  }
+  TGHandler *tg_handler = TGHandler::instance();
+  const TGHandler::ClientList& clients = tg_handler->clientsForTG(tg);
+  for (TGHandler::ClientList::const_iterator it = clients.begin();
+       it != clients.end(); ++it)
+  {
+    ReflectorClient *client = *it;
+    if (filter(client) &&
+        (client->conState() == ReflectorClient::STATE_CONNECTED))
+    {
+      client->sendFrame(msg.type(), frame);
+    }
+  }
+
+  if (incl_monitors)
+  {
+    const TGHandler::ClientList& monitors = tg_handler->monitorsForTG(tg);
+    for (TGHandler::ClientList::const_iterator it = monitors.begin();
+         it != monitors.end(); ++it)
+    {
+      ReflectorClient *client = *it;
+      if ((tg_handler->TGForClient(client) != tg) && filter(client) &&
+          (client->conState() == ReflectorClient::STATE_CONNECTED))
+      {
+        client->sendFrame(msg.type(), frame);
+      }
+    }
+  }
+} /* Reflector::broadcastTgMsg */
+
+
 bool Reflector::sendUdpDatagram(ReflectorClient *client, const void *buf,
                                 size_t count)
 {
@@ -275,19 +387,20 @@ bool Reflector::sendUdpDatagram(ReflectorClient *client, const void *buf,
 } /* Reflector::sendUdpDatagram */
 
 
-void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg,
+void Reflector::broadcastUdpMsg(const ReflectorUdpMsg& msg, uint32_t tg,
                                 const ReflectorClient::Filter& filter)
 {
-  for (ReflectorClientMap::iterator it = m_client_map.begin();
-       it != m_client_map.end(); ++it)
+    // Pack the message body only once. It is the same for all clients.
+  m_udp_payload_buf.clear();
+  Async::MsgWriter w(m_udp_payload_buf);
+  if (!msg.pack(w))
   {
-    ReflectorClient *client = (*it).second;
-    if (filter(client) &&
-        (client->conState() == ReflectorClient::STATE_CONNECTED))
-    {
-      client->sendUdpMsg(msg);
-    }
+    cerr << "*** ERROR: Failed to pack reflector UDP message type "
+         << msg.type() << endl;
+    return;
   }
+  broadcastUdpPayload(msg.type(), w.data(), w.size(),
+                      TGHandler::instance()->clientsForTG(tg), filter);
 } /* Reflector::broadcastUdpMsg */
 
 
@@ -303,13 +416,266 @@ void Reflector::requestQsy(ReflectorClient *client, uint32_t tg)
   cout << client->callsign() << ": Requesting QSY from TG #"
        << current_tg << " to TG #" << tg << endl;
 
-  broadcastMsg(MsgRequestQsy(tg),
-      ReflectorClient::mkAndFilter(
-        v2_client_filter,
-        ReflectorClient::TgFilter(current_tg)));
+  broadcastTgMsg(MsgRequestQsy(tg), current_tg, false, v2_client_filter);
 } /* Reflector::requestQsy */
 
 
+void Reflector::updateRouting(void)
+{
+  if (m_udp_workers.empty() || m_routing_update_pending)
+  {
+    return;
+  }
+  m_routing_update_pending = true;
+  Application::app().runTask(mem_fun(*this, &Reflector::publishRouting));
+} /* Reflector::updateRouting */
+
+
+void Reflector::sendTrunkMsg(const ReflectorMsg& msg, uint32_t tg)
+{
+  for (TrunkList::const_iterator it = m_trunks.begin(); it != m_trunks.end();
+       ++it)
+  {
+    ReflectorTrunk *trunk = *it;
+    if (trunk->isConnected() && ((tg == 0) || trunk->sharesTG(tg)))
+    {
+      trunk->sendMsg(msg);
+    }
+  }
+} /* Reflector::sendTrunkMsg */
+
+
+void Reflector::trunkConnected(ReflectorTrunk *trunk)
+{
+  TGHandler *tg_handler = TGHandler::instance();
+  MsgNodeList node_list;
+  for (ReflectorClientMap::const_iterator it = m_client_map.begin();
+       it != m_client_map.end(); ++it)
+  {
+    ReflectorClient *client = (*it).second;
+    if ((client->conState() == ReflectorClient::STATE_CONNECTED) &&
+        !client->callsign().empty())
+    {
+      node_list.nodes().push_back(client->callsign());
+    }
+  }
+  trunk->sendMsg(node_list);
+
+  for (ReflectorClientMap::const_iterator it = m_client_map.begin();
+       it != m_client_map.end(); ++it)
+  {
+    ReflectorClient *client = (*it).second;
+    uint32_t tg = tg_handler->TGForClient(client);
+    if ((tg > 0) && trunk->sharesTG(tg) &&
+        (tg_handler->talkerForTG(tg) == client))
+    {
+      trunk->sendMsg(MsgTalkerStart(tg, client->callsign()));
+    }
+  }
+
+  updateTrunkStatus();
+} /* Reflector::trunkConnected */
+
+
+void Reflector::trunkDisconnected(ReflectorTrunk *trunk)
+{
+  TrunkTalkerMap::iterator it = m_trunk_talkers.begin();
+  while (it != m_trunk_talkers.end())
+  {
+    TrunkTalkerMap::iterator talker_it = it++;
+    if ((*talker_it).second.trunk == trunk)
+    {
+      clearTrunkTalker((*talker_it).first);
+    }
+  }
+  updateTrunkStatus();
+} /* Reflector::trunkDisconnected */
+
+
+void Reflector::trunkTalkerStart(ReflectorTrunk *trunk, uint32_t tg,
+                                 const std::string& callsign)
+{
+  TGHandler *tg_handler = TGHandler::instance();
+  if (tg_handler->talkerForTG(tg) != 0)
+  {
+    if (m_trunk_id < trunk->peerId())
+    {
+        // The local talker win. The peer will stop its talker when it
+        // receive our talker start.
+      return;
+    }
+    tg_handler->setTalkerForTG(tg, 0);
+  }
+
+  const TrunkTalker *talker = trunkTalkerForTG(tg);
+  if (talker != 0)
+  {
+    if ((talker->trunk == trunk) && (talker->callsign == callsign))
+    {
+      return;
+    }
+    if ((talker->trunk != trunk) &&
+        (talker->trunk->peerId() < trunk->peerId()))
+    {
+      return;
+    }
+    clearTrunkTalker(tg);
+  }
+
+  cout << callsign << ": Talker start on TG #" << tg << " via trunk "
+       << trunk->peerId() << endl;
+  TrunkTalker& new_talker = m_trunk_talkers[tg];
+  new_talker.trunk = trunk;
+  new_talker.callsign = callsign;
+  gettimeofday(&new_talker.last_audio, NULL);
+  m_trunk_talker_timer.setEnable(true);
+  broadcastTalkerStart(tg, callsign);
+} /* Reflector::trunkTalkerStart */
+
+
+void Reflector::trunkTalkerStop(ReflectorTrunk *trunk, uint32_t tg,
+                                const std::string& callsign)
+{
+  const TrunkTalker *talker = trunkTalkerForTG(tg);
+  if ((talker != 0) && (talker->trunk == trunk) &&
+      (talker->callsign == callsign))
+  {
+    clearTrunkTalker(tg);
+  }
+} /* Reflector::trunkTalkerStop */
+
+
+void Reflector::trunkAudio(ReflectorTrunk *trunk, uint32_t tg,
+                           const std::vector<uint8_t>& audio)
+{
+  TrunkTalkerMap::iterator it = m_trunk_talkers.find(tg);
+  if ((it != m_trunk_talkers.end()) && ((*it).second.trunk == trunk) &&
+      !audio.empty())
+  {
+    gettimeofday(&(*it).second.last_audio, NULL);
+    broadcastUdpMsg(MsgUdpAudio(audio), tg);
+  }
+} /* Reflector::trunkAudio */
+
+
+void Reflector::updateNodeStatus(ReflectorClient *client)
+{
+  if (client->callsign().empty() ||
+      (client->conState() != ReflectorClient::STATE_CONNECTED))
+  {
+    return;
+  }
+
+  Json::Value node(client->nodeInfo());
+  //node["addr"] = client->remoteHost().toString();
+  node["protoVer"]["majorVer"] = client->protoVer().majorVer();
+  node["protoVer"]["minorVer"] = client->protoVer().minorVer();
+  node["tg"] = client->currentTG();
+  Json::Value tgs = Json::Value(Json::arrayValue);
+  const std::set<uint32_t>& monitored_tgs = client->monitoredTGs();
+  for (std::set<uint32_t>::const_iterator mtg_it=monitored_tgs.begin();
+       mtg_it!=monitored_tgs.end(); ++mtg_it)
+  {
+    tgs.append(*mtg_it);
+  }
+  node["monitoredTGs"] = tgs;
+  bool is_talker =
+    TGHandler::instance()->talkerForTG(client->currentTG()) == client;
+  node["isTalker"] = is_talker;
+
+  if (node.isMember("qth") && node["qth"].isArray())
+  {
+    //std::cout << "### Found qth" << std::endl;
+    Json::Value& qths(node["qth"]);
+    for (Json::Value::ArrayIndex i=0; i<qths.size(); ++i)
+    {
+      Json::Value& qth(qths[i]);
+      if (qth.isMember("rx") && qth["rx"].isObject())
+      {
+        //std::cout << "### Found rx" << std::endl;
+        Json::Value::Members rxs(qth["rx"].getMemberNames());
+        for (Json::Value::Members::const_iterator it=rxs.begin(); it!=rxs.end(); ++it)
+        {
+          //std::cout << "### member=" << *it << std::endl;
+          const std::string& rx_id_str(*it);
+          if (rx_id_str.size() == 1)
+          {
+            char rx_id(rx_id_str[0]);
+            Json::Value& rx(qth["rx"][rx_id_str]);
+            if (client->rxExist(rx_id))
+            {
+              rx["siglev"] = client->rxSiglev(rx_id);
+              rx["enabled"] = client->rxEnabled(rx_id);
+              rx["sql_open"] = client->rxSqlOpen(rx_id);
+              rx["active"] = client->rxActive(rx_id);
+            }
+          }
+        }
+      }
+      if (qth.isMember("tx") && qth["tx"].isObject())
+      {
+        //std::cout << "### Found tx" << std::endl;
+        Json::Value::Members txs(qth["tx"].getMemberNames());
+        for (Json::Value::Members::const_iterator it=txs.begin(); it!=txs.end(); ++it)
+        {
+          //std::cout << "### member=" << *it << std::endl;
+          const std::string& tx_id_str(*it);
+          if (tx_id_str.size() == 1)
+          {
+            char tx_id(tx_id_str[0]);
+            Json::Value& tx(qth["tx"][tx_id_str]);
+            if (client->txExist(tx_id))
+            {
+              tx["transmit"] = client->txTransmit(tx_id);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  m_status["nodes"][client->callsign()] = node;
+  m_status_dirty = true;
+  if (!m_status_streams.empty())
+  {
+    m_status_patch["nodes"][client->callsign()] = node;
+    m_status_push_timer.setEnable(true);
+  }
+} /* Reflector::updateNodeStatus */
+
+
+void Reflector::updateTrunkStatus(void)
+{
+  Json::Value trunks(Json::objectValue);
+  for (TrunkList::const_iterator it = m_trunks.begin();
+       it != m_trunks.end(); ++it)
+  {
+    ReflectorTrunk *trunk = *it;
+    Json::Value trunk_status;
+    trunk_status["connected"] =
+      trunk->isConnected() && trunk->hasInboundConnection();
+    Json::Value nodes = Json::Value(Json::arrayValue);
+    const std::set<std::string>& remote_nodes = trunk->remoteNodes();
+    for (std::set<std::string>::const_iterator node_it=remote_nodes.begin();
+         node_it!=remote_nodes.end(); ++node_it)
+    {
+      nodes.append(*node_it);
+    }
+    trunk_status["nodes"] = nodes;
+    std::ostringstream peer_id;
+    peer_id << trunk->peerId();
+    trunks[peer_id.str()] = trunk_status;
+  }
+  m_status["trunks"] = trunks;
+  m_status_dirty = true;
+  if (!m_status_streams.empty())
+  {
+    m_status_patch["trunks"] = trunks;
+    m_status_push_timer.setEnable(true);
+  }
+} /* Reflector::updateTrunkStatus */
+
+
 /****************************************************************************
  *
  * Protected member functions
@@ -356,11 +722,14 @@ void Reflector::clientDisconnected(Async::FramedTcpConnection *con,
 
   m_client_map.erase(client->clientId());
   m_client_con_map.erase(it);
+  updateRouting();
 
   if (!client->callsign().empty())
   {
+    removeNodeStatus(client->callsign());
     broadcastMsg(MsgNodeLeft(client->callsign()),
         ReflectorClient::ExceptFilter(client));
+    sendTrunkMsg(MsgNodeLeft(client->callsign()));
   }
   Application::app().runTask([=]{ delete client; });
 } /* Reflector::clientDisconnected */
@@ -369,16 +738,16 @@ void Reflector::clientDisconnected(Async::FramedTcpConnection *con,
 void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
                                     void *buf, int count)
 {
-  stringstream ss;
-  ss.write(reinterpret_cast<const char *>(buf), count);
-
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(buf);
   ReflectorUdpMsg header;
-  if (!header.unpack(ss))
+  if ((count < 0) || !header.unpackHeader(data, count))
   {
     cout << "*** WARNING: Unpacking message header failed for UDP datagram "
             "from " << addr << ":" << port << endl;
     return;
   }
+  const uint8_t *payload = data + ReflectorUdpMsg::HEADER_SIZE;
+  size_t payload_len = count - ReflectorUdpMsg::HEADER_SIZE;
 
   ReflectorClientMap::iterator it = m_client_map.find(header.clientId());
   if (it == m_client_map.end())
@@ -437,18 +806,24 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     {
       if (!client->isBlocked())
       {
-        MsgUdpAudio msg;
-        if (!msg.unpack(ss))
+          // The audio payload is forwarded as is so there is no need to
+          // unpack it. Just check that the length field is consistent.
+        size_t audio_len = 0;
+        if (payload_len >= 2)
+        {
+          audio_len = (static_cast<size_t>(payload[0]) << 8) | payload[1];
+        }
+        if ((payload_len < 2) || (payload_len < 2 + audio_len))
         {
           cerr << "*** WARNING[" << client->callsign()
                << "]: Could not unpack incoming MsgUdpAudioV1 message" << endl;
           return;
         }
         uint32_t tg = TGHandler::instance()->TGForClient(client);
-        if (!msg.audioData().empty() && (tg > 0))
+        if ((audio_len > 0) && (tg > 0))
         {
           ReflectorClient* talker = TGHandler::instance()->talkerForTG(tg);
-          if (talker == 0)
+          if ((talker == 0) && (trunkTalkerForTG(tg) == 0))
           {
             TGHandler::instance()->setTalkerForTG(tg, client);
             talker = TGHandler::instance()->talkerForTG(tg);
@@ -456,10 +831,13 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
           if (talker == client)
           {
             TGHandler::instance()->setTalkerForTG(tg, client);
-            broadcastUdpMsg(msg,
-                ReflectorClient::mkAndFilter(
-                  ReflectorClient::ExceptFilter(client),
-                  ReflectorClient::TgFilter(tg)));
+            broadcastUdpPayload(MsgUdpAudio::TYPE, payload, 2 + audio_len,
+                TGHandler::instance()->clientsForTG(tg),
+                ReflectorClient::ExceptFilter(client));
+            if (isTrunkedTG(tg))
+            {
+              sendTrunkMsg(MsgTrunkAudio(tg, payload + 2, audio_len), tg);
+            }
             //broadcastUdpMsgExcept(tg, client, msg,
             //    ProtoVerRange(ProtoVer(0, 6),
             //                  ProtoVer(1, ProtoVer::max().minor())));
@@ -531,8 +909,9 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
     {
       if (!client->isBlocked())
       {
+        Async::MsgReader r(payload, payload_len);
         MsgUdpSignalStrengthValues msg;
-        if (!msg.unpack(ss))
+        if (!msg.unpack(r))
         {
           cerr << "*** WARNING[" << client->callsign()
                << "]: Could not unpack incoming "
@@ -555,6 +934,7 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
           client->setRxSqlOpen(rx.id(), rx.sqlOpen());
           client->setRxActive(rx.id(), rx.active());
         }
+        updateNodeStatus(client);
       }
       break;
     }
@@ -571,40 +951,77 @@ void Reflector::udpDatagramReceived(const IpAddress& addr, uint16_t port,
 } /* Reflector::udpDatagramReceived */
 
 
+void Reflector::udpDatagramsReceived(const UdpSocket::RecvDatagram *dgrams,
+                                     size_t count)
+{
+  for (size_t i=0; i<count; ++i)
+  {
+    const UdpSocket::RecvDatagram& dgram = dgrams[i];
+    udpDatagramReceived(dgram.remote_ip, dgram.remote_port, dgram.buf,
+                        dgram.len);
+  }
+} /* Reflector::udpDatagramsReceived */
+
+
+void Reflector::broadcastUdpPayload(uint16_t type, const void *payload,
+                                    size_t len,
+                                    const TGHandler::ClientList& clients,
+                                    const ReflectorClient::Filter& filter)
+{
+    // Size the header buffer before filling it in so that the pointers
+    // stored in the datagram descriptors stay valid
+  m_udp_batch.clear();
+  m_udp_batch_headers.resize(ReflectorUdpMsg::HEADER_SIZE * clients.size());
+  for (TGHandler::ClientList::const_iterator it = clients.begin();
+       it != clients.end(); ++it)
+  {
+    ReflectorClient *client = *it;
+    ReflectorUdpMsg header;
+    if (!filter(client) ||
+        (client->conState() != ReflectorClient::STATE_CONNECTED) ||
+        !client->nextUdpTxHeader(type, header))
+    {
+      continue;
+    }
+    uint8_t *hdr_buf = &m_udp_batch_headers[
+      ReflectorUdpMsg::HEADER_SIZE * m_udp_batch.size()];
+    header.packHeader(hdr_buf);
+    Async::UdpSocket::Datagram dgram;
+    dgram.remote_ip = client->remoteHost();
+    dgram.remote_port = client->remoteUdpPort();
+    dgram.header = hdr_buf;
+    dgram.header_len = ReflectorUdpMsg::HEADER_SIZE;
+    dgram.payload = payload;
+    dgram.payload_len = len;
+    m_udp_batch.push_back(dgram);
+  }
+  if (!m_udp_batch.empty())
+  {
+    m_udp_sock->writeBatch(&m_udp_batch[0], m_udp_batch.size());
+  }
+} /* Reflector::broadcastUdpPayload */
+
+
 void Reflector::onTalkerUpdated(uint32_t tg, ReflectorClient* old_talker,
                                 ReflectorClient *new_talker)
 {
+  updateRouting();
+
   if (old_talker != 0)
   {
+    updateNodeStatus(old_talker);
     cout << old_talker->callsign() << ": Talker stop on TG #" << tg << endl;
-    broadcastMsg(MsgTalkerStop(tg, old_talker->callsign()),
-        ReflectorClient::mkAndFilter(
-          v2_client_filter,
-          ReflectorClient::mkOrFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::TgMonitorFilter(tg))));
-    if (tg == tgForV1Clients())
-    {
-      broadcastMsg(MsgTalkerStopV1(old_talker->callsign()), v1_client_filter);
-    }
-    broadcastUdpMsg(MsgUdpFlushSamples(),
-          ReflectorClient::mkAndFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::ExceptFilter(old_talker)));
+    broadcastTalkerStop(tg, old_talker->callsign());
+    broadcastUdpMsg(MsgUdpFlushSamples(), tg,
+                    ReflectorClient::ExceptFilter(old_talker));
+    sendTrunkMsg(MsgTalkerStop(tg, old_talker->callsign()), tg);
   }
   if (new_talker != 0)
   {
+    updateNodeStatus(new_talker);
     cout << new_talker->callsign() << ": Talker start on TG #" << tg << endl;
-    broadcastMsg(MsgTalkerStart(tg, new_talker->callsign()),
-        ReflectorClient::mkAndFilter(
-          v2_client_filter,
-          ReflectorClient::mkOrFilter(
-            ReflectorClient::TgFilter(tg),
-            ReflectorClient::TgMonitorFilter(tg))));
-    if (tg == tgForV1Clients())
-    {
-      broadcastMsg(MsgTalkerStartV1(new_talker->callsign()), v1_client_filter);
-    }
+    broadcastTalkerStart(tg, new_talker->callsign());
+    sendTrunkMsg(MsgTalkerStart(tg, new_talker->callsign()), tg);
   }
 } /* Reflector::setTalker */
 
@@ -624,7 +1041,7 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     return;
   }
 
-  if (req.target != "/status")
+  if ((req.target != "/status") && (req.target != "/status/events"))
   {
     res.setCode(404);
     res.setContent("application/json",
@@ -633,89 +1050,30 @@ void Reflector::httpRequestReceived(Async::HttpServerConnection *con,
     return;
   }
 
-  Json::Value status;
-  status["nodes"] = Json::Value(Json::objectValue);
-  ReflectorClientMap::const_iterator client_it;
-  for (client_it = m_client_map.begin(); client_it != m_client_map.end(); ++client_it)
+  if (req.target == "/status/events")
   {
-    ReflectorClient* client = client_it->second;
-    Json::Value node(client->nodeInfo());
-    //node["addr"] = client->remoteHost().toString();
-    node["protoVer"]["majorVer"] = client->protoVer().majorVer();
-    node["protoVer"]["minorVer"] = client->protoVer().minorVer();
-    node["tg"] = client->currentTG();
-    Json::Value tgs = Json::Value(Json::arrayValue);
-    const std::set<uint32_t>& monitored_tgs = client->monitoredTGs();
-    for (std::set<uint32_t>::const_iterator mtg_it=monitored_tgs.begin();
-         mtg_it!=monitored_tgs.end(); ++mtg_it)
+      // Server-Sent Events. The full status is sent first and then patches
+      // containing the changed parts of the status.
+    if (req.method == "HEAD")
     {
-      tgs.append(*mtg_it);
-    }
-    node["monitoredTGs"] = tgs;
-    bool is_talker =
-      TGHandler::instance()->talkerForTG(client->currentTG()) == client;
-    node["isTalker"] = is_talker;
-
-    if (node.isMember("qth") && node["qth"].isArray())
-    {
-      //std::cout << "### Found qth" << std::endl;
-      Json::Value& qths(node["qth"]);
-      for (Json::Value::ArrayIndex i=0; i<qths.size(); ++i)
-      {
-        Json::Value& qth(qths[i]);
-        if (qth.isMember("rx") && qth["rx"].isObject())
-        {
-          //std::cout << "### Found rx" << std::endl;
-          Json::Value::Members rxs(qth["rx"].getMemberNames());
-          for (Json::Value::Members::const_iterator it=rxs.begin(); it!=rxs.end(); ++it)
-          {
-            //std::cout << "### member=" << *it << std::endl;
-            const std::string& rx_id_str(*it);
-            if (rx_id_str.size() == 1)
-            {
-              char rx_id(rx_id_str[0]);
-              Json::Value& rx(qth["rx"][rx_id_str]);
-              if (client->rxExist(rx_id))
-              {
-                rx["siglev"] = client->rxSiglev(rx_id);
-                rx["enabled"] = client->rxEnabled(rx_id);
-                rx["sql_open"] = client->rxSqlOpen(rx_id);
-                rx["active"] = client->rxActive(rx_id);
-              }
-            }
-          }
-        }
-        if (qth.isMember("tx") && qth["tx"].isObject())
-        {
-          //std::cout << "### Found tx" << std::endl;
-          Json::Value::Members txs(qth["tx"].getMemberNames());
-          for (Json::Value::Members::const_iterator it=txs.begin(); it!=txs.end(); ++it)
-          {
-            //std::cout << "### member=" << *it << std::endl;
-            const std::string& tx_id_str(*it);
-            if (tx_id_str.size() == 1)
-            {
-              char tx_id(tx_id_str[0]);
-              Json::Value& tx(qth["tx"][tx_id_str]);
-              if (client->txExist(tx_id))
-              {
-                tx["transmit"] = client->txTransmit(tx_id);
-              }
-            }
-          }
-        }
-      }
+      res.setCode(200);
+      res.setHeader("Content-type", "text/event-stream");
+      con->write(res);
+      return;
     }
-    status["nodes"][client->callsign()] = node;
+    res.setCode(200);
+    res.setHeader("Content-type", "text/event-stream");
+    res.setHeader("Cache-Control", "no-cache");
+    res.setSendContent(false);
+    con->write(res);
+    std::string event("event: status\ndata: " + statusStr() + "\n\n");
+    con->write(event.data(), event.size());
+    m_status_streams.insert(con);
+    m_status_keepalive_timer.setEnable(true);
+    return;
   }
-  std::ostringstream os;
-  Json::StreamWriterBuilder builder;
-  builder["commentStyle"] = "None";
-  builder["indentation"] = ""; //The JSON document is written on a single line
-  Json::StreamWriter* writer = builder.newStreamWriter();
-  writer->write(status, &os);
-  delete writer;
-  res.setContent("application/json", os.str());
+
+  res.setContent("application/json", statusStr());
   if (req.method == "HEAD")
   {
     res.setSendContent(false);
@@ -736,6 +1094,8 @@ void Reflector::httpClientConnected(Async::HttpServerConnection *con)
 void Reflector::httpClientDisconnected(Async::HttpServerConnection *con,
     Async::HttpServerConnection::DisconnectReason reason)
 {
+  m_status_streams.erase(con);
+  m_status_keepalive_timer.setEnable(!m_status_streams.empty());
   //std::cout << "### HTTP Client disconnected: "
   //          << con->remoteHost() << ":" << con->remotePort()
   //          << ": " << Async::HttpServerConnection::disconnectReasonStr(reason)
@@ -743,6 +1103,92 @@ void Reflector::httpClientDisconnected(Async::HttpServerConnection *con,
 } /* Reflector::httpClientDisconnected */
 
 
+void Reflector::removeNodeStatus(const std::string& callsign)
+{
+  if (!m_status["nodes"].isMember(callsign))
+  {
+    return;
+  }
+  m_status["nodes"].removeMember(callsign);
+  m_status_dirty = true;
+  if (!m_status_streams.empty())
+  {
+    m_status_patch["nodes"][callsign] = Json::Value(Json::nullValue);
+    m_status_push_timer.setEnable(true);
+  }
+} /* Reflector::removeNodeStatus */
+
+
+const std::string& Reflector::statusStr(void)
+{
+  if (m_status_dirty)
+  {
+    m_status_str = jsonStr(m_status);
+    m_status_dirty = false;
+  }
+  return m_status_str;
+} /* Reflector::statusStr */
+
+
+std::string Reflector::jsonStr(const Json::Value& value)
+{
+  if (m_json_writer == 0)
+  {
+    Json::StreamWriterBuilder builder;
+    builder["commentStyle"] = "None";
+    builder["indentation"] = ""; //The JSON document is written on a single line
+    m_json_writer = builder.newStreamWriter();
+  }
+  std::ostringstream os;
+  m_json_writer->write(value, &os);
+  return os.str();
+} /* Reflector::jsonStr */
+
+
+void Reflector::pushStatusPatch(Async::Timer *t)
+{
+  m_status_push_timer.setEnable(false);
+  if (m_status_patch.empty())
+  {
+    return;
+  }
+  writeStatusStreams("event: patch\ndata: " + jsonStr(m_status_patch) +
+                     "\n\n");
+  m_status_patch = Json::Value(Json::objectValue);
+} /* Reflector::pushStatusPatch */
+
+
+void Reflector::sendStatusKeepalive(Async::Timer *t)
+{
+    // A comment line keep proxies from closing idle event streams
+  writeStatusStreams(":\n\n");
+} /* Reflector::sendStatusKeepalive */
+
+
+void Reflector::writeStatusStreams(const std::string& data)
+{
+  std::vector<Async::HttpServerConnection*> failed;
+  for (StatusStreamSet::const_iterator it = m_status_streams.begin();
+       it != m_status_streams.end(); ++it)
+  {
+    if (!(*it)->write(data.data(), data.size()))
+    {
+      failed.push_back(*it);
+    }
+  }
+
+    // Clients that cannot keep up are disconnected. They will get the full
+    // status when they reconnect.
+  for (std::vector<Async::HttpServerConnection*>::iterator it = failed.begin();
+       it != failed.end(); ++it)
+  {
+    Async::HttpServerConnection *con = *it;
+    con->disconnect();
+    con->disconnected(con, Async::HttpServerConnection::DR_ORDERED_DISCONNECT);
+  }
+} /* Reflector::writeStatusStreams */
+
+
 void Reflector::onRequestAutoQsy(uint32_t from_tg)
 {
   uint32_t tg = nextRandomQsyTg();
@@ -751,13 +1197,75 @@ void Reflector::onRequestAutoQsy(uint32_t from_tg)
   std::cout << "Requesting auto-QSY from TG #" << from_tg
             << " to TG #" << tg << std::endl;
 
-  broadcastMsg(MsgRequestQsy(tg),
-      ReflectorClient::mkAndFilter(
-        v2_client_filter,
-        ReflectorClient::TgFilter(from_tg)));
+  broadcastTgMsg(MsgRequestQsy(tg), from_tg, false, v2_client_filter);
 } /* Reflector::onRequestAutoQsy */
 
 
+void Reflector::publishRouting(void)
+{
+  m_routing_update_pending = false;
+
+  std::shared_ptr<ReflectorUdpWorker::Routing> routing =
+    std::make_shared<ReflectorUdpWorker::Routing>();
+  routing->clients.reserve(m_client_map.size());
+  TGHandler *tg_handler = TGHandler::instance();
+  for (ReflectorClientMap::const_iterator it = m_client_map.begin();
+       it != m_client_map.end(); ++it)
+  {
+    ReflectorClient *client = (*it).second;
+    ReflectorUdpWorker::Route route;
+    route.client_id = client->clientId();
+    route.addr = client->remoteHost();
+    route.port = client->remoteUdpPort();
+    route.tg = tg_handler->TGForClient(client);
+    route.connected =
+      (client->conState() == ReflectorClient::STATE_CONNECTED) &&
+      (route.port != 0);
+    route.blocked = client->blockActive();
+    route.state = client->udpState();
+
+    size_t idx = routing->clients.size();
+    routing->clients.push_back(route);
+    routing->client_idx[route.client_id] = idx;
+    if (route.connected && (route.tg > 0))
+    {
+      routing->tg_receivers[route.tg].push_back(idx);
+        // Audio on trunked talk groups must also be sent to the trunk
+        // peers so it is always handled by the main thread
+      if ((tg_handler->talkerForTG(route.tg) == client) &&
+          !isTrunkedTG(route.tg))
+      {
+        routing->tg_talker[route.tg] = route.client_id;
+      }
+    }
+  }
+
+  ReflectorUdpWorker::RoutingPtr snapshot(routing);
+  for (std::vector<ReflectorUdpWorker*>::iterator it = m_udp_workers.begin();
+       it != m_udp_workers.end(); ++it)
+  {
+    (*it)->setRouting(snapshot);
+  }
+} /* Reflector::publishRouting */
+
+
+void Reflector::onWorkerTalkerActive(uint32_t client_id)
+{
+  ReflectorClientMap::iterator it = m_client_map.find(client_id);
+  if (it == m_client_map.end())
+  {
+    return;
+  }
+  ReflectorClient *client = (*it).second;
+  uint32_t tg = TGHandler::instance()->TGForClient(client);
+  if ((tg > 0) && (TGHandler::instance()->talkerForTG(tg) == client))
+  {
+      // Refresh the talker timestamp so that the talker does not time out
+    TGHandler::instance()->setTalkerForTG(tg, client);
+  }
+} /* Reflector::onWorkerTalkerActive */
+
+
 uint32_t Reflector::nextRandomQsyTg(void)
 {
   if (m_random_qsy_tg == 0)
@@ -785,6 +1293,254 @@ uint32_t Reflector::nextRandomQsyTg(void)
 } /* Reflector::nextRandomQsyTg */
 
 
+bool Reflector::initTrunks(void)
+{
+  std::list<std::string> sections = m_cfg->listSections();
+  for (std::list<std::string>::const_iterator it = sections.begin();
+       it != sections.end(); ++it)
+  {
+    const std::string& section = *it;
+    if ((section.size() <= 6) || (section.compare(0, 6, "TRUNK_") != 0))
+    {
+      continue;
+    }
+    std::string trunk_id;
+    if (m_trunks.empty() &&
+        (!m_cfg->getValue("GLOBAL", "TRUNK_ID", trunk_id) ||
+         !ReflectorTrunk::parseId(trunk_id, m_trunk_id)))
+    {
+      cerr << "*** ERROR: GLOBAL/TRUNK_ID must be set to a number when "
+              "trunks are configured" << endl;
+      return false;
+    }
+    uint32_t peer_id = 0;
+    if (!ReflectorTrunk::parseId(section.substr(6), peer_id))
+    {
+      cerr << "*** ERROR: The trunk id in the configuration section name "
+           << section << " must be a number" << endl;
+      return false;
+    }
+    if (peer_id == m_trunk_id)
+    {
+      cerr << "*** ERROR: The trunk id in the configuration section name "
+           << section << " is the same as GLOBAL/TRUNK_ID" << endl;
+      return false;
+    }
+    for (TrunkList::const_iterator trunk_it = m_trunks.begin();
+         trunk_it != m_trunks.end(); ++trunk_it)
+    {
+      if ((*trunk_it)->peerId() == peer_id)
+      {
+        cerr << "*** ERROR: More than one trunk configuration section for "
+                "trunk id " << peer_id << endl;
+        return false;
+      }
+    }
+    ReflectorTrunk *trunk = new ReflectorTrunk(this, m_trunk_id, peer_id);
+    m_trunks.push_back(trunk);
+    if (!trunk->initialize(*m_cfg, section))
+    {
+      return false;
+    }
+  }
+
+  if (m_trunks.empty())
+  {
+    return true;
+  }
+  updateTrunkStatus();
+
+  std::string trunk_listen_port("5302");
+  m_cfg->getValue("GLOBAL", "TRUNK_LISTEN_PORT", trunk_listen_port);
+  m_trunk_srv = new FramedTcpServer(trunk_listen_port);
+  m_trunk_srv->clientConnected.connect(
+      mem_fun(*this, &Reflector::trunkClientConnected));
+  m_trunk_srv->clientDisconnected.connect(
+      mem_fun(*this, &Reflector::trunkClientDisconnected));
+  cout << "Trunk " << m_trunk_id << ": Listening for trunk peers on port "
+       << trunk_listen_port << endl;
+
+  return true;
+} /* Reflector::initTrunks */
+
+
+void Reflector::trunkClientConnected(Async::FramedTcpConnection *con)
+{
+  cout << "Trunk connection from " << con->remoteHost() << ":"
+       << con->remotePort() << endl;
+  con->setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
+  con->frameReceived.connect(
+      mem_fun(*this, &Reflector::trunkFrameReceived));
+
+  MsgAuthChallenge challenge_msg;
+  m_trunk_pending[con].assign(challenge_msg.challenge(),
+      challenge_msg.challenge() + MsgAuthChallenge::CHALLENGE_LEN);
+
+  ReflectorMsg header(challenge_msg.type());
+  std::vector<uint8_t> buf;
+  Async::MsgWriter w(buf);
+  if (header.pack(w) && challenge_msg.pack(w))
+  {
+    con->write(w.data(), w.size());
+  }
+} /* Reflector::trunkClientConnected */
+
+
+void Reflector::trunkClientDisconnected(Async::FramedTcpConnection *con,
+    Async::FramedTcpConnection::DisconnectReason reason)
+{
+  m_trunk_pending.erase(con);
+  TrunkConMap::iterator it = m_trunk_con_map.find(con);
+  if (it != m_trunk_con_map.end())
+  {
+    ReflectorTrunk *trunk = (*it).second;
+    m_trunk_con_map.erase(it);
+    trunk->inboundDisconnected(con);
+  }
+} /* Reflector::trunkClientDisconnected */
+
+
+void Reflector::trunkFrameReceived(Async::FramedTcpConnection *con,
+                                   std::vector<uint8_t>& data)
+{
+  TrunkConMap::iterator con_it = m_trunk_con_map.find(con);
+  if (con_it != m_trunk_con_map.end())
+  {
+    (*con_it).second->inboundFrameReceived(data);
+    return;
+  }
+
+  TrunkPendingMap::iterator pending_it = m_trunk_pending.find(con);
+  if ((pending_it == m_trunk_pending.end()) || data.empty())
+  {
+    return;
+  }
+
+  stringstream ss;
+  ss.write(reinterpret_cast<char*>(&data.front()), data.size());
+  ReflectorMsg header;
+  MsgAuthResponse msg;
+  if (!header.unpack(ss) || (header.type() == MsgHeartbeat::TYPE))
+  {
+    return;
+  }
+
+  ReflectorTrunk *trunk = 0;
+  if ((header.type() == MsgAuthResponse::TYPE) && msg.unpack(ss))
+  {
+    for (TrunkList::const_iterator it = m_trunks.begin();
+         it != m_trunks.end(); ++it)
+    {
+      if ((*it)->verify(msg, &(*pending_it).second.front()))
+      {
+        trunk = *it;
+        break;
+      }
+    }
+  }
+  m_trunk_pending.erase(pending_it);
+
+  if (trunk == 0)
+  {
+    cout << "Trunk connection from " << con->remoteHost() << ":"
+         << con->remotePort() << ": Authentication failed for peer \""
+         << msg.callsign() << "\"" << endl;
+    con->disconnect();
+    con->disconnected(con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
+    return;
+  }
+
+  trunk->setInboundConnection(con);
+  m_trunk_con_map[con] = trunk;
+} /* Reflector::trunkFrameReceived */
+
+
+bool Reflector::isTrunkedTG(uint32_t tg) const
+{
+  for (TrunkList::const_iterator it = m_trunks.begin(); it != m_trunks.end();
+       ++it)
+  {
+    if ((*it)->sharesTG(tg))
+    {
+      return true;
+    }
+  }
+  return false;
+} /* Reflector::isTrunkedTG */
+
+
+const Reflector::TrunkTalker* Reflector::trunkTalkerForTG(uint32_t tg) const
+{
+  TrunkTalkerMap::const_iterator it = m_trunk_talkers.find(tg);
+  if (it == m_trunk_talkers.end())
+  {
+    return 0;
+  }
+  return &(*it).second;
+} /* Reflector::trunkTalkerForTG */
+
+
+void Reflector::clearTrunkTalker(uint32_t tg)
+{
+  TrunkTalkerMap::iterator it = m_trunk_talkers.find(tg);
+  if (it == m_trunk_talkers.end())
+  {
+    return;
+  }
+  std::string callsign = (*it).second.callsign;
+  cout << callsign << ": Talker stop on TG #" << tg << " via trunk "
+       << (*it).second.trunk->peerId() << endl;
+  m_trunk_talkers.erase(it);
+  m_trunk_talker_timer.setEnable(!m_trunk_talkers.empty());
+  broadcastTalkerStop(tg, callsign);
+  broadcastUdpMsg(MsgUdpFlushSamples(), tg);
+} /* Reflector::clearTrunkTalker */
+
+
+void Reflector::checkTrunkTalkers(Async::Timer *t)
+{
+    // A talker stop may be lost, e.g. if the peer reflector hangs, so a
+    // trunk talker is also stopped when no audio has been received from it
+    // for a while, just like a local talker
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  TrunkTalkerMap::iterator it = m_trunk_talkers.begin();
+  while (it != m_trunk_talkers.end())
+  {
+    TrunkTalkerMap::iterator talker_it = it++;
+    struct timeval diff;
+    timersub(&now, &(*talker_it).second.last_audio, &diff);
+    if (diff.tv_sec > TRUNK_TALKER_AUDIO_TIMEOUT)
+    {
+      cout << (*talker_it).second.callsign << ": Talker audio timeout on TG #"
+           << (*talker_it).first << " via trunk "
+           << (*talker_it).second.trunk->peerId() << endl;
+      clearTrunkTalker((*talker_it).first);
+    }
+  }
+} /* Reflector::checkTrunkTalkers */
+
+
+void Reflector::broadcastTalkerStart(uint32_t tg, const std::string& callsign)
+{
+  broadcastTgMsg(MsgTalkerStart(tg, callsign), tg, true, v2_client_filter);
+  if (tg == tgForV1Clients())
+  {
+    broadcastMsg(MsgTalkerStartV1(callsign), v1_client_filter);
+  }
+} /* Reflector::broadcastTalkerStart */
+
+
+void Reflector::broadcastTalkerStop(uint32_t tg, const std::string& callsign)
+{
+  broadcastTgMsg(MsgTalkerStop(tg, callsign), tg, true, v2_client_filter);
+  if (tg == tgForV1Clients())
+  {
+    broadcastMsg(MsgTalkerStopV1(callsign), v1_client_filter);
+  }
+} /* Reflector::broadcastTalkerStop */
+
+
 /*
  * This file has not been truncated
  */
@@ -37,7 +37,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sigc++/sigc++.h>
 #include <sys/time.h>
 #include <vector>
+#include <map>
+#include <set>
 #include <string>
+#include <json/json.h>
 
 
 /****************************************************************************
@@ -49,6 +52,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncTcpServer.h>
 #include <AsyncFramedTcpConnection.h>
 #include <AsyncTimer.h>
+#include <AsyncUdpSocket.h>
 #include <AsyncHttpServerConnection.h>
 
 
@@ -60,6 +64,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "ProtoVer.h"
 #include "ReflectorClient.h"
+#include "TGHandler.h"
+#include "ReflectorUdpWorker.h"
 
 
 /****************************************************************************
@@ -70,12 +76,12 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 namespace Async
 {
-  class UdpSocket;
   class Config;
 };
 
 class ReflectorMsg;
 class ReflectorUdpMsg;
+class ReflectorTrunk;
 
 
 /****************************************************************************
@@ -157,6 +163,21 @@ class Reflector : public sigc::trackable
     void broadcastMsg(const ReflectorMsg& msg,
         const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
 
+    /**
+     * @brief   Send a TCP message to the clients on a talk group
+     * @param   msg The message to send
+     * @param   tg The talk group
+     * @param   incl_monitors Set to \em true to also send to monitoring clients
+     * @param   filter The client filter to apply
+     *
+     * Only the clients that have selected the talk group, and optionally
+     * the clients monitoring it, are visited. Each client get the message
+     * at most once.
+     */
+    void broadcastTgMsg(const ReflectorMsg& msg, uint32_t tg,
+        bool incl_monitors,
+        const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
+
     /**
      * @brief   Send a UDP datagram to the specificed ReflectorClient
      * @param   client The client to the send datagram to
@@ -166,7 +187,18 @@ class Reflector : public sigc::trackable
      */
     bool sendUdpDatagram(ReflectorClient *client, const void *buf, size_t count);
 
-    void broadcastUdpMsg(const ReflectorUdpMsg& msg,
+    /**
+     * @brief   Send a UDP message to the clients on a talk group
+     * @param   msg The message to send
+     * @param   tg The talk group
+     * @param   filter The client filter to apply
+     *
+     * The message payload is packed only once and then sent to all clients
+     * that have selected the talk group and match the filter. Only the
+     * message header, containing the client ID and sequence number, differ
+     * between the clients.
+     */
+    void broadcastUdpMsg(const ReflectorUdpMsg& msg, uint32_t tg,
         const ReflectorClient::Filter& filter=ReflectorClient::NoFilter());
 
     /**
@@ -181,11 +213,109 @@ class Reflector : public sigc::trackable
      */
     void requestQsy(ReflectorClient *client, uint32_t tg);
 
+    /**
+     * @brief   Tell the reflector that the UDP routing may have changed
+     *
+     * This function should be called when anything that affect how UDP
+     * audio is relayed has changed, e.g. the talk group or UDP port of a
+     * client. When UDP worker threads are used, a new routing snapshot is
+     * published to them from the main loop. Several calls in a row only
+     * cause one snapshot to be created.
+     */
+    void updateRouting(void);
+
+    /**
+     * @brief   Send a TCP message to all connected trunk peers
+     * @param   msg The message to send
+     * @param   tg  Only send to peers sharing this talk group (0 = all)
+     */
+    void sendTrunkMsg(const ReflectorMsg& msg, uint32_t tg=0);
+
+    /**
+     * @brief   Called by a trunk when the link to the peer is up
+     * @param   trunk The trunk
+     *
+     * The current local state, i.e. the connected nodes and the talkers on
+     * the shared talk groups, is sent to the peer.
+     */
+    void trunkConnected(ReflectorTrunk *trunk);
+
+    /**
+     * @brief   Called by a trunk when the peer has disconnected
+     * @param   trunk The trunk
+     */
+    void trunkDisconnected(ReflectorTrunk *trunk);
+
+    /**
+     * @brief   Called by a trunk when a remote talker start talking
+     * @param   trunk     The trunk
+     * @param   tg        The talk group
+     * @param   callsign  The callsign of the remote talker
+     *
+     * If the talk group already have a talker, the talker on the reflector
+     * with the lowest trunk id win. All reflectors make the same decision so
+     * they will agree on who the talker is.
+     */
+    void trunkTalkerStart(ReflectorTrunk *trunk, uint32_t tg,
+                          const std::string& callsign);
+
+    /**
+     * @brief   Called by a trunk when a remote talker stop talking
+     * @param   trunk     The trunk
+     * @param   tg        The talk group
+     * @param   callsign  The callsign of the remote talker
+     */
+    void trunkTalkerStop(ReflectorTrunk *trunk, uint32_t tg,
+                         const std::string& callsign);
+
+    /**
+     * @brief   Called by a trunk when audio from a remote talker is received
+     * @param   trunk The trunk
+     * @param   tg    The talk group
+     * @param   audio The encoded audio
+     */
+    void trunkAudio(ReflectorTrunk *trunk, uint32_t tg,
+                    const std::vector<uint8_t>& audio);
+
+    /**
+     * @brief   Update the cached status for a client
+     * @param   client The client that has changed
+     *
+     * This function should be called when anything that is shown in the
+     * status document for a client has changed. Only the part of the status
+     * belonging to the client is rebuilt. The document is rendered at most
+     * once per change, when it is requested, and the change is pushed to
+     * the clients of the status event stream.
+     */
+    void updateNodeStatus(ReflectorClient *client);
+
+    /**
+     * @brief   Update the cached status for the trunks
+     */
+    void updateTrunkStatus(void);
+
   private:
     typedef std::map<uint32_t, ReflectorClient*> ReflectorClientMap;
     typedef std::map<Async::FramedTcpConnection*,
                      ReflectorClient*> ReflectorClientConMap;
     typedef Async::TcpServer<Async::FramedTcpConnection> FramedTcpServer;
+    typedef std::vector<ReflectorTrunk*> TrunkList;
+    typedef std::map<Async::FramedTcpConnection*,
+                     std::vector<uint8_t> > TrunkPendingMap;
+    typedef std::map<Async::FramedTcpConnection*,
+                     ReflectorTrunk*> TrunkConMap;
+    struct TrunkTalker
+    {
+      ReflectorTrunk* trunk;
+      std::string     callsign;
+      struct timeval  last_audio;
+    };
+    typedef std::map<uint32_t, TrunkTalker> TrunkTalkerMap;
+    typedef std::set<Async::HttpServerConnection*> StatusStreamSet;
+
+    static const unsigned STATUS_PUSH_DELAY_MS  = 250;
+    static const unsigned STATUS_KEEPALIVE_MS   = 15000;
+    static const time_t   TRUNK_TALKER_AUDIO_TIMEOUT = 3; // Max 3s gap
 
     FramedTcpServer*                                m_srv;
     Async::UdpSocket*                               m_udp_sock;
@@ -197,6 +327,26 @@ class Reflector : public sigc::trackable
     uint32_t                                        m_random_qsy_hi;
     uint32_t                                        m_random_qsy_tg;
     Async::TcpServer<Async::HttpServerConnection>*  m_http_server;
+    std::vector<Async::UdpSocket::Datagram>         m_udp_batch;
+    std::vector<uint8_t>                            m_udp_batch_headers;
+    std::vector<uint8_t>                            m_udp_payload_buf;
+    std::vector<ReflectorUdpWorker*>                m_udp_workers;
+    bool                                            m_routing_update_pending;
+    uint32_t                                        m_trunk_id;
+    FramedTcpServer*                                m_trunk_srv;
+    TrunkList                                       m_trunks;
+    TrunkPendingMap                                 m_trunk_pending;
+    TrunkConMap                                     m_trunk_con_map;
+    TrunkTalkerMap                                  m_trunk_talkers;
+    Async::Timer                                    m_trunk_talker_timer;
+    Json::Value                                     m_status;
+    std::string                                     m_status_str;
+    bool                                            m_status_dirty;
+    Json::StreamWriter*                             m_json_writer;
+    Json::Value                                     m_status_patch;
+    StatusStreamSet                                 m_status_streams;
+    Async::Timer                                    m_status_push_timer;
+    Async::Timer                                    m_status_keepalive_timer;
 
     Reflector(const Reflector&);
     Reflector& operator=(const Reflector&);
@@ -205,6 +355,11 @@ class Reflector : public sigc::trackable
                             Async::FramedTcpConnection::DisconnectReason reason);
     void udpDatagramReceived(const Async::IpAddress& addr, uint16_t port,
                              void *buf, int count);
+    void udpDatagramsReceived(const Async::UdpSocket::RecvDatagram *dgrams,
+                              size_t count);
+    void broadcastUdpPayload(uint16_t type, const void *payload, size_t len,
+                             const TGHandler::ClientList& clients,
+                             const ReflectorClient::Filter& filter);
     void onTalkerUpdated(uint32_t tg, ReflectorClient* old_talker,
                          ReflectorClient *new_talker);
     void httpRequestReceived(Async::HttpServerConnection *con,
@@ -213,7 +368,27 @@ class Reflector : public sigc::trackable
     void httpClientDisconnected(Async::HttpServerConnection *con,
         Async::HttpServerConnection::DisconnectReason reason);
     void onRequestAutoQsy(uint32_t from_tg);
+    void publishRouting(void);
+    void onWorkerTalkerActive(uint32_t client_id);
     uint32_t nextRandomQsyTg(void);
+    bool initTrunks(void);
+    void trunkClientConnected(Async::FramedTcpConnection *con);
+    void trunkClientDisconnected(Async::FramedTcpConnection *con,
+        Async::FramedTcpConnection::DisconnectReason reason);
+    void trunkFrameReceived(Async::FramedTcpConnection *con,
+                            std::vector<uint8_t>& data);
+    bool isTrunkedTG(uint32_t tg) const;
+    const TrunkTalker* trunkTalkerForTG(uint32_t tg) const;
+    void clearTrunkTalker(uint32_t tg);
+    void checkTrunkTalkers(Async::Timer *t);
+    void broadcastTalkerStart(uint32_t tg, const std::string& callsign);
+    void broadcastTalkerStop(uint32_t tg, const std::string& callsign);
+    void removeNodeStatus(const std::string& callsign);
+    const std::string& statusStr(void);
+    std::string jsonStr(const Json::Value& value);
+    void pushStatusPatch(Async::Timer *t);
+    void sendStatusKeepalive(Async::Timer *t);
+    void writeStatusStreams(const std::string& data);
 
 };  /* class Reflector */
 
@@ -133,7 +133,7 @@ ReflectorClient::ReflectorClient(Reflector *ref, Async::FramedTcpConnection *con
   : m_con(con), m_con_state(STATE_EXPECT_PROTO_VER),
     m_disc_timer(10000, Timer::TYPE_ONESHOT, false),
     m_client_id(next_client_id++), m_remote_udp_port(0), m_cfg(cfg),
-    m_next_udp_tx_seq(0), m_next_udp_rx_seq(0),
+    m_udp_state(std::make_shared<UdpState>()),
     m_heartbeat_timer(1000, Timer::TYPE_PERIODIC),
     m_heartbeat_tx_cnt(HEARTBEAT_TX_CNT_RESET),
     m_heartbeat_rx_cnt(HEARTBEAT_RX_CNT_RESET),
@@ -143,6 +143,7 @@ ReflectorClient::ReflectorClient(Reflector *ref, Async::FramedTcpConnection *con
     m_current_tg(0)
 {
   m_con->setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
+  m_con->setMaxTxQueueSize(MAX_TX_QUEUE_SIZE);
   m_con->frameReceived.connect(
       mem_fun(*this, &ReflectorClient::onFrameReceived));
   m_disc_timer.expired.connect(
@@ -189,8 +190,7 @@ ReflectorClient::~ReflectorClient(void)
 
 int ReflectorClient::sendMsg(const ReflectorMsg& msg)
 {
-  if (((m_con_state != STATE_CONNECTED) && (msg.type() >= 100)) ||
-      !m_con->isConnected())
+  if (!canSend(msg.type()))
   {
     errno = ENOTCONN;
     return -1;
@@ -199,20 +199,58 @@ int ReflectorClient::sendMsg(const ReflectorMsg& msg)
   m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
 
   ReflectorMsg header(msg.type());
-  ostringstream ss;
-  if (!header.pack(ss) || !msg.pack(ss))
+  m_pack_buf.clear();
+  Async::MsgWriter w(m_pack_buf);
+  if (!header.pack(w) || !msg.pack(w))
   {
     cerr << "*** ERROR: Failed to pack TCP message\n";
     errno = EBADMSG;
     return -1;
   }
-  return m_con->write(ss.str().data(), ss.str().size());
+  return checkTxResult(m_con->write(w.data(), w.size()));
 } /* ReflectorClient::sendMsg */
 
 
+int ReflectorClient::sendFrame(uint16_t type,
+                               const Async::FramedTcpConnection::FramePtr& frame)
+{
+  if (!canSend(type))
+  {
+    errno = ENOTCONN;
+    return -1;
+  }
+
+  m_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+
+  return checkTxResult(m_con->write(frame));
+} /* ReflectorClient::sendFrame */
+
+
+Async::FramedTcpConnection::FramePtr ReflectorClient::packMsg(
+    const ReflectorMsg& msg)
+{
+  std::vector<uint8_t> buf;
+  Async::MsgWriter w(buf);
+  ReflectorMsg header(msg.type());
+  if (!header.pack(w) || !msg.pack(w))
+  {
+    cerr << "*** ERROR: Failed to pack TCP message\n";
+    return Async::FramedTcpConnection::FramePtr();
+  }
+  return Async::FramedTcpConnection::createFrame(w.data(), w.size());
+} /* ReflectorClient::packMsg */
+
+
+void ReflectorClient::setRemoteUdpPort(uint16_t port)
+{
+  m_remote_udp_port = port;
+  m_reflector->updateRouting();
+} /* ReflectorClient::setRemoteUdpPort */
+
+
 void ReflectorClient::udpMsgReceived(const ReflectorUdpMsg &header)
 {
-  m_next_udp_rx_seq = header.sequenceNum() + 1;
+  m_udp_state->next_rx_seq = header.sequenceNum() + 1;
 
   m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
 
@@ -225,24 +263,37 @@ void ReflectorClient::udpMsgReceived(const ReflectorUdpMsg &header)
 
 void ReflectorClient::sendUdpMsg(const ReflectorUdpMsg &msg)
 {
-  if (remoteUdpPort() == 0)
+  ReflectorUdpMsg header;
+  if (!nextUdpTxHeader(msg.type(), header))
   {
     return;
   }
 
-  m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
-
-  ReflectorUdpMsg header(msg.type(), clientId(), nextUdpTxSeq());
-  ostringstream ss;
-  assert(header.pack(ss) && msg.pack(ss));
-  (void)m_reflector->sendUdpDatagram(this, ss.str().data(), ss.str().size());
+  m_pack_buf.clear();
+  Async::MsgWriter w(m_pack_buf);
+  assert(header.pack(w) && msg.pack(w));
+  (void)m_reflector->sendUdpDatagram(this, w.data(), w.size());
 } /* ReflectorClient::sendUdpMsg */
 
 
+bool ReflectorClient::nextUdpTxHeader(uint16_t type, ReflectorUdpMsg &header)
+{
+  if (remoteUdpPort() == 0)
+  {
+    return false;
+  }
+
+  m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+  header = ReflectorUdpMsg(type, clientId(), nextUdpTxSeq());
+  return true;
+} /* ReflectorClient::nextUdpTxHeader */
+
+
 void ReflectorClient::setBlock(unsigned blocktime)
 {
   m_blocktime = blocktime;
   m_remaining_blocktime = blocktime;
+  m_reflector->updateRouting();
 } /* ReflectorClient::setBlock */
 
 
@@ -447,7 +498,10 @@ void ReflectorClient::handleMsgAuthResponse(std::istream& is)
         TGHandler::instance()->switchTo(this, m_reflector->tgForV1Clients());
         m_current_tg = m_reflector->tgForV1Clients();
       }
+      m_reflector->updateRouting();
+      m_reflector->updateNodeStatus(this);
       m_reflector->broadcastMsg(MsgNodeJoined(m_callsign), ExceptFilter(this));
+      m_reflector->sendTrunkMsg(MsgNodeJoined(m_callsign));
     }
     else
     {
@@ -481,10 +535,8 @@ void ReflectorClient::handleSelectTG(std::istream& is)
     ReflectorClient *talker = TGHandler::instance()->talkerForTG(m_current_tg);
     if (talker == this)
     {
-      m_reflector->broadcastUdpMsg(MsgUdpFlushSamples(),
-          mkAndFilter(
-            TgFilter(m_current_tg),
-            ExceptFilter(this)));
+      m_reflector->broadcastUdpMsg(MsgUdpFlushSamples(), m_current_tg,
+                                   ExceptFilter(this));
     }
     else if (talker != 0)
     {
@@ -492,6 +544,8 @@ void ReflectorClient::handleSelectTG(std::istream& is)
     }
     m_current_tg = msg.tg();
     TGHandler::instance()->switchTo(this, msg.tg());
+    m_reflector->updateRouting();
+    m_reflector->updateNodeStatus(this);
   }
 } /* ReflectorClient::handleSelectTG */
 
@@ -512,6 +566,8 @@ void ReflectorClient::handleTgMonitor(std::istream& is)
   cout << "]" << endl;
 
   m_monitored_tgs = tgs;
+  TGHandler::instance()->setMonitoredTGs(this, tgs);
+  m_reflector->updateNodeStatus(this);
 } /* ReflectorClient::handleTgMonitor */
 
 
@@ -537,6 +593,7 @@ void ReflectorClient::handleNodeInfo(std::istream& is)
               << "]: Failed to parse MsgNodeInfo JSON object: "
               << e.what() << std::endl;
   }
+  m_reflector->updateNodeStatus(this);
 } /* ReflectorClient::handleNodeInfo */
 
 
@@ -566,6 +623,7 @@ void ReflectorClient::handleMsgSignalStrengthValues(std::istream& is)
     setRxSqlOpen(rx.id(), rx.sqlOpen());
     setRxActive(rx.id(), rx.active());
   }
+  m_reflector->updateNodeStatus(this);
 } /* ReflectorClient::handleMsgSignalStrengthValues */
 
 
@@ -588,6 +646,7 @@ void ReflectorClient::handleMsgTxStatus(std::istream& is)
     //  << std::endl;
     setTxTransmit(tx.id(), tx.transmit());
   }
+  m_reflector->updateNodeStatus(this);
 } /* ReflectorClient::handleMsgTxStatus */
 
 
@@ -733,6 +792,7 @@ void ReflectorClient::sendError(const std::string& msg)
   m_remote_udp_port = 0;
   m_disc_timer.setEnable(true);
   m_con_state = STATE_EXPECT_DISCONNECT;
+  m_reflector->updateRouting();
 } /* ReflectorClient::sendError */
 
 
@@ -753,6 +813,36 @@ void ReflectorClient::disconnect(void)
 } /* ReflectorClient::disconnect */
 
 
+bool ReflectorClient::canSend(uint16_t type) const
+{
+  return ((m_con_state == STATE_CONNECTED) || (type < 100)) &&
+         m_con->isConnected();
+} /* ReflectorClient::canSend */
+
+
+int ReflectorClient::checkTxResult(int ret)
+{
+  if ((ret == -1) && (errno == ENOBUFS))
+  {
+      // The client is not reading fast enough. Drop the connection directly,
+      // freeing the queued frames, and let the disconnect timer do the
+      // cleanup since we may be called while the reflector is iterating
+      // over the clients.
+    cerr << "*** WARNING[" << m_callsign << "]: The TCP transmit queue is "
+            "full. Disconnecting the client." << endl;
+    m_heartbeat_timer.setEnable(false);
+    m_remote_udp_port = 0;
+    m_con->disconnect();
+    m_con_state = STATE_EXPECT_DISCONNECT;
+    m_disc_timer.setTimeout(0);
+    m_disc_timer.setEnable(true);
+    m_reflector->updateRouting();
+    errno = ENOBUFS;
+  }
+  return ret;
+} /* ReflectorClient::checkTxResult */
+
+
 void ReflectorClient::handleHeartbeat(Async::Timer *t)
 {
   if (--m_heartbeat_tx_cnt == 0)
@@ -780,6 +870,12 @@ void ReflectorClient::handleHeartbeat(Async::Timer *t)
     sendError("TCP heartbeat timeout");
   }
 
+    // Datagrams handled by a UDP worker thread are not seen by the main
+    // thread so the worker just flag that the client is alive
+  if (m_udp_state->rx_active.exchange(false))
+  {
+    m_udp_heartbeat_rx_cnt = UDP_HEARTBEAT_RX_CNT_RESET;
+  }
   if (--m_udp_heartbeat_rx_cnt == 0)
   {
     if (!callsign().empty())
@@ -800,6 +896,7 @@ void ReflectorClient::handleHeartbeat(Async::Timer *t)
     if (m_remaining_blocktime == 0)
     {
       m_blocktime = 0;
+      m_reflector->updateRouting();
     }
     else
     {
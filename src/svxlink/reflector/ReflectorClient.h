@@ -35,6 +35,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <string>
+#include <atomic>
+#include <memory>
 #include <json/json.h>
 
 
@@ -134,6 +136,23 @@ class ReflectorClient
     };
     typedef std::map<char, Tx> TxMap;
 
+      /**
+       * @brief The UDP state that is shared with the UDP worker threads
+       *
+       * The sequence numbers are atomic since UDP messages to and from a
+       * client may be handled both by the main thread and by a UDP worker
+       * thread. The worker threads keep a reference to the object so it
+       * stay valid after the client has been deleted.
+       */
+    struct UdpState
+    {
+      std::atomic<uint16_t> next_tx_seq;  ///< Next UDP transmit sequence
+      std::atomic<uint16_t> next_rx_seq;  ///< Next expected UDP sequence
+      std::atomic<bool>     rx_active;    ///< A worker received a datagram
+
+      UdpState(void) : next_tx_seq(0), next_rx_seq(0), rx_active(false) {}
+    };
+
     class Filter
     {
       public:
@@ -282,7 +301,7 @@ class ReflectorClient
      * client so that UDP packets can be send to the client and check that
      * incoming packets originate from the correct port.
      */
-    void setRemoteUdpPort(uint16_t port) { m_remote_udp_port = port; }
+    void setRemoteUdpPort(uint16_t port);
 
     /**
      * @brief   Get the callsign for this connection
@@ -300,7 +319,7 @@ class ReflectorClient
      * used by the receiver to find out if a packet is out of order or if a
      * packet has been lost in transit.
      */
-    uint16_t nextUdpTxSeq(void) { return m_next_udp_tx_seq++; }
+    uint16_t nextUdpTxSeq(void) { return m_udp_state->next_tx_seq++; }
 
     /**
      * @brief   Get the next expected UDP packet sequence number
@@ -309,7 +328,16 @@ class ReflectorClient
      * This function will return the next expected UDP sequence number, which
      * is simply the previously received sequence number plus one.
      */
-    uint16_t nextUdpRxSeq(void) { return m_next_udp_rx_seq; }
+    uint16_t nextUdpRxSeq(void) { return m_udp_state->next_rx_seq; }
+
+    /**
+     * @brief   Get the UDP state shared with the UDP worker threads
+     * @return  Returns a reference counted pointer to the UDP state
+     */
+    const std::shared_ptr<UdpState>& udpState(void) const
+    {
+      return m_udp_state;
+    }
 
     /**
      * @brief   Send a TCP message to the remote end
@@ -318,6 +346,27 @@ class ReflectorClient
      */
     int sendMsg(const ReflectorMsg& msg);
 
+    /**
+     * @brief   Send a previously packed TCP message to the remote end
+     * @param   type The message type
+     * @param   frame The packed message (@see packMsg)
+     * @return  On success 0 is returned or else -1
+     *
+     * This function is used when the same message is sent to many clients.
+     * The message is then only packed once and the frame is shared by the
+     * connections until it has been sent.
+     */
+    int sendFrame(uint16_t type,
+                  const Async::FramedTcpConnection::FramePtr& frame);
+
+    /**
+     * @brief   Pack a TCP message into a frame that can be sent to many clients
+     * @param   msg The message to pack
+     * @return  Returns the frame or a null pointer if the packing failed
+     */
+    static Async::FramedTcpConnection::FramePtr packMsg(
+        const ReflectorMsg& msg);
+
     /**
      * @brief   Handle a received UDP message
      * @param   The received UDP message
@@ -333,6 +382,19 @@ class ReflectorClient
      */
     void sendUdpMsg(const ReflectorUdpMsg &msg);
 
+    /**
+     * @brief   Set up the header for the next UDP message to the client
+     * @param   type The type of the message to send
+     * @param   header The header to fill in
+     * @return  Returns \em false if the client UDP port is not known yet
+     *
+     * This function is used when the message payload is packed elsewhere,
+     * for example when the same audio is sent to many clients. A transmit
+     * sequence number is allocated so the message must be sent if this
+     * function returns \em true.
+     */
+    bool nextUdpTxHeader(uint16_t type, ReflectorUdpMsg &header);
+
     /**
      * @brief   Block client audio for the specified time
      * @param   The number of seconds to block
@@ -349,6 +411,15 @@ class ReflectorClient
      */
     bool isBlocked(void) const { return (m_remaining_blocktime > 0); }
 
+    /**
+     * @brief   Check if a block is in effect
+     * @return  Returns \em true if audio from the client may extend a block
+     *
+     * Incoming audio extend the block as long as this function return
+     * \em true, even if isBlocked has started to return \em false.
+     */
+    bool blockActive(void) const { return (m_blocktime > 0); }
+
     /**
      * @brief   Get the state of the connection
      * @return  Returns the state of the connection
@@ -420,6 +491,7 @@ class ReflectorClient
     static const unsigned HEARTBEAT_RX_CNT_RESET      = 15;
     static const unsigned UDP_HEARTBEAT_TX_CNT_RESET  = 15;
     static const unsigned UDP_HEARTBEAT_RX_CNT_RESET  = 120;
+    static const size_t   MAX_TX_QUEUE_SIZE           = 256 * 1024;
 
     Async::FramedTcpConnection* m_con;
     unsigned char               m_auth_challenge[MsgAuthChallenge::CHALLENGE_LEN];
@@ -429,8 +501,7 @@ class ReflectorClient
     uint32_t                    m_client_id;
     uint16_t                    m_remote_udp_port;
     Async::Config*              m_cfg;
-    uint16_t                    m_next_udp_tx_seq;
-    uint16_t                    m_next_udp_rx_seq;
+    std::shared_ptr<UdpState>   m_udp_state;
     Async::Timer                m_heartbeat_timer;
     unsigned                    m_heartbeat_tx_cnt;
     unsigned                    m_heartbeat_rx_cnt;
@@ -446,6 +517,7 @@ class ReflectorClient
     RxMap                       m_rx_map;
     TxMap                       m_tx_map;
     Json::Value                 m_node_info;
+    std::vector<uint8_t>        m_pack_buf;
 
     ReflectorClient(const ReflectorClient&);
     ReflectorClient& operator=(const ReflectorClient&);
@@ -464,6 +536,8 @@ class ReflectorClient
     void sendError(const std::string& msg);
     void onDiscTimeout(Async::Timer *t);
     void disconnect(void);
+    bool canSend(uint16_t type) const;
+    int checkTxResult(int ret);
     void handleHeartbeat(Async::Timer *t);
     std::string lookupUserKey(const std::string& callsign);
 
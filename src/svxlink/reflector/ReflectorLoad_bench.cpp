@@ -0,0 +1,1012 @@
+/**
+@file   ReflectorLoad_bench.cpp
+@brief  A load generator for the reflector
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-16
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2019 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <popt.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncFramedTcpConnection.h>
+#include <AsyncTcpClient.h>
+#include <AsyncTimer.h>
+#include <AsyncUdpSocket.h>
+#include <AsyncIpAddress.h>
+#include <AsyncAudioEncoder.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorMsg.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+  // Load generator for the reflector. A number of simulated nodes connect
+  // to a running reflector over the network, log in using the normal
+  // protocol and select a talk group each. The nodes are spread evenly over
+  // the talk groups. On each talk group one node at a time talk, sending an
+  // audio frame every 20 ms, for a random time and then there is a random
+  // pause before another node on the talk group start talking.
+  //
+  // The audio payload is produced by the codec announced by the reflector,
+  // if it is available, so the frames have realistic sizes. A trailer with
+  // the sender and the send time is appended to each frame. The reflector
+  // does not look at the payload so the receiving nodes can use the trailer
+  // to measure the fan-out latency and to check that the frame arrived on
+  // the right talk group. Lost frames are counted by comparing the number of
+  // received frames with the number of receivers present on the talk group
+  // when each frame was sent.
+  //
+  // If the process id of the reflector is given, the CPU time and the
+  // resident memory used by the reflector is read from /proc and reported
+  // per connected node.
+  //
+  // All simulated nodes must exist in the reflector configuration. Use the
+  // --print-config option to print USERS and PASSWORDS sections to add to
+  // the reflector configuration.
+  //
+  // Since the sending and the receiving is done by the same single thread,
+  // the latency include the time it takes for this program to get around
+  // to reading the datagram. Check that the CPU usage of the load generator
+  // is well below 100% for the latency figures to be meaningful.
+
+namespace {
+  const unsigned FRAME_INTERVAL_MS  = 20;
+  const unsigned CONNECT_BATCH      = 20;
+  const unsigned CONNECT_INTERVAL   = 100;
+  const unsigned DRAIN_TIME_MS      = 1000;
+  const uint32_t TRAILER_MAGIC      = 0x53564c54;
+
+  struct FrameTrailer
+  {
+    uint32_t  magic;
+    uint32_t  tg;
+    uint64_t  send_time;
+  };
+
+  const char  *host = "127.0.0.1";
+  int         port = 5300;
+  int         node_cnt = 100;
+  int         tg_cnt = 10;
+  int         first_tg = 1;
+  int         duration = 30;
+  int         talk_min = 2;
+  int         talk_max = 10;
+  int         pause_max = 3;
+  const char  *callsign_prefix = "LOAD";
+  const char  *auth_key = "LoadGenKey";
+  int         reflector_pid = 0;
+  int         print_config = 0;
+
+  uint64_t nowNs(void)
+  {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+  }
+
+  uint64_t randomNs(unsigned min_s, unsigned max_s)
+  {
+    uint64_t min_ns = min_s * 1000000000ULL;
+    uint64_t max_ns = max_s * 1000000000ULL;
+    if (max_ns <= min_ns)
+    {
+      return min_ns;
+    }
+    return min_ns + (static_cast<uint64_t>(std::rand()) << 16) %
+                    (max_ns - min_ns);
+  }
+
+  string nodeCallsign(unsigned idx)
+  {
+    ostringstream ss;
+    ss << callsign_prefix;
+    ss.width(4);
+    ss.fill('0');
+    ss << (idx + 1);
+    return ss.str();
+  }
+
+  bool readProcStats(int pid, uint64_t& cpu_ticks, long& rss_kb)
+  {
+    ostringstream stat_path;
+    stat_path << "/proc/" << pid << "/stat";
+    ifstream stat_file(stat_path.str().c_str());
+    string stat;
+    if (!getline(stat_file, stat))
+    {
+      return false;
+    }
+      // The command name may contain spaces so start after it. The first
+      // field after the name is the state and utime/stime are the 12th and
+      // 13th fields after that.
+    size_t name_end = stat.rfind(')');
+    if (name_end == string::npos)
+    {
+      return false;
+    }
+    istringstream is(stat.substr(name_end + 1));
+    string field;
+    for (int i=0; i<11; ++i)
+    {
+      is >> field;
+    }
+    uint64_t utime, stime;
+    if (!(is >> utime >> stime))
+    {
+      return false;
+    }
+    cpu_ticks = utime + stime;
+
+    ostringstream status_path;
+    status_path << "/proc/" << pid << "/status";
+    ifstream status_file(status_path.str().c_str());
+    string line;
+    rss_kb = 0;
+    while (getline(status_file, line))
+    {
+      if (line.compare(0, 6, "VmRSS:") == 0)
+      {
+        istringstream ls(line.substr(6));
+        ls >> rss_kb;
+        break;
+      }
+    }
+    return true;
+  }
+
+  double cpuSeconds(void)
+  {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1.0e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1.0e6;
+  }
+
+  class LoadGen;
+
+  class SimNode : public sigc::trackable
+  {
+    public:
+      SimNode(LoadGen *gen, unsigned idx, uint32_t tg)
+        : m_gen(gen), m_callsign(nodeCallsign(idx)), m_tg(tg),
+          m_con(IpAddress(host), port), m_udp_sock(0),
+          m_state(STATE_DISCONNECTED), m_client_id(0), m_next_udp_tx_seq(0),
+          m_next_udp_rx_seq(0), m_tcp_heartbeat_tx_cnt(0),
+          m_udp_heartbeat_tx_cnt(0), m_talk_start(0), m_frames_sent(0)
+      {
+        m_con.connected.connect(mem_fun(*this, &SimNode::onConnected));
+        m_con.disconnected.connect(mem_fun(*this, &SimNode::onDisconnected));
+        m_con.frameReceived.connect(mem_fun(*this, &SimNode::onFrameReceived));
+      }
+
+      ~SimNode(void)
+      {
+        delete m_udp_sock;
+      }
+
+      const string& callsign(void) const { return m_callsign; }
+      uint32_t tg(void) const { return m_tg; }
+      bool isLoggedIn(void) const { return m_state == STATE_CONNECTED; }
+      bool isTalking(void) const { return m_talk_start != 0; }
+
+      void connect(void) { m_con.connect(); }
+
+      void tick(void)
+      {
+        if (!isLoggedIn())
+        {
+          return;
+        }
+        if (--m_tcp_heartbeat_tx_cnt == 0)
+        {
+          sendMsg(MsgHeartbeat());
+        }
+        if (--m_udp_heartbeat_tx_cnt == 0)
+        {
+          sendUdpMsg(MsgUdpHeartbeat());
+        }
+      }
+
+      void startTalking(uint64_t now)
+      {
+        m_talk_start = now;
+        m_frames_sent = 0;
+      }
+
+      void stopTalking(void)
+      {
+        m_talk_start = 0;
+        sendUdpMsg(MsgUdpFlushSamples());
+      }
+
+      unsigned sendDueFrames(uint64_t now);
+
+    private:
+      typedef enum
+      {
+        STATE_DISCONNECTED, STATE_EXPECT_AUTH_CHALLENGE, STATE_EXPECT_AUTH_OK,
+        STATE_EXPECT_SERVER_INFO, STATE_CONNECTED
+      } ConState;
+
+      static const unsigned TCP_HEARTBEAT_TX_CNT_RESET  = 10;
+      static const unsigned UDP_HEARTBEAT_TX_CNT_RESET  = 15;
+
+      LoadGen*                      m_gen;
+      string                        m_callsign;
+      uint32_t                      m_tg;
+      TcpClient<FramedTcpConnection> m_con;
+      UdpSocket*                    m_udp_sock;
+      ConState                      m_state;
+      uint16_t                      m_client_id;
+      uint16_t                      m_next_udp_tx_seq;
+      uint16_t                      m_next_udp_rx_seq;
+      unsigned                      m_tcp_heartbeat_tx_cnt;
+      unsigned                      m_udp_heartbeat_tx_cnt;
+      uint64_t                      m_talk_start;
+      uint64_t                      m_frames_sent;
+      vector<uint8_t>               m_udp_buf;
+
+      void onConnected(void);
+      void onDisconnected(TcpConnection *con,
+                          TcpConnection::DisconnectReason reason);
+      void onFrameReceived(FramedTcpConnection *con, vector<uint8_t>& data);
+      void handleMsgServerInfo(istream& is);
+      void udpDatagramReceived(const IpAddress& addr, uint16_t port,
+                               void *buf, int count);
+      void sendMsg(const ReflectorMsg& msg);
+      void sendUdpMsg(const ReflectorUdpMsg& msg);
+      void sendAudioFrame(uint64_t now);
+  };
+
+  class LoadGen : public sigc::trackable
+  {
+    public:
+      LoadGen(void)
+        : m_connect_timer(CONNECT_INTERVAL, Timer::TYPE_PERIODIC),
+          m_tick_timer(1000, Timer::TYPE_PERIODIC),
+          m_audio_timer(FRAME_INTERVAL_MS, Timer::TYPE_PERIODIC, false),
+          m_login_timer(10000 + 10 * node_cnt),
+          m_run_timer(1000 * duration, Timer::TYPE_ONESHOT, false),
+          m_drain_timer(DRAIN_TIME_MS, Timer::TYPE_ONESHOT, false),
+          m_next_connect(0),
+          m_logged_in_cnt(0), m_disconnect_cnt(0), m_frames_sent(0),
+          m_frames_expected(0), m_frames_received(0), m_frames_misrouted(0),
+          m_udp_lost(0), m_start_ticks(0), m_base_rss_kb(0),
+          m_loaded_rss_kb(0), m_start_time(0), m_start_cpu(0.0),
+          m_end_ticks(0), m_run_time(0.0), m_gen_cpu(0.0)
+      {
+        m_logged_in.resize(tg_cnt, 0);
+        m_tgs.resize(tg_cnt);
+        for (int i=0; i<node_cnt; ++i)
+        {
+          uint32_t tg = first_tg + i % tg_cnt;
+          SimNode *node = new SimNode(this, i, tg);
+          m_nodes.push_back(node);
+          m_tgs[tg - first_tg].nodes.push_back(node);
+        }
+
+        if (reflector_pid > 0)
+        {
+          uint64_t ticks;
+          if (!readProcStats(reflector_pid, ticks, m_base_rss_kb))
+          {
+            cerr << "*** ERROR: Could not read the process statistics for "
+                    "PID " << reflector_pid << endl;
+            exit(1);
+          }
+        }
+
+        cout << "Connecting " << node_cnt << " nodes to " << host << ":"
+             << port << endl;
+        m_connect_timer.expired.connect(
+            mem_fun(*this, &LoadGen::connectNodes));
+        m_tick_timer.expired.connect(mem_fun(*this, &LoadGen::tick));
+        m_audio_timer.expired.connect(mem_fun(*this, &LoadGen::sendAudio));
+        m_login_timer.expired.connect(
+            mem_fun(*this, &LoadGen::startMeasurement));
+        m_run_timer.expired.connect(mem_fun(*this, &LoadGen::stopTalkers));
+        m_drain_timer.expired.connect(mem_fun(*this, &LoadGen::report));
+      }
+
+      ~LoadGen(void)
+      {
+        for (vector<SimNode*>::iterator it=m_nodes.begin();
+             it!=m_nodes.end(); ++it)
+        {
+          delete *it;
+        }
+      }
+
+      void nodeLoggedIn(SimNode *node)
+      {
+        ++m_logged_in[node->tg() - first_tg];
+        if ((++m_logged_in_cnt == node_cnt) && m_login_timer.isEnabled())
+        {
+          startMeasurement(&m_login_timer);
+        }
+      }
+
+      void nodeDisconnected(SimNode *node, bool was_logged_in)
+      {
+        if (was_logged_in)
+        {
+          --m_logged_in[node->tg() - first_tg];
+          --m_logged_in_cnt;
+          ++m_disconnect_cnt;
+        }
+        TgState& tg_state = m_tgs[node->tg() - first_tg];
+        if (tg_state.talker == node)
+        {
+          tg_state.talker = 0;
+          tg_state.next_change = nowNs() + randomNs(0, pause_max);
+        }
+      }
+
+      void setCodec(const string& codec_name);
+
+      const vector<uint8_t>& audioFrame(uint64_t frame_no) const
+      {
+        return m_audio_frames[frame_no % m_audio_frames.size()];
+      }
+
+      void frameSent(uint32_t tg)
+      {
+        ++m_frames_sent;
+        m_frames_expected += m_logged_in[tg - first_tg] - 1;
+      }
+
+      void frameReceived(SimNode *node, const FrameTrailer& trailer,
+                         uint64_t now)
+      {
+        if (trailer.tg != node->tg())
+        {
+          ++m_frames_misrouted;
+          return;
+        }
+        ++m_frames_received;
+        m_latencies.push_back((now - trailer.send_time) / 1000);
+      }
+
+      void udpFramesLost(unsigned cnt) { m_udp_lost += cnt; }
+
+    private:
+      struct TgState
+      {
+        TgState(void) : talker(0), next_change(0) {}
+        vector<SimNode*>  nodes;
+        SimNode*          talker;
+        uint64_t          next_change;
+      };
+
+      vector<SimNode*>        m_nodes;
+      vector<TgState>         m_tgs;
+      vector<int>             m_logged_in;
+      vector<vector<uint8_t> > m_audio_frames;
+      string                  m_codec_name;
+      Timer                   m_connect_timer;
+      Timer                   m_tick_timer;
+      Timer                   m_audio_timer;
+      Timer                   m_login_timer;
+      Timer                   m_run_timer;
+      Timer                   m_drain_timer;
+      int                     m_next_connect;
+      int                     m_logged_in_cnt;
+      unsigned                m_disconnect_cnt;
+      uint64_t                m_frames_sent;
+      uint64_t                m_frames_expected;
+      uint64_t                m_frames_received;
+      uint64_t                m_frames_misrouted;
+      uint64_t                m_udp_lost;
+      vector<uint32_t>        m_latencies;
+      uint64_t                m_start_ticks;
+      long                    m_base_rss_kb;
+      long                    m_loaded_rss_kb;
+      uint64_t                m_start_time;
+      double                  m_start_cpu;
+      uint64_t                m_end_ticks;
+      double                  m_run_time;
+      double                  m_gen_cpu;
+
+      void connectNodes(Timer *t)
+      {
+        for (unsigned i=0; (i<CONNECT_BATCH) && (m_next_connect<node_cnt); ++i)
+        {
+          m_nodes[m_next_connect++]->connect();
+        }
+        if (m_next_connect == node_cnt)
+        {
+          m_connect_timer.setEnable(false);
+        }
+      }
+
+      void tick(Timer *t)
+      {
+        for (vector<SimNode*>::iterator it=m_nodes.begin();
+             it!=m_nodes.end(); ++it)
+        {
+          (*it)->tick();
+        }
+      }
+
+      void startMeasurement(Timer *t)
+      {
+        m_login_timer.setEnable(false);
+        if (m_logged_in_cnt < node_cnt)
+        {
+          cout << "*** WARNING: Only " << m_logged_in_cnt << " of " << node_cnt
+               << " nodes logged in" << endl;
+        }
+        if (m_logged_in_cnt == 0)
+        {
+          Application::app().quit();
+          return;
+        }
+        if (m_audio_frames.empty())
+        {
+          setCodec("");
+        }
+        cout << m_logged_in_cnt << " nodes logged in. Running for "
+             << duration << " seconds..." << endl;
+
+        if (reflector_pid > 0)
+        {
+          readProcStats(reflector_pid, m_start_ticks, m_loaded_rss_kb);
+        }
+        m_start_time = nowNs();
+        m_start_cpu = cpuSeconds();
+        for (vector<TgState>::iterator it=m_tgs.begin(); it!=m_tgs.end(); ++it)
+        {
+          (*it).next_change = m_start_time + randomNs(0, pause_max);
+        }
+        m_audio_timer.setEnable(true);
+        m_run_timer.setEnable(true);
+      }
+
+      void sendAudio(Timer *t)
+      {
+        uint64_t now = nowNs();
+        for (vector<TgState>::iterator it=m_tgs.begin(); it!=m_tgs.end(); ++it)
+        {
+          TgState& tg_state = *it;
+          if ((tg_state.talker != 0) && (now >= tg_state.next_change))
+          {
+            tg_state.talker->stopTalking();
+            tg_state.talker = 0;
+            tg_state.next_change = now + randomNs(0, pause_max);
+          }
+          else if ((tg_state.talker == 0) && (now >= tg_state.next_change))
+          {
+            SimNode *node = tg_state.nodes[std::rand() % tg_state.nodes.size()];
+            if (node->isLoggedIn())
+            {
+              tg_state.talker = node;
+              tg_state.next_change = now + randomNs(talk_min, talk_max);
+              node->startTalking(now);
+            }
+          }
+          if (tg_state.talker != 0)
+          {
+            tg_state.talker->sendDueFrames(now);
+          }
+        }
+      }
+
+      void stopTalkers(Timer *t)
+      {
+        m_audio_timer.setEnable(false);
+        m_run_time = (nowNs() - m_start_time) / 1.0e9;
+        m_gen_cpu = cpuSeconds() - m_start_cpu;
+        if (reflector_pid > 0)
+        {
+          long rss_kb;
+          readProcStats(reflector_pid, m_end_ticks, rss_kb);
+        }
+        for (vector<TgState>::iterator it=m_tgs.begin(); it!=m_tgs.end(); ++it)
+        {
+          if ((*it).talker != 0)
+          {
+            (*it).talker->stopTalking();
+            (*it).talker = 0;
+          }
+        }
+        m_drain_timer.setEnable(true);
+      }
+
+      void addAudioFrame(const void *buf, int count)
+      {
+        const uint8_t *bbuf = reinterpret_cast<const uint8_t*>(buf);
+        m_audio_frames.push_back(vector<uint8_t>(bbuf, bbuf + count));
+      }
+
+      void report(Timer *t);
+  };
+
+
+  void SimNode::onConnected(void)
+  {
+    m_state = STATE_EXPECT_AUTH_CHALLENGE;
+    m_con.setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
+    m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
+    m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+    m_next_udp_tx_seq = 0;
+    m_next_udp_rx_seq = 0;
+    sendMsg(MsgProtoVer());
+  }
+
+
+  void SimNode::onDisconnected(TcpConnection *con,
+                               TcpConnection::DisconnectReason reason)
+  {
+    cerr << "*** WARNING[" << m_callsign << "]: Disconnected: "
+         << TcpConnection::disconnectReasonStr(reason) << endl;
+    bool was_logged_in = isLoggedIn();
+    m_state = STATE_DISCONNECTED;
+    m_talk_start = 0;
+    delete m_udp_sock;
+    m_udp_sock = 0;
+    m_gen->nodeDisconnected(this, was_logged_in);
+  }
+
+
+  void SimNode::onFrameReceived(FramedTcpConnection *con,
+                                vector<uint8_t>& data)
+  {
+    stringstream ss;
+    ss.write(reinterpret_cast<const char*>(&data.front()), data.size());
+    ReflectorMsg header;
+    if (!header.unpack(ss))
+    {
+      cerr << "*** ERROR[" << m_callsign
+           << "]: Unpacking failed for TCP message header" << endl;
+      m_con.disconnect();
+      return;
+    }
+
+    switch (header.type())
+    {
+      case MsgError::TYPE:
+      {
+        MsgError msg;
+        msg.unpack(ss);
+        cerr << "*** ERROR[" << m_callsign << "]: Error message received: "
+             << msg.message() << endl;
+        break;
+      }
+      case MsgAuthChallenge::TYPE:
+      {
+        MsgAuthChallenge msg;
+        if ((m_state != STATE_EXPECT_AUTH_CHALLENGE) || !msg.unpack(ss) ||
+            (msg.challenge() == 0))
+        {
+          cerr << "*** ERROR[" << m_callsign
+               << "]: Unexpected or bad MsgAuthChallenge" << endl;
+          m_con.disconnect();
+          return;
+        }
+        sendMsg(MsgAuthResponse(m_callsign, auth_key, msg.challenge()));
+        m_state = STATE_EXPECT_AUTH_OK;
+        break;
+      }
+      case MsgAuthOk::TYPE:
+        m_con.setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
+        m_state = STATE_EXPECT_SERVER_INFO;
+        break;
+      case MsgServerInfo::TYPE:
+        handleMsgServerInfo(ss);
+        break;
+      default:
+        break;
+    }
+  }
+
+
+  void SimNode::handleMsgServerInfo(istream& is)
+  {
+    MsgServerInfo msg;
+    if ((m_state != STATE_EXPECT_SERVER_INFO) || !msg.unpack(is))
+    {
+      cerr << "*** ERROR[" << m_callsign
+           << "]: Unexpected or bad MsgServerInfo" << endl;
+      m_con.disconnect();
+      return;
+    }
+    m_client_id = msg.clientId();
+    m_gen->setCodec(msg.codecs().empty() ? "" : msg.codecs().front());
+
+    delete m_udp_sock;
+    m_udp_sock = new UdpSocket;
+    m_udp_sock->dataReceived.connect(
+        mem_fun(*this, &SimNode::udpDatagramReceived));
+
+    m_state = STATE_CONNECTED;
+    sendMsg(MsgNodeInfo("{\"sw\":\"ReflectorLoad_bench\"}"));
+    sendMsg(MsgSelectTG(m_tg));
+    sendUdpMsg(MsgUdpHeartbeat());
+    m_gen->nodeLoggedIn(this);
+  }
+
+
+  void SimNode::udpDatagramReceived(const IpAddress& addr, uint16_t port,
+                                    void *buf, int count)
+  {
+    uint64_t now = nowNs();
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(buf);
+    ReflectorUdpMsg header;
+    if ((count < 0) || !header.unpackHeader(data, count) ||
+        (header.clientId() != m_client_id))
+    {
+      return;
+    }
+
+    uint16_t udp_rx_seq_diff = header.sequenceNum() - m_next_udp_rx_seq;
+    if (udp_rx_seq_diff <= 0x7fff)
+    {
+      m_gen->udpFramesLost(udp_rx_seq_diff);
+      m_next_udp_rx_seq = header.sequenceNum() + 1;
+    }
+
+    if (header.type() != MsgUdpAudio::TYPE)
+    {
+      return;
+    }
+    const uint8_t *payload = data + ReflectorUdpMsg::HEADER_SIZE;
+    size_t payload_len = count - ReflectorUdpMsg::HEADER_SIZE;
+    if (payload_len < 2 + sizeof(FrameTrailer))
+    {
+      return;
+    }
+    size_t audio_len = (static_cast<size_t>(payload[0]) << 8) | payload[1];
+    if ((audio_len < sizeof(FrameTrailer)) || (payload_len < 2 + audio_len))
+    {
+      return;
+    }
+    FrameTrailer trailer;
+    memcpy(&trailer, payload + 2 + audio_len - sizeof(FrameTrailer),
+           sizeof(trailer));
+    if (trailer.magic == TRAILER_MAGIC)
+    {
+      m_gen->frameReceived(this, trailer, now);
+    }
+  }
+
+
+  void SimNode::sendMsg(const ReflectorMsg& msg)
+  {
+    m_tcp_heartbeat_tx_cnt = TCP_HEARTBEAT_TX_CNT_RESET;
+    ostringstream ss;
+    ReflectorMsg header(msg.type());
+    if (!header.pack(ss) || !msg.pack(ss))
+    {
+      cerr << "*** ERROR[" << m_callsign << "]: Failed to pack TCP message"
+           << endl;
+      return;
+    }
+    m_con.write(ss.str().data(), ss.str().size());
+  }
+
+
+  void SimNode::sendUdpMsg(const ReflectorUdpMsg& msg)
+  {
+    if ((m_udp_sock == 0) || !isLoggedIn())
+    {
+      return;
+    }
+    m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+    ReflectorUdpMsg header(msg.type(), m_client_id, m_next_udp_tx_seq++);
+    ostringstream ss;
+    if (!header.pack(ss) || !msg.pack(ss))
+    {
+      cerr << "*** ERROR[" << m_callsign << "]: Failed to pack UDP message"
+           << endl;
+      return;
+    }
+    m_udp_sock->write(m_con.remoteHost(), m_con.remotePort(),
+                      ss.str().data(), ss.str().size());
+  }
+
+
+  unsigned SimNode::sendDueFrames(uint64_t now)
+  {
+      // Keep the 20 ms cadence even if the timer is late by sending all
+      // frames that are due
+    unsigned cnt = 0;
+    while (isTalking() && (m_frames_sent * FRAME_INTERVAL_MS * 1000000ULL <=
+                           now - m_talk_start))
+    {
+      sendAudioFrame(now);
+      ++cnt;
+    }
+    return cnt;
+  }
+
+
+  void SimNode::sendAudioFrame(uint64_t now)
+  {
+    const vector<uint8_t>& audio = m_gen->audioFrame(m_frames_sent++);
+    size_t audio_len = audio.size() + sizeof(FrameTrailer);
+    m_udp_buf.resize(ReflectorUdpMsg::HEADER_SIZE + 2 + audio_len);
+    ReflectorUdpMsg header(MsgUdpAudio::TYPE, m_client_id,
+                           m_next_udp_tx_seq++);
+    header.packHeader(&m_udp_buf[0]);
+    uint8_t *payload = &m_udp_buf[ReflectorUdpMsg::HEADER_SIZE];
+    payload[0] = audio_len >> 8;
+    payload[1] = audio_len & 0xff;
+    if (!audio.empty())
+    {
+      memcpy(payload + 2, &audio[0], audio.size());
+    }
+    FrameTrailer trailer;
+    trailer.magic = TRAILER_MAGIC;
+    trailer.tg = m_tg;
+    trailer.send_time = now;
+    memcpy(payload + 2 + audio.size(), &trailer, sizeof(trailer));
+    m_udp_heartbeat_tx_cnt = UDP_HEARTBEAT_TX_CNT_RESET;
+    m_udp_sock->write(m_con.remoteHost(), m_con.remotePort(),
+                      &m_udp_buf[0], m_udp_buf.size());
+    m_gen->frameSent(m_tg);
+  }
+
+
+  void LoadGen::setCodec(const string& codec_name)
+  {
+    if (!m_audio_frames.empty())
+    {
+      return;
+    }
+
+      // Encode a second of a tone to get a set of frames with realistic
+      // sizes for the codec. Empty frames are used if the codec is not
+      // available.
+    m_codec_name = codec_name;
+    if (!codec_name.empty() && AudioEncoder::isAvailable(codec_name))
+    {
+      AudioEncoder *enc = AudioEncoder::create(codec_name,
+                                               AudioEncoder::Options());
+      if (enc != 0)
+      {
+        enc->writeEncodedSamples.connect(
+            sigc::mem_fun(*this, &LoadGen::addAudioFrame));
+        vector<float> samples(INTERNAL_SAMPLE_RATE);
+        for (size_t i=0; i<samples.size(); ++i)
+        {
+          samples[i] = 0.5f * sinf(2.0f * M_PI * 1000.0f * i /
+                                   INTERNAL_SAMPLE_RATE);
+        }
+        enc->writeSamples(&samples[0], samples.size());
+        enc->flushSamples();
+        delete enc;
+      }
+    }
+    if (m_audio_frames.empty())
+    {
+      m_codec_name += " (not available)";
+      m_audio_frames.push_back(vector<uint8_t>());
+    }
+  }
+
+
+  void LoadGen::report(Timer *t)
+  {
+    double run_time = m_run_time;
+
+    size_t frame_bytes = 0;
+    for (vector<vector<uint8_t> >::const_iterator it=m_audio_frames.begin();
+         it!=m_audio_frames.end(); ++it)
+    {
+      frame_bytes += (*it).size();
+    }
+
+    printf("%-28s %d of %d\n", "Nodes logged in", m_logged_in_cnt, node_cnt);
+    printf("%-28s %d\n", "Talk groups", tg_cnt);
+    printf("%-28s %s, %.1f bytes/frame\n", "Codec", m_codec_name.c_str(),
+           static_cast<double>(frame_bytes) / m_audio_frames.size());
+    printf("%-28s %.1f s\n", "Measurement time", run_time);
+    printf("%-28s %u\n", "Node disconnects", m_disconnect_cnt);
+    printf("%-28s %llu (%.1f frames/s)\n", "Audio frames sent",
+           static_cast<unsigned long long>(m_frames_sent),
+           m_frames_sent / run_time);
+    printf("%-28s %llu (%.1f frames/s)\n", "Audio frames received",
+           static_cast<unsigned long long>(m_frames_received),
+           m_frames_received / run_time);
+    uint64_t lost = (m_frames_expected > m_frames_received) ?
+                    m_frames_expected - m_frames_received : 0;
+    printf("%-28s %llu of %llu (%.3f%%)\n", "Audio frames lost",
+           static_cast<unsigned long long>(lost),
+           static_cast<unsigned long long>(m_frames_expected),
+           (m_frames_expected > 0) ? 100.0 * lost / m_frames_expected : 0.0);
+    printf("%-28s %llu\n", "Audio frames misrouted",
+           static_cast<unsigned long long>(m_frames_misrouted));
+    printf("%-28s %llu\n", "UDP sequence gaps",
+           static_cast<unsigned long long>(m_udp_lost));
+
+    if (!m_latencies.empty())
+    {
+      sort(m_latencies.begin(), m_latencies.end());
+      const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+      printf("%-28s min=%u", "Fan-out latency (us)", m_latencies.front());
+      for (size_t i=0; i<sizeof(percentiles)/sizeof(*percentiles); ++i)
+      {
+        size_t idx = static_cast<size_t>(
+            percentiles[i] / 100.0 * (m_latencies.size() - 1));
+        printf(" p%g=%u", percentiles[i], m_latencies[idx]);
+      }
+      printf(" max=%u\n", m_latencies.back());
+    }
+
+    if (reflector_pid > 0)
+    {
+      double cpu = static_cast<double>(m_end_ticks - m_start_ticks) /
+                   sysconf(_SC_CLK_TCK);
+      printf("%-28s %.1f%% of one core, %.1f us/s per node\n",
+             "Reflector CPU", 100.0 * cpu / run_time,
+             1.0e6 * cpu / run_time / m_logged_in_cnt);
+      printf("%-28s %ld kB, %ld kB before connect, %.1f kB per node\n",
+             "Reflector RSS", m_loaded_rss_kb, m_base_rss_kb,
+             static_cast<double>(m_loaded_rss_kb - m_base_rss_kb) /
+             m_logged_in_cnt);
+    }
+    printf("%-28s %.1f%% of one core\n", "Load generator CPU",
+           100.0 * m_gen_cpu / run_time);
+
+    Application::app().quit();
+  }
+
+
+  void parseArguments(int argc, const char **argv)
+  {
+    const struct poptOption optionsTable[] =
+    {
+      POPT_AUTOHELP
+      {"host", 0, POPT_ARG_STRING, &host, 0,
+              "The IP address of the reflector", "<ip address>"},
+      {"port", 0, POPT_ARG_INT, &port, 0,
+              "The port of the reflector", "<port>"},
+      {"nodes", 'n', POPT_ARG_INT, &node_cnt, 0,
+              "The number of simulated nodes", "<count>"},
+      {"tgs", 't', POPT_ARG_INT, &tg_cnt, 0,
+              "The number of talk groups", "<count>"},
+      {"first-tg", 0, POPT_ARG_INT, &first_tg, 0,
+              "The first talk group to use", "<tg>"},
+      {"duration", 'd', POPT_ARG_INT, &duration, 0,
+              "The measurement time in seconds", "<seconds>"},
+      {"talk-min", 0, POPT_ARG_INT, &talk_min, 0,
+              "The shortest talk time in seconds", "<seconds>"},
+      {"talk-max", 0, POPT_ARG_INT, &talk_max, 0,
+              "The longest talk time in seconds", "<seconds>"},
+      {"pause-max", 0, POPT_ARG_INT, &pause_max, 0,
+              "The longest pause between talkers in seconds", "<seconds>"},
+      {"callsign-prefix", 0, POPT_ARG_STRING, &callsign_prefix, 0,
+              "The prefix of the node callsigns", "<prefix>"},
+      {"auth-key", 0, POPT_ARG_STRING, &auth_key, 0,
+              "The password of the nodes", "<key>"},
+      {"pid", 'p', POPT_ARG_INT, &reflector_pid, 0,
+              "The PID of the reflector, for CPU and memory statistics",
+              "<pid>"},
+      {"print-config", 0, POPT_ARG_NONE, &print_config, 0,
+              "Print the reflector configuration for the nodes and exit",
+              NULL},
+      {NULL, 0, 0, NULL, 0}
+    };
+
+    poptContext optCon = poptGetContext("ReflectorLoad_bench", argc, argv,
+                                        optionsTable, 0);
+    int err = poptGetNextOpt(optCon);
+    if (err != -1)
+    {
+      fprintf(stderr, "\t%s: %s\n",
+              poptBadOption(optCon, POPT_BADOPTION_NOALIAS),
+              poptStrerror(err));
+      exit(1);
+    }
+    poptFreeContext(optCon);
+
+    if ((node_cnt < 2) || (tg_cnt < 1) || (tg_cnt > node_cnt) ||
+        (first_tg < 1) || (duration < 1) || (talk_min < 1) ||
+        (talk_max < talk_min) || (pause_max < 0))
+    {
+      cerr << "*** ERROR: Illegal argument value" << endl;
+      exit(1);
+    }
+  }
+};
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, const char **argv)
+{
+  parseArguments(argc, argv);
+
+  if (print_config)
+  {
+    cout << "[USERS]" << endl;
+    for (int i=0; i<node_cnt; ++i)
+    {
+      cout << nodeCallsign(i) << "=LoadGen" << endl;
+    }
+    cout << endl << "[PASSWORDS]" << endl;
+    cout << "LoadGen=\"" << auth_key << "\"" << endl;
+    return 0;
+  }
+
+  CppApplication app;
+  LoadGen gen;
+  app.exec();
+
+  return 0;
+}
+
+
+/*
+ * This file has not been truncated
+ */
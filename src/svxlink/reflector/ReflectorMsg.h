@@ -162,6 +162,8 @@ the argument type for functions that take a UDP message as argument.
 class ReflectorUdpMsg : public Async::Msg
 {
   public:
+    static const size_t HEADER_SIZE = 6;
+
     /**
      * @brief 	Constuctor
      * @param 	type The message type
@@ -193,6 +195,43 @@ class ReflectorUdpMsg : public Async::Msg
      */
     uint16_t sequenceNum(void) const { return m_seq; }
 
+    /**
+     * @brief   Pack the header directly into a byte buffer
+     * @param   buf The buffer to write HEADER_SIZE bytes to
+     *
+     * This function produce the same result as the pack function but is
+     * much faster. It is used when the same message payload is sent to many
+     * receivers so that only the header have to be rewritten per receiver.
+     */
+    void packHeader(uint8_t *buf) const
+    {
+      buf[0] = m_type >> 8;
+      buf[1] = m_type & 0xff;
+      buf[2] = m_client_id >> 8;
+      buf[3] = m_client_id & 0xff;
+      buf[4] = m_seq >> 8;
+      buf[5] = m_seq & 0xff;
+    }
+
+    /**
+     * @brief   Unpack the header directly from a byte buffer
+     * @param   buf The buffer to read from
+     * @param   len The number of bytes available in the buffer
+     * @return  Returns \em true on success or \em false if the buffer is too
+     *          short
+     */
+    bool unpackHeader(const uint8_t *buf, size_t len)
+    {
+      if (len < HEADER_SIZE)
+      {
+        return false;
+      }
+      m_type = (static_cast<uint16_t>(buf[0]) << 8) | buf[1];
+      m_client_id = (static_cast<uint16_t>(buf[2]) << 8) | buf[3];
+      m_seq = (static_cast<uint16_t>(buf[4]) << 8) | buf[5];
+      return true;
+    }
+
     ASYNC_MSG_MEMBERS(m_type, m_client_id, m_seq)
 
   private:
@@ -1106,6 +1145,42 @@ class MsgTxStatus : public ReflectorMsgBase<113>
 }; /* class MsgTxStatus */
 
 
+/**
+@brief   Trunk audio TCP network message
+@author  Tobias Blomberg / SM0SVX
+@date    2020-07-25
+
+This message is only used on a trunk link between two reflectors. It carry
+the audio from a talker on a talk group that is shared between the reflectors.
+The audio data is the same as in the MsgUdpAudio message so the receiving
+reflector can forward it to its clients without decoding it. Talker start and
+stop on the trunk is signalled using the MsgTalkerStart and MsgTalkerStop
+messages.
+*/
+class MsgTrunkAudio : public ReflectorMsgBase<200>
+{
+  public:
+    MsgTrunkAudio(void) : m_tg(0) {}
+    MsgTrunkAudio(uint32_t tg, const void *buf, int count)
+      : m_tg(tg)
+    {
+      if (count > 0)
+      {
+        const uint8_t *bbuf = reinterpret_cast<const uint8_t*>(buf);
+        m_audio_data.assign(bbuf, bbuf+count);
+      }
+    }
+    uint32_t tg(void) const { return m_tg; }
+    const std::vector<uint8_t>& audioData(void) const { return m_audio_data; }
+
+    ASYNC_MSG_MEMBERS(m_tg, m_audio_data)
+
+  private:
+    uint32_t              m_tg;
+    std::vector<uint8_t>  m_audio_data;
+}; /* class MsgTrunkAudio */
+
+
 /***************************** UDP Messages *****************************/
 
 /**
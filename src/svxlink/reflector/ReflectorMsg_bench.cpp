@@ -0,0 +1,165 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <AsyncMsg.h>
+
+#include "ReflectorMsg.h"
+
+using namespace std;
+
+  // Benchmark the two ways of packing and unpacking reflector protocol
+  // messages, using iostreams or using the Async::MsgWriter/MsgReader
+  // contiguous buffer classes. The output of the two methods is compared
+  // before timing starts so the benchmark also works as a check that the
+  // buffer based packing is wire compatible with the stream based.
+  //
+  // Usage: ReflectorMsg_bench [iterations]
+
+namespace {
+  struct timespec start;
+
+  void startClock(void)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+  }
+
+  void stopClock(const char *msg_name, const char *what, size_t cnt)
+  {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) +
+                     (end.tv_nsec - start.tv_nsec) / 1.0e9;
+    printf("%-27s %-14s %10.1f ns/msg\n", msg_name, what,
+           1.0e9 * elapsed / cnt);
+  }
+
+  template <typename Header, typename M>
+  void bench(const char *msg_name, const Header& header, const M& msg,
+             size_t iterations)
+  {
+      // Check that both methods produce exactly the same bytes
+    ostringstream ss;
+    vector<uint8_t> arena;
+    Async::MsgWriter w(arena);
+    if (!header.pack(ss) || !msg.pack(ss) || !header.pack(w) ||
+        !msg.pack(w))
+    {
+      cerr << "*** ERROR: Failed to pack " << msg_name << endl;
+      exit(1);
+    }
+    const string packed(ss.str());
+    if ((packed.size() != arena.size()) ||
+        (memcmp(packed.data(), &arena[0], arena.size()) != 0))
+    {
+      cerr << "*** ERROR: Packed data differ for " << msg_name << endl;
+      exit(1);
+    }
+
+    size_t bytes = 0;
+    startClock();
+    for (size_t i=0; i<iterations; ++i)
+    {
+      ostringstream os;
+      header.pack(os);
+      msg.pack(os);
+      bytes += os.str().size();
+    }
+    stopClock(msg_name, "pack stream", iterations);
+
+    startClock();
+    for (size_t i=0; i<iterations; ++i)
+    {
+      arena.clear();
+      Async::MsgWriter aw(arena);
+      header.pack(aw);
+      msg.pack(aw);
+      bytes += aw.size();
+    }
+    stopClock(msg_name, "pack buffer", iterations);
+
+    startClock();
+    for (size_t i=0; i<iterations; ++i)
+    {
+      stringstream is;
+      is.write(packed.data(), packed.size());
+      Header h;
+      M m;
+      if (!h.unpack(is) || !m.unpack(is))
+      {
+        cerr << "*** ERROR: Failed to unpack " << msg_name << endl;
+        exit(1);
+      }
+    }
+    stopClock(msg_name, "unpack stream", iterations);
+
+    startClock();
+    for (size_t i=0; i<iterations; ++i)
+    {
+      Async::MsgReader r(packed.data(), packed.size());
+      Header h;
+      M m;
+      if (!h.unpack(r) || !m.unpack(r))
+      {
+        cerr << "*** ERROR: Failed to unpack " << msg_name << endl;
+        exit(1);
+      }
+    }
+    stopClock(msg_name, "unpack buffer", iterations);
+
+    if (bytes == 0)
+    {
+      cerr << "*** ERROR: Nothing packed\n";
+    }
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  size_t iterations = (argc > 1) ? atol(argv[1]) : 1000000;
+  if (iterations == 0)
+  {
+    cerr << "Usage: " << argv[0] << " [iterations]\n";
+    exit(1);
+  }
+
+    // A 20ms OPUS frame is typically about 80 bytes
+  vector<uint8_t> audio(80);
+  for (size_t i=0; i<audio.size(); ++i)
+  {
+    audio[i] = i * 7;
+  }
+  bench("MsgUdpAudio", ReflectorUdpMsg(MsgUdpAudio::TYPE, 4711, 42),
+        MsgUdpAudio(audio), iterations);
+
+  MsgUdpSignalStrengthValues ssv;
+  for (char id='A'; id<'E'; ++id)
+  {
+    MsgSignalStrengthValuesBase::Rx rx(id, 30 + id);
+    rx.setEnabled(true);
+    rx.setSqlOpen(id == 'B');
+    ssv.pushBack(rx);
+  }
+  bench("MsgUdpSignalStrengthValues",
+        ReflectorUdpMsg(MsgUdpSignalStrengthValues::TYPE, 4711, 43), ssv,
+        iterations);
+
+  string json("{\"sw\":\"SvxLink\",\"swVer\":\"1.7.99\",\"projVer\":\"1.7.99\","
+              "\"nodeLocation\":\"Stockholm\",\"sysop\":\"SM0SVX\","
+              "\"qth\":[{\"name\":\"Site 1\",\"pos\":{\"lat\":\"59.20.00N\","
+              "\"long\":\"018.00.00E\",\"loc\":\"JO99BH\"},\"rx\":{\"Rx1\":{"
+              "\"name\":\"Rx1\",\"freq\":145.6,\"sqlType\":\"CTCSS\"}},"
+              "\"tx\":{\"Tx1\":{\"name\":\"Tx1\",\"freq\":145.0,"
+              "\"ctcssFrq\":136.5,\"pwr\":25}}}]}");
+  bench("MsgNodeInfo", ReflectorMsg(MsgNodeInfo::TYPE), MsgNodeInfo(json),
+        iterations);
+
+  return 0;
+}
@@ -0,0 +1,650 @@
+/**
+@file	 ReflectorTrunk.cpp
+@brief   A trunk link to another reflector
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-25
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sstream>
+#include <cstdlib>
+#include <cerrno>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorTrunk.h"
+#include "Reflector.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+bool ReflectorTrunk::parseId(const std::string& str, uint32_t& id)
+{
+  if (str.empty() || (str[0] < '0') || (str[0] > '9'))
+  {
+    return false;
+  }
+  char *endptr = 0;
+  errno = 0;
+  unsigned long val = strtoul(str.c_str(), &endptr, 10);
+  if ((*endptr != '\0') || (errno != 0) || (val > 0xffffffffUL))
+  {
+    return false;
+  }
+  id = val;
+  return true;
+} /* ReflectorTrunk::parseId */
+
+
+ReflectorTrunk::ReflectorTrunk(Reflector *ref, uint32_t local_id,
+                               uint32_t peer_id)
+  : m_reflector(ref), m_local_id(local_id), m_peer_id(peer_id), m_port(5302),
+    m_out_con(0), m_out_state(STATE_DISCONNECTED), m_in_con(0),
+    m_reconnect_timer(1000, Timer::TYPE_ONESHOT, false),
+    m_heartbeat_timer(1000, Timer::TYPE_PERIODIC),
+    m_out_heartbeat_tx_cnt(HEARTBEAT_TX_CNT_RESET),
+    m_out_heartbeat_rx_cnt(HEARTBEAT_RX_CNT_RESET),
+    m_in_heartbeat_tx_cnt(HEARTBEAT_TX_CNT_RESET),
+    m_in_heartbeat_rx_cnt(HEARTBEAT_RX_CNT_RESET)
+{
+  m_reconnect_timer.expired.connect(
+      sigc::hide(mem_fun(*this, &ReflectorTrunk::reconnect)));
+  m_heartbeat_timer.expired.connect(
+      mem_fun(*this, &ReflectorTrunk::handleHeartbeat));
+} /* ReflectorTrunk::ReflectorTrunk */
+
+
+ReflectorTrunk::~ReflectorTrunk(void)
+{
+  delete m_out_con;
+  m_out_con = 0;
+} /* ReflectorTrunk::~ReflectorTrunk */
+
+
+bool ReflectorTrunk::initialize(Async::Config &cfg, const std::string& section)
+{
+  if (!cfg.getValue(section, "HOST", m_host) || m_host.empty())
+  {
+    cerr << "*** ERROR: " << section << "/HOST missing in configuration"
+         << endl;
+    return false;
+  }
+  cfg.getValue(section, "PORT", m_port);
+  if (!cfg.getValue(section, "SECRET", m_secret) || m_secret.empty())
+  {
+    cerr << "*** ERROR: " << section << "/SECRET missing in configuration"
+         << endl;
+    return false;
+  }
+  std::vector<uint32_t> tgs;
+  if (!cfg.getValue(section, "TGS", tgs) || tgs.empty())
+  {
+    cerr << "*** ERROR: " << section << "/TGS missing or illegal in "
+            "configuration" << endl;
+    return false;
+  }
+  m_tgs.insert(tgs.begin(), tgs.end());
+  m_tgs.erase(0);
+
+  connect();
+
+  return true;
+} /* ReflectorTrunk::initialize */
+
+
+int ReflectorTrunk::sendMsg(const ReflectorMsg& msg)
+{
+  if (m_out_state != STATE_CONNECTED)
+  {
+    errno = ENOTCONN;
+    return -1;
+  }
+  m_out_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  return writeMsg(m_out_con, msg);
+} /* ReflectorTrunk::sendMsg */
+
+
+void ReflectorTrunk::setInboundConnection(Async::FramedTcpConnection *con)
+{
+  if (m_in_con != 0)
+  {
+    cout << "Trunk " << m_peer_id << ": Replacing incoming connection from "
+         << m_in_con->remoteHost() << ":" << m_in_con->remotePort() << endl;
+    disconnectInbound();
+  }
+  cout << "Trunk " << m_peer_id << ": Incoming connection from "
+       << con->remoteHost() << ":" << con->remotePort()
+       << " authenticated" << endl;
+  m_in_con = con;
+  m_in_con->setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
+  m_in_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  m_in_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+  writeMsg(m_in_con, MsgAuthOk());
+  m_reflector->updateTrunkStatus();
+} /* ReflectorTrunk::setInboundConnection */
+
+
+void ReflectorTrunk::inboundFrameReceived(std::vector<uint8_t>& data)
+{
+  if (data.empty())
+  {
+    return;
+  }
+
+  stringstream ss;
+  ss.write(reinterpret_cast<char*>(&data.front()), data.size());
+
+  ReflectorMsg header;
+  if (!header.unpack(ss))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Unpacking failed for TCP message header" << endl;
+    disconnectInbound();
+    return;
+  }
+
+  m_in_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+
+  switch (header.type())
+  {
+    case MsgHeartbeat::TYPE:
+      break;
+    case MsgNodeList::TYPE:
+      handleNodeList(ss);
+      break;
+    case MsgNodeJoined::TYPE:
+      handleNodeJoined(ss);
+      break;
+    case MsgNodeLeft::TYPE:
+      handleNodeLeft(ss);
+      break;
+    case MsgTalkerStart::TYPE:
+      handleTalkerStart(ss);
+      break;
+    case MsgTalkerStop::TYPE:
+      handleTalkerStop(ss);
+      break;
+    case MsgTrunkAudio::TYPE:
+      handleTrunkAudio(ss);
+      break;
+    case MsgError::TYPE:
+    {
+      MsgError msg;
+      msg.unpack(ss);
+      cout << "Trunk " << m_peer_id
+           << ": Error message received from peer: " << msg.message()
+           << endl;
+      disconnectInbound();
+      break;
+    }
+    default:
+      // Ignore unknown messages to be forward compatible
+      break;
+  }
+} /* ReflectorTrunk::inboundFrameReceived */
+
+
+void ReflectorTrunk::inboundDisconnected(Async::FramedTcpConnection *con)
+{
+  if (con != m_in_con)
+  {
+    return;
+  }
+  cout << "Trunk " << m_peer_id << ": Incoming connection closed" << endl;
+  m_in_con = 0;
+  clearRemoteNodes();
+  m_reflector->trunkDisconnected(this);
+} /* ReflectorTrunk::inboundDisconnected */
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ReflectorTrunk::connect(void)
+{
+  cout << "Trunk " << m_peer_id << ": Connecting to " << m_host << ":"
+       << m_port << endl;
+  m_reconnect_timer.setEnable(false);
+  m_out_con = new FramedTcpClient(m_host, m_port);
+  m_out_con->connected.connect(
+      mem_fun(*this, &ReflectorTrunk::onOutConnected));
+  m_out_con->disconnected.connect(
+      mem_fun(*this, &ReflectorTrunk::onOutDisconnected));
+  m_out_con->frameReceived.connect(
+      mem_fun(*this, &ReflectorTrunk::onOutFrameReceived));
+  m_out_con->connect();
+} /* ReflectorTrunk::connect */
+
+
+void ReflectorTrunk::reconnect(void)
+{
+  delete m_out_con;
+  m_out_con = 0;
+  connect();
+} /* ReflectorTrunk::reconnect */
+
+
+void ReflectorTrunk::disconnectOutbound(void)
+{
+  if ((m_out_con != 0) && m_out_con->isConnected())
+  {
+    m_out_con->disconnect();
+    onOutDisconnected(m_out_con, TcpConnection::DR_ORDERED_DISCONNECT);
+  }
+} /* ReflectorTrunk::disconnectOutbound */
+
+
+void ReflectorTrunk::disconnectInbound(void)
+{
+  if (m_in_con != 0)
+  {
+      // Let the TCP server clean up the connection. That will also lead to
+      // a call to inboundDisconnected.
+    FramedTcpConnection *con = m_in_con;
+    con->disconnect();
+    con->disconnected(con, FramedTcpConnection::DR_ORDERED_DISCONNECT);
+  }
+} /* ReflectorTrunk::disconnectInbound */
+
+
+void ReflectorTrunk::onOutConnected(void)
+{
+  cout << "Trunk " << m_peer_id << ": Connection established to "
+       << m_out_con->remoteHost() << ":" << m_out_con->remotePort() << endl;
+  m_out_con->setMaxFrameSize(ReflectorMsg::MAX_PREAUTH_FRAME_SIZE);
+  m_out_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+  m_out_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+  m_out_state = STATE_EXPECT_AUTH_CHALLENGE;
+} /* ReflectorTrunk::onOutConnected */
+
+
+void ReflectorTrunk::onOutDisconnected(Async::TcpConnection *con,
+                                       Async::TcpConnection::DisconnectReason reason)
+{
+  if (m_out_state == STATE_DISCONNECTED)
+  {
+    cout << "Trunk " << m_peer_id << ": Could not connect to "
+         << m_host << ":" << m_port << ": "
+         << TcpConnection::disconnectReasonStr(reason) << endl;
+  }
+  else
+  {
+    cout << "Trunk " << m_peer_id << ": Disconnected from "
+         << m_host << ":" << m_port << ": "
+         << TcpConnection::disconnectReasonStr(reason) << endl;
+  }
+  m_out_state = STATE_DISCONNECTED;
+  m_reconnect_timer.setTimeout(1000 + std::rand() % 5000);
+  m_reconnect_timer.setEnable(true);
+  m_reflector->updateTrunkStatus();
+} /* ReflectorTrunk::onOutDisconnected */
+
+
+void ReflectorTrunk::onOutFrameReceived(Async::FramedTcpConnection *con,
+                                        std::vector<uint8_t>& data)
+{
+  if (data.empty())
+  {
+    return;
+  }
+
+  stringstream ss;
+  ss.write(reinterpret_cast<char*>(&data.front()), data.size());
+
+  ReflectorMsg header;
+  if (!header.unpack(ss))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Unpacking failed for TCP message header" << endl;
+    disconnectOutbound();
+    return;
+  }
+
+  m_out_heartbeat_rx_cnt = HEARTBEAT_RX_CNT_RESET;
+
+  switch (header.type())
+  {
+    case MsgHeartbeat::TYPE:
+      break;
+
+    case MsgAuthChallenge::TYPE:
+    {
+      MsgAuthChallenge msg;
+      if ((m_out_state != STATE_EXPECT_AUTH_CHALLENGE) || !msg.unpack(ss) ||
+          (msg.challenge() == 0))
+      {
+        cout << "Trunk " << m_peer_id
+             << ": ERROR: Unexpected or illegal MsgAuthChallenge" << endl;
+        disconnectOutbound();
+        return;
+      }
+      std::ostringstream local_id;
+      local_id << m_local_id;
+      writeMsg(m_out_con,
+               MsgAuthResponse(local_id.str(), m_secret, msg.challenge()));
+      m_out_state = STATE_EXPECT_AUTH_OK;
+      break;
+    }
+
+    case MsgAuthOk::TYPE:
+    {
+      if (m_out_state != STATE_EXPECT_AUTH_OK)
+      {
+        cout << "Trunk " << m_peer_id << ": ERROR: Unexpected MsgAuthOk"
+             << endl;
+        disconnectOutbound();
+        return;
+      }
+      cout << "Trunk " << m_peer_id << ": Authentication OK" << endl;
+      m_out_con->setMaxFrameSize(ReflectorMsg::MAX_POSTAUTH_FRAME_SIZE);
+      m_out_state = STATE_CONNECTED;
+      m_reflector->trunkConnected(this);
+      break;
+    }
+
+    case MsgError::TYPE:
+    {
+      MsgError msg;
+      msg.unpack(ss);
+      cout << "Trunk " << m_peer_id
+           << ": Error message received from peer: " << msg.message()
+           << endl;
+      disconnectOutbound();
+      break;
+    }
+
+    default:
+      break;
+  }
+} /* ReflectorTrunk::onOutFrameReceived */
+
+
+void ReflectorTrunk::handleNodeList(std::istream& is)
+{
+  MsgNodeList msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Trunk " << m_peer_id << ": ERROR: Could not unpack MsgNodeList"
+         << endl;
+    return;
+  }
+  std::set<std::string> nodes(msg.nodes().begin(), msg.nodes().end());
+  std::set<std::string> old_nodes(m_remote_nodes);
+  for (std::set<std::string>::const_iterator it = old_nodes.begin();
+       it != old_nodes.end(); ++it)
+  {
+    if (nodes.find(*it) == nodes.end())
+    {
+      removeRemoteNode(*it);
+    }
+  }
+  for (std::set<std::string>::const_iterator it = nodes.begin();
+       it != nodes.end(); ++it)
+  {
+    addRemoteNode(*it);
+  }
+} /* ReflectorTrunk::handleNodeList */
+
+
+void ReflectorTrunk::handleNodeJoined(std::istream& is)
+{
+  MsgNodeJoined msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Could not unpack MsgNodeJoined" << endl;
+    return;
+  }
+  addRemoteNode(msg.callsign());
+} /* ReflectorTrunk::handleNodeJoined */
+
+
+void ReflectorTrunk::handleNodeLeft(std::istream& is)
+{
+  MsgNodeLeft msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Could not unpack MsgNodeLeft" << endl;
+    return;
+  }
+  removeRemoteNode(msg.callsign());
+} /* ReflectorTrunk::handleNodeLeft */
+
+
+void ReflectorTrunk::handleTalkerStart(std::istream& is)
+{
+  MsgTalkerStart msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Could not unpack MsgTalkerStart" << endl;
+    return;
+  }
+  if (sharesTG(msg.tg()))
+  {
+    m_reflector->trunkTalkerStart(this, msg.tg(), msg.callsign());
+  }
+} /* ReflectorTrunk::handleTalkerStart */
+
+
+void ReflectorTrunk::handleTalkerStop(std::istream& is)
+{
+  MsgTalkerStop msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Could not unpack MsgTalkerStop" << endl;
+    return;
+  }
+  if (sharesTG(msg.tg()))
+  {
+    m_reflector->trunkTalkerStop(this, msg.tg(), msg.callsign());
+  }
+} /* ReflectorTrunk::handleTalkerStop */
+
+
+void ReflectorTrunk::handleTrunkAudio(std::istream& is)
+{
+  MsgTrunkAudio msg;
+  if (!msg.unpack(is))
+  {
+    cout << "Trunk " << m_peer_id
+         << ": ERROR: Could not unpack MsgTrunkAudio" << endl;
+    return;
+  }
+  if (sharesTG(msg.tg()))
+  {
+    m_reflector->trunkAudio(this, msg.tg(), msg.audioData());
+  }
+} /* ReflectorTrunk::handleTrunkAudio */
+
+
+void ReflectorTrunk::addRemoteNode(const std::string& callsign)
+{
+  if (m_remote_nodes.insert(callsign).second)
+  {
+    m_reflector->broadcastMsg(MsgNodeJoined(callsign));
+    m_reflector->updateTrunkStatus();
+  }
+} /* ReflectorTrunk::addRemoteNode */
+
+
+void ReflectorTrunk::removeRemoteNode(const std::string& callsign)
+{
+  if (m_remote_nodes.erase(callsign) > 0)
+  {
+    m_reflector->broadcastMsg(MsgNodeLeft(callsign));
+    m_reflector->updateTrunkStatus();
+  }
+} /* ReflectorTrunk::removeRemoteNode */
+
+
+void ReflectorTrunk::clearRemoteNodes(void)
+{
+  std::set<std::string> nodes;
+  nodes.swap(m_remote_nodes);
+  for (std::set<std::string>::const_iterator it = nodes.begin();
+       it != nodes.end(); ++it)
+  {
+    m_reflector->broadcastMsg(MsgNodeLeft(*it));
+  }
+} /* ReflectorTrunk::clearRemoteNodes */
+
+
+void ReflectorTrunk::handleHeartbeat(Async::Timer *t)
+{
+  if (m_out_state != STATE_DISCONNECTED)
+  {
+    if (--m_out_heartbeat_tx_cnt == 0)
+    {
+      m_out_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+      writeMsg(m_out_con, MsgHeartbeat());
+    }
+    if (--m_out_heartbeat_rx_cnt == 0)
+    {
+      cout << "Trunk " << m_peer_id
+           << ": Heartbeat timeout on outgoing connection" << endl;
+      disconnectOutbound();
+    }
+  }
+
+  if (m_in_con != 0)
+  {
+    if (--m_in_heartbeat_tx_cnt == 0)
+    {
+      m_in_heartbeat_tx_cnt = HEARTBEAT_TX_CNT_RESET;
+      writeMsg(m_in_con, MsgHeartbeat());
+    }
+    if (--m_in_heartbeat_rx_cnt == 0)
+    {
+      cout << "Trunk " << m_peer_id
+           << ": Heartbeat timeout on incoming connection" << endl;
+      disconnectInbound();
+    }
+  }
+} /* ReflectorTrunk::handleHeartbeat */
+
+
+int ReflectorTrunk::writeMsg(Async::FramedTcpConnection *con,
+                             const ReflectorMsg& msg)
+{
+  ReflectorMsg header(msg.type());
+  m_pack_buf.clear();
+  Async::MsgWriter w(m_pack_buf);
+  if (!header.pack(w) || !msg.pack(w))
+  {
+    cerr << "*** ERROR: Failed to pack trunk TCP message\n";
+    errno = EBADMSG;
+    return -1;
+  }
+  return con->write(w.data(), w.size());
+} /* ReflectorTrunk::writeMsg */
+
+
+/*
+ * This file has not been truncated
+ */
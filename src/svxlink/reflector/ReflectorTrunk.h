@@ -0,0 +1,304 @@
+/**
+@file	 ReflectorTrunk.h
+@brief   A trunk link to another reflector
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-25
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_TRUNK_INCLUDED
+#define REFLECTOR_TRUNK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+
+#include <set>
+#include <string>
+#include <vector>
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncFramedTcpConnection.h>
+#include <AsyncTcpClient.h>
+#include <AsyncTimer.h>
+#include <AsyncConfig.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorMsg.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+class Reflector;
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A trunk link to another reflector
+@author Tobias Blomberg / SM0SVX
+@date   2020-07-25
+
+A trunk connect two reflectors so that the nodes connected to them can talk
+to each other on a configured set of talk groups. Talker start/stop, the
+audio on the shared talk groups and node presence is forwarded over the trunk.
+The audio is sent once to each peer reflector, which distribute it to its own
+nodes.
+
+Each side of a trunk use two TCP connections. The outgoing connection, set up
+by this object to the trunk port of the peer, is used to send the local
+events. The incoming connection is set up by the peer to the trunk port of
+this reflector. It is accepted and authenticated by the Reflector class and
+then handed over to this object, which handle the events received from the
+peer. Heartbeats are sent in both directions on both connections.
+
+Events received from the peer are never forwarded to another peer so the
+reflectors must be connected in a full mesh, that is each reflector must have
+a trunk to every other reflector.
+*/
+class ReflectorTrunk : public sigc::trackable
+{
+  public:
+    /**
+     * @brief   Parse a trunk id
+     * @param   str The string to parse
+     * @param   id  The parsed id is returned here
+     * @return  Returns \em true on success or \em false if not a number
+     *
+     * Trunk ids are numbers so "01" and "1" is the same id.
+     */
+    static bool parseId(const std::string& str, uint32_t& id);
+
+    /**
+     * @brief 	Constructor
+     * @param   ref       The reflector that the trunk belong to
+     * @param   local_id  The trunk id of this reflector
+     * @param   peer_id   The trunk id of the peer reflector
+     */
+    ReflectorTrunk(Reflector *ref, uint32_t local_id, uint32_t peer_id);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~ReflectorTrunk(void);
+
+    /**
+     * @brief   Initialize the trunk and start connecting to the peer
+     * @param   cfg     A previously initialized configuration object
+     * @param   section The configuration section for the trunk
+     * @return  Returns \em true on success or else \em false
+     */
+    bool initialize(Async::Config &cfg, const std::string& section);
+
+    /**
+     * @brief   Get the trunk id of the peer reflector
+     * @return  Returns the id of the peer
+     */
+    uint32_t peerId(void) const { return m_peer_id; }
+
+    /**
+     * @brief   Check if a talk group is shared with the peer
+     * @param   tg The talk group
+     * @return  Returns \em true if the talk group is shared
+     */
+    bool sharesTG(uint32_t tg) const
+    {
+      return m_tgs.find(tg) != m_tgs.end();
+    }
+
+    /**
+     * @brief   Check if the outgoing connection is up and authenticated
+     * @return  Returns \em true if messages can be sent to the peer
+     */
+    bool isConnected(void) const { return m_out_state == STATE_CONNECTED; }
+
+    /**
+     * @brief   Check if the peer is connected to this reflector
+     * @return  Returns \em true if there is an incoming connection
+     */
+    bool hasInboundConnection(void) const { return m_in_con != 0; }
+
+    /**
+     * @brief   Send a message to the peer
+     * @param   msg The message to send
+     * @return  Returns 0 on success or -1 on failure
+     *
+     * The message is sent on the outgoing connection. Nothing is sent if
+     * the connection is not up.
+     */
+    int sendMsg(const ReflectorMsg& msg);
+
+    /**
+     * @brief   Verify the authentication response from the peer
+     * @param   msg       The received authentication response
+     * @param   challenge The challenge that was sent to the peer
+     * @return  Returns \em true if the peer used the correct secret
+     */
+    bool verify(const MsgAuthResponse& msg,
+                const unsigned char *challenge) const
+    {
+      uint32_t id = 0;
+      return parseId(msg.callsign(), id) && (id == m_peer_id) &&
+             msg.verify(m_secret, challenge);
+    }
+
+    /**
+     * @brief   Hand over an authenticated incoming connection
+     * @param   con The connection from the peer
+     *
+     * A previous incoming connection from the peer, if any, is closed.
+     */
+    void setInboundConnection(Async::FramedTcpConnection *con);
+
+    /**
+     * @brief   Handle a frame received on the incoming connection
+     * @param   data The frame data
+     */
+    void inboundFrameReceived(std::vector<uint8_t>& data);
+
+    /**
+     * @brief   Tell the trunk that the incoming connection has been closed
+     * @param   con The connection that was closed
+     */
+    void inboundDisconnected(Async::FramedTcpConnection *con);
+
+    /**
+     * @brief   Get the nodes connected to the peer reflector
+     * @return  Returns the callsigns of the remote nodes
+     */
+    const std::set<std::string>& remoteNodes(void) const
+    {
+      return m_remote_nodes;
+    }
+
+  private:
+    typedef enum
+    {
+      STATE_DISCONNECTED, STATE_EXPECT_AUTH_CHALLENGE, STATE_EXPECT_AUTH_OK,
+      STATE_CONNECTED
+    } OutState;
+    typedef Async::TcpClient<Async::FramedTcpConnection> FramedTcpClient;
+
+    static const unsigned HEARTBEAT_TX_CNT_RESET  = 10;
+    static const unsigned HEARTBEAT_RX_CNT_RESET  = 15;
+
+    Reflector*                  m_reflector;
+    uint32_t                    m_local_id;
+    uint32_t                    m_peer_id;
+    std::string                 m_host;
+    uint16_t                    m_port;
+    std::string                 m_secret;
+    std::set<uint32_t>          m_tgs;
+    FramedTcpClient*            m_out_con;
+    OutState                    m_out_state;
+    Async::FramedTcpConnection* m_in_con;
+    Async::Timer                m_reconnect_timer;
+    Async::Timer                m_heartbeat_timer;
+    unsigned                    m_out_heartbeat_tx_cnt;
+    unsigned                    m_out_heartbeat_rx_cnt;
+    unsigned                    m_in_heartbeat_tx_cnt;
+    unsigned                    m_in_heartbeat_rx_cnt;
+    std::set<std::string>       m_remote_nodes;
+    std::vector<uint8_t>        m_pack_buf;
+
+    ReflectorTrunk(const ReflectorTrunk&);
+    ReflectorTrunk& operator=(const ReflectorTrunk&);
+    void connect(void);
+    void reconnect(void);
+    void disconnectOutbound(void);
+    void disconnectInbound(void);
+    void onOutConnected(void);
+    void onOutDisconnected(Async::TcpConnection *con,
+                           Async::TcpConnection::DisconnectReason reason);
+    void onOutFrameReceived(Async::FramedTcpConnection *con,
+                            std::vector<uint8_t>& data);
+    void handleNodeList(std::istream& is);
+    void handleNodeJoined(std::istream& is);
+    void handleNodeLeft(std::istream& is);
+    void handleTalkerStart(std::istream& is);
+    void handleTalkerStop(std::istream& is);
+    void handleTrunkAudio(std::istream& is);
+    void addRemoteNode(const std::string& callsign);
+    void removeRemoteNode(const std::string& callsign);
+    void clearRemoteNodes(void);
+    void handleHeartbeat(Async::Timer *t);
+    int writeMsg(Async::FramedTcpConnection *con, const ReflectorMsg& msg);
+
+};  /* class ReflectorTrunk */
+
+
+#endif /* REFLECTOR_TRUNK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,556 @@
+/**
+@file	 ReflectorUdpWorker.cpp
+@brief   A thread relaying reflector UDP audio outside of the main loop
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-18
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncFdWatch.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorUdpWorker.h"
+#include "ReflectorMsg.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+namespace {
+  class MutexLocker
+  {
+    public:
+      MutexLocker(pthread_mutex_t *mutex) : m_mutex(mutex)
+      {
+        pthread_mutex_lock(m_mutex);
+      }
+      ~MutexLocker(void)
+      {
+        pthread_mutex_unlock(m_mutex);
+      }
+    private:
+      pthread_mutex_t *m_mutex;
+  };
+
+  uint64_t monotonicMs(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+  }
+};
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+ReflectorUdpWorker::ReflectorUdpWorker(uint16_t port)
+  : m_port(port), m_sock(-1), m_notify_watch(0), m_thread_started(false),
+    m_rx_buf(MAX_DATAGRAM_SIZE)
+{
+  m_stop_pipe[0] = m_stop_pipe[1] = -1;
+  m_notify_pipe[0] = m_notify_pipe[1] = -1;
+  pthread_mutex_init(&m_event_mutex, NULL);
+} /* ReflectorUdpWorker::ReflectorUdpWorker */
+
+
+ReflectorUdpWorker::~ReflectorUdpWorker(void)
+{
+  if (m_thread_started)
+  {
+    char stop = 1;
+    if (write(m_stop_pipe[1], &stop, 1) != 1)
+    {
+      cerr << "*** WARNING: Could not stop UDP worker thread: "
+           << strerror(errno) << endl;
+    }
+    int ret = pthread_join(m_thread, NULL);
+    if (ret != 0)
+    {
+      cerr << "*** WARNING: pthread_join: " << strerror(ret) << endl;
+    }
+  }
+  delete m_notify_watch;
+  m_notify_watch = 0;
+  closeFds();
+  pthread_mutex_destroy(&m_event_mutex);
+} /* ReflectorUdpWorker::~ReflectorUdpWorker */
+
+
+bool ReflectorUdpWorker::start(void)
+{
+#ifdef SO_REUSEPORT
+  m_sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_sock == -1)
+  {
+    perror("socket");
+    return false;
+  }
+  int on = 1;
+  if (setsockopt(m_sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1)
+  {
+    perror("setsockopt(SO_REUSEPORT)");
+    closeFds();
+    return false;
+  }
+  if (fcntl(m_sock, F_SETFL, O_NONBLOCK) == -1)
+  {
+    perror("fcntl");
+    closeFds();
+    return false;
+  }
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(m_port);
+  addr.sin_addr.s_addr = INADDR_ANY;
+  if (::bind(m_sock, reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) == -1)
+  {
+    perror("bind");
+    closeFds();
+    return false;
+  }
+#else
+  cerr << "*** ERROR: UDP workers need the SO_REUSEPORT socket option, "
+          "which is not supported on this platform" << endl;
+  return false;
+#endif
+
+  if ((pipe(m_stop_pipe) == -1) || (pipe(m_notify_pipe) == -1))
+  {
+    perror("pipe");
+    closeFds();
+    return false;
+  }
+  if (fcntl(m_notify_pipe[0], F_SETFL, O_NONBLOCK) == -1)
+  {
+    perror("fcntl");
+    closeFds();
+    return false;
+  }
+  m_notify_watch = new FdWatch(m_notify_pipe[0], FdWatch::FD_WATCH_RD);
+  m_notify_watch->activity.connect(
+      mem_fun(*this, &ReflectorUdpWorker::handleEvents));
+
+  int ret = pthread_create(&m_thread, NULL, threadFunc, this);
+  if (ret != 0)
+  {
+    cerr << "*** ERROR: pthread_create: " << strerror(ret) << endl;
+    delete m_notify_watch;
+    m_notify_watch = 0;
+    closeFds();
+    return false;
+  }
+  m_thread_started = true;
+
+  return true;
+} /* ReflectorUdpWorker::start */
+
+
+void ReflectorUdpWorker::setRouting(const RoutingPtr& routing)
+{
+  std::atomic_store(&m_routing, routing);
+} /* ReflectorUdpWorker::setRouting */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void *ReflectorUdpWorker::threadFunc(void *data)
+{
+  ReflectorUdpWorker *worker = reinterpret_cast<ReflectorUdpWorker*>(data);
+  worker->run();
+  return NULL;
+} /* ReflectorUdpWorker::threadFunc */
+
+
+void ReflectorUdpWorker::run(void)
+{
+  struct pollfd fds[2];
+  fds[0].fd = m_sock;
+  fds[0].events = POLLIN;
+  fds[1].fd = m_stop_pipe[0];
+  fds[1].events = POLLIN;
+  for (;;)
+  {
+    fds[0].revents = fds[1].revents = 0;
+    int ret = poll(fds, 2, -1);
+    if (ret == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      perror("poll in ReflectorUdpWorker::run");
+      return;
+    }
+    if (fds[1].revents != 0)
+    {
+      return;
+    }
+
+      // Use the same routing snapshot for all datagrams that are waiting
+    RoutingPtr routing = std::atomic_load(&m_routing);
+    for (;;)
+    {
+      struct sockaddr_in addr;
+      socklen_t addr_len = sizeof(addr);
+      ssize_t len = recvfrom(m_sock, &m_rx_buf[0], m_rx_buf.size(), 0,
+                             reinterpret_cast<struct sockaddr *>(&addr),
+                             &addr_len);
+      if (len == -1)
+      {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+        {
+          perror("recvfrom in ReflectorUdpWorker::run");
+        }
+        break;
+      }
+      handleDatagram(routing, addr, len);
+    }
+  }
+} /* ReflectorUdpWorker::run */
+
+
+void ReflectorUdpWorker::handleDatagram(const RoutingPtr& routing,
+                                        const struct sockaddr_in& addr,
+                                        size_t len)
+{
+  const IpAddress ip(addr.sin_addr);
+  const uint16_t port = ntohs(addr.sin_port);
+  const uint8_t *data = &m_rx_buf[0];
+
+    // Only audio from a talker is handled here. Everything else, including
+    // anything that look wrong, is handled by the main thread.
+  ReflectorUdpMsg header;
+  if (!routing || !header.unpackHeader(data, len) ||
+      (header.type() != MsgUdpAudio::TYPE))
+  {
+    postEvent(0, ip, port, data, len);
+    return;
+  }
+
+  Routing::ClientIdxMap::const_iterator idx_it =
+    routing->client_idx.find(header.clientId());
+  if (idx_it == routing->client_idx.end())
+  {
+    postEvent(0, ip, port, data, len);
+    return;
+  }
+  const Route& client = routing->clients[idx_it->second];
+  Routing::TgTalkerMap::const_iterator talker_it =
+    routing->tg_talker.find(client.tg);
+  if (!client.connected || client.blocked || (ip != client.addr) ||
+      (port != client.port) || (talker_it == routing->tg_talker.end()) ||
+      (talker_it->second != client.client_id) ||
+      (header.sequenceNum() != client.state->next_rx_seq))
+  {
+    postEvent(0, ip, port, data, len);
+    return;
+  }
+
+  const uint8_t *payload = data + ReflectorUdpMsg::HEADER_SIZE;
+  size_t payload_len = len - ReflectorUdpMsg::HEADER_SIZE;
+  if (!relayAudio(*routing, client, payload, payload_len))
+  {
+    postEvent(0, ip, port, data, len);
+    return;
+  }
+
+  client.state->next_rx_seq = header.sequenceNum() + 1;
+  client.state->rx_active = true;
+
+  if (m_talker_reported.size() > 2 * routing->clients.size() + 16)
+  {
+    m_talker_reported.clear();
+  }
+  uint64_t now = monotonicMs();
+  uint64_t& reported = m_talker_reported[client.client_id];
+  if (now - reported >= TALKER_REPORT_MS)
+  {
+    reported = now;
+    postEvent(client.client_id, ip, port, 0, 0);
+  }
+} /* ReflectorUdpWorker::handleDatagram */
+
+
+bool ReflectorUdpWorker::relayAudio(const Routing& routing,
+                                    const Route& talker,
+                                    const uint8_t *payload, size_t len)
+{
+    // Check that the length field is consistent in the same way as the
+    // main thread does. An empty audio message is left to the main thread.
+  size_t audio_len = 0;
+  if (len >= 2)
+  {
+    audio_len = (static_cast<size_t>(payload[0]) << 8) | payload[1];
+  }
+  if ((len < 2) || (len < 2 + audio_len) || (audio_len == 0))
+  {
+    return false;
+  }
+
+  Routing::TgReceiverMap::const_iterator rcv_it =
+    routing.tg_receivers.find(talker.tg);
+  if (rcv_it == routing.tg_receivers.end())
+  {
+    return true;
+  }
+  const vector<size_t>& receivers = rcv_it->second;
+  if (m_tx_msgs.size() < receivers.size())
+  {
+    m_tx_headers.resize(ReflectorUdpMsg::HEADER_SIZE * receivers.size());
+    m_tx_msgs.resize(receivers.size());
+    m_tx_iov.resize(2 * receivers.size());
+    m_tx_addrs.resize(receivers.size());
+  }
+
+  size_t cnt = 0;
+  for (vector<size_t>::const_iterator it = receivers.begin();
+       it != receivers.end(); ++it)
+  {
+    const Route& client = routing.clients[*it];
+    if (client.client_id == talker.client_id)
+    {
+      continue;
+    }
+
+    uint8_t *hdr_buf = &m_tx_headers[ReflectorUdpMsg::HEADER_SIZE * cnt];
+    ReflectorUdpMsg header(MsgUdpAudio::TYPE, client.client_id,
+                           client.state->next_tx_seq++);
+    header.packHeader(hdr_buf);
+
+    struct sockaddr_in& addr = m_tx_addrs[cnt];
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(client.port);
+    addr.sin_addr = client.addr.ip4Addr();
+
+    struct iovec *iov = &m_tx_iov[2 * cnt];
+    iov[0].iov_base = hdr_buf;
+    iov[0].iov_len = ReflectorUdpMsg::HEADER_SIZE;
+    iov[1].iov_base = const_cast<uint8_t*>(payload);
+    iov[1].iov_len = 2 + audio_len;
+
+    struct msghdr& hdr = m_tx_msgs[cnt].msg_hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_name = &addr;
+    hdr.msg_namelen = sizeof(addr);
+    hdr.msg_iov = iov;
+    hdr.msg_iovlen = 2;
+    m_tx_msgs[cnt].msg_len = 0;
+    ++cnt;
+  }
+
+  size_t pos = 0;
+  while (pos < cnt)
+  {
+    int ret = sendmmsg(m_sock, &m_tx_msgs[pos], cnt - pos, 0);
+    if (ret == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      if (errno == EAGAIN)
+      {
+          // The socket buffer is full. Drop the rest of the datagrams
+          // rather than stalling the relay for all talk groups.
+        break;
+      }
+      perror("sendmmsg in ReflectorUdpWorker::relayAudio");
+      ++pos;
+      continue;
+    }
+    pos += ret;
+  }
+
+  return true;
+} /* ReflectorUdpWorker::relayAudio */
+
+
+void ReflectorUdpWorker::postEvent(uint32_t client_id, const IpAddress& addr,
+                                   uint16_t port, const uint8_t *data,
+                                   size_t len)
+{
+  bool notify = false;
+  {
+    MutexLocker lock(&m_event_mutex);
+    notify = m_events.empty();
+    m_events.push_back(Event());
+    Event& event = m_events.back();
+    event.client_id = client_id;
+    event.addr = addr;
+    event.port = port;
+    event.data.assign(data, data + len);
+  }
+  if (notify)
+  {
+    char ch = 1;
+    if (write(m_notify_pipe[1], &ch, 1) != 1)
+    {
+      perror("write in ReflectorUdpWorker::postEvent");
+    }
+  }
+} /* ReflectorUdpWorker::postEvent */
+
+
+void ReflectorUdpWorker::handleEvents(FdWatch *w)
+{
+  char buf[64];
+  while (read(m_notify_pipe[0], buf, sizeof(buf)) > 0) {}
+
+  {
+    MutexLocker lock(&m_event_mutex);
+    m_main_events.swap(m_events);
+  }
+  for (vector<Event>::iterator it = m_main_events.begin();
+       it != m_main_events.end(); ++it)
+  {
+    if (it->data.empty())
+    {
+      talkerActive(it->client_id);
+    }
+    else
+    {
+      datagramPosted(it->addr, it->port, &it->data[0], it->data.size());
+    }
+  }
+  m_main_events.clear();
+} /* ReflectorUdpWorker::handleEvents */
+
+
+void ReflectorUdpWorker::closeFds(void)
+{
+  int *fds[] = {
+    &m_sock, &m_stop_pipe[0], &m_stop_pipe[1], &m_notify_pipe[0],
+    &m_notify_pipe[1]
+  };
+  for (size_t i=0; i<sizeof(fds)/sizeof(*fds); ++i)
+  {
+    if (*fds[i] != -1)
+    {
+      close(*fds[i]);
+      *fds[i] = -1;
+    }
+  }
+} /* ReflectorUdpWorker::closeFds */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,260 @@
+/**
+@file	 ReflectorUdpWorker.h
+@brief   A thread relaying reflector UDP audio outside of the main loop
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-18
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef REFLECTOR_UDP_WORKER_INCLUDED
+#define REFLECTOR_UDP_WORKER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <sigc++/sigc++.h>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncIpAddress.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorClient.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+namespace Async
+{
+  class FdWatch;
+};
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A thread relaying reflector UDP audio outside of the main loop
+@author Tobias Blomberg / SM0SVX
+@date   2020-07-18
+
+A UDP worker own a UDP socket bound to the reflector port with the
+SO_REUSEPORT option set, so that the kernel distribute incoming datagrams
+between the main thread socket and the worker sockets. All datagrams from one
+client end up on the same socket.
+
+The worker thread only handle the common case, audio from the current talker
+on a talk group. The audio is sent directly to all other clients on the talk
+group. Every other datagram is posted to the main thread, which handle it
+exactly as if it had been received on the main socket. That include the first
+audio datagrams from a new talker, since talker arbitration is done by the
+TGHandler in the main thread.
+
+The worker decide what to do using a routing snapshot published by the main
+thread. A snapshot is never changed after it has been published. The main
+thread create a new one when anything relevant change and swap it in
+atomically, so the worker thread never take a lock when relaying audio.
+*/
+class ReflectorUdpWorker : public sigc::trackable
+{
+  public:
+      /// A client in the routing snapshot
+    struct Route
+    {
+      uint32_t          client_id;
+      Async::IpAddress  addr;
+      uint16_t          port;
+      uint32_t          tg;
+      bool              connected;  ///< Connected and UDP port known
+      bool              blocked;    ///< Audio from the client is blocked
+      std::shared_ptr<ReflectorClient::UdpState> state;
+    };
+
+      /// A routing snapshot, published by the main thread
+    struct Routing
+    {
+      typedef std::unordered_map<uint32_t, size_t>        ClientIdxMap;
+      typedef std::map<uint32_t, std::vector<size_t> >    TgReceiverMap;
+      typedef std::map<uint32_t, uint32_t>                TgTalkerMap;
+
+      std::vector<Route>  clients;
+      ClientIdxMap        client_idx;     ///< Client id to index in clients
+      TgReceiverMap       tg_receivers;   ///< Connected clients per TG
+      TgTalkerMap         tg_talker;      ///< The client id of each talker
+    };
+    typedef std::shared_ptr<const Routing> RoutingPtr;
+
+    /**
+     * @brief 	Constructor
+     * @param   port The UDP port to bind to
+     */
+    explicit ReflectorUdpWorker(uint16_t port);
+
+    /**
+     * @brief 	Destructor
+     *
+     * The worker thread is stopped before the object is destroyed.
+     */
+    ~ReflectorUdpWorker(void);
+
+    /**
+     * @brief   Create the socket and start the worker thread
+     * @return  Returns \em true on success or else \em false
+     */
+    bool start(void);
+
+    /**
+     * @brief   Publish a new routing snapshot to the worker thread
+     * @param   routing The new routing snapshot
+     *
+     * This function must be called from the main thread.
+     */
+    void setRouting(const RoutingPtr& routing);
+
+    /**
+     * @brief   A signal emitted for datagrams the worker cannot handle
+     * @param   addr  The source IP address
+     * @param   port  The source UDP port
+     * @param   buf   The datagram
+     * @param   count The size of the datagram
+     *
+     * This signal is emitted in the main thread.
+     */
+    sigc::signal<void, const Async::IpAddress&, uint16_t,
+                 void*, int> datagramPosted;
+
+    /**
+     * @brief   A signal emitted when the worker relayed talker audio
+     * @param   client_id The id of the talking client
+     *
+     * This signal is emitted in the main thread about once a second per
+     * talker so that the talker timeout is not triggered.
+     */
+    sigc::signal<void, uint32_t> talkerActive;
+
+  private:
+    static const size_t   MAX_DATAGRAM_SIZE     = 65536;
+    static const uint64_t TALKER_REPORT_MS      = 1000;
+
+    struct Event
+    {
+      uint32_t              client_id;
+      Async::IpAddress      addr;
+      uint16_t              port;
+      std::vector<uint8_t>  data;
+    };
+
+    uint16_t                              m_port;
+    int                                   m_sock;
+    int                                   m_stop_pipe[2];
+    int                                   m_notify_pipe[2];
+    Async::FdWatch*                       m_notify_watch;
+    pthread_t                             m_thread;
+    bool                                  m_thread_started;
+    RoutingPtr                            m_routing;
+    pthread_mutex_t                       m_event_mutex;
+    std::vector<Event>                    m_events;
+    std::vector<Event>                    m_main_events;
+    std::unordered_map<uint32_t, uint64_t> m_talker_reported;
+    std::vector<uint8_t>                  m_rx_buf;
+    std::vector<uint8_t>                  m_tx_headers;
+    std::vector<struct mmsghdr>           m_tx_msgs;
+    std::vector<struct iovec>             m_tx_iov;
+    std::vector<struct sockaddr_in>       m_tx_addrs;
+
+    ReflectorUdpWorker(const ReflectorUdpWorker&);
+    ReflectorUdpWorker& operator=(const ReflectorUdpWorker&);
+    static void *threadFunc(void *data);
+    void run(void);
+    void handleDatagram(const RoutingPtr& routing,
+                        const struct sockaddr_in& addr, size_t len);
+    bool relayAudio(const Routing& routing, const Route& talker,
+                    const uint8_t *payload, size_t len);
+    void postEvent(uint32_t client_id, const Async::IpAddress& addr,
+                   uint16_t port, const uint8_t *data, size_t len);
+    void handleEvents(Async::FdWatch *w);
+    void closeFds(void);
+
+};  /* class ReflectorUdpWorker */
+
+
+#endif /* REFLECTOR_UDP_WORKER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
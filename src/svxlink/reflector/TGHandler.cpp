@@ -168,7 +168,7 @@ void TGHandler::switchTo(ReflectorClient *client, uint32_t tg)
       }
       m_id_map[tg] = tg_info;
     }
-    tg_info->clients.insert(client);
+    tg_info->clients.push_back(client);
     m_client_map[client] = tg_info;
   }
 
@@ -189,21 +189,75 @@ void TGHandler::removeClient(ReflectorClient* client)
     removeClientP(tg_info, client);
     //printTGStatus();
   }
+  setMonitoredTGs(client, std::set<uint32_t>());
 } /* TGHandler::removeClient */
 
 
-const TGHandler::ClientSet& TGHandler::clientsForTG(uint32_t tg) const
+void TGHandler::setMonitoredTGs(ReflectorClient* client,
+                                const std::set<uint32_t>& tgs)
 {
-  static const TGHandler::ClientSet empty_set;
+  ClientMonitorMap::iterator client_it = m_client_monitor_map.find(client);
+  if (client_it != m_client_monitor_map.end())
+  {
+    const std::set<uint32_t>& old_tgs = client_it->second;
+    for (std::set<uint32_t>::const_iterator it = old_tgs.begin();
+         it != old_tgs.end(); ++it)
+    {
+      if (tgs.count(*it) == 0)
+      {
+        removeMonitor(*it, client);
+      }
+    }
+  }
+
+  for (std::set<uint32_t>::const_iterator it = tgs.begin();
+       it != tgs.end(); ++it)
+  {
+    if ((client_it == m_client_monitor_map.end()) ||
+        (client_it->second.count(*it) == 0))
+    {
+      m_monitor_map[*it].push_back(client);
+    }
+  }
+
+  if (tgs.empty())
+  {
+    if (client_it != m_client_monitor_map.end())
+    {
+      m_client_monitor_map.erase(client_it);
+    }
+  }
+  else
+  {
+    m_client_monitor_map[client] = tgs;
+  }
+} /* TGHandler::setMonitoredTGs */
+
+
+const TGHandler::ClientList& TGHandler::clientsForTG(uint32_t tg) const
+{
+  static const TGHandler::ClientList empty_list;
   IdMap::const_iterator id_map_it = m_id_map.find(tg);
   if (id_map_it == m_id_map.end())
   {
-    return empty_set;
+    return empty_list;
   }
   return id_map_it->second->clients;
 } /* TGHandler::clientsForTG */
 
 
+const TGHandler::ClientList& TGHandler::monitorsForTG(uint32_t tg) const
+{
+  static const TGHandler::ClientList empty_list;
+  MonitorMap::const_iterator monitor_map_it = m_monitor_map.find(tg);
+  if (monitor_map_it == m_monitor_map.end())
+  {
+    return empty_list;
+  }
+  return monitor_map_it->second;
+} /* TGHandler::monitorsForTG */
+
+
 void TGHandler::setTalkerForTG(uint32_t tg, ReflectorClient* new_talker)
 {
   IdMap::const_iterator id_map_it = m_id_map.find(tg);
@@ -316,7 +370,7 @@ void TGHandler::removeClientP(TGInfo *tg_info, ReflectorClient* client)
   {
     tg_info->talker = 0;
   }
-  tg_info->clients.erase(client);
+  eraseClient(tg_info->clients, client);
   m_client_map.erase(client);
   if (tg_info->clients.empty())
   {
@@ -326,6 +380,33 @@ void TGHandler::removeClientP(TGInfo *tg_info, ReflectorClient* client)
 } /* TGHandler::removeClientP */
 
 
+void TGHandler::removeMonitor(uint32_t tg, ReflectorClient* client)
+{
+  MonitorMap::iterator monitor_map_it = m_monitor_map.find(tg);
+  if (monitor_map_it != m_monitor_map.end())
+  {
+    eraseClient(monitor_map_it->second, client);
+    if (monitor_map_it->second.empty())
+    {
+      m_monitor_map.erase(monitor_map_it);
+    }
+  }
+} /* TGHandler::removeMonitor */
+
+
+void TGHandler::eraseClient(ClientList& clients, ReflectorClient* client)
+{
+    // The order of the clients does not matter so the last client is moved
+    // into the hole to avoid moving all the clients after it
+  ClientList::iterator it = std::find(clients.begin(), clients.end(), client);
+  if (it != clients.end())
+  {
+    *it = clients.back();
+    clients.pop_back();
+  }
+} /* TGHandler::eraseClient */
+
+
 void TGHandler::printTGStatus(void)
 {
   std::cout << "### ----------- BEGIN ----------------" << std::endl;
@@ -334,7 +415,7 @@ void TGHandler::printTGStatus(void)
   {
     TGInfo *tg_info = it->second;
     std::cout << "### " << tg_info->id << ": ";
-    for (ClientSet::const_iterator it = tg_info->clients.begin();
+    for (ClientList::const_iterator it = tg_info->clients.begin();
          it != tg_info->clients.end(); ++it)
     {
       ReflectorClient* client = *it;
@@ -36,6 +36,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <map>
 #include <set>
+#include <vector>
 #include <sigc++/sigc++.h>
 #include <sys/time.h>
 
@@ -113,11 +114,17 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 This class is responsible for keeping track of all talk groups that are used in
 the system.
+
+For each talk group, a list of the clients that have selected it and a list of
+the clients that monitor it are kept up to date when clients switch talk
+group, change monitored talk groups or disconnect. The lists are plain vectors
+so that sending a message to all clients on a talk group only has to visit the
+clients that should receive it.
 */
 class TGHandler : public sigc::trackable
 {
   public:
-    typedef std::set<ReflectorClient*> ClientSet;
+    typedef std::vector<ReflectorClient*> ClientList;
 
     static TGHandler* instance(void)
     {
@@ -150,7 +157,30 @@ class TGHandler : public sigc::trackable
 
     void removeClient(ReflectorClient* client);
 
-    const ClientSet& clientsForTG(uint32_t tg) const;
+    /**
+     * @brief   Set the talk groups that a client monitor
+     * @param   client The client
+     * @param   tgs The monitored talk groups, replacing any previous set
+     */
+    void setMonitoredTGs(ReflectorClient* client,
+                         const std::set<uint32_t>& tgs);
+
+    /**
+     * @brief   Get the clients that have selected a talk group
+     * @param   tg The talk group
+     * @return  Returns a list of the clients, in no particular order
+     */
+    const ClientList& clientsForTG(uint32_t tg) const;
+
+    /**
+     * @brief   Get the clients that monitor a talk group
+     * @param   tg The talk group
+     * @return  Returns a list of the clients, in no particular order
+     *
+     * A client that monitor the talk group it has selected will be present
+     * both in this list and in the list returned by clientsForTG.
+     */
+    const ClientList& monitorsForTG(uint32_t tg) const;
 
     void setTalkerForTG(uint32_t tg, ReflectorClient* client);
 
@@ -169,7 +199,7 @@ class TGHandler : public sigc::trackable
     struct TGInfo
     {
       uint32_t          id;
-      ClientSet         clients;
+      ClientList        clients;
       ReflectorClient*  talker;
       struct timeval    last_talker_timestamp;
       unsigned          sql_timeout_cnt;
@@ -185,10 +215,15 @@ class TGHandler : public sigc::trackable
     };
     typedef std::map<uint32_t, TGInfo*>               IdMap;
     typedef std::map<const ReflectorClient*, TGInfo*> ClientMap;
+    typedef std::map<uint32_t, ClientList>            MonitorMap;
+    typedef std::map<const ReflectorClient*,
+                     std::set<uint32_t> >             ClientMonitorMap;
 
     const Async::Config*  m_cfg;
     IdMap                 m_id_map;
     ClientMap             m_client_map;
+    MonitorMap            m_monitor_map;
+    ClientMonitorMap      m_client_monitor_map;
     Async::Timer          m_timeout_timer;
     unsigned              m_sql_timeout;
     unsigned              m_sql_timeout_blocktime;
@@ -197,6 +232,8 @@ class TGHandler : public sigc::trackable
     TGHandler& operator=(const TGHandler&);
     void checkTimers(Async::Timer *t);
     void removeClientP(TGInfo *tg_info, ReflectorClient* client);
+    void removeMonitor(uint32_t tg, ReflectorClient* client);
+    static void eraseClient(ClientList& clients, ReflectorClient* client);
     void printTGStatus(void);
 };  /* class TGHandler */
 
@@ -0,0 +1,237 @@
+/**
+@file   TGHandler_bench.cpp
+@brief  Benchmark of the talk group audio routing
+@author Tobias Blomberg / SM0SVX
+@date   2026-10-16
+
+\verbatim
+SvxReflector - An audio reflector for connecting SvxLink Servers
+Copyright (C) 2003-2019 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncCppApplication.h>
+#include <AsyncConfig.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "ReflectorClient.h"
+#include "TGHandler.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+  // Benchmark the cost of finding the receivers of one audio frame in the
+  // reflector. The old way, scanning all connected clients and applying a
+  // filter chain to each one, is compared with using the per talk group
+  // client lists maintained by the TGHandler. The nodes are spread evenly
+  // over the talk groups and each node also monitor a few other talk groups.
+  // Both methods must find the same receivers.
+  //
+  // Only the routing is measured. The client objects are never dereferenced
+  // so no real connections are needed.
+  //
+  // Usage: TGHandler_bench [nodes] [talk groups] [frames]
+
+namespace {
+  const unsigned MONITORED_TGS = 3;
+
+  typedef std::map<uint32_t, ReflectorClient*> ReflectorClientMap;
+
+  double elapsed(const struct timespec &start)
+  {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1.0e9 +
+           (end.tv_nsec - start.tv_nsec);
+  }
+};
+
+
+/****************************************************************************
+ *
+ * MAIN
+ *
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  unsigned node_cnt = (argc > 1) ? atoi(argv[1]) : 1000;
+  unsigned tg_cnt = (argc > 2) ? atoi(argv[2]) : 200;
+  unsigned frame_cnt = (argc > 3) ? atoi(argv[3]) : 100000;
+  if ((node_cnt == 0) || (tg_cnt == 0) || (frame_cnt == 0))
+  {
+    cerr << "Usage: " << argv[0] << " [nodes] [talk groups] [frames]\n";
+    exit(1);
+  }
+
+  Async::CppApplication app;
+  Async::Config cfg;
+  TGHandler *tg_handler = TGHandler::instance();
+  tg_handler->setConfig(&cfg);
+
+  vector<char> storage(node_cnt);
+  ReflectorClientMap client_map;
+  vector<ReflectorClient*> talkers(tg_cnt);
+  for (unsigned i=0; i<node_cnt; ++i)
+  {
+    ReflectorClient *client = reinterpret_cast<ReflectorClient*>(&storage[i]);
+    client_map[i] = client;
+    uint32_t tg = 1 + i % tg_cnt;
+    tg_handler->switchTo(client, tg);
+    talkers[tg - 1] = client;
+    set<uint32_t> tgs;
+    for (unsigned m=1; m<=MONITORED_TGS; ++m)
+    {
+      tgs.insert(1 + (i + m * 7) % tg_cnt);
+    }
+    tg_handler->setMonitoredTGs(client, tgs);
+  }
+
+  size_t scan_cnt = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned frame=0; frame<frame_cnt; ++frame)
+  {
+    uint32_t tg = 1 + frame % tg_cnt;
+    ReflectorClient *talker = talkers[tg - 1];
+    ReflectorClient::ExceptFilter except_filter(talker);
+    ReflectorClient::TgFilter tg_filter(tg);
+    ReflectorClient::AndFilter<ReflectorClient::ExceptFilter,
+                               ReflectorClient::TgFilter> filter(
+        except_filter, tg_filter);
+    for (ReflectorClientMap::const_iterator it = client_map.begin();
+         it != client_map.end(); ++it)
+    {
+      if (filter((*it).second))
+      {
+        ++scan_cnt;
+      }
+    }
+  }
+  double scan_ns = elapsed(start) / frame_cnt;
+
+  size_t list_cnt = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned frame=0; frame<frame_cnt; ++frame)
+  {
+    uint32_t tg = 1 + frame % tg_cnt;
+    ReflectorClient *talker = talkers[tg - 1];
+    ReflectorClient::ExceptFilter filter(talker);
+    const TGHandler::ClientList& clients = tg_handler->clientsForTG(tg);
+    for (TGHandler::ClientList::const_iterator it = clients.begin();
+         it != clients.end(); ++it)
+    {
+      if (filter(*it))
+      {
+        ++list_cnt;
+      }
+    }
+  }
+  double list_ns = elapsed(start) / frame_cnt;
+
+  size_t monitor_cnt = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (unsigned frame=0; frame<frame_cnt; ++frame)
+  {
+    uint32_t tg = 1 + frame % tg_cnt;
+    const TGHandler::ClientList& monitors = tg_handler->monitorsForTG(tg);
+    for (TGHandler::ClientList::const_iterator it = monitors.begin();
+         it != monitors.end(); ++it)
+    {
+      if (tg_handler->TGForClient(*it) != tg)
+      {
+        ++monitor_cnt;
+      }
+    }
+  }
+  double monitor_ns = elapsed(start) / frame_cnt;
+
+  printf("%u nodes on %u talk groups, %.1f receivers per frame\n",
+         node_cnt, tg_cnt, static_cast<double>(list_cnt) / frame_cnt);
+  printf("%-28s %10.1f ns/frame\n", "Scan all clients", scan_ns);
+  printf("%-28s %10.1f ns/frame\n", "Talk group client list", list_ns);
+  printf("%-28s %10.1f ns/frame\n", "Talk group monitor list", monitor_ns);
+
+  if (scan_cnt != list_cnt)
+  {
+    cerr << "*** ERROR: The number of receivers differ: scan=" << scan_cnt
+         << " list=" << list_cnt << endl;
+    return 1;
+  }
+
+  for (ReflectorClientMap::const_iterator it = client_map.begin();
+       it != client_map.end(); ++it)
+  {
+    tg_handler->removeClient((*it).second);
+  }
+  for (unsigned tg=1; tg<=tg_cnt; ++tg)
+  {
+    if (!tg_handler->clientsForTG(tg).empty() ||
+        !tg_handler->monitorsForTG(tg).empty())
+    {
+      cerr << "*** ERROR: Clients left on TG " << tg << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+/*
+ * This file has not been truncated
+ */
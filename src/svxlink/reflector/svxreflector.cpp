@@ -174,7 +174,7 @@ int main(int argc, const char *argv[])
 {
   setlocale(LC_ALL, "");
 
-  CppApplication app;
+  CppApplication app(CppApplication::BACKEND_EPOLL);
   app.catchUnixSignal(SIGHUP);
   app.catchUnixSignal(SIGINT);
   app.catchUnixSignal(SIGTERM);
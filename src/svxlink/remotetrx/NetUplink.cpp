@@ -49,6 +49,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncTimer.h>
 #include <AsyncAudioEncoder.h>
 #include <AsyncAudioDecoder.h>
+#include <AsyncAudioEncoderThreaded.h>
+#include <AsyncAudioDecoderThreaded.h>
 #include <AsyncAudioSplitter.h>
 #include <AsyncAudioSelector.h>
 #include <AsyncAudioPassthrough.h>
@@ -129,7 +131,7 @@ NetUplink::NetUplink(Config &cfg, const string &name, Rx *rx, Tx *tx,
     cfg(cfg), name(name), last_msg_timestamp(), heartbeat_timer(0),
     audio_enc(0), audio_dec(0), loopback_con(0), rx_splitter(0),
     tx_selector(0), state(STATE_DISC), mute_tx_timer(0), tx_muted(false),
-    fallback_enabled(false), tx_ctrl_mode(Tx::TX_OFF)
+    fallback_enabled(false), tx_ctrl_mode(Tx::TX_OFF), threaded_codec(false)
 {
   heartbeat_timer = new Timer(10000);
   heartbeat_timer->setEnable(false);
@@ -193,6 +195,7 @@ bool NetUplink::initialize(void)
   
   cfg.getValue(name, "FALLBACK_REPEATER", fallback_enabled, true);
   cfg.getValue(name, "AUTH_KEY", auth_key, true);
+  cfg.getValue(name, "THREADED_CODEC", threaded_codec, true);
   
   int mute_tx_on_rx = -1;
   cfg.getValue(name, "MUTE_TX_ON_RX", mute_tx_on_rx, true);
@@ -594,6 +597,10 @@ void NetUplink::handleMsg(Msg *msg)
 	  }
   
       audio_enc = AudioEncoder::create(codec_msg->name(), enc_options);
+      if ((audio_enc != 0) && threaded_codec)
+      {
+        audio_enc = new AudioEncoderThreaded(audio_enc);
+      }
       if (audio_enc != 0)
       {
         audio_enc->writeEncodedSamples.connect(
@@ -628,6 +635,10 @@ void NetUplink::handleMsg(Msg *msg)
 	    dec_options[(*it).first] = (*it).second;
 	  }     
       audio_dec = AudioDecoder::create(codec_msg->name(), dec_options);
+      if ((audio_dec != 0) && threaded_codec)
+      {
+        audio_dec = new AudioDecoderThreaded(audio_dec);
+      }
       if (audio_dec != 0)
       {
         audio_dec->registerSink(fifo);
@@ -714,7 +725,7 @@ void NetUplink::sendMsg(Msg *msg)
   if ((state == STATE_CON_SETUP) || (state == STATE_READY))
   {
     int written = con->write(msg, msg->size());
-    if (written == -1)
+    if ((written == -1) && (errno != ENOBUFS))
     {
       cerr << "*** ERROR: TCP transmit error in NetUplink \"" << name
            << "\": " << strerror(errno) << ".\n";
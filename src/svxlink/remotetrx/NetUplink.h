@@ -190,6 +190,7 @@ class NetUplink : public Uplink
     bool		    tx_muted;
     bool                    fallback_enabled;
     Tx::TxCtrlMode	    tx_ctrl_mode;
+    bool                    threaded_codec;
     
     NetUplink(const NetUplink&);
     NetUplink& operator=(const NetUplink&);
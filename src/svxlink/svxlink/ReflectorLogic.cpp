@@ -48,6 +48,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncUdpSocket.h>
 #include <AsyncAudioPassthrough.h>
 #include <AsyncAudioValve.h>
+#include <AsyncAudioEncoderThreaded.h>
+#include <AsyncAudioDecoderThreaded.h>
 #include <version/SVXLINK.h>
 
 
@@ -138,7 +140,8 @@ ReflectorLogic::ReflectorLogic(Async::Config& cfg, const std::string& name)
     m_tg_local_activity(false), m_last_qsy(0), m_logic_con_in_valve(0),
     m_mute_first_tx_loc(true), m_mute_first_tx_rem(false),
     m_tmp_monitor_timer(1000, Async::Timer::TYPE_PERIODIC),
-    m_tmp_monitor_timeout(DEFAULT_TMP_MONITOR_TIMEOUT), m_use_prio(true)
+    m_tmp_monitor_timeout(DEFAULT_TMP_MONITOR_TIMEOUT), m_use_prio(true),
+    m_threaded_codec(false)
 {
   m_reconnect_timer.expired.connect(
       sigc::hide(mem_fun(*this, &ReflectorLogic::reconnect)));
@@ -258,6 +261,8 @@ bool ReflectorLogic::initialize(void)
       sigc::mem_fun(*this, &ReflectorLogic::onLogicConInStreamStateChanged));
   AudioSource *prev_src = m_logic_con_in;
 
+  cfg().getValue(name(), "THREADED_CODEC", m_threaded_codec);
+
   cfg().getValue(name(), "MUTE_FIRST_TX_LOC", m_mute_first_tx_loc);
   cfg().getValue(name(), "MUTE_FIRST_TX_REM", m_mute_first_tx_rem);
   if (m_mute_first_tx_loc || m_mute_first_tx_rem)
@@ -1440,6 +1445,10 @@ bool ReflectorLogic::setAudioCodec(const std::string& codec_name)
     assert(m_enc != 0);
     return false;
   }
+  if (m_threaded_codec && (codec_name != "DUMMY"))
+  {
+    m_enc = new Async::AudioEncoderThreaded(m_enc);
+  }
   m_enc->writeEncodedSamples.connect(
       mem_fun(*this, &ReflectorLogic::sendEncodedAudio));
   m_enc->flushEncodedSamples.connect(
@@ -1480,6 +1489,10 @@ bool ReflectorLogic::setAudioCodec(const std::string& codec_name)
     assert(m_dec != 0);
     return false;
   }
+  if (m_threaded_codec && (codec_name != "DUMMY"))
+  {
+    m_dec = new Async::AudioDecoderThreaded(m_dec);
+  }
   m_dec->allEncodedSamplesFlushed.connect(
       mem_fun(*this, &ReflectorLogic::allEncodedSamplesFlushed));
   if (sink != 0)
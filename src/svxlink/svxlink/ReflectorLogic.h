@@ -255,6 +255,7 @@ class ReflectorLogic : public LogicBase
     Async::Timer                      m_tmp_monitor_timer;
     int                               m_tmp_monitor_timeout;
     bool                              m_use_prio;
+    bool                              m_threaded_codec;
 
     ReflectorLogic(const ReflectorLogic&);
     ReflectorLogic& operator=(const ReflectorLogic&);
@@ -0,0 +1,451 @@
+/**
+@file	 CtcssScanner.cpp
+@brief   Detect which one of the standard CTCSS tones that is present
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-22
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "CtcssScanner.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static double besselI0(double x);
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+namespace {
+  const float TONES[] = {
+     67.0f,  69.3f,  71.9f,  74.4f,  77.0f,  79.7f,  82.5f,  85.4f,  88.5f,
+     91.5f,  94.8f,  97.4f, 100.0f, 103.5f, 107.2f, 110.9f, 114.8f, 118.8f,
+    123.0f, 127.3f, 131.8f, 136.5f, 141.3f, 146.2f, 151.4f, 156.7f, 159.8f,
+    162.2f, 165.5f, 167.9f, 171.3f, 173.8f, 177.3f, 179.9f, 183.5f, 186.2f,
+    189.9f, 192.8f, 196.6f, 199.5f, 203.5f, 206.5f, 210.7f, 218.1f, 225.7f,
+    229.1f, 233.6f, 241.8f, 250.3f, 254.1f
+  };
+  const unsigned TONE_CNT = sizeof(TONES) / sizeof(*TONES);
+
+    // The sample rate after decimation and the highest frequency that must
+    // pass the decimation filter without being disturbed by aliasing
+  const unsigned SCAN_RATE = 800;
+  const double PASSBAND_EDGE = 260.0;
+  const double STOPBAND_ATTENUATION = 60.0;
+
+    // The DFT length give a bin spacing of 1Hz. With the Hann window the
+    // main lobe is +/-2Hz, which separate the closest standard tones.
+  const unsigned DFT_LEN = SCAN_RATE;
+  const unsigned HOP_LEN = SCAN_RATE / 10;
+
+  const unsigned DETECT_CNT = 3;
+  const unsigned UNDETECT_CNT = 3;
+
+  const float DEFAULT_DETECT_THRESH = 15.0f;
+  const float DEFAULT_UNDETECT_THRESH = 10.0f;
+};
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+unsigned CtcssScanner::toneCount(void)
+{
+  return TONE_CNT;
+} /* CtcssScanner::toneCount */
+
+
+float CtcssScanner::toneFq(unsigned idx)
+{
+  assert(idx < TONE_CNT);
+  return TONES[idx];
+} /* CtcssScanner::toneFq */
+
+
+int CtcssScanner::toneIndex(float fq)
+{
+  for (unsigned i=0; i<TONE_CNT; ++i)
+  {
+    if (fabsf(TONES[i] - fq) < 0.05f)
+    {
+      return i;
+    }
+  }
+  return -1;
+} /* CtcssScanner::toneIndex */
+
+
+CtcssScanner::CtcssScanner(unsigned sample_rate)
+  : m_dec_fact(sample_rate / SCAN_RATE), m_hist_pos(0), m_dec_cnt(0),
+    m_dft_pos(0), m_hop_cnt(0), m_pwr(TONE_CNT), m_sorted(TONE_CNT),
+    m_snr(TONE_CNT, 0.0f), m_det_thresh(DEFAULT_DETECT_THRESH),
+    m_undet_thresh(DEFAULT_UNDETECT_THRESH), m_cand(-1), m_cand_cnt(0),
+    m_active(-1), m_lost_cnt(0)
+{
+  assert((sample_rate % SCAN_RATE) == 0);
+
+    // Design the decimation filter using a Kaiser window. Everything above
+    // SCAN_RATE - PASSBAND_EDGE alias into the tone range after decimation
+    // so the transition band is placed between that frequency and the
+    // passband edge.
+  const double A = STOPBAND_ATTENUATION;
+  const double beta = 0.1102 * (A - 8.7);
+  const double dw = 2.0 * M_PI * (SCAN_RATE - 2.0 * PASSBAND_EDGE) /
+                    sample_rate;
+  const unsigned taps =
+      static_cast<unsigned>(ceil((A - 8.0) / (2.285 * dw))) + 1;
+  const double fc = 0.5 * SCAN_RATE / sample_rate;
+  vector<double> h(taps);
+  double sum = 0.0;
+  for (unsigned n=0; n<taps; ++n)
+  {
+    double t = n - (taps - 1) / 2.0;
+    double sinc = (t == 0.0) ? 1.0 : sin(2.0 * M_PI * fc * t) /
+                                     (2.0 * M_PI * fc * t);
+    double r = 2.0 * n / (taps - 1) - 1.0;
+    double w = besselI0(beta * sqrt(max(0.0, 1.0 - r * r))) / besselI0(beta);
+    h[n] = sinc * w;
+    sum += h[n];
+  }
+  m_coeff.resize(taps);
+  for (unsigned n=0; n<taps; ++n)
+  {
+    m_coeff[n] = h[n] / sum;
+  }
+
+    // The input history is stored twice so that the latest taps samples
+    // always are available in one contiguous block
+  m_hist.assign(2 * taps, 0.0f);
+
+    // Each tone use three sliding DFT bins, at the tone frequency and one
+    // bin spacing below and above it. Since the tone frequency is not
+    // a multiple of the bin spacing, the rotation for the sample leaving the
+    // DFT window is not one and has to be stored too. It is the same for all
+    // three bins.
+  m_rot_re.resize(3 * TONE_CNT);
+  m_rot_im.resize(3 * TONE_CNT);
+  m_rotn_re.resize(3 * TONE_CNT);
+  m_rotn_im.resize(3 * TONE_CNT);
+  for (unsigned t=0; t<TONE_CNT; ++t)
+  {
+    const double offsets[] = { 0.0, -1.0, 1.0 };
+    for (unsigned k=0; k<3; ++k)
+    {
+      double w = 2.0 * M_PI *
+                 (TONES[t] / static_cast<double>(SCAN_RATE) +
+                  offsets[k] / DFT_LEN);
+      m_rot_re[3 * t + k] = cos(w);
+      m_rot_im[3 * t + k] = -sin(w);
+      m_rotn_re[3 * t + k] = cos(w * DFT_LEN);
+      m_rotn_im[3 * t + k] = -sin(w * DFT_LEN);
+    }
+  }
+
+  reset();
+} /* CtcssScanner::CtcssScanner */
+
+
+CtcssScanner::~CtcssScanner(void)
+{
+} /* CtcssScanner::~CtcssScanner */
+
+
+float CtcssScanner::activeTone(void) const
+{
+  return (m_active >= 0) ? TONES[m_active] : 0.0f;
+} /* CtcssScanner::activeTone */
+
+
+void CtcssScanner::reset(void)
+{
+  fill(m_hist.begin(), m_hist.end(), 0.0f);
+  m_hist_pos = 0;
+  m_dec_cnt = 0;
+  m_re.assign(3 * TONE_CNT, 0.0);
+  m_im.assign(3 * TONE_CNT, 0.0);
+  m_dft_hist.assign(DFT_LEN, 0.0f);
+  m_dft_pos = 0;
+  m_hop_cnt = 0;
+  fill(m_snr.begin(), m_snr.end(), 0.0f);
+  m_cand = -1;
+  m_cand_cnt = 0;
+  m_active = -1;
+  m_lost_cnt = 0;
+} /* CtcssScanner::reset */
+
+
+int CtcssScanner::writeSamples(const float *samples, int count)
+{
+  const unsigned taps = m_coeff.size();
+  for (int i=0; i<count; ++i)
+  {
+    m_hist[m_hist_pos] = samples[i];
+    m_hist[m_hist_pos + taps] = samples[i];
+    if (++m_hist_pos == taps)
+    {
+      m_hist_pos = 0;
+    }
+
+      // Only every m_dec_fact:th output sample of the filter is calculated
+    if (++m_dec_cnt == m_dec_fact)
+    {
+      m_dec_cnt = 0;
+      const float *hist = &m_hist[m_hist_pos];
+      float out = 0.0f;
+      for (unsigned n=0; n<taps; ++n)
+      {
+        out += m_coeff[n] * hist[n];
+      }
+      processDecimated(out);
+    }
+  }
+
+  return count;
+
+} /* CtcssScanner::writeSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void CtcssScanner::processDecimated(float sample)
+{
+  const double in = sample;
+  const double out = m_dft_hist[m_dft_pos];
+  m_dft_hist[m_dft_pos] = sample;
+  if (++m_dft_pos == DFT_LEN)
+  {
+    m_dft_pos = 0;
+  }
+
+    // The sliding DFT update X = x(n) + X * exp(-jw) - x(n-N) * exp(-jwN).
+    // Double precision is used so that the rounding errors in the rotation
+    // do not accumulate over hours of operation.
+  const unsigned bins = m_re.size();
+  for (unsigned b=0; b<bins; ++b)
+  {
+    double re = m_re[b];
+    double im = m_im[b];
+    m_re[b] = in + re * m_rot_re[b] - im * m_rot_im[b] - out * m_rotn_re[b];
+    m_im[b] = re * m_rot_im[b] + im * m_rot_re[b] - out * m_rotn_im[b];
+  }
+
+  if (++m_hop_cnt == HOP_LEN)
+  {
+    m_hop_cnt = 0;
+    evaluate();
+  }
+} /* CtcssScanner::processDecimated */
+
+
+void CtcssScanner::evaluate(void)
+{
+    // Apply the Hann window in the frequency domain
+  for (unsigned t=0; t<TONE_CNT; ++t)
+  {
+    double re = 0.5 * m_re[3 * t] - 0.25 * (m_re[3 * t + 1] + m_re[3 * t + 2]);
+    double im = 0.5 * m_im[3 * t] - 0.25 * (m_im[3 * t + 1] + m_im[3 * t + 2]);
+    m_pwr[t] = re * re + im * im;
+  }
+
+  m_sorted = m_pwr;
+  nth_element(m_sorted.begin(), m_sorted.begin() + TONE_CNT / 2,
+              m_sorted.end());
+  const double noise = m_sorted[TONE_CNT / 2] + 1.0e-20;
+  int best = 0;
+  for (unsigned t=0; t<TONE_CNT; ++t)
+  {
+    m_snr[t] = 10.0 * log10((m_pwr[t] + 1.0e-20) / noise);
+    if (m_snr[t] > m_snr[best])
+    {
+      best = t;
+    }
+  }
+
+  if (m_snr[best] >= m_det_thresh)
+  {
+    if (best == m_cand)
+    {
+      ++m_cand_cnt;
+    }
+    else
+    {
+      m_cand = best;
+      m_cand_cnt = 1;
+    }
+  }
+  else
+  {
+    m_cand = -1;
+    m_cand_cnt = 0;
+  }
+
+  int lost = -1;
+  int found = -1;
+  if (m_active >= 0)
+  {
+    m_lost_cnt = (m_snr[m_active] < m_undet_thresh) ? m_lost_cnt + 1 : 0;
+    if ((m_lost_cnt >= UNDETECT_CNT) ||
+        ((m_cand != m_active) && (m_cand_cnt >= DETECT_CNT)))
+    {
+      lost = m_active;
+      m_active = -1;
+    }
+  }
+  if ((m_active < 0) && (m_cand >= 0) && (m_cand_cnt >= DETECT_CNT))
+  {
+    m_active = found = m_cand;
+    m_lost_cnt = 0;
+  }
+
+  if (lost >= 0)
+  {
+    undetected(TONES[lost]);
+  }
+  if (found >= 0)
+  {
+    detected(TONES[found]);
+  }
+  snrUpdated(m_snr);
+} /* CtcssScanner::evaluate */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+/*
+ * The zeroth order modified Bessel function of the first kind, used to
+ * calculate the Kaiser window
+ */
+static double besselI0(double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k=1; k<50; ++k)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < 1.0e-12 * sum)
+    {
+      break;
+    }
+  }
+  return sum;
+} /* besselI0 */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,276 @@
+/**
+@file	 CtcssScanner.h
+@brief   Detect which one of the standard CTCSS tones that is present
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-22
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef CTCSS_SCANNER_INCLUDED
+#define CTCSS_SCANNER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	Detect which one of the standard CTCSS tones that is present
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-22
+
+This class continuously measure the SNR for all of the 50 standard CTCSS tones
+and report which one of them, if any, that is present in the audio stream.
+Checking for all tones using ToneDetector objects would require 50 detectors
+with three bins each, all running at the full sample rate.
+
+Since all CTCSS tones are below 255Hz, the incoming audio is first low pass
+filtered and decimated to 800Hz. A sliding DFT is then evaluated at each tone
+frequency and at one bin spacing above and below it, which give a Hann
+windowed DFT over the last second of audio (1Hz bin spacing) after each
+decimated sample. The result is checked ten times per second. The SNR for a
+tone is the power in its bin relative to the median power of all tone bins,
+which is a robust noise floor estimate since at most a few bins contain the
+tone or its leakage.
+
+A tone is reported as detected when it has been the strongest tone and above
+the detection threshold in three consecutive evaluations. It is reported as
+lost when its SNR has been below the undetection threshold in three
+consecutive evaluations or when another tone is detected. A strong tone is
+detected in about 0.3 seconds. Weak tones need more of the one second DFT
+window to rise above the threshold so the detection time grow to a couple of
+seconds close to the sensitivity limit.
+*/
+class CtcssScanner : public sigc::trackable, public Async::AudioSink
+{
+  public:
+    /**
+     * @brief   Get the number of standard CTCSS tones
+     * @return  Returns the number of tones handled by the scanner
+     */
+    static unsigned toneCount(void);
+
+    /**
+     * @brief   Get the frequency of a standard CTCSS tone
+     * @param   idx The tone index, 0 to toneCount()-1
+     * @return  Returns the tone frequency in Hz
+     */
+    static float toneFq(unsigned idx);
+
+    /**
+     * @brief   Find the index of a standard CTCSS tone
+     * @param   fq The tone frequency in Hz
+     * @return  Returns the tone index or -1 if not a standard tone
+     */
+    static int toneIndex(float fq);
+
+    /**
+     * @brief 	Constructor
+     * @param   sample_rate The sample rate of the incoming samples
+     *
+     * The sample rate must be a multiple of 800Hz.
+     */
+    explicit CtcssScanner(unsigned sample_rate=INTERNAL_SAMPLE_RATE);
+
+    /**
+     * @brief 	Destructor
+     */
+    ~CtcssScanner(void);
+
+    /**
+     * @brief   Set the SNR needed for a tone to be detected
+     * @param   thresh_db The threshold in dB
+     */
+    void setDetectSnrThresh(float thresh_db) { m_det_thresh = thresh_db; }
+
+    /**
+     * @brief   Set the SNR below which a detected tone is lost
+     * @param   thresh_db The threshold in dB
+     */
+    void setUndetectSnrThresh(float thresh_db) { m_undet_thresh = thresh_db; }
+
+    /**
+     * @brief   Get the currently detected tone
+     * @return  Returns the tone frequency in Hz or 0 if no tone is detected
+     */
+    float activeTone(void) const;
+
+    /**
+     * @brief   Get the last calculated SNR for a tone
+     * @param   idx The tone index, 0 to toneCount()-1
+     * @return  Returns the SNR in dB
+     */
+    float toneSnr(unsigned idx) const { return m_snr[idx]; }
+
+    /**
+     * @brief   Clear the filter and DFT states and the detection state
+     *
+     * No signal is emitted for a tone that was detected.
+     */
+    void reset(void);
+
+    /**
+     * @brief 	Write samples into the scanner
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the scanner to flush the previously written samples
+     */
+    virtual void flushSamples(void) { sourceAllSamplesFlushed(); }
+
+    /**
+     * @brief   A signal that is emitted when a tone has been detected
+     * @param   fq The frequency of the detected tone
+     */
+    sigc::signal<void, float> detected;
+
+    /**
+     * @brief   A signal that is emitted when a detected tone is lost
+     * @param   fq The frequency of the lost tone
+     */
+    sigc::signal<void, float> undetected;
+
+    /**
+     * @brief   A signal that is emitted when the SNR values are updated
+     * @param   snr The SNR in dB for each tone, in tone index order
+     *
+     * This signal is emitted ten times per second.
+     */
+    sigc::signal<void, const std::vector<float>&> snrUpdated;
+
+  private:
+    unsigned              m_dec_fact;
+    std::vector<float>    m_coeff;
+    std::vector<float>    m_hist;
+    unsigned              m_hist_pos;
+    unsigned              m_dec_cnt;
+    std::vector<double>   m_rot_re;
+    std::vector<double>   m_rot_im;
+    std::vector<double>   m_rotn_re;
+    std::vector<double>   m_rotn_im;
+    std::vector<double>   m_re;
+    std::vector<double>   m_im;
+    std::vector<float>    m_dft_hist;
+    unsigned              m_dft_pos;
+    unsigned              m_hop_cnt;
+    std::vector<double>   m_pwr;
+    std::vector<double>   m_sorted;
+    std::vector<float>    m_snr;
+    float                 m_det_thresh;
+    float                 m_undet_thresh;
+    int                   m_cand;
+    unsigned              m_cand_cnt;
+    int                   m_active;
+    unsigned              m_lost_cnt;
+
+    CtcssScanner(const CtcssScanner&);
+    CtcssScanner& operator=(const CtcssScanner&);
+    void processDecimated(float sample);
+    void evaluate(void);
+
+};  /* class CtcssScanner */
+
+
+//} /* namespace */
+
+#endif /* CTCSS_SCANNER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,214 @@
+#include <time.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "CtcssScanner.h"
+#include "GoertzelBank.h"
+#include "ToneDetector.h"
+
+using namespace std;
+
+  // Benchmark the CTCSS scanner against checking for all standard CTCSS
+  // tones using one ToneDetector per tone, set up like the detectors used for
+  // CTCSS_TO_TG (4Hz bandwidth, 10dB peak threshold, 1000ms detection delay).
+  // All tone detectors share one Goertzel bank.
+  //
+  // For each noise level, every standard tone is sent for a few seconds,
+  // mixed with a synthetic voice signal and white gaussian noise. The tone
+  // level is -20dBFS and the noise level is given relative to the tone over
+  // the whole audio band. A number of runs with no tone at all are used to
+  // count false detections. For each implementation the number of correctly
+  // detected tones, wrong tones, missed tones, the mean detection time and
+  // the number of detections in the no-tone runs are printed. The runtime is
+  // given as the time needed to process one second of audio at 16kHz.
+  //
+  // Usage: CtcssScannerBench [seconds per run]
+
+namespace {
+  const unsigned RATE = 16000;
+  const unsigned BLOCKSIZE = 256;
+  const unsigned NO_TONE_RUNS = 20;
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+
+  double gauss(void)
+  {
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+  }
+
+    // A tone (if fq > 0), a voice like signal and noise
+  void makeSignal(vector<float> &buf, float fq, double snr_db)
+  {
+    const double tone_amp = 0.1;
+    const double noise_amp =
+        sqrt(tone_amp * tone_amp / 2.0 / pow(10.0, snr_db / 10.0));
+    const double phase = 2.0 * M_PI * rand() / RAND_MAX;
+    for (size_t i=0; i<buf.size(); ++i)
+    {
+      double t = static_cast<double>(i) / RATE;
+      double voice = 0.0;
+      for (unsigned h=2; h<=20; ++h)
+      {
+        voice += sin(2.0 * M_PI * 150.0 * h * t + h) / h;
+      }
+      voice *= 0.3 * (0.6 + 0.4 * sin(2.0 * M_PI * 3.0 * t));
+      double tone = (fq > 0.0f) ? tone_amp * sin(2.0 * M_PI * fq * t + phase)
+                                : 0.0;
+      buf[i] = tone + voice + noise_amp * gauss();
+    }
+  }
+
+  struct Result
+  {
+    float   fq;
+    double  time;
+    Result(void) : fq(0.0f), time(0.0) {}
+  };
+
+  class Recorder : public sigc::trackable
+  {
+    public:
+      Result  res;
+      double  pos;
+
+      Recorder(void) : pos(0.0) {}
+      void detected(float fq)
+      {
+        if (res.fq == 0.0f)
+        {
+          res.fq = fq;
+          res.time = pos;
+        }
+      }
+  };
+
+  Result runReference(const vector<float> &buf, double &runtime)
+  {
+    Recorder rec;
+    GoertzelBank bank(RATE);
+    for (unsigned i=0; i<CtcssScanner::toneCount(); ++i)
+    {
+      ToneDetector *det = new ToneDetector(CtcssScanner::toneFq(i), 4, 1000);
+      det->setPeakThresh(10);
+      det->detected.connect(sigc::mem_fun(rec, &Recorder::detected));
+      bank.addSubscriber(det, true);
+    }
+    double start = now();
+    for (size_t i=0; i+BLOCKSIZE<=buf.size(); i+=BLOCKSIZE)
+    {
+      rec.pos = static_cast<double>(i + BLOCKSIZE) / RATE;
+      bank.writeSamples(&buf[i], BLOCKSIZE);
+    }
+    runtime += now() - start;
+    return rec.res;
+  }
+
+  Result runScanner(const vector<float> &buf, double &runtime)
+  {
+    Recorder rec;
+    CtcssScanner scanner(RATE);
+    scanner.detected.connect(sigc::mem_fun(rec, &Recorder::detected));
+    double start = now();
+    for (size_t i=0; i+BLOCKSIZE<=buf.size(); i+=BLOCKSIZE)
+    {
+      rec.pos = static_cast<double>(i + BLOCKSIZE) / RATE;
+      scanner.writeSamples(&buf[i], BLOCKSIZE);
+    }
+    runtime += now() - start;
+    return rec.res;
+  }
+
+  struct Stats
+  {
+    unsigned  correct;
+    unsigned  wrong;
+    unsigned  missed;
+    double    time_sum;
+    unsigned  false_det;
+    double    runtime;
+    Stats(void)
+      : correct(0), wrong(0), missed(0), time_sum(0.0), false_det(0),
+        runtime(0.0)
+    {}
+
+    void add(const Result &res, float fq)
+    {
+      if (res.fq == 0.0f)
+      {
+        ++missed;
+      }
+      else if (fabsf(res.fq - fq) < 0.05f)
+      {
+        ++correct;
+        time_sum += res.time;
+      }
+      else
+      {
+        ++wrong;
+      }
+    }
+
+    void print(const char *name, double audio_seconds)
+    {
+      printf("%-9s %7u %7u %7u %9.2f %7u %12.3f\n", name, correct, wrong,
+             missed, (correct > 0) ? time_sum / correct : 0.0, false_det,
+             1000.0 * runtime / audio_seconds);
+    }
+  };
+};
+
+
+int main(int argc, char **argv)
+{
+  double seconds = (argc > 1) ? atof(argv[1]) : 4.0;
+  if (seconds <= 0.0)
+  {
+    cerr << "Usage: " << argv[0] << " [seconds per run]\n";
+    exit(1);
+  }
+  vector<float> buf(static_cast<size_t>(RATE * seconds));
+
+  printf("%-9s %7s %7s %7s %9s %7s %12s\n", "", "Correct", "Wrong",
+         "Missed", "Det time", "False", "Runtime");
+  printf("%-9s %7s %7s %7s %9s %7s %12s\n", "", "", "", "", "s", "",
+         "ms/s audio");
+  const double snrs[] = { 10.0, 0.0, -10.0, -15.0, -20.0, -25.0 };
+  for (size_t s=0; s<sizeof(snrs)/sizeof(*snrs); ++s)
+  {
+    Stats ref;
+    Stats scan;
+    for (unsigned i=0; i<CtcssScanner::toneCount(); ++i)
+    {
+      float fq = CtcssScanner::toneFq(i);
+      makeSignal(buf, fq, snrs[s]);
+      ref.add(runReference(buf, ref.runtime), fq);
+      scan.add(runScanner(buf, scan.runtime), fq);
+    }
+    for (unsigned i=0; i<NO_TONE_RUNS; ++i)
+    {
+      makeSignal(buf, 0.0f, snrs[s]);
+      ref.false_det += (runReference(buf, ref.runtime).fq != 0.0f);
+      scan.false_det += (runScanner(buf, scan.runtime).fq != 0.0f);
+    }
+
+    double audio_seconds =
+        (CtcssScanner::toneCount() + NO_TONE_RUNS) * buf.size() /
+        static_cast<double>(RATE);
+    printf("Tone to noise ratio %.0fdB:\n", snrs[s]);
+    ref.print("  Ref", audio_seconds);
+    scan.print("  Scanner", audio_seconds);
+  }
+
+  return 0;
+}
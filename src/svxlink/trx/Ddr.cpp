@@ -61,6 +61,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncConfig.h>
 #include <AsyncAudioSource.h>
 #include <AsyncTcpClient.h>
+#include <AsyncPolyphaseFir.h>
 
 
 /****************************************************************************
@@ -71,6 +72,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "Ddr.h"
 #include "WbRxRtlSdr.h"
+#include "PolyphaseChannelizer.h"
 #include "DdrFilterCoeffs.h"
 
 
@@ -105,84 +107,45 @@ namespace {
   class Decimator
   {
     public:
-      Decimator(void) : dec_fact(0), p_Z(0), taps(0) {}
+      Decimator(void) : dec_fact(0) {}
 
       Decimator(int dec_fact, const float *coeff, int taps)
-        : dec_fact(dec_fact), p_Z(0), taps(taps)
+        : dec_fact(dec_fact)
       {
         setDecimatorParams(dec_fact, coeff, taps);
       }
 
-      ~Decimator(void)
-      {
-        delete [] p_Z;
-      }
-
       int decFact(void) const { return dec_fact; }
 
       void setDecimatorParams(int dec_fact, const float *coeff, int taps)
       {
         assert(taps >= dec_fact);
-
-        set_coeff.assign(coeff, coeff + taps);
         this->dec_fact = dec_fact;
-        this->coeff = set_coeff;
-        this->taps = taps;
-
-        delete [] p_Z;
-        p_Z = new T[taps]();
+        fir.setDecimator(dec_fact, coeff, taps);
       }
 
       void setGain(double gain_adjust)
       {
-        coeff = set_coeff;
-        for (vector<float>::iterator it=coeff.begin(); it!=coeff.end(); ++it)
-        {
-          *it *= pow(10.0, gain_adjust / 20.0);
-        }
+        fir.setGain(pow(10.0, gain_adjust / 20.0));
       }
 
       void decimate(vector<T> &out, const vector<T> &in)
       {
-        int orig_count = in.size();
-
           // this implementation assumes in.size() is a multiple of factor_M
         assert(in.size() % dec_fact == 0);
 
-        int num_out = 0;
-        typename vector<T>::const_iterator src = in.begin();
-        out.clear();
-        out.reserve(in.size() / dec_fact);
-        while (src != in.end())
+        out.resize(in.size() / dec_fact);
+        if (!in.empty())
         {
-            // shift Z delay line up to make room for next samples
-          memmove(p_Z + dec_fact, p_Z, (taps - dec_fact) * sizeof(T));
-
-            // copy next samples from input buffer to bottom of Z delay line
-          for (int tap = dec_fact - 1; tap >= 0; tap--)
-          {
-            assert(src != in.end());
-            p_Z[tap] = *src++;
-          }
-
-            // calculate FIR sum
-          T sum(0);
-          for (int tap = 0; tap < taps; tap++)
-          {
-            sum += coeff[tap] * p_Z[tap];
-          }
-          out.push_back(sum);     /* store sum */
-          num_out++;
+          size_t num_out = fir.process(&out[0], &in[0], in.size());
+          assert(num_out == out.size());
+          (void)num_out;
         }
-        assert(num_out == orig_count / dec_fact);
       }
 
     private:
-      int             dec_fact;
-      T               *p_Z;
-      int             taps;
-      vector<float>   set_coeff;
-      vector<float>   coeff;
+      int                 dec_fact;
+      PolyphaseFir<T>     fir;
   };
 
   template <class T>
@@ -207,11 +170,10 @@ namespace {
       virtual int decFact(void) const { return 1; }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        out.clear();
-        out.reserve(in.size());
+        out.resize(in.size());
         for (size_t i=0; i<in.size(); ++i)
         {
-          out.push_back(gain * in[i]);
+          out[i] = gain * in[i];
         }
       }
 
@@ -244,13 +206,13 @@ namespace {
       virtual int decFact(void) const { return d1.decFact() * d2.decFact(); }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1;
         d1.decimate(dec_samp1, in);
         d2.decimate(out, dec_samp1);
       }
 
     private:
       Decimator<T> &d1, &d2;
+      vector<T>    dec_samp1;
   };
 
   template <class T>
@@ -266,7 +228,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(out, dec_samp2);
@@ -274,6 +235,7 @@ namespace {
 
     private:
       Decimator<T> &d1, &d2, &d3;
+      vector<T>    dec_samp1, dec_samp2;
   };
 
   template <class T>
@@ -290,7 +252,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2, dec_samp3;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(dec_samp3, dec_samp2);
@@ -299,6 +260,7 @@ namespace {
 
     private:
       Decimator<T> &d1, &d2, &d3, &d4;
+      vector<T>    dec_samp1, dec_samp2, dec_samp3;
   };
 
   template <class T>
@@ -316,7 +278,6 @@ namespace {
       }
       virtual void decimate(vector<T> &out, const vector<T> &in)
       {
-        vector<T> dec_samp1, dec_samp2, dec_samp3, dec_samp4;
         d1.decimate(dec_samp1, in);
         d2.decimate(dec_samp2, dec_samp1);
         d3.decimate(dec_samp3, dec_samp2);
@@ -326,6 +287,7 @@ namespace {
 
     private:
       Decimator<T> &d1, &d2, &d3, &d4, &d5;
+      vector<T>    dec_samp1, dec_samp2, dec_samp3, dec_samp4;
   };
 
 
@@ -356,27 +318,28 @@ namespace {
         }
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> &out,
-                       const vector<WbRxRtlSdr::Sample> &in)
+        /*
+         * Translate the samples in "in". If there is no offset to translate,
+         * "in" is returned as is. Otherwise the result is written to "out",
+         * which is then returned.
+         */
+      const vector<WbRxRtlSdr::Sample>& iq_received(
+          vector<WbRxRtlSdr::Sample> &out, const vector<WbRxRtlSdr::Sample> &in)
       {
-        if (exp_lut.size() > 0)
+        if (exp_lut.empty())
         {
-          out.clear();
-          out.reserve(in.size());
-          vector<WbRxRtlSdr::Sample>::const_iterator it;
-          for (it = in.begin(); it != in.end(); ++it)
-          {
-            out.push_back(*it * exp_lut[n]);
-            if (++n == exp_lut.size())
-            {
-              n = 0;
-            }
-          }
+          return in;
         }
-        else
+        out.resize(in.size());
+        for (size_t idx=0; idx<in.size(); ++idx)
         {
-          out = in;
+          out[idx] = in[idx] * exp_lut[n];
+          if (++n == exp_lut.size())
+          {
+            n = 0;
+          }
         }
+        return out;
       }
 
     private:
@@ -423,17 +386,13 @@ namespace {
       void iq_received(vector<WbRxRtlSdr::Sample> &out,
                        const vector<WbRxRtlSdr::Sample> &in)
       {
-        out.clear();
-        out.reserve(in.size());
+        out.resize(in.size());
         float P = 0.0f;
-        for (vector<WbRxRtlSdr::Sample>::const_iterator it = in.begin();
-             it != in.end();
-             ++it)
+        for (size_t idx=0; idx<in.size(); ++idx)
         {
-          const WbRxRtlSdr::Sample &samp = *it;
-          WbRxRtlSdr::Sample osamp = m_gain * samp;
+          WbRxRtlSdr::Sample osamp = m_gain * in[idx];
           P = osamp.real() * osamp.real() + osamp.imag() * osamp.imag();
-          out.push_back(osamp);
+          out[idx] = osamp;
 
           float err = m_reference - P;
           float rate;
@@ -473,7 +432,7 @@ namespace {
     public:
       virtual ~Demodulator(void) {}
 
-      virtual void iq_received(vector<WbRxRtlSdr::Sample> samples) = 0;
+      virtual void iq_received(const vector<WbRxRtlSdr::Sample> &samples) = 0;
 
       /**
        * @brief Resume audio output to the sink
@@ -553,7 +512,7 @@ namespace {
         dec->setGain(adj_db);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
           // From article-sdr-is-qs.pdf: Watch your Is and Qs:
           //   FM = (Qn.In-1 - In.Qn-1)/(In.In-1 + Qn.Qn-1)
@@ -561,7 +520,7 @@ namespace {
           // A more indepth report:
           //   Implementation of FM demodulator algorithms on a
           //   high performance digital signal processor
-        vector<float> audio;
+        audio.resize(samples.size());
         for (size_t idx=0; idx<samples.size(); ++idx)
         {
           complex<float> samp = samples[idx];
@@ -576,9 +535,8 @@ namespace {
           iold = i;
           qold = q;
 
-          audio.push_back(demod);
+          audio[idx] = demod;
         }
-        vector<float> dec_audio;
         dec->decimate(dec_audio, audio);
         sinkWriteSamples(&dec_audio[0], dec_audio.size());
       }
@@ -589,6 +547,8 @@ namespace {
       Decimator<float> audio_dec_wb;
       Decimator<float> audio_dec;
       DecimatorMS<float> *dec;
+      vector<float> audio;
+      vector<float> dec_audio;
   };
 
 
@@ -602,23 +562,24 @@ namespace {
         agc.setReference(1);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
 
-        vector<float> audio;
+        audio.resize(gain_adjusted.size());
         for (size_t idx=0; idx<gain_adjusted.size(); ++idx)
         {
           complex<float> samp = gain_adjusted[idx];
           float demod = abs(samp);
-          audio.push_back(demod);
+          audio[idx] = demod;
         }
         sinkWriteSamples(&audio[0], audio.size());
       }
 
     private:
-      AGC              agc;
+      AGC                         agc;
+      vector<WbRxRtlSdr::Sample>  gain_adjusted;
+      vector<float>               audio;
   };
 
 
@@ -639,7 +600,7 @@ namespace {
         use_lsb = use;
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
         vector<float> Q, Qh, audio;
         Q.reserve(samples.size());
@@ -690,29 +651,28 @@ namespace {
         trans.setOffset(lsb ? 2000 : -2000);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
 
-        vector<WbRxRtlSdr::Sample> translated;
-        trans.iq_received(translated, gain_adjusted);
+        const vector<WbRxRtlSdr::Sample> &translated =
+          trans.iq_received(translated_buf, gain_adjusted);
 
-        vector<float> audio;
-        audio.reserve(gain_adjusted.size());
-        for (vector<WbRxRtlSdr::Sample>::const_iterator it = translated.begin();
-             it != translated.end();
-             ++it)
+        audio.resize(translated.size());
+        for (size_t idx=0; idx<translated.size(); ++idx)
         {
-          float demod = it->real();
-          audio.push_back(demod);
+          float demod = translated[idx].real();
+          audio[idx] = demod;
         }
         sinkWriteSamples(&audio[0], audio.size());
       }
 
     private:
-      Translate         trans;
-      AGC               agc;
+      Translate                   trans;
+      AGC                         agc;
+      vector<WbRxRtlSdr::Sample>  gain_adjusted;
+      vector<WbRxRtlSdr::Sample>  translated_buf;
+      vector<float>               audio;
   };
 #endif
 
@@ -728,28 +688,28 @@ namespace {
         agc.setReference(0.05);
       }
 
-      void iq_received(vector<WbRxRtlSdr::Sample> samples)
+      void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
       {
-        vector<WbRxRtlSdr::Sample> gain_adjusted;
         agc.iq_received(gain_adjusted, samples);
 
-        vector<WbRxRtlSdr::Sample> translated;
-        trans.iq_received(translated, gain_adjusted);
-        vector<float> audio;
-        audio.reserve(translated.size());
-        for (vector<WbRxRtlSdr::Sample>::const_iterator it = translated.begin();
-             it != translated.end();
-             ++it)
+        const vector<WbRxRtlSdr::Sample> &translated =
+          trans.iq_received(translated_buf, gain_adjusted);
+
+        audio.resize(translated.size());
+        for (size_t idx=0; idx<translated.size(); ++idx)
         {
-          float demod = it->real();
-          audio.push_back(demod);
+          float demod = translated[idx].real();
+          audio[idx] = demod;
         }
         sinkWriteSamples(&audio[0], audio.size());
       }
 
     private:
-      Translate         trans;
-      AGC               agc;
+      Translate                   trans;
+      AGC                         agc;
+      vector<WbRxRtlSdr::Sample>  gain_adjusted;
+      vector<WbRxRtlSdr::Sample>  translated_buf;
+      vector<float>               audio;
   };
 
 
@@ -960,34 +920,122 @@ namespace {
       DecimatorMS<complex<float> >  *dec;
   };
 
+  /*
+   * Channelizer for the narrowband part of the signal chain when the first
+   * decimation stages are done by the PolyphaseChannelizer shared by all
+   * DDRs on a tuner. The input is a bin from the filter bank, already mixed
+   * so that the channel is centered at DC.
+   */
+  class Channelizer160 : public Channelizer
+  {
+    public:
+      Channelizer160(void)
+        : dec_160k_32k  (5, coeff_dec_160k_32k,   coeff_dec_160k_32k_cnt  ),
+          dec_32k_16k   (2, coeff_dec_32k_16k,    coeff_dec_32k_16k_cnt   ),
+          ch_filt       (1, coeff_25k_channel,    coeff_25k_channel_cnt   ),
+          ch_filt_narr  (1, coeff_12k5_channel,   coeff_12k5_channel_cnt  ),
+          ch_filt_6k    (1, coeff_nbam_channel,   coeff_nbam_channel_cnt  ),
+          ch_filt_3k    (1, coeff_ssb_channel,    coeff_ssb_channel_cnt   ),
+          ch_filt_500   (1, coeff_cw_channel,     coeff_cw_channel_cnt    ),
+          dec(0)
+      {
+        setBw(BW_20K);
+      }
+      virtual ~Channelizer160(void)
+      {
+        delete dec;
+        dec = 0;
+      }
+
+      virtual void setBw(Bandwidth bw)
+      {
+        delete dec;
+        dec = 0;
+
+        switch (bw)
+        {
+          case BW_WIDE:
+            break;
+          case BW_20K:
+            dec = new DecimatorMS2<complex<float> >(dec_160k_32k, ch_filt);
+            return;
+          case BW_10K:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_narr);
+            return;
+          case BW_6K:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_6k);
+            return;
+          case BW_3K:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_3k);
+            return;
+          case BW_500:
+            dec = new DecimatorMS3<complex<float> >(dec_160k_32k,
+                                                    dec_32k_16k,
+                                                    ch_filt_500);
+            return;
+        }
+        assert(!"Channelizer160::setBw: Unsupported bandwidth");
+      }
+
+      virtual unsigned chSampRate(void) const
+      {
+        return 160000 / dec->decFact();
+      }
+
+      virtual void iq_received(vector<WbRxRtlSdr::Sample> &out,
+                               const vector<WbRxRtlSdr::Sample> &in)
+      {
+        dec->decimate(out, in);
+        preDemod(out);
+      }
+
+    private:
+      Decimator<complex<float> >    dec_160k_32k;
+      Decimator<complex<float> >    dec_32k_16k;
+      Decimator<complex<float> >    ch_filt;
+      Decimator<complex<float> >    ch_filt_narr;
+      Decimator<complex<float> >    ch_filt_6k;
+      Decimator<complex<float> >    ch_filt_3k;
+      Decimator<complex<float> >    ch_filt_500;
+      DecimatorMS<complex<float> >  *dec;
+  };
+
 }; /* anonymous namespace */
 
 
 class Ddr::Channel : public sigc::trackable, public Async::AudioSource
 {
   public:
-    Channel(int fq_offset, unsigned sample_rate)
-      : sample_rate(sample_rate), channelizer(0),
-        fm_demod(32000, 5000.0), ssb_demod(16000), cw_demod(16000), demod(0),
-        trans(sample_rate, fq_offset), enabled(true), ch_offset(0),
-        fq_offset(fq_offset)
+    Channel(WbRxRtlSdr *rtl, int fq_offset)
+      : rtl(rtl), sample_rate(rtl->sampleRate()), wb_channelizer(0),
+        channelizer(0), pfb(0), fm_demod(32000, 5000.0), ssb_demod(16000),
+        cw_demod(16000), demod(0), trans(sample_rate, fq_offset),
+        bin_trans(2 * PolyphaseChannelizer::CH_SPACING, 0), bin(0),
+        use_pfb(false), enabled(true), ch_offset(0), fq_offset(fq_offset)
     {
     }
 
     ~Channel(void)
     {
-      delete channelizer;
+      iq_con.disconnect();
+      delete wb_channelizer;
     }
 
     bool initialize(void)
     {
       if (sample_rate == 2400000)
       {
-        channelizer = new Channelizer2400;
+        wb_channelizer = new Channelizer2400;
       }
       else if (sample_rate == 960000)
       {
-        channelizer = new Channelizer960;
+        wb_channelizer = new Channelizer960;
       }
       else
       {
@@ -995,51 +1043,65 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
              << ". Legal values are: 960000 and 2400000\n";
         return false;
       }
+      channelizer = wb_channelizer;
+      pfb = rtl->channelizer();
       setModulation(Modulation::MOD_FM);
-      channelizer->preDemod.connect(preDemod.make_slot());
+      wb_channelizer->preDemod.connect(preDemod.make_slot());
+      bin_channelizer.preDemod.connect(preDemod.make_slot());
       return true;
     }
 
     void setFqOffset(int fq_offset)
     {
       this->fq_offset = fq_offset;
-      trans.setOffset(fq_offset - ch_offset);
+      int offset = fq_offset - ch_offset;
+      if (use_pfb)
+      {
+          // The filter bank take care of the mixing to the bin center
+          // frequency. The rest of the offset is handled at the lower
+          // sampling rate of the bin.
+        bin = pfb->binForOffset(offset);
+        bin_trans.setOffset(offset - pfb->binOffset(bin));
+      }
+      else
+      {
+        trans.setOffset(offset);
+      }
+      connectInput();
     }
 
     void setModulation(Modulation::Type mod)
     {
       demod = 0;
       ch_offset = 0;
+      Channelizer::Bandwidth bw = Channelizer::BW_20K;
       switch (mod)
       {
         case Modulation::MOD_FM:
-          channelizer->setBw(Channelizer::BW_20K);
-          fm_demod.setDemodParams(channelizer->chSampRate(), 5000);
+          bw = Channelizer::BW_20K;
           demod = &fm_demod;
           break;
         case Modulation::MOD_NBFM:
-          channelizer->setBw(Channelizer::BW_10K);
-          fm_demod.setDemodParams(channelizer->chSampRate(), 2500);
+          bw = Channelizer::BW_10K;
           demod = &fm_demod;
           break;
         case Modulation::MOD_WBFM:
-          channelizer->setBw(Channelizer::BW_WIDE);
-          fm_demod.setDemodParams(channelizer->chSampRate(), 75000);
+          bw = Channelizer::BW_WIDE;
           demod = &fm_demod;
           break;
         case Modulation::MOD_AM:
-          channelizer->setBw(Channelizer::BW_10K);
+          bw = Channelizer::BW_10K;
           demod = &am_demod;
           break;
         case Modulation::MOD_NBAM:
-          channelizer->setBw(Channelizer::BW_6K);
+          bw = Channelizer::BW_6K;
           demod = &am_demod;
           break;
         case Modulation::MOD_USB:
 #ifdef USE_SSB_PHASE_DEMOD
-          channelizer->setBw(Channelizer::BW_6K);
+          bw = Channelizer::BW_6K;
 #else
-          channelizer->setBw(Channelizer::BW_3K);
+          bw = Channelizer::BW_3K;
           ch_offset = -2000;
 #endif
           ssb_demod.useLsb(false);
@@ -1047,27 +1109,46 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
           break;
         case Modulation::MOD_LSB:
 #ifdef USE_SSB_PHASE_DEMOD
-          channelizer->setBw(Channelizer::BW_6K);
+          bw = Channelizer::BW_6K;
 #else
-          channelizer->setBw(Channelizer::BW_3K);
+          bw = Channelizer::BW_3K;
           ch_offset = 2000;
 #endif
           ssb_demod.useLsb(true);
           demod = &ssb_demod;
           break;
         case Modulation::MOD_CW:
-          channelizer->setBw(Channelizer::BW_500);
+          bw = Channelizer::BW_500;
           demod = &cw_demod;
           break;
         case Modulation::MOD_WBCW:
-          channelizer->setBw(Channelizer::BW_3K);
+          bw = Channelizer::BW_3K;
           demod = &cw_demod;
           break;
         case Modulation::MOD_UNKNOWN:
           break;
       }
-      setFqOffset(fq_offset);
       assert((demod != 0) && "Channel::setModulation: Unknown modulation");
+
+        // The wideband modes do not fit in a filter bank bin so they have to
+        // use a dedicated channelizer working on the full tuner bandwidth
+      use_pfb = (pfb != 0) && (bw != Channelizer::BW_WIDE);
+      channelizer = use_pfb ? &bin_channelizer : wb_channelizer;
+      channelizer->setBw(bw);
+      if (demod == &fm_demod)
+      {
+        double max_dev = 5000.0;
+        if (mod == Modulation::MOD_NBFM)
+        {
+          max_dev = 2500.0;
+        }
+        else if (mod == Modulation::MOD_WBFM)
+        {
+          max_dev = 75000.0;
+        }
+        fm_demod.setDemodParams(channelizer->chSampRate(), max_dev);
+      }
+      setFqOffset(fq_offset);
       setHandler(demod);
     }
 
@@ -1076,25 +1157,30 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
       return channelizer->chSampRate();
     }
 
-    void iq_received(vector<WbRxRtlSdr::Sample> samples)
+    void iq_received(const vector<WbRxRtlSdr::Sample> &samples)
     {
-      if (enabled)
-      {
-        vector<WbRxRtlSdr::Sample> translated, channelized;
-        trans.iq_received(translated, samples);
-        channelizer->iq_received(channelized, translated);
-        demod->iq_received(channelized);
-      }
+      channelizer->iq_received(channelized,
+                               trans.iq_received(translated, samples));
+      demod->iq_received(channelized);
     };
 
+    void binReceived(const vector<WbRxRtlSdr::Sample> &samples)
+    {
+      channelizer->iq_received(channelized,
+                               bin_trans.iq_received(translated, samples));
+      demod->iq_received(channelized);
+    }
+
     void enable(void)
     {
       enabled = true;
+      connectInput();
     }
 
     void disable(void)
     {
       enabled = false;
+      connectInput();
     }
 
     bool isEnabled(void) const { return enabled; }
@@ -1102,17 +1188,49 @@ class Ddr::Channel : public sigc::trackable, public Async::AudioSource
     sigc::signal<void, const std::vector<RtlTcp::Sample>&> preDemod;
 
   private:
+    WbRxRtlSdr *rtl;
     unsigned sample_rate;
+    Channelizer *wb_channelizer;
+    Channelizer160 bin_channelizer;
     Channelizer *channelizer;
+    PolyphaseChannelizer *pfb;
     DemodulatorFm fm_demod;
     DemodulatorAm am_demod;
     DemodulatorSsb ssb_demod;
     DemodulatorCw cw_demod;
     Demodulator *demod;
     Translate trans;
+    Translate bin_trans;
+    unsigned bin;
+    bool use_pfb;
     bool enabled;
     int ch_offset;
     int fq_offset;
+    sigc::connection iq_con;
+    vector<WbRxRtlSdr::Sample> translated;
+    vector<WbRxRtlSdr::Sample> channelized;
+
+      // Connect to the wideband samples or to the filter bank bin, depending
+      // on the modulation. A disabled channel is not connected at all so
+      // that the filter bank do not have to calculate its bin.
+    void connectInput(void)
+    {
+      iq_con.disconnect();
+      if (!enabled)
+      {
+        return;
+      }
+      if (use_pfb)
+      {
+        iq_con = pfb->binSignal(bin).connect(
+            mem_fun(*this, &Channel::binReceived));
+      }
+      else
+      {
+        iq_con = rtl->iqReceived.connect(
+            mem_fun(*this, &Channel::iq_received));
+      }
+    }
 }; /* Channel */
 
 
@@ -1167,6 +1285,9 @@ Ddr::Ddr(Config &cfg, const std::string& name)
 
 Ddr::~Ddr(void)
 {
+  delete channel;
+  channel = 0;
+
   if (rtl != 0)
   {
     rtl->unregisterDdr(this);
@@ -1178,8 +1299,6 @@ Ddr::~Ddr(void)
   {
     ddr_map.erase(it);
   }
-
-  delete channel;
 } /* Ddr::~Ddr */
 
 
@@ -1218,7 +1337,7 @@ bool Ddr::initialize(void)
   }
   rtl->registerDdr(this);
 
-  channel = new Channel(fq-rtl->centerFq(), rtl->sampleRate());
+  channel = new Channel(rtl, fq-rtl->centerFq());
   if (!channel->initialize())
   {
     cout << "*** ERROR: Could not initialize channel object for receiver "
@@ -1228,7 +1347,6 @@ bool Ddr::initialize(void)
     return false;
   }
   channel->preDemod.connect(preDemod.make_slot());
-  rtl->iqReceived.connect(mem_fun(*channel, &Channel::iq_received));
   rtl->readyStateChanged.connect(readyStateChanged.make_slot());
 
   string modstr("FM");
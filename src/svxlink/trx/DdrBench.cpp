@@ -0,0 +1,295 @@
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <AsyncCppApplication.h>
+#include <AsyncConfig.h>
+#include <AsyncAudioSink.h>
+
+#include "Ddr.h"
+#include "WbRxRtlSdr.h"
+#include "PolyphaseChannelizer.h"
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the DDR signal processing for each modulation using I/Q
+  // samples replayed from a file, recorded with rtl_sdr, as fast as possible.
+  // A real WbRxRtlSdr of type RtlFile and a real Ddr object are set up so the
+  // whole receiver chain is measured, from the I/Q samples to the audio out
+  // of the receiver.
+  //
+  // Each block of I/Q samples is timestamped at the points where the signal
+  // chain is visible from the outside: when the filter bank bin is ready
+  // (only for modulations using the filter bank), when the channel samples
+  // are emitted on the preDemod signal, after the DDR signal level detector
+  // and when all processing is done. The time between the marks is reported
+  // per stage as microseconds per 10ms block. The number of heap allocations
+  // done per block is also reported. It should be zero for the DSP stages.
+  //
+  // Each modulation is run in its own process so that the tuner and receiver
+  // singletons do not interfere with each other.
+  //
+  // Usage: DdrBench <IQ file> <960000|2400000> [seconds] [modulation...]
+
+namespace {
+  size_t alloc_cnt = 0;
+};
+
+void *operator new(size_t size)
+{
+  ++alloc_cnt;
+  void *ptr = malloc((size > 0) ? size : 1);
+  if (ptr == 0)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+  free(ptr);
+}
+
+namespace {
+  const unsigned WARMUP_BLOCKS = 100;
+  const int DDR_OFFSET = 2 * PolyphaseChannelizer::CH_SPACING;
+  const uint32_t CENTER_FQ = 100000000;
+
+  class NullSink : public AudioSink
+  {
+    public:
+      virtual int writeSamples(const float *samples, int count)
+      {
+        return count;
+      }
+
+      virtual void flushSamples(void)
+      {
+        sourceAllSamplesFlushed();
+      }
+  };
+
+  class DdrRun : public sigc::trackable
+  {
+    public:
+      typedef enum
+      {
+        STAGE_PFB, STAGE_CHANNELIZER, STAGE_SIGLEV, STAGE_DEMOD, STAGE_CNT
+      } Stage;
+
+      DdrRun(unsigned blocks)
+        : blocks(blocks), block_idx(0), measuring(false), allocs(0),
+          alloc_start(0)
+      {
+        memset(stage_ns, 0, sizeof(stage_ns));
+      }
+
+      bool run(Config &cfg, const string &mod, unsigned samp_rate)
+      {
+        WbRxRtlSdr *wbrx = WbRxRtlSdr::instance(cfg, "WbRx");
+        wbrx->iqReceived.connect(
+            sigc::hide(mem_fun(*this, &DdrRun::blockStart)));
+        bool use_pfb = (mod != "WBFM") && (wbrx->channelizer() != 0);
+        if (use_pfb)
+        {
+          PolyphaseChannelizer *pfb = wbrx->channelizer();
+          pfb->binSignal(pfb->binForOffset(DDR_OFFSET)).connect(
+              sigc::hide(sigc::bind(mem_fun(*this, &DdrRun::mark),
+                                    STAGE_PFB)));
+        }
+
+        Ddr ddr(cfg, "Rx");
+        ddr.preDemod.connect(
+            sigc::hide(sigc::bind(mem_fun(*this, &DdrRun::mark),
+                                  STAGE_CHANNELIZER)));
+        if (!ddr.initialize())
+        {
+          cerr << "*** ERROR: Could not initialize the DDR\n";
+          return false;
+        }
+        ddr.preDemod.connect(
+            sigc::hide(sigc::bind(mem_fun(*this, &DdrRun::mark),
+                                  STAGE_SIGLEV)));
+        wbrx->iqReceived.connect(
+            sigc::hide(mem_fun(*this, &DdrRun::blockEnd)));
+        NullSink sink;
+        ddr.registerSink(&sink);
+        ddr.setMuteState(Rx::MUTE_NONE);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        Application::app().exec();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double wall = (end.tv_sec - start.tv_sec) +
+                      (end.tv_nsec - start.tv_nsec) / 1.0e9;
+
+        double total_ns = 0.0;
+        for (int stage=0; stage<STAGE_CNT; ++stage)
+        {
+          total_ns += stage_ns[stage];
+        }
+        double samples = 10.0e-3 * samp_rate * blocks;
+        printf("%-5s %-3s %6u %8.2f %7.1f %8.1f %8.1f %8.1f %8.1f %8.1f "
+               "%7.1f\n",
+               mod.c_str(), use_pfb ? "PFB" : "WB", ddr.preDemodSampleRate(),
+               samples / total_ns * 1.0e3, samples / samp_rate / wall,
+               perBlock(STAGE_PFB), perBlock(STAGE_CHANNELIZER),
+               perBlock(STAGE_SIGLEV), perBlock(STAGE_DEMOD),
+               total_ns / blocks / 1.0e3,
+               static_cast<double>(allocs) / blocks);
+        return true;
+      }
+
+    private:
+      unsigned          blocks;
+      unsigned          block_idx;
+      bool              measuring;
+      size_t            allocs;
+      size_t            alloc_start;
+      double            stage_ns[STAGE_CNT];
+      struct timespec   last;
+
+      double perBlock(Stage stage) const
+      {
+        return stage_ns[stage] / blocks / 1.0e3;
+      }
+
+      void blockStart(void)
+      {
+        measuring = (block_idx >= WARMUP_BLOCKS);
+        clock_gettime(CLOCK_MONOTONIC, &last);
+        alloc_start = alloc_cnt;
+      }
+
+      void mark(Stage stage)
+      {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (measuring)
+        {
+          stage_ns[stage] += (now.tv_sec - last.tv_sec) * 1.0e9 +
+                             (now.tv_nsec - last.tv_nsec);
+        }
+        last = now;
+      }
+
+      void blockEnd(void)
+      {
+        mark(STAGE_DEMOD);
+        if (measuring)
+        {
+          allocs += alloc_cnt - alloc_start;
+        }
+        if (++block_idx == WARMUP_BLOCKS + blocks)
+        {
+          Application::app().quit();
+        }
+      }
+  };
+
+  template <typename T>
+  string toString(const T& val)
+  {
+    ostringstream ss;
+    ss << val;
+    return ss.str();
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    cerr << "Usage: " << argv[0]
+         << " <IQ file> <960000|2400000> [seconds] [modulation...]\n";
+    exit(1);
+  }
+  const string filename(argv[1]);
+  unsigned samp_rate = atoi(argv[2]);
+  if ((samp_rate != 960000) && (samp_rate != 2400000))
+  {
+    cerr << "*** ERROR: The sample rate must be 960000 or 2400000\n";
+    exit(1);
+  }
+  double seconds = (argc > 3) ? atof(argv[3]) : 10.0;
+  if (seconds <= 0.0)
+  {
+    cerr << "*** ERROR: Bad number of seconds\n";
+    exit(1);
+  }
+  unsigned blocks = static_cast<unsigned>(seconds * 100.0);
+
+  vector<string> mods;
+  for (int i=4; i<argc; ++i)
+  {
+    mods.push_back(argv[i]);
+  }
+  if (mods.empty())
+  {
+    const char *all_mods[] = {
+      "FM", "NBFM", "WBFM", "AM", "NBAM", "USB", "LSB", "CW", "WBCW"
+    };
+    mods.assign(all_mods, all_mods + sizeof(all_mods) / sizeof(*all_mods));
+  }
+
+  printf("%-5s %-3s %6s %8s %7s %8s %8s %8s %8s %8s %7s\n", "Mod", "Chn",
+         "ChRate", "Msamp/s", "xRT", "PFB", "Chan", "Siglev", "Demod+Rx",
+         "Total", "Allocs");
+  printf("%-5s %-3s %6s %8s %7s %8s %8s %8s %8s %8s %7s\n", "", "", "Hz", "",
+         "", "us/blk", "us/blk", "us/blk", "us/blk", "us/blk", "/blk");
+  fflush(stdout);
+
+  int ret = 0;
+  for (vector<string>::const_iterator it=mods.begin(); it!=mods.end(); ++it)
+  {
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+      perror("fork");
+      exit(1);
+    }
+    if (pid == 0)
+    {
+      CppApplication app;
+      Config cfg;
+      cfg.setValue("WbRx", "TYPE", "RtlFile");
+      cfg.setValue("WbRx", "FILENAME", filename);
+      cfg.setValue("WbRx", "SAMPLE_RATE", toString(samp_rate));
+      cfg.setValue("WbRx", "CENTER_FQ", toString(CENTER_FQ));
+      cfg.setValue("WbRx", "SPEED", "0");
+      cfg.setValue("WbRx", "LOOP", "1");
+      cfg.setValue("Rx", "FQ", toString(CENTER_FQ + DDR_OFFSET));
+      cfg.setValue("Rx", "WBRX", "WbRx");
+      cfg.setValue("Rx", "MODULATION", *it);
+      cfg.setValue("Rx", "SQL_DET", "OPEN");
+      cfg.setValue("Rx", "SIGLEV_DET", "DDR");
+      DdrRun run(blocks);
+      bool ok = run.run(cfg, *it, samp_rate);
+      fflush(stdout);
+      _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    if ((waitpid(pid, &status, 0) == -1) || !WIFEXITED(status) ||
+        (WEXITSTATUS(status) != 0))
+    {
+      cerr << "*** ERROR: The benchmark failed for modulation " << *it
+           << endl;
+      ret = 1;
+    }
+  }
+
+  return ret;
+}
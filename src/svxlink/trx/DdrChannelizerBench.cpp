@@ -0,0 +1,314 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <AsyncPolyphaseFir.h>
+
+#include "PolyphaseChannelizer.h"
+#include "DdrFilterCoeffs.h"
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the CPU usage for a growing number of FM DDR channels on one
+  // tuner. The old signal chain, where each channel mix and decimate the
+  // whole wideband signal, is compared with the PolyphaseChannelizer where
+  // the first decimation stages are shared by all channels. Only the
+  // channelization is measured, not the demodulation.
+  //
+  // The I/Q samples are read from a file recorded with rtl_sdr, which write
+  // interleaved unsigned 8 bit I and Q values. If no file is given, a noise
+  // signal is used.
+  //
+  // Usage: DdrChannelizerBench <2400000|960000> [max channels] [IQ file]
+
+namespace {
+  typedef complex<float> Sample;
+
+  class Mixer
+  {
+    public:
+      Mixer(unsigned samp_rate, int offset) : n(0)
+      {
+        if (offset == 0)
+        {
+          lut.push_back(Sample(1.0f, 0.0f));
+          return;
+        }
+        unsigned a = samp_rate;
+        unsigned b = abs(offset);
+        while (b != 0)
+        {
+          unsigned r = a % b;
+          a = b;
+          b = r;
+        }
+        lut.resize(samp_rate / a);
+        for (size_t i=0; i<lut.size(); ++i)
+        {
+          lut[i] = polar(1.0f,
+              static_cast<float>(-2.0 * M_PI * offset * i / samp_rate));
+        }
+      }
+
+      void mix(vector<Sample> &out, const vector<Sample> &in)
+      {
+        out.resize(in.size());
+        for (size_t i=0; i<in.size(); ++i)
+        {
+          out[i] = in[i] * lut[n];
+          if (++n == lut.size())
+          {
+            n = 0;
+          }
+        }
+      }
+
+    private:
+      vector<Sample>  lut;
+      size_t          n;
+  };
+
+  class Stage
+  {
+    public:
+      Stage(int dec_fact, const float *coeff, int taps) : dec_fact(dec_fact)
+      {
+        fir.setDecimator(dec_fact, coeff, taps);
+      }
+
+      void decimate(vector<Sample> &out, const vector<Sample> &in)
+      {
+        out.resize(in.size() / dec_fact + 1);
+        if (!in.empty())
+        {
+          out.resize(fir.process(&out[0], &in[0], in.size()));
+        }
+      }
+
+    private:
+      int                     dec_fact;
+      PolyphaseFir<Sample>    fir;
+  };
+
+    // A channel using the wideband signal chain from the Ddr class
+  class WidebandChannel
+  {
+    public:
+      WidebandChannel(unsigned samp_rate, int offset)
+        : mixer(samp_rate, offset)
+      {
+        if (samp_rate == 2400000)
+        {
+          stages.push_back(new Stage(3, coeff_dec_2400k_800k,
+                                     coeff_dec_2400k_800k_cnt));
+          stages.push_back(new Stage(5, coeff_dec_800k_160k,
+                                     coeff_dec_800k_160k_cnt));
+          stages.push_back(new Stage(5, coeff_dec_160k_32k,
+                                     coeff_dec_160k_32k_cnt));
+        }
+        else
+        {
+          stages.push_back(new Stage(5, coeff_dec_960k_192k,
+                                     coeff_dec_960k_192k_cnt));
+          stages.push_back(new Stage(3, coeff_dec_192k_64k,
+                                     coeff_dec_192k_64k_cnt));
+          stages.push_back(new Stage(2, coeff_dec_64k_32k,
+                                     coeff_dec_64k_32k_cnt));
+        }
+        stages.push_back(new Stage(1, coeff_25k_channel,
+                                   coeff_25k_channel_cnt));
+      }
+
+      ~WidebandChannel(void)
+      {
+        for (size_t i=0; i<stages.size(); ++i)
+        {
+          delete stages[i];
+        }
+      }
+
+      size_t process(const vector<Sample> &in)
+      {
+        mixer.mix(buf[0], in);
+        for (size_t i=0; i<stages.size(); ++i)
+        {
+          stages[i]->decimate(buf[(i + 1) % 2], buf[i % 2]);
+        }
+        return buf[stages.size() % 2].size();
+      }
+
+    private:
+      Mixer           mixer;
+      vector<Stage*>  stages;
+      vector<Sample>  buf[2];
+  };
+
+    // A channel fed from a PolyphaseChannelizer bin
+  class BinChannel : public sigc::trackable
+  {
+    public:
+      BinChannel(PolyphaseChannelizer &pfb, int offset)
+        : mixer(pfb.chSampRate(),
+                offset - pfb.binOffset(pfb.binForOffset(offset))),
+          dec_160k_32k(5, coeff_dec_160k_32k, coeff_dec_160k_32k_cnt),
+          ch_filt(1, coeff_25k_channel, coeff_25k_channel_cnt), out_cnt(0)
+      {
+        pfb.binSignal(pfb.binForOffset(offset)).connect(
+            mem_fun(*this, &BinChannel::binReceived));
+      }
+
+      size_t outCnt(void) const { return out_cnt; }
+
+    private:
+      Mixer           mixer;
+      Stage           dec_160k_32k;
+      Stage           ch_filt;
+      vector<Sample>  buf[2];
+      size_t          out_cnt;
+
+      void binReceived(const vector<Sample> &in)
+      {
+        mixer.mix(buf[0], in);
+        dec_160k_32k.decimate(buf[1], buf[0]);
+        ch_filt.decimate(buf[0], buf[1]);
+        out_cnt += buf[0].size();
+      }
+  };
+
+  double cpuTime(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+
+    // Spread the channels over the tuner bandwidth on a 12.5kHz raster
+  int channelOffset(unsigned samp_rate, int ch, int num_ch)
+  {
+    int span = samp_rate * 8 / 10;
+    int offset = -span / 2 + (ch + 1) * span / (num_ch + 1);
+    return offset / 12500 * 12500;
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  unsigned samp_rate = (argc > 1) ? atoi(argv[1]) : 0;
+  int max_ch = (argc > 2) ? atoi(argv[2]) : 8;
+  if (((samp_rate != 2400000) && (samp_rate != 960000)) || (max_ch <= 0))
+  {
+    cerr << "Usage: " << argv[0]
+         << " <2400000|960000> [max channels] [IQ file]\n";
+    exit(1);
+  }
+
+    // Use the same 10ms block size as the RtlSdr class
+  const size_t blocksize = samp_rate / 100;
+  vector<Sample> iq;
+  if (argc > 3)
+  {
+    ifstream file(argv[3], ios::binary);
+    if (!file)
+    {
+      cerr << "*** ERROR: Could not open file " << argv[3] << endl;
+      exit(1);
+    }
+    vector<unsigned char> raw(2 * blocksize);
+    while (file.read(reinterpret_cast<char*>(&raw[0]), raw.size()))
+    {
+      for (size_t i=0; i<raw.size(); i+=2)
+      {
+        iq.push_back(Sample((raw[i] - 127.5f) / 127.5f,
+                            (raw[i+1] - 127.5f) / 127.5f));
+      }
+    }
+  }
+  else
+  {
+    iq.resize(10 * samp_rate / blocksize * blocksize);
+    for (size_t i=0; i<iq.size(); ++i)
+    {
+      iq[i] = Sample(2.0f * rand() / RAND_MAX - 1.0f,
+                     2.0f * rand() / RAND_MAX - 1.0f);
+    }
+  }
+  if (iq.empty())
+  {
+    cerr << "*** ERROR: No I/Q samples to process\n";
+    exit(1);
+  }
+  double seconds = static_cast<double>(iq.size()) / samp_rate;
+
+  printf("Processing %.1f seconds of I/Q samples at %u samples/s\n",
+         seconds, samp_rate);
+  printf("%8s %18s %18s %8s\n", "Channels", "Wideband CPU/DDR",
+         "Filter bank CPU/DDR", "Speedup");
+  for (int num_ch=1; num_ch<=max_ch; ++num_ch)
+  {
+    vector<Sample> block(blocksize);
+
+    vector<WidebandChannel*> wb_channels;
+    for (int ch=0; ch<num_ch; ++ch)
+    {
+      wb_channels.push_back(
+          new WidebandChannel(samp_rate, channelOffset(samp_rate, ch, num_ch)));
+    }
+    size_t wb_out = 0;
+    double start = cpuTime();
+    for (size_t pos=0; pos<iq.size(); pos+=blocksize)
+    {
+      block.assign(iq.begin() + pos, iq.begin() + pos + blocksize);
+      for (int ch=0; ch<num_ch; ++ch)
+      {
+        wb_out += wb_channels[ch]->process(block);
+      }
+    }
+    double wb_time = cpuTime() - start;
+    for (int ch=0; ch<num_ch; ++ch)
+    {
+      delete wb_channels[ch];
+    }
+
+    PolyphaseChannelizer pfb(samp_rate);
+    vector<BinChannel*> bin_channels;
+    for (int ch=0; ch<num_ch; ++ch)
+    {
+      bin_channels.push_back(
+          new BinChannel(pfb, channelOffset(samp_rate, ch, num_ch)));
+    }
+    start = cpuTime();
+    for (size_t pos=0; pos<iq.size(); pos+=blocksize)
+    {
+      block.assign(iq.begin() + pos, iq.begin() + pos + blocksize);
+      pfb.iqReceived(block);
+    }
+    double pfb_time = cpuTime() - start;
+    size_t pfb_out = 0;
+    for (int ch=0; ch<num_ch; ++ch)
+    {
+      pfb_out += bin_channels[ch]->outCnt();
+      delete bin_channels[ch];
+    }
+
+    if (pfb_out + 2 * num_ch < wb_out)
+    {
+      cerr << "*** ERROR: The filter bank produced too few samples\n";
+      exit(1);
+    }
+
+      // Report the CPU usage in percent of one core per DDR
+    printf("%8d %17.2f%% %18.2f%% %7.2fx\n", num_ch,
+           100.0 * wb_time / seconds / num_ch,
+           100.0 * pfb_time / seconds / num_ch, wb_time / pfb_time);
+  }
+
+  return 0;
+}
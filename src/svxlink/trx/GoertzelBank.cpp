@@ -0,0 +1,482 @@
+/**
+@file	 GoertzelBank.cpp
+@brief   A bank of Goertzel detectors evaluated in one pass over the samples
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-15
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "GoertzelBank.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+GoertzelBank::Subscriber::Subscriber(void)
+  : m_bank(0), m_bins_changed(false), m_first_bin(0), m_slice_cnt(0),
+    m_win(0), m_pos(0), m_energy(0.0), m_event_left(0)
+{
+} /* GoertzelBank::Subscriber::Subscriber */
+
+
+GoertzelBank::Subscriber::~Subscriber(void)
+{
+  if (m_bank != 0)
+  {
+    m_bank->detach(this);
+  }
+} /* GoertzelBank::Subscriber::~Subscriber */
+
+
+GoertzelBank::GoertzelBank(unsigned sample_rate)
+  : m_sample_rate(sample_rate), m_layout_dirty(false)
+{
+} /* GoertzelBank::GoertzelBank */
+
+
+GoertzelBank::~GoertzelBank(void)
+{
+  removeAllSubscribers();
+} /* GoertzelBank::~GoertzelBank */
+
+
+void GoertzelBank::addSubscriber(Subscriber *sub, bool managed)
+{
+  if (sub->m_bank == this)
+  {
+    return;
+  }
+  if (sub->m_bank != 0)
+  {
+    sub->m_bank->detach(sub);
+  }
+  Entry entry;
+  entry.sub = sub;
+  entry.managed = managed;
+  m_subs.push_back(entry);
+  sub->m_bank = this;
+  sub->m_slice_cnt = 0;
+  m_layout_dirty = true;
+} /* GoertzelBank::addSubscriber */
+
+
+void GoertzelBank::removeSubscriber(Subscriber *sub)
+{
+  for (vector<Entry>::iterator it=m_subs.begin(); it!=m_subs.end(); ++it)
+  {
+    if (it->sub == sub)
+    {
+      bool managed = it->managed;
+      detach(sub);
+      if (managed)
+      {
+        delete sub;
+      }
+      return;
+    }
+  }
+} /* GoertzelBank::removeSubscriber */
+
+
+void GoertzelBank::removeAllSubscribers(void)
+{
+  while (!m_subs.empty())
+  {
+    removeSubscriber(m_subs.back().sub);
+  }
+} /* GoertzelBank::removeAllSubscribers */
+
+
+unsigned GoertzelBank::binCount(void) const
+{
+  unsigned cnt = 0;
+  for (vector<Entry>::const_iterator it=m_subs.begin(); it!=m_subs.end(); ++it)
+  {
+    cnt += it->sub->m_fqs.size();
+  }
+  return cnt;
+} /* GoertzelBank::binCount */
+
+
+int GoertzelBank::writeSamples(const float *samples, int count)
+{
+  unsigned left = count;
+  while (left > 0)
+  {
+      // Subscribers may have changed their bins in the last event handler
+    if (m_layout_dirty)
+    {
+      updateLayout();
+    }
+
+      // Stop the chunk where the nearest subscriber event is
+    unsigned len = min(left, MAX_CHUNK);
+    for (vector<Entry>::const_iterator it=m_subs.begin(); it!=m_subs.end();
+         ++it)
+    {
+      unsigned event_left = it->sub->m_event_left;
+      if ((event_left > 0) && (event_left < len))
+      {
+        len = event_left;
+      }
+    }
+
+    processChunk(samples, len);
+    samples += len;
+    left -= len;
+  }
+
+  return count;
+
+} /* GoertzelBank::writeSamples */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void GoertzelBank::Subscriber::setBins(const float *fqs, unsigned cnt)
+{
+  if ((cnt == m_fqs.size()) && equal(fqs, fqs + cnt, m_fqs.begin()))
+  {
+    return;
+  }
+  m_fqs.assign(fqs, fqs + cnt);
+  m_bins_changed = true;
+  if (m_bank != 0)
+  {
+    m_bank->m_layout_dirty = true;
+  }
+} /* GoertzelBank::Subscriber::setBins */
+
+
+void GoertzelBank::Subscriber::resetBins(void)
+{
+  m_pos = 0;
+  m_energy = 0.0;
+  if (m_bank != 0)
+  {
+    fill_n(m_bank->m_q0.begin() + m_first_bin, m_slice_cnt, 0.0f);
+    fill_n(m_bank->m_q1.begin() + m_first_bin, m_slice_cnt, 0.0f);
+  }
+} /* GoertzelBank::Subscriber::resetBins */
+
+
+float GoertzelBank::Subscriber::magnitudeSquared(unsigned bin) const
+{
+  if ((m_bank == 0) || (bin >= m_slice_cnt))
+  {
+    return 0.0f;
+  }
+  unsigned idx = m_first_bin + bin;
+  float q0 = m_bank->m_q0[idx];
+  float q1 = m_bank->m_q1[idx];
+  return q0 * q0 + q1 * q1 - q0 * q1 * m_bank->m_coeff[idx];
+} /* GoertzelBank::Subscriber::magnitudeSquared */
+
+
+complex<float> GoertzelBank::Subscriber::result(unsigned bin) const
+{
+  if ((m_bank == 0) || (bin >= m_slice_cnt))
+  {
+    return complex<float>(0.0f, 0.0f);
+  }
+  unsigned idx = m_first_bin + bin;
+  float q0 = m_bank->m_q0[idx];
+  float q1 = m_bank->m_q1[idx];
+  float real = m_bank->m_cosw[idx] * q0 - q1;
+  float imag = m_bank->m_sinw[idx] * q0;
+  return complex<float>(real, imag);
+} /* GoertzelBank::Subscriber::result */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void GoertzelBank::detach(Subscriber *sub)
+{
+  for (vector<Entry>::iterator it=m_subs.begin(); it!=m_subs.end(); ++it)
+  {
+    if (it->sub == sub)
+    {
+      m_subs.erase(it);
+      break;
+    }
+  }
+  replace(m_due.begin(), m_due.end(), sub, static_cast<Subscriber*>(0));
+  sub->m_bank = 0;
+  sub->m_slice_cnt = 0;
+  m_layout_dirty = true;
+} /* GoertzelBank::detach */
+
+
+void GoertzelBank::updateLayout(void)
+{
+  unsigned bin_cnt = binCount();
+  unsigned padded_cnt = (bin_cnt + LANES - 1) / LANES * LANES;
+
+    // The padding bins have a zero coefficient and zero input so they stay
+    // at zero
+  vector<float> coeff(padded_cnt, 0.0f);
+  vector<float> cosw(padded_cnt, 0.0f);
+  vector<float> sinw(padded_cnt, 0.0f);
+  vector<float> q0(padded_cnt, 0.0f);
+  vector<float> q1(padded_cnt, 0.0f);
+
+  unsigned pos = 0;
+  for (vector<Entry>::iterator it=m_subs.begin(); it!=m_subs.end(); ++it)
+  {
+    Subscriber *sub = it->sub;
+    unsigned cnt = sub->m_fqs.size();
+    bool keep_state = !sub->m_bins_changed && (sub->m_slice_cnt == cnt);
+    for (unsigned i=0; i<cnt; ++i)
+    {
+        // Same calculation as in Goertzel::initialize
+      float w = 2.0f * M_PI * (sub->m_fqs[i] / (float)m_sample_rate);
+      cosw[pos + i] = cosf(w);
+      sinw[pos + i] = sinf(w);
+      coeff[pos + i] = 2.0f * cosw[pos + i];
+      if (keep_state)
+      {
+        q0[pos + i] = m_q0[sub->m_first_bin + i];
+        q1[pos + i] = m_q1[sub->m_first_bin + i];
+      }
+    }
+    sub->m_first_bin = pos;
+    sub->m_slice_cnt = cnt;
+    sub->m_bins_changed = false;
+    pos += cnt;
+  }
+
+  m_coeff.swap(coeff);
+  m_cosw.swap(cosw);
+  m_sinw.swap(sinw);
+  m_q0.swap(q0);
+  m_q1.swap(q1);
+  m_in.assign(MAX_CHUNK * padded_cnt, 0.0f);
+  m_layout_dirty = false;
+} /* GoertzelBank::updateLayout */
+
+
+void GoertzelBank::processChunk(const float *samples, unsigned count)
+{
+  const unsigned stride = m_coeff.size();
+
+    // Apply the window and calculate the passband energy once for each
+    // subscriber. Then copy the windowed samples to the input of each bin.
+  for (vector<Entry>::iterator it=m_subs.begin(); it!=m_subs.end(); ++it)
+  {
+    Subscriber *sub = it->sub;
+    const float *x = samples;
+    if (sub->m_win != 0)
+    {
+      const float *win = sub->m_win + sub->m_pos;
+      for (unsigned i=0; i<count; ++i)
+      {
+        m_windowed[i] = samples[i] * win[i];
+      }
+      x = m_windowed;
+    }
+    double energy = sub->m_energy;
+    for (unsigned i=0; i<count; ++i)
+    {
+      energy += x[i] * x[i];
+    }
+    sub->m_energy = energy;
+    sub->m_pos += count;
+
+    if (sub->m_slice_cnt > 0)
+    {
+      float *in = &m_in[sub->m_first_bin];
+      for (unsigned i=0; i<count; ++i)
+      {
+        for (unsigned b=0; b<sub->m_slice_cnt; ++b)
+        {
+          in[b] = x[i];
+        }
+        in += stride;
+      }
+    }
+  }
+
+    // Run the recursive stage. Four vectors at a time are processed to hide
+    // the latency of the recursion.
+  const unsigned vec_cnt = stride / LANES;
+  unsigned vec = 0;
+  for (; vec + 4 <= vec_cnt; vec += 4)
+  {
+    runVectors<4>(vec, count);
+  }
+  for (; vec < vec_cnt; ++vec)
+  {
+    runVectors<1>(vec, count);
+  }
+
+    // Find out which subscribers that have an event. The event handlers are
+    // called after all event delays have been updated since the handlers may
+    // add, remove or change subscribers.
+  m_due.clear();
+  for (vector<Entry>::iterator it=m_subs.begin(); it!=m_subs.end(); ++it)
+  {
+    Subscriber *sub = it->sub;
+    if (sub->m_event_left > 0)
+    {
+      sub->m_event_left -= count;
+      if (sub->m_event_left == 0)
+      {
+        m_due.push_back(sub);
+      }
+    }
+  }
+  for (unsigned i=0; i<m_due.size(); ++i)
+  {
+    if (m_due[i] != 0)
+    {
+      m_due[i]->processEvent();
+    }
+  }
+} /* GoertzelBank::processChunk */
+
+
+template <unsigned K>
+void GoertzelBank::runVectors(unsigned first_vec, unsigned count)
+{
+  const unsigned stride = m_coeff.size();
+  const unsigned offset = first_vec * LANES;
+
+  Vec coeff[K];
+  Vec q0[K];
+  Vec q1[K];
+  memcpy(coeff, &m_coeff[offset], sizeof(coeff));
+  memcpy(q0, &m_q0[offset], sizeof(q0));
+  memcpy(q1, &m_q1[offset], sizeof(q1));
+
+  const float *in = &m_in[offset];
+  for (unsigned i=0; i<count; ++i)
+  {
+    for (unsigned k=0; k<K; ++k)
+    {
+      Vec x;
+      memcpy(&x, in + k * LANES, sizeof(x));
+      Vec q2 = q1[k];
+      q1[k] = q0[k];
+      q0[k] = coeff[k] * q1[k] - q2 + x;
+    }
+    in += stride;
+  }
+
+  memcpy(&m_q0[offset], q0, sizeof(q0));
+  memcpy(&m_q1[offset], q1, sizeof(q1));
+} /* GoertzelBank::runVectors */
+
+
+
+/*
+ * This file has not been truncated
+ */
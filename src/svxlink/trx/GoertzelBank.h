@@ -0,0 +1,350 @@
+/**
+@file	 GoertzelBank.h
+@brief   A bank of Goertzel detectors evaluated in one pass over the samples
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-08-15
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef GOERTZEL_BANK_INCLUDED
+#define GOERTZEL_BANK_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <complex>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncAudioSink.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A bank of Goertzel detectors evaluated in one pass over the samples
+@author Tobias Blomberg / SM0SVX
+@date   2020-08-15
+
+This class run the Goertzel algorithm (see the Goertzel class) for all bins
+used by a number of tone detectors that are fed with the same audio stream.
+The tone detectors inherit from GoertzelBank::Subscriber and are added to the
+bank. Each subscriber set up its own bins, an optional window function and
+tell the bank after how many samples it want to be called to evaluate the
+result. The bank then process the samples in chunks that end where the
+nearest subscriber event is. For each chunk, the window and the passband
+energy is calculated once per subscriber and then the recursive stage for all
+bins of all subscribers is run using the GCC vector extensions, so that the
+compiler will use SSE, AVX or NEON instructions to handle several bins in
+parallel.
+
+The calculations are done in the same order as in the Goertzel class so a bin
+in the bank give the same result as a Goertzel object fed with the same
+windowed samples.
+*/
+class GoertzelBank : public Async::AudioSink
+{
+  public:
+    /**
+     * @brief   Base class for objects that use bins in a GoertzelBank
+     *
+     * A subscriber set up its bins using setBins. The bin states, the window
+     * position and the passband energy are cleared using resetBins. When the
+     * number of samples given to setEventDelay have been processed, the
+     * processEvent function is called. The bin results can then be read and
+     * a new event delay should be set. No more events are generated if the
+     * event delay is not set again.
+     */
+    class Subscriber
+    {
+      public:
+        /**
+         * @brief   Default constructor
+         */
+        Subscriber(void);
+
+        /**
+         * @brief   Destructor
+         *
+         * The subscriber is automatically removed from the bank.
+         */
+        virtual ~Subscriber(void);
+
+        /**
+         * @brief   Get the bank that the subscriber has been added to
+         * @return  Returns the bank or 0 if not added to a bank
+         */
+        GoertzelBank *bank(void) const { return m_bank; }
+
+      protected:
+        /**
+         * @brief   Set up the bins to calculate
+         * @param   fqs The bin frequencies in Hz
+         * @param   cnt The number of bins
+         *
+         * If the frequencies differ from the current ones, the bin states
+         * are cleared.
+         */
+        void setBins(const float *fqs, unsigned cnt);
+
+        /**
+         * @brief   Get the number of bins
+         * @return  Returns the number of bins set up using setBins
+         */
+        unsigned binCount(void) const { return m_fqs.size(); }
+
+        /**
+         * @brief   Set the window function to apply to the samples
+         * @param   win The window coefficients or 0 for no window
+         *
+         * The window is applied from the position where the last call to
+         * resetBins was made. The window table must be at least as long as
+         * the number of samples processed before the next call to resetBins.
+         * The table is not copied so it must be kept alive.
+         */
+        void setWindow(const float *win) { m_win = win; }
+
+        /**
+         * @brief   Clear the bin states, the window position and the energy
+         */
+        void resetBins(void);
+
+        /**
+         * @brief   Set the number of samples to process before next event
+         * @param   samples The number of samples or 0 for no event
+         */
+        void setEventDelay(unsigned samples) { m_event_left = samples; }
+
+        /**
+         * @brief   Get the squared magnitude for a bin
+         * @param   bin The bin index
+         * @return  Returns the squared magnitude
+         *
+         * The value is the same as Goertzel::magnitudeSquared would return.
+         */
+        float magnitudeSquared(unsigned bin) const;
+
+        /**
+         * @brief   Get the result for a bin in complex form
+         * @param   bin The bin index
+         * @return  Returns the result as a complex value
+         *
+         * The value is the same as Goertzel::result would return.
+         */
+        std::complex<float> result(unsigned bin) const;
+
+        /**
+         * @brief   Get the energy in the windowed samples since last reset
+         * @return  Returns the sum of the squared windowed samples
+         */
+        double energy(void) const { return m_energy; }
+
+        /**
+         * @brief   Called when the event delay has expired
+         */
+        virtual void processEvent(void) = 0;
+
+      private:
+        friend class GoertzelBank;
+
+        GoertzelBank*       m_bank;
+        std::vector<float>  m_fqs;
+        bool                m_bins_changed;
+        unsigned            m_first_bin;
+        unsigned            m_slice_cnt;
+        const float*        m_win;
+        unsigned            m_pos;
+        double              m_energy;
+        unsigned            m_event_left;
+
+        Subscriber(const Subscriber&);
+        Subscriber& operator=(const Subscriber&);
+
+    };  /* class Subscriber */
+
+    /**
+     * @brief 	Constructor
+     * @param   sample_rate The sample rate of the incoming samples
+     */
+    explicit GoertzelBank(unsigned sample_rate=INTERNAL_SAMPLE_RATE);
+
+    /**
+     * @brief 	Destructor
+     *
+     * Managed subscribers are deleted. Other subscribers are removed.
+     */
+    ~GoertzelBank(void);
+
+    /**
+     * @brief   Add a subscriber to the bank
+     * @param   sub     The subscriber to add
+     * @param   managed If \em true, the bank will delete the subscriber
+     *
+     * If the subscriber has been added to another bank, it is first removed
+     * from that bank.
+     */
+    void addSubscriber(Subscriber *sub, bool managed=false);
+
+    /**
+     * @brief   Remove a subscriber from the bank
+     * @param   sub The subscriber to remove
+     *
+     * A managed subscriber is deleted.
+     */
+    void removeSubscriber(Subscriber *sub);
+
+    /**
+     * @brief   Remove all subscribers from the bank
+     *
+     * Managed subscribers are deleted.
+     */
+    void removeAllSubscribers(void);
+
+    /**
+     * @brief   Get the total number of bins in the bank
+     * @return  Returns the number of bins for all subscribers
+     */
+    unsigned binCount(void) const;
+
+    /**
+     * @brief 	Write samples into the bank
+     * @param 	samples The buffer containing the samples
+     * @param 	count The number of samples in the buffer
+     * @return	Returns the number of samples that has been taken care of
+     */
+    virtual int writeSamples(const float *samples, int count);
+
+    /**
+     * @brief 	Tell the bank to flush the previously written samples
+     */
+    virtual void flushSamples(void) { sourceAllSamplesFlushed(); }
+
+  private:
+#ifdef __AVX__
+    typedef float Vec __attribute__((vector_size(32)));
+#else
+    typedef float Vec __attribute__((vector_size(16)));
+#endif
+
+    struct Entry
+    {
+      Subscriber* sub;
+      bool        managed;
+    };
+
+    static const unsigned LANES = sizeof(Vec) / sizeof(float);
+    static const unsigned MAX_CHUNK = 64;
+
+    unsigned                  m_sample_rate;
+    std::vector<Entry>        m_subs;
+    std::vector<Subscriber*>  m_due;
+    bool                      m_layout_dirty;
+    std::vector<float>        m_coeff;
+    std::vector<float>        m_cosw;
+    std::vector<float>        m_sinw;
+    std::vector<float>        m_q0;
+    std::vector<float>        m_q1;
+    std::vector<float>        m_in;
+    float                     m_windowed[MAX_CHUNK];
+
+    GoertzelBank(const GoertzelBank&);
+    GoertzelBank& operator=(const GoertzelBank&);
+    void detach(Subscriber *sub);
+    void updateLayout(void);
+    void processChunk(const float *samples, unsigned count);
+    template <unsigned K> void runVectors(unsigned first_vec, unsigned count);
+
+};  /* class GoertzelBank */
+
+
+//} /* namespace */
+
+#endif /* GOERTZEL_BANK_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
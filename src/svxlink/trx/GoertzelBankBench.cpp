@@ -0,0 +1,210 @@
+#include <time.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Goertzel.h"
+#include "GoertzelBank.h"
+
+using namespace std;
+
+  // Benchmark the Goertzel bank against running one set of Goertzel objects
+  // per tone detector, which is how the tone detectors used to work. Each
+  // detector use three bins (center, lower and upper), a Hamming window and
+  // calculate the passband energy, just like a CTCSS tone detector. The
+  // block length is the one a CTCSS detector with 8Hz bandwidth get. The
+  // runtime is given as the time needed to process one second of audio at
+  // 16kHz for all detectors. The largest relative difference between the
+  // bin magnitudes calculated by the two implementations is printed as a
+  // sanity check.
+  //
+  // Usage: GoertzelBankBench [seconds of audio]
+
+namespace {
+  const unsigned RATE = 16000;
+  const unsigned BLOCKSIZE = 256;
+
+  float toneFq(unsigned idx)
+  {
+    return 67.0f + 3.7f * idx;
+  }
+
+  unsigned blockLen(float fq)
+  {
+    const float bw = 8.0f;
+    return lrintf(RATE * ceilf(fq / bw) / fq);
+  }
+
+  void hamming(vector<float> &win, unsigned len)
+  {
+    win.resize(len);
+    for (unsigned i=0; i<len; ++i)
+    {
+      win[i] = 0.54 - 0.46 * cosf(2.0f * M_PI * i / (len - 1));
+    }
+  }
+
+  class RefDetector
+  {
+    public:
+      RefDetector(float fq)
+        : bins(3), block_len(blockLen(fq)), pos(0), energy(0.0), last_mag(3)
+      {
+        hamming(win, block_len);
+        bins[0].initialize(fq, RATE);
+        bins[1].initialize(fq - 16.0f, RATE);
+        bins[2].initialize(fq + 16.0f, RATE);
+      }
+
+      void writeSamples(const float *samples, unsigned count)
+      {
+        for (unsigned i=0; i<count; ++i)
+        {
+          float sample = samples[i] * win[pos];
+          energy += sample * sample;
+          for (unsigned b=0; b<bins.size(); ++b)
+          {
+            bins[b].calc(sample);
+          }
+          if (++pos == block_len)
+          {
+            for (unsigned b=0; b<bins.size(); ++b)
+            {
+              last_mag[b] = bins[b].magnitudeSquared();
+              bins[b].reset();
+            }
+            pos = 0;
+            energy = 0.0;
+          }
+        }
+      }
+
+      vector<Goertzel>  bins;
+      unsigned          block_len;
+      vector<float>     win;
+      unsigned          pos;
+      double            energy;
+      vector<float>     last_mag;
+  };
+
+  class BankDetector : public GoertzelBank::Subscriber
+  {
+    public:
+      BankDetector(float fq) : block_len(blockLen(fq)), last_mag(3)
+      {
+        hamming(win, block_len);
+        const float fqs[] = { fq, fq - 16.0f, fq + 16.0f };
+        setBins(fqs, 3);
+        setWindow(&win[0]);
+        setEventDelay(block_len);
+      }
+
+      unsigned          block_len;
+      vector<float>     win;
+      vector<float>     last_mag;
+
+    protected:
+      virtual void processEvent(void)
+      {
+        for (unsigned b=0; b<3; ++b)
+        {
+          last_mag[b] = magnitudeSquared(b);
+        }
+        resetBins();
+        setEventDelay(block_len);
+      }
+  };
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  double seconds = (argc > 1) ? atof(argv[1]) : 60.0;
+  if (seconds <= 0.0)
+  {
+    cerr << "Usage: " << argv[0] << " [seconds of audio]\n";
+    exit(1);
+  }
+  size_t blocks = static_cast<size_t>(RATE * seconds / BLOCKSIZE);
+
+    // A tone in noise
+  vector<float> samples(RATE);
+  for (size_t i=0; i<samples.size(); ++i)
+  {
+    samples[i] = 0.3f * sinf(2.0f * M_PI * 100.0f * i / RATE) +
+                 0.1f * (rand() / static_cast<float>(RAND_MAX) - 0.5f);
+  }
+  const size_t sample_blocks = samples.size() / BLOCKSIZE;
+
+  printf("%9s %5s %14s %14s %10s\n", "Detectors", "Bins", "Per detector",
+         "Goertzel bank", "Max diff");
+  printf("%9s %5s %14s %14s %10s\n", "", "", "ms/s audio", "ms/s audio", "");
+  const unsigned det_cnts[] = { 1, 2, 5, 10, 20, 50 };
+  for (size_t d=0; d<sizeof(det_cnts)/sizeof(*det_cnts); ++d)
+  {
+    unsigned det_cnt = det_cnts[d];
+    vector<RefDetector*> ref_dets;
+    vector<BankDetector*> bank_dets;
+    GoertzelBank bank(RATE);
+    for (unsigned i=0; i<det_cnt; ++i)
+    {
+      ref_dets.push_back(new RefDetector(toneFq(i)));
+      bank_dets.push_back(new BankDetector(toneFq(i)));
+      bank.addSubscriber(bank_dets.back(), true);
+    }
+
+    double start = now();
+    for (size_t b=0; b<blocks; ++b)
+    {
+      const float *buf = &samples[(b % sample_blocks) * BLOCKSIZE];
+      for (unsigned i=0; i<det_cnt; ++i)
+      {
+        ref_dets[i]->writeSamples(buf, BLOCKSIZE);
+      }
+    }
+    double ref_time = now() - start;
+
+    start = now();
+    for (size_t b=0; b<blocks; ++b)
+    {
+      const float *buf = &samples[(b % sample_blocks) * BLOCKSIZE];
+      bank.writeSamples(buf, BLOCKSIZE);
+    }
+    double bank_time = now() - start;
+
+      // Both implementations have processed the same samples so the latest
+      // block results should be the same
+    float max_diff = 0.0f;
+    for (unsigned i=0; i<det_cnt; ++i)
+    {
+      for (unsigned b=0; b<3; ++b)
+      {
+        float ref = ref_dets[i]->last_mag[b];
+        float diff = fabsf(bank_dets[i]->last_mag[b] - ref);
+        if (ref > 0.0f)
+        {
+          diff /= ref;
+        }
+        max_diff = max(max_diff, diff);
+      }
+      delete ref_dets[i];
+    }
+
+    double audio_seconds = static_cast<double>(blocks) * BLOCKSIZE / RATE;
+    printf("%9u %5u %14.3f %14.3f %10.2g\n", det_cnt, bank.binCount(),
+           1000.0 * ref_time / audio_seconds,
+           1000.0 * bank_time / audio_seconds, max_diff);
+  }
+
+  return 0;
+}
@@ -41,6 +41,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <cmath>
 #include <cstring>
 #include <limits>
+#include <algorithm>
 #include <json/json.h>
 
 
@@ -75,6 +76,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "SigLevDet.h"
 #include "DtmfDecoder.h"
 #include "ToneDetector.h"
+#include "GoertzelBank.h"
+#include "CtcssScanner.h"
 #include "SquelchCtcss.h"
 #include "LocalRxBase.h"
 #include "multirate_filter_coeff.h"
@@ -234,7 +237,9 @@ namespace {
 LocalRxBase::LocalRxBase(Config &cfg, const std::string& name)
   : Rx(cfg, name), mute_state(MUTE_ALL),
     squelch_det(0), siglevdet(0), /* siglev_offset(0.0), siglev_slope(1.0), */
-    tone_dets(0), sql_valve(0), delay(0), sql_tail_elim(0),
+    tone_dets(0), tone_det_bank(0), ctcss_scanner(0), ctcss_scan_active(-1),
+    ctcss_scan_elapsed(0), ctcss_scan_timer(0, Timer::TYPE_ONESHOT, false),
+    sql_valve(0), delay(0), sql_tail_elim(0),
     preamp_gain(0), mute_valve(0), sql_hangtime(0), sql_extended_hangtime(0),
     sql_extended_hangtime_thresh(0), input_fifo(0), dtmf_muting_pre(0),
     ob_afsk_deframer(0), ib_afsk_deframer(0), audio_dev_keep_open(false)
@@ -512,6 +517,34 @@ bool LocalRxBase::initialize(void)
   prev_src->registerSink(tone_dets, true);
   prev_src = tone_dets;
 
+    // All tone detectors share one Goertzel bank so that the samples only
+    // have to be processed once for all of them
+  tone_det_bank = new GoertzelBank;
+  tone_dets->addSink(tone_det_bank, true);
+
+    // The CTCSS scanner detect all standard CTCSS tones at once so that no
+    // separate tone detectors are needed for them. Only the tones requested
+    // through addToneDetector are reported, after the required duration.
+  bool ctcss_scan = false;
+  cfg().getValue(name(), "CTCSS_SCAN", ctcss_scan);
+  if (ctcss_scan)
+  {
+    ctcss_scanner = new CtcssScanner;
+    float ctcss_scan_thresh = 0.0f;
+    if (cfg().getValue(name(), "CTCSS_SCAN_THRESH", ctcss_scan_thresh))
+    {
+      ctcss_scanner->setDetectSnrThresh(ctcss_scan_thresh);
+      ctcss_scanner->setUndetectSnrThresh(ctcss_scan_thresh - 5.0f);
+    }
+    ctcss_scanner->detected.connect(
+        mem_fun(*this, &LocalRxBase::ctcssScanDetected));
+    ctcss_scanner->undetected.connect(
+        mem_fun(*this, &LocalRxBase::ctcssScanUndetected));
+    ctcss_scan_timer.expired.connect(
+        mem_fun(*this, &LocalRxBase::ctcssScanCheckDuration));
+    tone_dets->addSink(ctcss_scanner, true);
+  }
+
     // Filter out the voice band, removing high- and subaudible frequencies,
     // for example CTCSS.
 #if (INTERNAL_SAMPLE_RATE == 16000)
@@ -643,7 +676,9 @@ bool LocalRxBase::initialize(void)
     assert(calldet != 0);
     calldet->setPeakThresh(13);
     calldet->activated.connect(mem_fun(*this, &LocalRxBase::tone1750detected));
-    voiceband_splitter->addSink(calldet, true);
+    GoertzelBank *calldet_bank = new GoertzelBank;
+    calldet_bank->addSubscriber(calldet, true);
+    voiceband_splitter->addSink(calldet_bank, true);
     //cout << "### Enabling 1750Hz muting\n";
   }
 
@@ -719,12 +754,18 @@ bool LocalRxBase::addToneDetector(float fq, int bw, float thresh,
 {
   //printf("Adding tone detector with fq=%d  bw=%d  req_dur=%d\n",
   //    	 fq, bw, required_duration);
+  if ((ctcss_scanner != 0) && (CtcssScanner::toneIndex(fq) >= 0))
+  {
+    ctcss_scan_tones.insert(
+        make_pair(CtcssScanner::toneIndex(fq), required_duration));
+    return true;
+  }
   ToneDetector *det = new ToneDetector(fq, bw, required_duration);
   assert(det != 0);
   det->setPeakThresh(thresh);
   det->detected.connect(toneDetected.make_slot());
   
-  tone_dets->addSink(det, true);
+  tone_det_bank->addSubscriber(det, true);
   
   return true;
 
@@ -750,7 +791,13 @@ char LocalRxBase::sqlRxId(void) const
 void LocalRxBase::reset(void)
 {
   setMuteState(Rx::MUTE_ALL);
-  tone_dets->removeAllSinks();
+  tone_det_bank->removeAllSubscribers();
+  if (ctcss_scanner != 0)
+  {
+    ctcss_scanner->reset();
+    ctcss_scan_tones.clear();
+    ctcssScanUndetected(0.0f);
+  }
   if (delay != 0)
   {
     delay->mute(false);
@@ -843,6 +890,62 @@ void LocalRxBase::audioStreamStateChange(bool is_active, bool is_idle)
 } /* LocalRxBase::audioStreamStateChange */
 
 
+void LocalRxBase::ctcssScanDetected(float fq)
+{
+  ctcssScanUndetected(0.0f);
+
+    // Each call to addToneDetector for the tone get its own detection, just
+    // like when using one tone detector for each call
+  int idx = CtcssScanner::toneIndex(fq);
+  multimap<int, int>::const_iterator it;
+  for (it=ctcss_scan_tones.lower_bound(idx);
+       it!=ctcss_scan_tones.upper_bound(idx); ++it)
+  {
+    ctcss_scan_durations.push_back(it->second);
+  }
+  if (ctcss_scan_durations.empty())
+  {
+    return;
+  }
+  sort(ctcss_scan_durations.begin(), ctcss_scan_durations.end());
+  ctcss_scan_active = idx;
+  ctcssScanCheckDuration();
+} /* LocalRxBase::ctcssScanDetected */
+
+
+void LocalRxBase::ctcssScanUndetected(float fq)
+{
+  ctcss_scan_timer.setEnable(false);
+  ctcss_scan_durations.clear();
+  ctcss_scan_active = -1;
+  ctcss_scan_elapsed = 0;
+} /* LocalRxBase::ctcssScanUndetected */
+
+
+void LocalRxBase::ctcssScanCheckDuration(Timer *t)
+{
+  const int idx = ctcss_scan_active;
+  while (!ctcss_scan_durations.empty() &&
+         (ctcss_scan_durations.front() <= ctcss_scan_elapsed))
+  {
+    ctcss_scan_durations.erase(ctcss_scan_durations.begin());
+    toneDetected(CtcssScanner::toneFq(idx));
+    if (ctcss_scan_active != idx)
+    {
+      return;
+    }
+  }
+
+  if (!ctcss_scan_durations.empty())
+  {
+    ctcss_scan_timer.setTimeout(
+        ctcss_scan_durations.front() - ctcss_scan_elapsed);
+    ctcss_scan_timer.setEnable(true);
+    ctcss_scan_elapsed = ctcss_scan_durations.front();
+  }
+} /* LocalRxBase::ctcssScanCheckDuration */
+
+
 void LocalRxBase::onSquelchOpen(bool is_open)
 {
   if (mute_state == MUTE_ALL)
@@ -42,6 +42,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <sys/time.h>
 #include <stdint.h>
 #include <vector>
+#include <map>
 
 
 /****************************************************************************
@@ -52,6 +53,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncAudioValve.h>
 #include <AsyncAudioDelayLine.h>
+#include <AsyncTimer.h>
 
 
 /****************************************************************************
@@ -79,6 +81,8 @@ namespace Async
 
 class Squelch;
 class HdlcDeframer;
+class GoertzelBank;
+class CtcssScanner;
 
 
 /****************************************************************************
@@ -241,6 +245,13 @@ class LocalRxBase : public Rx
     Squelch   	      	      	*squelch_det;
     SigLevDet 	      	        *siglevdet;
     Async::AudioSplitter      	*tone_dets;
+    GoertzelBank                *tone_det_bank;
+    CtcssScanner                *ctcss_scanner;
+    std::multimap<int, int>     ctcss_scan_tones;
+    std::vector<int>            ctcss_scan_durations;
+    int                         ctcss_scan_active;
+    int                         ctcss_scan_elapsed;
+    Async::Timer                ctcss_scan_timer;
     Async::AudioValve 	        *sql_valve;
     Async::AudioDelayLine     	*delay;
     int       	      	      	sql_tail_elim;
@@ -264,6 +275,9 @@ class LocalRxBase : public Rx
     void audioStreamStateChange(bool is_active, bool is_idle);
     void onSquelchOpen(bool is_open);
     void tone1750detected(bool detected);
+    void ctcssScanDetected(float fq);
+    void ctcssScanUndetected(float fq);
+    void ctcssScanCheckDuration(Async::Timer *t=0);
     void onSignalLevelUpdated(float siglev);
     void setSqlHangtimeFromSiglev(float siglev);
     void rxReadyStateChanged(void);
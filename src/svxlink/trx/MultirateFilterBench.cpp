@@ -0,0 +1,237 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <complex>
+#include <iostream>
+#include <vector>
+
+#include <AsyncPolyphaseFir.h>
+
+#include "multirate_filter_coeff.h"
+#include "DdrFilterCoeffs.h"
+
+using namespace std;
+using namespace Async;
+
+  // Benchmark the decimators and interpolators used in the audio paths of
+  // LocalRxBase, LocalTx and Ddr. Each filter is compared with a reference
+  // implementation, using the delay line shifting algorithm that was used
+  // before the polyphase implementation was introduced. The output of the two
+  // must be bit identical.
+  //
+  // Usage: MultirateFilterBench [seconds of audio]
+
+namespace {
+  template <class T>
+  class RefDecimator
+  {
+    public:
+      RefDecimator(int dec_fact, const float *coeff, int taps)
+        : dec_fact(dec_fact), coeff(coeff, coeff + taps), z(taps) {}
+
+      size_t process(T *dest, const T *src, size_t count)
+      {
+        size_t num_out = 0;
+        const int taps = coeff.size();
+        for (size_t i=0; i+dec_fact<=count; i+=dec_fact)
+        {
+          memmove(&z[dec_fact], &z[0], (taps - dec_fact) * sizeof(T));
+          for (int tap = dec_fact - 1; tap >= 0; tap--)
+          {
+            z[tap] = *src++;
+          }
+          T sum(0);
+          for (int tap = 0; tap < taps; tap++)
+          {
+            sum += coeff[tap] * z[tap];
+          }
+          dest[num_out++] = sum;
+        }
+        return num_out;
+      }
+
+    private:
+      int             dec_fact;
+      vector<float>   coeff;
+      vector<T>       z;
+  };
+
+  class RefInterpolator
+  {
+    public:
+      RefInterpolator(int interp_fact, const float *coeff, int taps)
+        : interp_fact(interp_fact), coeff(coeff, coeff + taps),
+          z(taps / interp_fact) {}
+
+      size_t process(float *dest, const float *src, size_t count)
+      {
+        size_t num_out = 0;
+        const int taps_per_phase = z.size();
+        for (size_t i=0; i<count; ++i)
+        {
+          memmove(&z[1], &z[0], (taps_per_phase - 1) * sizeof(float));
+          z[0] = *src++;
+          for (int phase = 0; phase < interp_fact; phase++)
+          {
+            const float *p_coeff = &coeff[phase];
+            float sum = 0.0;
+            for (int tap = 0; tap < taps_per_phase; tap++)
+            {
+              sum += *p_coeff * z[tap];
+              p_coeff += interp_fact;
+            }
+            dest[num_out++] = sum * interp_fact;
+          }
+        }
+        return num_out;
+      }
+
+    private:
+      int             interp_fact;
+      vector<float>   coeff;
+      vector<float>   z;
+  };
+
+  double now(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1.0e9;
+  }
+
+  template <class T>
+  void randomSamples(vector<T>& vec, size_t count);
+
+  template <>
+  void randomSamples<float>(vector<float>& vec, size_t count)
+  {
+    vec.resize(count);
+    for (size_t i=0; i<count; ++i)
+    {
+      vec[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+    }
+  }
+
+  template <>
+  void randomSamples<complex<float> >(vector<complex<float> >& vec,
+                                      size_t count)
+  {
+    vec.resize(count);
+    for (size_t i=0; i<count; ++i)
+    {
+      vec[i] = complex<float>(2.0f * rand() / RAND_MAX - 1.0f,
+                              2.0f * rand() / RAND_MAX - 1.0f);
+    }
+  }
+
+    // Run both filters over the same input, blocksize samples at a time, and
+    // compare the output. The factor is the decimation factor and the
+    // out_mult is the number of output samples per input block.
+  template <class T, class Ref>
+  void bench(const char *name, Ref& ref, PolyphaseFir<T>& fir, int in_rate,
+             int factor, int out_mult, size_t blocksize, double seconds)
+  {
+    vector<T> in;
+    randomSamples(in, static_cast<size_t>(in_rate * seconds));
+    in.resize(in.size() - in.size() % blocksize);
+    size_t max_out = blocksize * out_mult / factor;
+    vector<T> ref_out(in.size() * out_mult / factor);
+    vector<T> fir_out(ref_out.size());
+
+    double start = now();
+    size_t ref_cnt = 0;
+    for (size_t pos=0; pos<in.size(); pos+=blocksize)
+    {
+      ref_cnt += ref.process(&ref_out[ref_cnt], &in[pos], blocksize);
+    }
+    double ref_time = now() - start;
+
+    start = now();
+    size_t fir_cnt = 0;
+    for (size_t pos=0; pos<in.size(); pos+=blocksize)
+    {
+      size_t cnt = fir.process(&fir_out[fir_cnt], &in[pos], blocksize);
+      if (cnt > max_out)
+      {
+        cerr << "*** ERROR: Too many output samples for " << name << endl;
+        exit(1);
+      }
+      fir_cnt += cnt;
+    }
+    double fir_time = now() - start;
+
+    if ((ref_cnt != fir_cnt) ||
+        (memcmp(&ref_out[0], &fir_out[0], ref_cnt * sizeof(T)) != 0))
+    {
+      cerr << "*** ERROR: Output differ from the reference for " << name
+           << endl;
+      exit(1);
+    }
+
+    printf("%-30s %8.1f Msamples/s %8.1f Msamples/s %6.2fx\n", name,
+           in.size() / ref_time / 1.0e6, in.size() / fir_time / 1.0e6,
+           ref_time / fir_time);
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  double seconds = (argc > 1) ? atof(argv[1]) : 60.0;
+  if (seconds <= 0.0)
+  {
+    cerr << "Usage: " << argv[0] << " [seconds of audio]\n";
+    exit(1);
+  }
+
+  printf("%-30s %19s %19s\n", "Filter", "Reference", "Polyphase");
+
+  {
+    RefDecimator<float> ref(3, coeff_48_16_wide, coeff_48_16_wide_taps);
+    PolyphaseFir<float> fir;
+    fir.setDecimator(3, coeff_48_16_wide, coeff_48_16_wide_taps);
+    bench("Decimator 48k -> 16k", ref, fir, 48000, 3, 1, 768, seconds);
+  }
+
+  {
+    RefDecimator<float> ref(2, coeff_16_8, coeff_16_8_taps);
+    PolyphaseFir<float> fir;
+    fir.setDecimator(2, coeff_16_8, coeff_16_8_taps);
+    bench("Decimator 16k -> 8k", ref, fir, 16000, 2, 1, 250, seconds);
+  }
+
+  {
+    RefInterpolator ref(2, coeff_16_8, coeff_16_8_taps);
+    PolyphaseFir<float> fir;
+    fir.setInterpolator(2, coeff_16_8, coeff_16_8_taps);
+    bench("Interpolator 8k -> 16k", ref, fir, 8000, 1, 2, 128, seconds);
+  }
+
+  {
+    RefInterpolator ref(3, coeff_48_16, coeff_48_16_taps);
+    PolyphaseFir<float> fir;
+    fir.setInterpolator(3, coeff_48_16, coeff_48_16_taps);
+    bench("Interpolator 16k -> 48k", ref, fir, 16000, 1, 3, 100, seconds);
+  }
+
+  {
+    RefDecimator<complex<float> > ref(4, coeff_dec_192k_48k,
+                                      coeff_dec_192k_48k_cnt);
+    PolyphaseFir<complex<float> > fir;
+    fir.setDecimator(4, coeff_dec_192k_48k, coeff_dec_192k_48k_cnt);
+    bench("Ddr decimator 192k -> 48k", ref, fir, 192000, 4, 1, 2048,
+          seconds / 4);
+  }
+
+  {
+    RefDecimator<complex<float> > ref(3, coeff_dec_48k_16k,
+                                      coeff_dec_48k_16k_cnt);
+    PolyphaseFir<complex<float> > fir;
+    fir.setDecimator(3, coeff_dec_48k_16k, coeff_dec_48k_16k_cnt);
+    bench("Ddr decimator 48k -> 16k", ref, fir, 48000, 3, 1, 513, seconds);
+  }
+
+  return 0;
+}
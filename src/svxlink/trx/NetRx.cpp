@@ -47,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncConfig.h>
 #include <AsyncAudioDecoder.h>
+#include <AsyncAudioDecoderThreaded.h>
 
 
 /****************************************************************************
@@ -213,6 +214,12 @@ bool NetRx::initialize(void)
           << ") specified for receiver " << name() << "\n";
     return false;
   }
+  bool threaded_codec = false;
+  cfg.getValue(name(), "THREADED_CODEC", threaded_codec);
+  if (threaded_codec)
+  {
+    audio_dec = new AudioDecoderThreaded(audio_dec);
+  }
   audio_dec->allEncodedSamplesFlushed.connect(
           mem_fun(*this, &NetRx::allEncodedSamplesFlushed));
 
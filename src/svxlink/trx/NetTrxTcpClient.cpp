@@ -470,7 +470,7 @@ void NetTrxTcpClient::sendMsgP(Msg *msg)
   int written = write(msg, msg->size());
   if (written != static_cast<int>(msg->size()))
   {
-    if (written == -1)
+    if ((written == -1) && (errno != ENOBUFS))
     {
       cerr << "*** ERROR: TCP write error: " << strerror(errno) << "\n";
     }
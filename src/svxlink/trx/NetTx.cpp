@@ -47,6 +47,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <AsyncConfig.h>
 #include <AsyncAudioPacer.h>
 #include <AsyncAudioEncoder.h>
+#include <AsyncAudioEncoderThreaded.h>
 
 
 /****************************************************************************
@@ -196,6 +197,12 @@ bool NetTx::initialize(void)
           << ") specified for transmitter " << name() << "\n";
     return false;
   }
+  bool threaded_codec = false;
+  cfg.getValue(name(), "THREADED_CODEC", threaded_codec);
+  if (threaded_codec)
+  {
+    audio_enc = new AudioEncoderThreaded(audio_enc);
+  }
   audio_enc->writeEncodedSamples.connect(
           mem_fun(*this, &NetTx::writeEncodedSamples));
   audio_enc->flushEncodedSamples.connect(
@@ -0,0 +1,415 @@
+/**
+@file	 PolyphaseChannelizer.cpp
+@brief   A polyphase filter bank channelizer for wideband I/Q samples
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-06-28
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2014 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "PolyphaseChannelizer.h"
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+  // The prototype filter stopband attenuation in dB
+#define STOPBAND_ATTENUATION  50.0
+
+  // The prototype filter transition band width, as a fraction of CH_SPACING
+#define TRANSITION_WIDTH      0.6
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+static double besselI0(double x);
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+PolyphaseChannelizer::PolyphaseChannelizer(unsigned samp_rate)
+  : m_samp_rate(samp_rate), m_branches(samp_rate / CH_SPACING),
+    m_dec_fact(m_branches / 2), m_branch_taps(0), m_branch_len(0), m_pos(0),
+    m_rot_idx(0)
+{
+  assert(isSupported(samp_rate));
+
+    // Design the prototype low pass filter using a Kaiser window. The
+    // cutoff frequency is at the bin spacing so that the transition band is
+    // centered between the passband edge and the frequency that alias into
+    // the passband after decimation.
+  const double A = STOPBAND_ATTENUATION;
+  const double beta = 0.1102 * (A - 8.7);
+  const double dw = 2.0 * M_PI * TRANSITION_WIDTH * CH_SPACING / samp_rate;
+  unsigned taps = static_cast<unsigned>(ceil((A - 8.0) / (2.285 * dw))) + 1;
+  m_branch_taps = (taps + m_branches - 1) / m_branches;
+  taps = m_branch_taps * m_branches;
+  const double fc = static_cast<double>(CH_SPACING) / samp_rate;
+  vector<double> h(taps);
+  double sum = 0.0;
+  for (unsigned n=0; n<taps; ++n)
+  {
+    double t = n - (taps - 1) / 2.0;
+    double sinc = (t == 0.0) ? 1.0 : sin(2.0 * M_PI * fc * t) /
+                                     (2.0 * M_PI * fc * t);
+    double r = 2.0 * n / (taps - 1) - 1.0;
+    double w = besselI0(beta * sqrt(max(0.0, 1.0 - r * r))) / besselI0(beta);
+    h[n] = 2.0 * fc * sinc * w;
+    sum += h[n];
+  }
+
+    // Store the coefficients in the order they are used by calcBranches.
+    // For each group of m_branches taps, the coefficients are reversed and
+    // duplicated so that they can be multiplied directly with the I and Q
+    // values of a block of consecutive input samples.
+  const unsigned M = m_branches;
+  m_coeff.resize(2 * taps);
+  for (unsigned m=0; m<m_branch_taps; ++m)
+  {
+    for (unsigned j=0; j<M; ++j)
+    {
+      float c = h[(M - 1 - j) + m * M] / sum;
+      m_coeff[2 * (m * M + j)] = c;
+      m_coeff[2 * (m * M + j) + 1] = c;
+    }
+  }
+
+    // The branch outputs are stored as interleaved I and Q values, padded
+    // to a whole number of vectors
+  m_branch_len = (2 * M + VEC_LEN - 1) / VEC_LEN * VEC_LEN;
+  m_branch_out.assign(m_branch_len, 0.0f);
+  m_branch_swap.assign(m_branch_len, 0.0f);
+
+    // Precalculate the DFT twiddle factors for each bin and the rotation
+    // needed to compensate for the decimation factor not being equal to the
+    // number of branches. The twiddle factors are stored in two arrays to be
+    // multiplied with the branch outputs and with the branch outputs with I
+    // and Q swapped, which give the real and imaginary parts of the complex
+    // multiplication in the even and odd vector lanes.
+  const unsigned rot_len = M / m_dec_fact;
+  m_bins.resize(M);
+  for (unsigned k=0; k<M; ++k)
+  {
+    Bin &bin = m_bins[k];
+    bin.tw.assign(m_branch_len, 0.0f);
+    bin.tw_swap.assign(m_branch_len, 0.0f);
+    for (unsigned j=0; j<M; ++j)
+    {
+      double arg = 2.0 * M_PI * ((k * (M - 1 - j)) % M) / M;
+      bin.tw[2 * j] = cos(arg);
+      bin.tw[2 * j + 1] = cos(arg);
+      bin.tw_swap[2 * j] = -sin(arg);
+      bin.tw_swap[2 * j + 1] = sin(arg);
+    }
+    bin.rot.resize(rot_len);
+    for (unsigned p=0; p<rot_len; ++p)
+    {
+      bin.rot[p] = polar(1.0f,
+          static_cast<float>(-2.0 * M_PI * ((k * p * m_dec_fact) % M) / M));
+    }
+  }
+
+  reset();
+} /* PolyphaseChannelizer::PolyphaseChannelizer */
+
+
+PolyphaseChannelizer::~PolyphaseChannelizer(void)
+{
+} /* PolyphaseChannelizer::~PolyphaseChannelizer */
+
+
+unsigned PolyphaseChannelizer::binForOffset(int fq_offset) const
+{
+  int bin = static_cast<int>(
+      floor(static_cast<double>(fq_offset) / CH_SPACING + 0.5));
+  bin %= static_cast<int>(m_branches);
+  if (bin < 0)
+  {
+    bin += m_branches;
+  }
+  return bin;
+} /* PolyphaseChannelizer::binForOffset */
+
+
+int PolyphaseChannelizer::binOffset(unsigned bin) const
+{
+  assert(bin < m_branches);
+  int k = bin;
+  if (bin > m_branches / 2)
+  {
+    k -= m_branches;
+  }
+  return k * static_cast<int>(CH_SPACING);
+} /* PolyphaseChannelizer::binOffset */
+
+
+void PolyphaseChannelizer::iqReceived(const vector<Sample> &samples)
+{
+  m_active.clear();
+  for (vector<Bin>::iterator it=m_bins.begin(); it!=m_bins.end(); ++it)
+  {
+    if (!it->sig.empty())
+    {
+      it->out.clear();
+      m_active.push_back(&(*it));
+    }
+  }
+
+  m_buf.insert(m_buf.end(), samples.begin(), samples.end());
+  if (!m_active.empty())
+  {
+    for (; m_pos<m_buf.size(); m_pos+=m_dec_fact)
+    {
+      calcBranches(&m_buf[m_pos]);
+      for (vector<Bin*>::iterator it=m_active.begin();
+           it!=m_active.end(); ++it)
+      {
+        Bin *bin = *it;
+        bin->out.push_back(bin->rot[m_rot_idx] * calcBin(*bin));
+      }
+      if (++m_rot_idx == m_bins[0].rot.size())
+      {
+        m_rot_idx = 0;
+      }
+    }
+  }
+  else
+  {
+    while (m_pos < m_buf.size())
+    {
+      m_pos += m_dec_fact;
+      if (++m_rot_idx == m_bins[0].rot.size())
+      {
+        m_rot_idx = 0;
+      }
+    }
+  }
+
+    // Only keep the samples needed as filter history
+  size_t hist_len = m_branch_taps * m_branches - 1;
+  size_t drop = m_buf.size() - hist_len;
+  m_buf.erase(m_buf.begin(), m_buf.begin() + drop);
+  m_pos -= drop;
+
+  for (vector<Bin*>::iterator it=m_active.begin(); it!=m_active.end(); ++it)
+  {
+    if (!(*it)->out.empty())
+    {
+      (*it)->sig((*it)->out);
+    }
+  }
+} /* PolyphaseChannelizer::iqReceived */
+
+
+void PolyphaseChannelizer::reset(void)
+{
+  size_t hist_len = m_branch_taps * m_branches - 1;
+  m_buf.assign(hist_len, Sample(0.0f, 0.0f));
+  m_pos = hist_len + m_dec_fact - 1;
+  m_rot_idx = 0;
+} /* PolyphaseChannelizer::reset */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void PolyphaseChannelizer::calcBranches(const Sample *newest)
+{
+    // Branch r of the filter bank is stored at index M-1-r in m_branch_out
+    // so that all loops run over consecutive memory. The number of branches
+    // is even so each group of branches is a whole number of vectors.
+  const unsigned M = m_branches;
+  float *v = &m_branch_out[0];
+  for (unsigned i=0; i<2*M; i+=VEC_LEN)
+  {
+    Vec sum = Vec();
+    for (unsigned m=0; m<m_branch_taps; ++m)
+    {
+      const float *c = &m_coeff[2 * m * M + i];
+      const float *x =
+        reinterpret_cast<const float*>(newest - m * M - (M - 1)) + i;
+      Vec cv, xv;
+      memcpy(&cv, c, sizeof(Vec));
+      memcpy(&xv, x, sizeof(Vec));
+      sum += cv * xv;
+    }
+    memcpy(v + i, &sum, sizeof(Vec));
+  }
+  float *vs = &m_branch_swap[0];
+  for (unsigned i=0; i<2*M; i+=2)
+  {
+    vs[i] = v[i + 1];
+    vs[i + 1] = v[i];
+  }
+} /* PolyphaseChannelizer::calcBranches */
+
+
+PolyphaseChannelizer::Sample PolyphaseChannelizer::calcBin(
+    const Bin &bin) const
+{
+    // Calculate the DFT for one bin. Two accumulators are used to hide the
+    // latency of the additions. The even lanes sum up the real part and the
+    // odd lanes sum up the imaginary part of the result.
+  const float *v = &m_branch_out[0];
+  const float *vs = &m_branch_swap[0];
+  const float *tw = &bin.tw[0];
+  const float *tws = &bin.tw_swap[0];
+  Vec acc[2] = { Vec(), Vec() };
+  for (unsigned i=0; i<m_branch_len; i+=VEC_LEN)
+  {
+    Vec a, b, c, d;
+    memcpy(&a, tw + i, sizeof(Vec));
+    memcpy(&b, v + i, sizeof(Vec));
+    memcpy(&c, tws + i, sizeof(Vec));
+    memcpy(&d, vs + i, sizeof(Vec));
+    acc[(i / VEC_LEN) & 1] += a * b + c * d;
+  }
+  Vec sum = acc[0] + acc[1];
+  float re = 0.0f;
+  float im = 0.0f;
+  for (unsigned lane=0; lane<VEC_LEN; lane+=2)
+  {
+    re += sum[lane];
+    im += sum[lane + 1];
+  }
+  return Sample(re, im);
+} /* PolyphaseChannelizer::calcBin */
+
+
+
+/****************************************************************************
+ *
+ * Local functions
+ *
+ ****************************************************************************/
+
+/*
+ * The zeroth order modified Bessel function of the first kind, used to
+ * calculate the Kaiser window
+ */
+static double besselI0(double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k=1; k<50; ++k)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < 1.0e-12 * sum)
+    {
+      break;
+    }
+  }
+  return sum;
+} /* besselI0 */
+
+
+
+/*
+ * This file has not been truncated
+ */
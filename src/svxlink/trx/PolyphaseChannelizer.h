@@ -0,0 +1,257 @@
+/**
+@file	 PolyphaseChannelizer.h
+@brief   A polyphase filter bank channelizer for wideband I/Q samples
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-06-28
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef POLYPHASE_CHANNELIZER_INCLUDED
+#define POLYPHASE_CHANNELIZER_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sigc++/sigc++.h>
+
+#include <vector>
+#include <complex>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+  
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A polyphase filter bank channelizer for wideband I/Q samples
+@author Tobias Blomberg / SM0SVX
+@date   2020-06-28
+
+This class split the wideband I/Q stream from a tuner into a number of bins
+with a spacing of CH_SPACING Hz. Each bin is mixed down to baseband, low pass
+filtered and decimated to a sampling rate of twice the bin spacing. The
+filter bank is oversampled by a factor of two so a signal anywhere within
++/- CH_SPACING/2 Hz from the bin center frequency, plus the channel
+bandwidth, come out of the bin without aliasing.
+
+The filtering part of the work is shared by all bins. It is done using a
+polyphase decomposition of a single prototype low pass filter so it is only
+calculated once for each output sample, no matter how many bins are used.
+Only the bins that have something connected to their signal are then
+calculated, which cost one complex multiplication per filter branch and
+output sample. This make it cheap to have many narrowband receivers on
+the same tuner, compared to mixing and decimating the whole wideband stream
+for each receiver.
+*/
+class PolyphaseChannelizer : public sigc::trackable
+{
+  public:
+    typedef std::complex<float> Sample;
+
+    /**
+     * @brief   The frequency distance between the bin centers in Hz
+     */
+    static const unsigned CH_SPACING = 80000;
+
+    /**
+     * @brief   Check if the given wideband sampling rate is supported
+     * @param   samp_rate The sampling rate of the wideband samples
+     * @returns Returns \em true if the sampling rate is supported
+     *
+     * The sampling rate must be an even multiple of the bin spacing.
+     */
+    static bool isSupported(unsigned samp_rate)
+    {
+      return (samp_rate > 0) && (samp_rate % (2 * CH_SPACING) == 0);
+    }
+
+    /**
+     * @brief 	Constructor
+     * @param   samp_rate The sampling rate of the wideband samples
+     */
+    explicit PolyphaseChannelizer(unsigned samp_rate);
+  
+    /**
+     * @brief 	Destructor
+     */
+    ~PolyphaseChannelizer(void);
+  
+    /**
+     * @brief   Get the sampling rate of the bin outputs
+     * @returns Returns the sampling rate in Hz of the bin outputs
+     */
+    unsigned chSampRate(void) const { return 2 * CH_SPACING; }
+
+    /**
+     * @brief   Get the number of bins
+     * @returns Returns the number of bins covering the tuner bandwidth
+     */
+    unsigned numBins(void) const { return m_bins.size(); }
+
+    /**
+     * @brief   Find the bin closest to a frequency
+     * @param   fq_offset The offset in Hz from the tuner center frequency
+     * @returns Returns the bin number
+     */
+    unsigned binForOffset(int fq_offset) const;
+
+    /**
+     * @brief   Get the center frequency of a bin
+     * @param   bin The bin number
+     * @returns Returns the offset in Hz from the tuner center frequency
+     */
+    int binOffset(unsigned bin) const;
+
+    /**
+     * @brief   Get the signal for a bin
+     * @param   bin The bin number
+     * @returns Returns a signal that is emitted when new samples are ready
+     *
+     * Connect to the returned signal to receive samples from a bin. Only
+     * bins that have something connected are calculated. The samples are
+     * emitted at a sampling rate of chSampRate().
+     */
+    sigc::signal<void, const std::vector<Sample>&>& binSignal(unsigned bin)
+    {
+      return m_bins[bin].sig;
+    }
+
+    /**
+     * @brief   Feed wideband samples into the channelizer
+     * @param   samples A block of wideband samples
+     */
+    void iqReceived(const std::vector<Sample> &samples);
+
+    /**
+     * @brief   Clear the filter history
+     */
+    void reset(void);
+
+  protected:
+    
+  private:
+    typedef float Vec __attribute__((vector_size(16)));
+    static const unsigned VEC_LEN = sizeof(Vec) / sizeof(float);
+
+    struct Bin
+    {
+      sigc::signal<void, const std::vector<Sample>&> sig;
+      std::vector<float>                              tw;
+      std::vector<float>                              tw_swap;
+      std::vector<Sample>                             rot;
+      std::vector<Sample>                             out;
+    };
+
+    unsigned            m_samp_rate;
+    unsigned            m_branches;
+    unsigned            m_dec_fact;
+    unsigned            m_branch_taps;
+    unsigned            m_branch_len;
+    std::vector<float>  m_coeff;
+    std::vector<Sample> m_buf;
+    size_t              m_pos;
+    unsigned            m_rot_idx;
+    std::vector<float>  m_branch_out;
+    std::vector<float>  m_branch_swap;
+    std::vector<Bin>    m_bins;
+    std::vector<Bin*>   m_active;
+
+    PolyphaseChannelizer(const PolyphaseChannelizer&);
+    PolyphaseChannelizer& operator=(const PolyphaseChannelizer&);
+    void calcBranches(const Sample *newest);
+    Sample calcBin(const Bin &bin) const;
+    
+};  /* class PolyphaseChannelizer */
+
+
+//} /* namespace */
+
+#endif /* POLYPHASE_CHANNELIZER_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
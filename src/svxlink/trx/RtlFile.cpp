@@ -0,0 +1,257 @@
+/**
+@file	 RtlFile.cpp
+@brief   An RtlSdr implementation that replay I/Q samples from a file
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-04
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstring>
+#include <cmath>
+#include <iostream>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "RtlFile.h"
+
+
+
+/****************************************************************************
+ *
+ * Namespaces to use
+ *
+ ****************************************************************************/
+
+using namespace std;
+using namespace Async;
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local class definitions
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Prototypes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+
+/****************************************************************************
+ *
+ * Local Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Public member functions
+ *
+ ****************************************************************************/
+
+RtlFile::RtlFile(const string &filename, double speed, bool loop)
+  : filename(filename), speed(speed), loop(loop), fd(-1),
+    replay_timer(0, Timer::TYPE_ONESHOT), block_cnt(0)
+{
+  next_block.tv_sec = 0;
+  next_block.tv_nsec = 0;
+  fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    cerr << "*** ERROR: Could not open I/Q file \"" << filename << "\": "
+         << strerror(errno) << endl;
+    replay_timer.setEnable(false);
+    return;
+  }
+  replay_timer.expired.connect(hide(mem_fun(*this, &RtlFile::replayBlocks)));
+} /* RtlFile::RtlFile */
+
+
+RtlFile::~RtlFile(void)
+{
+  if (fd >= 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+} /* RtlFile::~RtlFile */
+
+
+
+/****************************************************************************
+ *
+ * Protected member functions
+ *
+ ****************************************************************************/
+
+void RtlFile::handleSetSampleRate(uint32_t rate)
+{
+  buf.resize(blockSize());
+  clock_gettime(CLOCK_MONOTONIC, &next_block);
+} /* RtlFile::handleSetSampleRate */
+
+
+
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void RtlFile::replayBlocks(void)
+{
+  if (speed <= 0.0)
+  {
+    if (readBlock())
+    {
+      replay_timer.setEnable(true);
+    }
+    return;
+  }
+
+    // Emit all blocks that are due and then sleep until the next one is. The
+    // deadline is advanced by a fixed amount for each block so that the
+    // timer resolution does not make the replay rate drift.
+  const long block_ns = lround(1.0e9 * (blockSize() / 2) /
+                               (sampleRate() * speed));
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (block_cnt == 0)
+  {
+    next_block = now;
+  }
+  while ((now.tv_sec > next_block.tv_sec) ||
+         ((now.tv_sec == next_block.tv_sec) &&
+          (now.tv_nsec >= next_block.tv_nsec)))
+  {
+    if (!readBlock())
+    {
+      return;
+    }
+    next_block.tv_nsec += block_ns;
+    next_block.tv_sec += next_block.tv_nsec / 1000000000L;
+    next_block.tv_nsec %= 1000000000L;
+  }
+
+  long wait_ms = (next_block.tv_sec - now.tv_sec) * 1000 +
+                 (next_block.tv_nsec - now.tv_nsec) / 1000000;
+  replay_timer.setTimeout(wait_ms);
+  replay_timer.setEnable(true);
+} /* RtlFile::replayBlocks */
+
+
+bool RtlFile::readBlock(void)
+{
+  if (buf.size() != blockSize())
+  {
+    buf.resize(blockSize());
+  }
+
+  size_t cnt = 0;
+  while (cnt < buf.size())
+  {
+    ssize_t len = read(fd, &buf[cnt], buf.size() - cnt);
+    if (len < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      cerr << "*** ERROR: Read error on I/Q file \"" << filename << "\": "
+           << strerror(errno) << endl;
+      return false;
+    }
+    else if (len == 0)
+    {
+        // A partial block at the end of the file is thrown away
+      if (!loop || (lseek(fd, 0, SEEK_SET) < 0) || (block_cnt == 0))
+      {
+        endOfFile();
+        return false;
+      }
+      cnt = 0;
+      continue;
+    }
+    cnt += len;
+  }
+
+  ++block_cnt;
+  handleIq(reinterpret_cast<const complex<uint8_t>*>(&buf[0]),
+           buf.size() / 2);
+  return true;
+} /* RtlFile::readBlock */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -0,0 +1,250 @@
+/**
+@file	 RtlFile.h
+@brief   An RtlSdr implementation that replay I/Q samples from a file
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-04
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef RTL_FILE_INCLUDED
+#define RTL_FILE_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+#include <AsyncTimer.h>
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+#include "RtlSdr.h"
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+  
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief  An RtlSdr implementation that replay I/Q samples from a file
+@author Tobias Blomberg / SM0SVX
+@date   2020-07-04
+
+Use this class to feed previously recorded I/Q samples into the DDR signal
+chain instead of using a real dongle. The file format is the one written by
+the rtl_sdr utility, that is interleaved unsigned 8 bit I and Q values. The
+sample rate of the recording must be set using the setSampleRate function.
+All tuner settings, like center frequency and gain, are accepted but have no
+effect on the samples.
+
+The samples can either be replayed in real time, or a multiple of real time,
+or as fast as possible. The latter is useful for benchmarking the signal
+processing. When replaying as fast as possible, one block of samples is
+processed for each iteration of the main loop so that timers and other
+events are still handled.
+*/
+class RtlFile : public RtlSdr
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   filename The name of the file to read samples from
+     * @param   speed The replay speed relative to real time. Use a value
+     *                less than or equal to zero to replay as fast as possible.
+     * @param   loop  Set to \em true to start over when the end of the file
+     *                is reached
+     */
+    RtlFile(const std::string &filename, double speed=1.0, bool loop=true);
+  
+    /**
+     * @brief 	Destructor
+     */
+    virtual ~RtlFile(void);
+  
+    /**
+     * @brief   Find out if the RTL dongle is ready for operation
+     * @returns Returns \em true if the file could be opened
+     */
+    virtual bool isReady(void) const { return fd >= 0; }
+
+    /**
+     * @brief   Return a string which identifies the specific dongle
+     * @returns Returns the name of the file
+     */
+    virtual const std::string displayName(void) const { return filename; }
+
+    /**
+     * @brief   Get the number of sample blocks replayed so far
+     * @returns Returns the number of sample blocks emitted
+     */
+    uint64_t blockCount(void) const { return block_cnt; }
+
+    /**
+     * @brief   A signal that is emitted when the end of the file is reached
+     *
+     * This signal is only emitted when not looping. No more samples will be
+     * emitted after this signal.
+     */
+    sigc::signal<void> endOfFile;
+
+  protected:
+    /**
+     * @brief   Set tuner IF gain for the specified stage
+     * @param   stage The number of the gain stage to set
+     * @param   gain The gain in tenths of a dB to set (105=10.5dB)
+     */
+    virtual void handleSetTunerIfGain(uint16_t stage, int16_t gain) {}
+
+    /**
+     * @brief   Set the center frequency of the tuner
+     * @param   fq The new center frequency, in Hz, to set
+     */
+    virtual void handleSetCenterFq(uint32_t fq) {}
+
+    /**
+     * @brief   Set the tuner sample rate
+     * @param   rate The new sample, in Hz, rate to set
+     *
+     * The sample rate must match the rate used when recording the file.
+     */
+    virtual void handleSetSampleRate(uint32_t rate);
+
+    /**
+     * @brief   Set the gain mode
+     * @param   mode The gain mode to set: 0=automatic, 1=manual
+     */
+    virtual void handleSetGainMode(uint32_t mode) {}
+
+    /**
+     * @brief   Set manual gain
+     * @param   gain The gain in tenths of a dB to set (105=10.5dB)
+     */
+    virtual void handleSetGain(int32_t gain) {}
+
+    /**
+     * @brief   Set frequency correction factor
+     * @param   corr The frequency correction factor in PPM
+     */
+    virtual void handleSetFqCorr(int corr) {}
+
+    /**
+     * @brief   Enable or disable test mode
+     * @param   enable Set to \em true to enable testing
+     */
+    virtual void handleEnableTestMode(bool enable) {}
+
+    /**
+     * @brief   Enable or disable the digital AGC of the RTL2832
+     * @param   enable Set to \em true to enable the digital AGC
+     */
+    virtual void handleEnableDigitalAgc(bool enable) {}
+
+  private:
+    std::string           filename;
+    double                speed;
+    bool                  loop;
+    int                   fd;
+    Async::Timer          replay_timer;
+    std::vector<uint8_t>  buf;
+    struct timespec       next_block;
+    uint64_t              block_cnt;
+
+    RtlFile(const RtlFile&);
+    RtlFile& operator=(const RtlFile&);
+    void replayBlocks(void);
+    bool readBlock(void);
+    
+};  /* class RtlFile */
+
+
+
+//} /* namespace */
+
+#endif /* RTL_FILE_INCLUDED */
+
+
+/*
+ * This file has not been truncated
+ */
@@ -280,8 +280,9 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
 {
   //cout << "RtlSdr::handleIq: samp_count=" << samp_count << endl;
 
-  vector<Sample> iq;
-  iq.reserve(samp_count);
+    // The sample buffer is kept between calls so that no memory have to be
+    // allocated for each block
+  iq_buf.resize(samp_count);
   for (int idx=0; idx<samp_count; ++idx)
   {
     if ((dist_print_cnt == 0) &&
@@ -293,7 +294,7 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
     i = i / 127.5f - 1.0f;
     float q = samples[idx].imag();
     q = q / 127.5f - 1.0f;
-    iq.push_back(complex<float>(i, q));
+    iq_buf[idx] = complex<float>(i, q);
   }
 
   if (dist_print_cnt > 0)
@@ -310,7 +311,7 @@ void RtlSdr::handleIq(const complex<uint8_t> *samples, int samp_count)
     }
   }
 
-  iqReceived(iq);
+  iqReceived(iq_buf);
 } /* RtlSdr::handleIq */
 
 
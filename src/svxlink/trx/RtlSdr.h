@@ -294,9 +294,10 @@ class RtlSdr : public sigc::trackable
      *
      * Connecting to this signal is the way to get samples from the DVB-T
      * dongle. The format is a vector of complex floats (I/Q) with a range from
-     * -1 to 1.
+     * -1 to 1. The same vector is reused for every block so a receiver that
+     * need to keep the samples after returning from the slot must copy them.
      */
-    sigc::signal<void, std::vector<Sample> > iqReceived;
+    sigc::signal<void, const std::vector<Sample>&> iqReceived;
     
     /**
      * @brief   A signal that is emitted when the ready state changes
@@ -416,6 +417,7 @@ class RtlSdr : public sigc::trackable
     bool              use_digital_agc_set;
     bool              use_digital_agc;
     int               dist_print_cnt;
+    std::vector<Sample> iq_buf;
 
     RtlSdr(const RtlSdr&);
     RtlSdr& operator=(const RtlSdr&);
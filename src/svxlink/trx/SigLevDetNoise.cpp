@@ -34,7 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <cmath>
 #include <limits>
-//#include <iostream>
+#include <iostream>
 
 
 /****************************************************************************
@@ -158,6 +158,17 @@ bool SigLevDetNoise::initialize(Config &cfg, const string& name,
   cfg.getValue(name, "SIGLEV_OFFSET", offset);
   cfg.getValue(name, "SIGLEV_SLOPE", slope);
   cfg.getValue(name, "SIGLEV_BOGUS_THRESH", bogus_thresh);
+  double percentile = 0.0;
+  if (cfg.getValue(name, "SIGLEV_PERCENTILE", percentile))
+  {
+    if ((percentile < 0.0) || (percentile > 100.0))
+    {
+      cerr << "*** ERROR: Config variable " << name
+           << "/SIGLEV_PERCENTILE must be in the range 0 to 100\n";
+      return false;
+    }
+    setPercentile(percentile / 100.0);
+  }
 
   reset();
 
@@ -186,6 +197,12 @@ void SigLevDetNoise::setBogusThresh(float thresh)
 } /* SigLevDetNoise::setBogusThresh */
 
 
+void SigLevDetNoise::setPercentile(double percentile)
+{
+  ss_values.setPercentile(percentile);
+} /* SigLevDetNoise::setPercentile */
+
+
 void SigLevDetNoise::setContinuousUpdateInterval(int interval_ms)
 {
   update_interval = interval_ms * sample_rate / 1000;
@@ -200,24 +217,19 @@ void SigLevDetNoise::setIntegrationTime(int time_ms)
     time_ms = BLOCK_TIME;
   }
   integration_time = time_ms * sample_rate / 1000;
-
-  while (ss_idx.size() > integration_time / block_len)
-  {
-    ss_values.erase(*ss_idx.begin());
-    ss_idx.pop_front();
-  }
+  ss_values.setCapacity(integration_time / block_len);
 } /* SigLevDetNoise::setIntegrationTime */
 
 
 float SigLevDetNoise::lastSiglev(void) const
 {
-  if (ss_idx.empty())
+  if (ss_values.empty())
   {
     return 0.0f;
   }
 
     // Calculate the siglev value
-  float siglev = offset - slope * log10(*ss_idx.back());
+  float siglev = offset - slope * log10(ss_values.newest());
 
     // If the siglev value is way above 100 (like 120), it's probably bogus.
     // It's likely that this is caused by a closed squelch on the receiver or
@@ -227,7 +239,7 @@ float SigLevDetNoise::lastSiglev(void) const
     return 0.0f;
   }
 
-  return offset - slope * log10(*ss_idx.back());
+  return offset - slope * log10(ss_values.newest());
 
 } /* SigLevDetNoise::lastSiglev */
 
@@ -241,14 +253,15 @@ float SigLevDetNoise::siglevIntegrated(void) const
 
     // Calculate the siglev value.
     // Compensate for the over estimation of the siglev value caused by
-    // using the minimum value over the "integration time".
+    // using the minimum value over the "integration time". When using a
+    // higher percentile than the minimum, the over estimation is smaller.
     // The over estimation have been determined by a small number of
     // experiments so it may be wrong for some receivers.
     // The compensation may have to be determined for each receiver using
     // calibration but we'll try to have it hard coded for now.
     // If the BLOCK_TIME is changed, the compensation probably will have to
     // be changed too.
-  float siglev = offset - slope * (log10(*ss_values.begin()) + 0.25);
+  float siglev = offset - slope * (log10(ss_values.value()) + 0.25);
 
     // If the siglev value is way above 100 (like 120), it's probably bogus.
     // It's likely that this is caused by a closed squelch on the receiver or
@@ -268,7 +281,6 @@ void SigLevDetNoise::reset(void)
   filter->reset();
   update_counter = 0;
   ss_values.clear();
-  ss_idx.clear();
   ss_cnt = 0;
   ss = 0.0;
 } /* SigLevDetNoise::reset */
@@ -298,14 +310,7 @@ int SigLevDetNoise::processSamples(float *samples, int count)
     ss += square;
     if (++ss_cnt >= block_len)
     {
-      SsSetIter it = ss_values.insert(ss);
-      ss_idx.push_back(it);
-      if (ss_idx.size() > integration_time / block_len)
-      {
-        ss_values.erase(*ss_idx.begin());
-        ss_idx.pop_front();
-      }
-
+      ss_values.push(ss);
       ss = 0.0;
       ss_cnt = 0;
     }
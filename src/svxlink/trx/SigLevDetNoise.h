@@ -34,8 +34,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-#include <list>
-#include <set>
 #include <sigc++/sigc++.h>
 
 
@@ -55,6 +53,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "SigLevDet.h"
+#include "SlidingOrderStatistic.h"
 
 
 /****************************************************************************
@@ -167,6 +166,16 @@ class SigLevDetNoise : public SigLevDet
      * audio if possible.
      */
     void setBogusThresh(float thresh);
+
+    /**
+     * @brief   Set which percentile to use for the integrated signal level
+     * @param   percentile The percentile to use (0.0 - 1.0)
+     *
+     * The integrated signal level is calculated from the given percentile of
+     * the noise levels measured during the integration time. The default is
+     * 0.0, which mean that the lowest noise level is used.
+     */
+    void setPercentile(double percentile);
   
     /**
      * @brief	Set the interval for continuous updates
@@ -208,10 +217,6 @@ class SigLevDetNoise : public SigLevDet
   protected:
     
   private:
-    typedef std::multiset<double> SsSet;
-    typedef SsSet::const_iterator SsSetIter;
-    typedef std::list<SsSetIter>  SsIndexList;
-
     static const unsigned BLOCK_TIME          = 25;     // milliseconds
 
     unsigned                  sample_rate;
@@ -223,8 +228,7 @@ class SigLevDetNoise : public SigLevDet
     int			      update_interval;
     int			      update_counter;
     unsigned		      integration_time;
-    SsSet                     ss_values;
-    SsIndexList               ss_idx;
+    SlidingOrderStatistic<double> ss_values;
     double                    ss;
     unsigned                  ss_cnt;
     float                     bogus_thresh;
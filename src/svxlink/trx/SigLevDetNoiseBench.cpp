@@ -0,0 +1,182 @@
+#include <time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <set>
+#include <vector>
+
+#include "SlidingOrderStatistic.h"
+
+using namespace std;
+
+  // Benchmark the sliding window statistic used by the noise signal level
+  // detector for a number of window lengths. The old implementation, using a
+  // std::multiset and a list of iterators to find the minimum value in the
+  // window, is compared with the SlidingOrderStatistic class. The result
+  // from both implementations are compared for each pushed value. The
+  // SlidingOrderStatistic is also run for the median.
+  //
+  // The noise detector push one value per 25ms block so the time per pushed
+  // value is also given as the time per audio sample at 16kHz.
+  //
+  // Usage: SigLevDetNoiseBench [number of values]
+
+namespace {
+  const unsigned BLOCK_LEN = 25 * 16000 / 1000;
+
+  class RefMinWindow
+  {
+    public:
+      RefMinWindow(size_t capacity) : capacity(capacity) {}
+
+      void push(double val)
+      {
+        SsSetIter it = ss_values.insert(val);
+        ss_idx.push_back(it);
+        if (ss_idx.size() > capacity)
+        {
+          ss_values.erase(*ss_idx.begin());
+          ss_idx.pop_front();
+        }
+      }
+
+      double value(void) const { return *ss_values.begin(); }
+
+    private:
+      typedef std::multiset<double> SsSet;
+      typedef SsSet::const_iterator SsSetIter;
+      typedef std::list<SsSetIter>  SsIndexList;
+
+      size_t        capacity;
+      SsSet         ss_values;
+      SsIndexList   ss_idx;
+  };
+
+  double elapsed(const struct timespec &start)
+  {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) * 1.0e9 +
+           (end.tv_nsec - start.tv_nsec);
+  }
+
+  bool isMin(const vector<double> &values, size_t i, size_t capacity,
+             double val)
+  {
+    size_t first = (i + 1 > capacity) ? i + 1 - capacity : 0;
+    for (size_t j=first; j<=i; ++j)
+    {
+      if (values[j] < val)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+
+int main(int argc, char **argv)
+{
+  size_t count = (argc > 1) ? atoi(argv[1]) : 1000000;
+  if (count == 0)
+  {
+    cerr << "Usage: " << argv[0] << " [number of values]\n";
+    exit(1);
+  }
+
+  vector<double> values(count);
+  srand(1);
+  for (size_t i=0; i<count; ++i)
+  {
+    values[i] = 1.0e-3 * (1 + rand() % 10000);
+  }
+
+  printf("%6s %14s %14s %14s %14s\n", "Window", "Multiset min",
+         "Sliding min", "Sliding median", "Sample (min)");
+  printf("%6s %14s %14s %14s %14s\n", "", "ns/value", "ns/value",
+         "ns/value", "ns/sample");
+
+  const size_t windows[] = { 1, 4, 8, 16, 40, 100, 400, 1000 };
+  int ret = 0;
+  for (size_t w=0; w<sizeof(windows)/sizeof(*windows); ++w)
+  {
+    const size_t capacity = windows[w];
+
+    double ref_sum = 0.0;
+    RefMinWindow ref(capacity);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i=0; i<count; ++i)
+    {
+      ref.push(values[i]);
+      ref_sum += ref.value();
+    }
+    double ref_ns = elapsed(start) / count;
+
+    double min_sum = 0.0;
+    SlidingOrderStatistic<double> min_win(capacity, 0.0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i=0; i<count; ++i)
+    {
+      min_win.push(values[i]);
+      min_sum += min_win.value();
+    }
+    double min_ns = elapsed(start) / count;
+
+    double median_sum = 0.0;
+    SlidingOrderStatistic<double> median_win(capacity, 0.5);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i=0; i<count; ++i)
+    {
+      median_win.push(values[i]);
+      median_sum += median_win.value();
+    }
+    double median_ns = elapsed(start) / count;
+
+    printf("%6zu %14.1f %14.1f %14.1f %14.3f\n", capacity, ref_ns, min_ns,
+           median_ns, min_ns / BLOCK_LEN);
+
+    if (min_sum != ref_sum)
+    {
+      cerr << "*** ERROR: The minimum differ for window " << capacity
+           << endl;
+      ret = 1;
+    }
+
+      // Verify every pushed value for a shorter run
+    RefMinWindow check_ref(capacity);
+    SlidingOrderStatistic<double> check_min(capacity, 0.0);
+    SlidingOrderStatistic<double> check_median(capacity, 0.5);
+    for (size_t i=0; i<min(count, size_t(10000)); ++i)
+    {
+      check_ref.push(values[i]);
+      check_min.push(values[i]);
+      check_median.push(values[i]);
+      if ((check_min.value() != check_ref.value()) ||
+          !isMin(values, i, capacity, check_min.value()) ||
+          (check_min.newest() != values[i]))
+      {
+        cerr << "*** ERROR: Bad minimum at value " << i << " for window "
+             << capacity << endl;
+        ret = 1;
+        break;
+      }
+      size_t first = (i + 1 > capacity) ? i + 1 - capacity : 0;
+      multiset<double> win(values.begin() + first, values.begin() + i + 1);
+      multiset<double>::const_iterator it = win.begin();
+      advance(it, (win.size() - 1) / 2);
+      if (check_median.value() != *it)
+      {
+        cerr << "*** ERROR: Bad median at value " << i << " for window "
+             << capacity << endl;
+        ret = 1;
+        break;
+      }
+    }
+  }
+
+  return ret;
+}
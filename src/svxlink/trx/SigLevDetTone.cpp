@@ -44,7 +44,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include <AsyncConfig.h>
-#include <AsyncSigCAudioSink.h>
 #include <AsyncAudioFilter.h>
 #include <common.h>
 
@@ -56,7 +55,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "SigLevDetTone.h"
-#include "Goertzel.h"
 
 
 
@@ -161,25 +159,16 @@ class SigLevDetTone::HammingWindow
  ****************************************************************************/
 
 SigLevDetTone::SigLevDetTone(void)
-  : sample_rate(0), tone_siglev_map(10), block_idx(0), last_siglev(0),
-    passband_energy(0.0f), filter(0), prev_peak_to_tot_pwr(0.0f),
-    integration_time(1), update_interval(0), update_counter(0)
+  : sample_rate(0), tone_siglev_map(10), last_siglev(0), filter(0),
+    prev_peak_to_tot_pwr(0.0f), integration_time(1), update_interval(0),
+    update_counter(0)
 {
-  for (int i=0; i<10; ++i)
-  {
-    det[i] = 0;
-  }
 } /* SigLevDetTone::SigLevDetTone */
 
 
 SigLevDetTone::~SigLevDetTone(void)
 {
   delete filter;
-
-  for (int i=0; i<10; ++i)
-  {
-    delete det[i];
-  }
 } /* SigLevDetTone::~SigLevDetTone */
 
 
@@ -202,18 +191,17 @@ bool SigLevDetTone::initialize(Config &cfg, const string& name, int sample_rate)
   filter = new AudioFilter("BpBu8/5400-6500", sample_rate);
   setHandler(filter);
 
-  SigCAudioSink *sigc_sink = new SigCAudioSink;
-  sigc_sink->sigWriteSamples.connect(
-      mem_fun(*this, &SigLevDetTone::processSamples));
-  sigc_sink->sigFlushSamples.connect(
-      mem_fun(*sigc_sink, &SigCAudioSink::allSamplesFlushed));
-  filter->registerSink(sigc_sink, true);
+  GoertzelBank *bank = new GoertzelBank(sample_rate);
+  filter->registerSink(bank, true);
+  bank->addSubscriber(this);
 
+  float fqs[10];
   for (int i=0; i<10; ++i)
   {
-    det[i] = new Goertzel(5500 + i * 100, sample_rate);
+    fqs[i] = 5500 + i * 100;
     tone_siglev_map[i] = 100 - i * 10;
   }
+  setBins(fqs, 10);
   reset();
 
   string mapstr;
@@ -235,13 +223,9 @@ bool SigLevDetTone::initialize(Config &cfg, const string& name, int sample_rate)
 
 void SigLevDetTone::reset(void)
 {
-  for (int i=0; i<10; ++i)
-  {
-    det[i]->reset();
-  }
-  block_idx = 0;
+  resetBins();
+  setEventDelay(BLOCK_SIZE);
   last_siglev = 0;
-  passband_energy = 0.0f;
   prev_peak_to_tot_pwr = 0.0f;
   update_counter = 0;
   siglev_values.clear();
@@ -298,107 +282,88 @@ float SigLevDetTone::siglevIntegrated(void) const
  *
  ****************************************************************************/
 
-int SigLevDetTone::processSamples(const float *samples, int count)
+void SigLevDetTone::processEvent(void)
 {
-  for (int i=0; i<count; ++i)
+  float max = 0.0f;
+  int max_idx = -1;
+  for (int detno=0; detno < 10; ++detno)
   {
-    const float &sample = samples[i];
-
-    passband_energy += sample * sample;
-
-    for (int detno=0; detno < 10; ++detno)
+    float res = magnitudeSquared(detno);
+    if (res > max)
     {
-      det[detno]->calc(sample);
+      max = res;
+      max_idx = detno;
     }
-    
-    if (++block_idx == BLOCK_SIZE)
-    {
-      float max = 0.0f;
-      int max_idx = -1;
-      for (int detno=0; detno < 10; ++detno)
-      {
-        float res = det[detno]->magnitudeSquared();
-        det[detno]->reset();
-        if (res > max)
-        {
-          max = res;
-          max_idx = detno;
-        }
-      }
+  }
 
-      last_siglev = 0;
+  last_siglev = 0;
 
-        // Check that we have enough energy in the tone to do a
-        // proper detection
-      if (max > ENERGY_THRESH)
-      {
-          // Calculate the coefficient used to get from relative magnitude
-          // squared to the "peak to total power" relation.
-        float coeff = 2.0f / (BLOCK_SIZE * passband_energy);
-
-          // Calculate the peak to total bandpass power relation
-        float peak_to_tot_pwr = coeff * max;
-        
-          // Filter it using a first order IIR filter.
-        peak_to_tot_pwr = prev_peak_to_tot_pwr
-                          + ALPHA * (peak_to_tot_pwr - prev_peak_to_tot_pwr);
-        prev_peak_to_tot_pwr = peak_to_tot_pwr;
-
-          // If the relation value is larger than 1.5 it's probably a bogus
-          // value. In theory, the relation value should never exceed 1.0.
-        if (peak_to_tot_pwr < 1.5f)
-        {
+    // Check that we have enough energy in the tone to do a
+    // proper detection
+  if (max > ENERGY_THRESH)
+  {
+      // Calculate the coefficient used to get from relative magnitude
+      // squared to the "peak to total power" relation.
+    float coeff = 2.0f / (BLOCK_SIZE * energy());
+
+      // Calculate the peak to total bandpass power relation
+    float peak_to_tot_pwr = coeff * max;
+    
+      // Filter it using a first order IIR filter.
+    peak_to_tot_pwr = prev_peak_to_tot_pwr
+                      + ALPHA * (peak_to_tot_pwr - prev_peak_to_tot_pwr);
+    prev_peak_to_tot_pwr = peak_to_tot_pwr;
+
+      // If the relation value is larger than 1.5 it's probably a bogus
+      // value. In theory, the relation value should never exceed 1.0.
+    if (peak_to_tot_pwr < 1.5f)
+    {
 #if 0
-            // The tone frequency may be offset so that energy spill into
-            // neighbouring bins. Check the bin above and below to see if
-            // adding the energy from either bin will get us above the
-            // threshold. Subtract the other bin to compensate a bit.
-          float lo_peak_to_tot_pwr = 0.0f, hi_peak_to_tot_pwr = 0.0f;
-          if (max_idx > 0)
-          {
-            lo_peak_to_tot_pwr = coeff * det[max_idx-1];
-          }
-          if (max_idx < 9)
-          {
-            hi_peak_to_tot_pwr = coeff * det[max_idx+1];
-          }
-          peak_to_tot_pwr += max(lo_peak_to_tot_pwr - hi_peak_to_tot_pwr,
-                                 hi_peak_to_tot_pwr - lo_peak_to_tot_pwr);
-#endif
-          if (peak_to_tot_pwr > DET_THRESH)
-          {
-            last_siglev = tone_siglev_map[max_idx];
-            //printf("fq=%d  max=%f  siglev=%d  quality=%.1f\n",
-            //       5500 + max_idx * 100, max, last_siglev, peak_to_tot_pwr);
-          }
-        }
+        // The tone frequency may be offset so that energy spill into
+        // neighbouring bins. Check the bin above and below to see if
+        // adding the energy from either bin will get us above the
+        // threshold. Subtract the other bin to compensate a bit.
+      float lo_peak_to_tot_pwr = 0.0f, hi_peak_to_tot_pwr = 0.0f;
+      if (max_idx > 0)
+      {
+        lo_peak_to_tot_pwr = coeff * magnitudeSquared(max_idx-1);
       }
-
-      siglev_values.push_back(last_siglev);
-      if (siglev_values.size() > integration_time)
+      if (max_idx < 9)
       {
-	siglev_values.erase(siglev_values.begin(),
-		siglev_values.begin()+siglev_values.size()-integration_time);
+        hi_peak_to_tot_pwr = coeff * magnitudeSquared(max_idx+1);
       }
-      
-      if (update_interval > 0)
+      peak_to_tot_pwr += max(lo_peak_to_tot_pwr - hi_peak_to_tot_pwr,
+                             hi_peak_to_tot_pwr - lo_peak_to_tot_pwr);
+#endif
+      if (peak_to_tot_pwr > DET_THRESH)
       {
-	update_counter += BLOCK_SIZE;
-	if (update_counter >= update_interval)
-	{
-	  signalLevelUpdated(siglevIntegrated());
-	  update_counter = 0;
-	}
+        last_siglev = tone_siglev_map[max_idx];
+        //printf("fq=%d  max=%f  siglev=%d  quality=%.1f\n",
+        //       5500 + max_idx * 100, max, last_siglev, peak_to_tot_pwr);
       }
-
-      passband_energy = 0.0f;
-      block_idx = 0;
     }
   }
+
+  siglev_values.push_back(last_siglev);
+  if (siglev_values.size() > integration_time)
+  {
+    siglev_values.erase(siglev_values.begin(),
+    	siglev_values.begin()+siglev_values.size()-integration_time);
+  }
   
-  return count;
-  
-} /* SigLevDetTone::processSamples */
+  if (update_interval > 0)
+  {
+    update_counter += BLOCK_SIZE;
+    if (update_counter >= update_interval)
+    {
+      signalLevelUpdated(siglevIntegrated());
+      update_counter = 0;
+    }
+  }
+
+  resetBins();
+  setEventDelay(BLOCK_SIZE);
+} /* SigLevDetTone::processEvent */
 
 
 
@@ -55,6 +55,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "SigLevDet.h"
+#include "GoertzelBank.h"
 
 
 /****************************************************************************
@@ -68,8 +69,6 @@ namespace Async
   class AudioFilter;
 };
 
-class Goertzel;
-
 
 /****************************************************************************
  *
@@ -124,7 +123,7 @@ locally measured signal strength. The received tone is then translated by this
 class to a signal level value that can be compared to signal level measurements
 from other receivers.
 */
-class SigLevDetTone : public SigLevDet
+class SigLevDetTone : public SigLevDet, private GoertzelBank::Subscriber
 {
   public:
       /// The name of this class when used by the object factory
@@ -198,10 +197,7 @@ class SigLevDetTone : public SigLevDet
 
     int	                sample_rate;
     std::vector<int>    tone_siglev_map;
-    Goertzel            *det[10];
-    unsigned            block_idx;
     int                 last_siglev;
-    float               passband_energy;
     Async::AudioFilter  *filter;
     float               prev_peak_to_tot_pwr;
     unsigned            integration_time;
@@ -211,7 +207,7 @@ class SigLevDetTone : public SigLevDet
     
     SigLevDetTone(const SigLevDetTone&);
     SigLevDetTone& operator=(const SigLevDetTone&);
-    int processSamples(const float *samples, int count);
+    virtual void processEvent(void);
     
 };  /* class SigLevDetTone */
 
@@ -0,0 +1,408 @@
+/**
+@file	 SlidingOrderStatistic.h
+@brief   A percentile over a sliding window of values
+@author  Tobias Blomberg / SM0SVX
+@date	 2020-07-11
+
+\verbatim
+SvxLink - A Multi Purpose Voice Services System for Ham Radio Use
+Copyright (C) 2003-2020 Tobias Blomberg / SM0SVX
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+\endverbatim
+*/
+
+#ifndef SLIDING_ORDER_STATISTIC_INCLUDED
+#define SLIDING_ORDER_STATISTIC_INCLUDED
+
+
+/****************************************************************************
+ *
+ * System Includes
+ *
+ ****************************************************************************/
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+
+
+/****************************************************************************
+ *
+ * Project Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Local Includes
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Forward declarations
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Namespace
+ *
+ ****************************************************************************/
+
+//namespace MyNameSpace
+//{
+
+
+/****************************************************************************
+ *
+ * Forward declarations of classes inside of the declared namespace
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Defines & typedefs
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Exported Global Variables
+ *
+ ****************************************************************************/
+
+
+
+/****************************************************************************
+ *
+ * Class definitions
+ *
+ ****************************************************************************/
+
+/**
+@brief	A percentile over a sliding window of values
+@author Tobias Blomberg / SM0SVX
+@date   2020-07-11
+
+This class keep track of the last N values pushed into it and can at any
+time return a given percentile of them, e.g. the minimum, the median or the
+maximum. The values are stored in a circular buffer and are split in two
+binary heaps. The lower heap is a max-heap containing all values up to and
+including the requested percentile and the upper heap is a min-heap
+containing the rest. Each value know its position in its heap so that the
+oldest value can be removed in O(log N) time when a new value is pushed.
+
+All memory is allocated when the capacity is set so pushing values never
+allocate memory.
+*/
+template <typename T>
+class SlidingOrderStatistic
+{
+  public:
+    /**
+     * @brief 	Constructor
+     * @param   capacity    The number of values in the window
+     * @param   percentile  The percentile to calculate (0.0 - 1.0)
+     */
+    explicit SlidingOrderStatistic(size_t capacity=1, double percentile=0.0)
+      : m_percentile(percentile), m_head(0), m_count(0), m_lo_size(0),
+        m_hi_size(0)
+    {
+      setCapacity(capacity);
+    }
+
+    /**
+     * @brief   Set the number of values in the window
+     * @param   capacity The new window size
+     *
+     * If the window currently contain more values than the new capacity,
+     * the oldest values are thrown away.
+     */
+    void setCapacity(size_t capacity)
+    {
+      assert(capacity > 0);
+      std::vector<T> keep;
+      keep.reserve(m_count);
+      const size_t drop = (m_count > capacity) ? m_count - capacity : 0;
+      for (size_t i=drop; i<m_count; ++i)
+      {
+        keep.push_back(m_slots[slotIdx(i)].val);
+      }
+      m_slots.resize(capacity);
+      m_lo.resize(capacity);
+      m_hi.resize(capacity);
+      clear();
+      for (size_t i=0; i<keep.size(); ++i)
+      {
+        push(keep[i]);
+      }
+    }
+
+    /**
+     * @brief   Get the number of values in the window
+     * @returns Returns the window size
+     */
+    size_t capacity(void) const { return m_slots.size(); }
+
+    /**
+     * @brief   Set which percentile to calculate
+     * @param   percentile The percentile to calculate (0.0 - 1.0)
+     *
+     * A percentile of 0.0 give the minimum value in the window, 0.5 give the
+     * median and 1.0 give the maximum. When the percentile fall between two
+     * values, the lower one is used.
+     */
+    void setPercentile(double percentile)
+    {
+      assert((percentile >= 0.0) && (percentile <= 1.0));
+      m_percentile = percentile;
+      rebalance();
+    }
+
+    /**
+     * @brief   Get the percentile that is calculated
+     * @returns Returns the percentile (0.0 - 1.0)
+     */
+    double percentile(void) const { return m_percentile; }
+
+    /**
+     * @brief   Remove all values
+     */
+    void clear(void)
+    {
+      m_head = 0;
+      m_count = 0;
+      m_lo_size = 0;
+      m_hi_size = 0;
+    }
+
+    /**
+     * @brief   Find out if the window is empty
+     * @returns Returns \em true if no values have been pushed
+     */
+    bool empty(void) const { return m_count == 0; }
+
+    /**
+     * @brief   Get the number of values currently in the window
+     * @returns Returns the number of values
+     */
+    size_t size(void) const { return m_count; }
+
+    /**
+     * @brief   Add a value to the window
+     * @param   val The value to add
+     *
+     * If the window is full, the oldest value is removed.
+     */
+    void push(const T& val)
+    {
+      if (m_count == capacity())
+      {
+        remove(m_head);
+        --m_count;
+      }
+      const size_t slot = m_head;
+      m_head = (m_head + 1 == capacity()) ? 0 : m_head + 1;
+      m_slots[slot].val = val;
+      if ((m_lo_size > 0) && !(m_slots[m_lo[0]].val < val))
+      {
+        insert(true, slot);
+      }
+      else
+      {
+        insert(false, slot);
+      }
+      ++m_count;
+      rebalance();
+    }
+
+    /**
+     * @brief   Get the value at the configured percentile
+     * @returns Returns the percentile of the values in the window
+     *
+     * The window must not be empty.
+     */
+    const T& value(void) const
+    {
+      assert(!empty());
+      return m_slots[m_lo[0]].val;
+    }
+
+    /**
+     * @brief   Get the last pushed value
+     * @returns Returns the newest value in the window
+     *
+     * The window must not be empty.
+     */
+    const T& newest(void) const
+    {
+      assert(!empty());
+      return m_slots[slotIdx(m_count - 1)].val;
+    }
+
+  private:
+    struct Slot
+    {
+      T       val;
+      bool    in_lo;
+      size_t  pos;
+    };
+
+    std::vector<Slot>   m_slots;
+    std::vector<size_t> m_lo;
+    std::vector<size_t> m_hi;
+    double              m_percentile;
+    size_t              m_head;
+    size_t              m_count;
+    size_t              m_lo_size;
+    size_t              m_hi_size;
+
+      // Return the slot of the i:th oldest value in the window
+    size_t slotIdx(size_t i) const
+    {
+      size_t slot = m_head + capacity() - m_count + i;
+      return (slot >= capacity()) ? slot - capacity() : slot;
+    }
+
+      // Return true if slot a should be closer to the top of the heap than b
+    bool above(bool lo, size_t a, size_t b) const
+    {
+      return lo ? (m_slots[b].val < m_slots[a].val)
+                : (m_slots[a].val < m_slots[b].val);
+    }
+
+    void place(bool lo, size_t pos, size_t slot)
+    {
+      (lo ? m_lo : m_hi)[pos] = slot;
+      m_slots[slot].in_lo = lo;
+      m_slots[slot].pos = pos;
+    }
+
+    void siftUp(bool lo, size_t pos)
+    {
+      std::vector<size_t> &heap = lo ? m_lo : m_hi;
+      const size_t slot = heap[pos];
+      while (pos > 0)
+      {
+        const size_t parent = (pos - 1) / 2;
+        if (!above(lo, slot, heap[parent]))
+        {
+          break;
+        }
+        place(lo, pos, heap[parent]);
+        pos = parent;
+      }
+      place(lo, pos, slot);
+    }
+
+    void siftDown(bool lo, size_t pos)
+    {
+      std::vector<size_t> &heap = lo ? m_lo : m_hi;
+      const size_t size = lo ? m_lo_size : m_hi_size;
+      const size_t slot = heap[pos];
+      for (;;)
+      {
+        size_t child = 2 * pos + 1;
+        if (child >= size)
+        {
+          break;
+        }
+        if ((child + 1 < size) && above(lo, heap[child + 1], heap[child]))
+        {
+          ++child;
+        }
+        if (!above(lo, heap[child], slot))
+        {
+          break;
+        }
+        place(lo, pos, heap[child]);
+        pos = child;
+      }
+      place(lo, pos, slot);
+    }
+
+    void insert(bool lo, size_t slot)
+    {
+      size_t &size = lo ? m_lo_size : m_hi_size;
+      place(lo, size, slot);
+      siftUp(lo, size++);
+    }
+
+    void remove(size_t slot)
+    {
+      const bool lo = m_slots[slot].in_lo;
+      const std::vector<size_t> &heap = lo ? m_lo : m_hi;
+      size_t &size = lo ? m_lo_size : m_hi_size;
+      const size_t pos = m_slots[slot].pos;
+      const size_t last = heap[--size];
+      if (pos < size)
+      {
+        place(lo, pos, last);
+        siftUp(lo, pos);
+        siftDown(lo, m_slots[last].pos);
+      }
+    }
+
+      // Move values between the heaps so that the top of the lower heap is
+      // the value at the requested percentile
+    void rebalance(void)
+    {
+      if (m_count == 0)
+      {
+        return;
+      }
+      const size_t lo_want =
+        static_cast<size_t>(m_percentile * (m_count - 1)) + 1;
+      while (m_lo_size > lo_want)
+      {
+        const size_t slot = m_lo[0];
+        remove(slot);
+        insert(false, slot);
+      }
+      while (m_lo_size < lo_want)
+      {
+        const size_t slot = m_hi[0];
+        remove(slot);
+        insert(true, slot);
+      }
+    }
+
+    SlidingOrderStatistic(const SlidingOrderStatistic&);
+    SlidingOrderStatistic& operator=(const SlidingOrderStatistic&);
+
+};  /* class SlidingOrderStatistic */
+
+
+//} /* namespace */
+
+#endif /* SLIDING_ORDER_STATISTIC_INCLUDED */
+
+
+
+/*
+ * This file has not been truncated
+ */
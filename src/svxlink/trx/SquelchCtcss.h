@@ -49,7 +49,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <AsyncConfig.h>
 #include <AsyncAudioFilter.h>
-#include <AsyncAudioSplitter.h>
 
 
 /****************************************************************************
@@ -59,6 +58,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "ToneDetector.h"
+#include "GoertzelBank.h"
 #include "Squelch.h"
 
 
@@ -117,7 +117,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 This squelch detector use tone detectors to detect the presence of one or more
 CTCSS squelch tones. The actual tone detector is implemented outside of this
-class.
+class. All tone detectors share one band pass filter and one Goertzel bank.
 */
 class SquelchCtcss : public Squelch
 {
@@ -129,14 +129,14 @@ class SquelchCtcss : public Squelch
      * @brief 	Default constuctor
      */
     explicit SquelchCtcss(void)
-      : m_splitter(0), m_active_det(0), m_ctcss_snr_offset(0.0f) {}
+      : m_bank(0), m_sink(0), m_active_det(0), m_ctcss_snr_offset(0.0f) {}
 
     /**
      * @brief 	Destructor
      */
     virtual ~SquelchCtcss(void)
     {
-      delete m_splitter;
+      delete m_sink;
     }
 
     /**
@@ -210,7 +210,19 @@ class SquelchCtcss : public Squelch
 	return false;
       }
 
-      m_splitter = new Async::AudioSplitter;
+        // All tone detectors use the same Goertzel bank. In all modes but
+        // the neighbour bins mode, the bank is fed through a CTCSS band pass
+        // filter.
+      m_bank = new GoertzelBank;
+      m_sink = m_bank;
+      if (ctcss_mode != 1)
+      {
+        std::stringstream filter_spec;
+        filter_spec << "BpBu8/" << bpf_low << "-" << bpf_high;
+        Async::AudioFilter *filter = new Async::AudioFilter(filter_spec.str());
+        filter->registerSink(m_bank, true);
+        m_sink = filter;
+      }
 
       for (FqList::const_iterator it = ctcss_fqs.begin();
            it != ctcss_fqs.end(); ++it)
@@ -232,13 +244,9 @@ class SquelchCtcss : public Squelch
         {
           det->snrUpdated.connect(snrUpdated.make_slot());
         }
-        Async::AudioSink *sink = det;
 
         m_dets.push_back(det);
 
-        std::stringstream filter_spec;
-        filter_spec << "BpBu8/" << bpf_low << "-" << bpf_high;
-
         switch (ctcss_mode)
         {
           case 1:
@@ -267,12 +275,6 @@ class SquelchCtcss : public Squelch
             det->setUndetectSnrThresh(close_thresh, bpf_high - bpf_low);
             det->setUndetectStableCountThresh(2);
             //det->setUndetectPhaseBwThresh(4.0f, 16.0f);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
 
@@ -293,17 +295,11 @@ class SquelchCtcss : public Squelch
             //det->setUndetectPeakToTotPwrThresh(0.3f);
             det->setUndetectSnrThresh(close_thresh, bpf_high - bpf_low);
             det->setUndetectStableCountThresh(2);
-
-              // Set up CTCSS band pass filter
-            Async::AudioFilter *filter =
-              new Async::AudioFilter(filter_spec.str());
-            filter->registerSink(det, true);
-            sink = filter;
             break;
           }
         }
 
-        m_splitter->addSink(sink, true);
+        m_bank->addSubscriber(det, true);
       }
 
       bool debug = false;
@@ -365,7 +361,7 @@ class SquelchCtcss : public Squelch
      */
     int processSamples(const float *samples, int count)
     {
-      return m_splitter->writeSamples(samples, count);
+      return m_sink->writeSamples(samples, count);
     }
 
     /**
@@ -384,7 +380,8 @@ class SquelchCtcss : public Squelch
     typedef std::vector<ToneDetector*> DetList;
 
     DetList                 m_dets;
-    Async::AudioSplitter *  m_splitter;
+    GoertzelBank *          m_bank;
+    Async::AudioSink *      m_sink;
     ToneDetector *          m_active_det;
     float                   m_ctcss_snr_offset;
 
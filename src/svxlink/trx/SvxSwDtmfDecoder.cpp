@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include <iomanip>
 #include <cmath>
 #include <cstring>
+#include <algorithm>
 
 
 /****************************************************************************
@@ -161,6 +162,13 @@ SvxSwDtmfDecoder::SvxSwDtmfDecoder(Config &cfg, const string &name)
   }
   win_pwr_comp /= BLOCK_SIZE;
   win_pwr_comp = 1.0f / win_pwr_comp;
+
+    // Set up one block detector for each block phase, each starting one
+    // step after the previous one
+  for (size_t start=0; start<BLOCK_SIZE; start+=STEP_SIZE)
+  {
+    bank.addSubscriber(new BlockDet(this, start), true);
+  }
 } /* SvxSwDtmfDecoder::SvxSwDtmfDecoder */
 
 
@@ -209,12 +217,19 @@ bool SvxSwDtmfDecoder::initialize(void)
 
 int SvxSwDtmfDecoder::writeSamples(const float *buf, int len)
 {
-  for (int i = 0; i < len; i++)
+  size_t left = len;
+  while (left > 0)
   {
-    block[block_pos] = buf[i];
-    if (++block_pos >= BLOCK_SIZE)
+      // The samples are stored in the block buffer, which is used by the
+      // overtone and intermodulation checks, and then fed to the Goertzel
+      // bank. Each piece end where a block end so that the block buffer is
+      // up to date when the block is processed.
+    size_t cnt = min(left, BLOCK_SIZE - block_pos);
+    memcpy(block + block_pos, buf, cnt * sizeof(*buf));
+    block_pos += cnt;
+    bank.writeSamples(buf, cnt);
+    if (block_pos >= BLOCK_SIZE)
     {
-      processBlock();
       if (STEP_SIZE < BLOCK_SIZE)
       {
         memmove(block, block + STEP_SIZE,
@@ -222,6 +237,8 @@ int SvxSwDtmfDecoder::writeSamples(const float *buf, int len)
       }
       block_pos = BLOCK_SIZE - STEP_SIZE;
     }
+    buf += cnt;
+    left -= cnt;
   }
 
   return len;
@@ -241,34 +258,11 @@ int SvxSwDtmfDecoder::writeSamples(const float *buf, int len)
  *
  ****************************************************************************/
 
-void SvxSwDtmfDecoder::processBlock(void)
+void SvxSwDtmfDecoder::processBlock(const BlockDet &det)
 {
-    // Reset all Goertzel objects
-  row[0].reset();
-  row[1].reset();
-  row[2].reset();
-  row[3].reset();
-  col[0].reset();
-  col[1].reset();
-  col[2].reset();
-  col[3].reset();
-
-    // Calculate the total block energy and energy for all individual
-    // Goertzel detectors over the block
-  double block_energy = 0.0;
-  for (size_t i=0; i<BLOCK_SIZE; ++i)
-  {
-    float sample = block[i] * win[i];
-    block_energy += sample * sample;
-    row[0].calc(sample);
-    row[1].calc(sample);
-    row[2].calc(sample);
-    row[3].calc(sample);
-    col[0].calc(sample);
-    col[1].calc(sample);
-    col[2].calc(sample);
-    col[3].calc(sample);
-  }
+    // The total block energy and the energy for all individual Goertzel
+    // bins over the block have been calculated by the Goertzel bank
+  double block_energy = det.energy();
   ios_base::fmtflags orig_cout_flags(cout.flags());
   if (debug)
   {
@@ -301,7 +295,7 @@ void SvxSwDtmfDecoder::processBlock(void)
     float col_sum = 0.0f;
     for (size_t i = 0; i < 4; ++i)
     {
-      const float row_ms = WIN_ENB * row[i].magnitudeSquared();
+      const float row_ms = WIN_ENB * det.magnitudeSquared(i);
       if (row_ms > max_row_ms)
       {
         max_row_ms = row_ms;
@@ -309,7 +303,7 @@ void SvxSwDtmfDecoder::processBlock(void)
       }
       row_sum += row_ms;
 
-      const float col_ms = WIN_ENB * col[i].magnitudeSquared();
+      const float col_ms = WIN_ENB * det.magnitudeSquared(4 + i);
       if (col_ms > max_col_ms)
       {
         max_col_ms = col_ms;
@@ -586,6 +580,33 @@ void SvxSwDtmfDecoder::DtmfGoertzel::initialize(float freq)
 } /* SvxSwDtmfDecoder::DtmfGoertzel::initialize */
 
 
+SvxSwDtmfDecoder::BlockDet::BlockDet(SvxSwDtmfDecoder *dec,
+                                     size_t start_delay)
+  : m_dec(dec), m_started(start_delay == 0)
+{
+  float fqs[8];
+  copy(row_fqs, row_fqs + 4, fqs);
+  copy(col_fqs, col_fqs + 4, fqs + 4);
+  setBins(fqs, 8);
+  setWindow(m_dec->win);
+  setEventDelay(m_started ? BLOCK_SIZE : start_delay);
+} /* SvxSwDtmfDecoder::BlockDet::BlockDet */
+
+
+void SvxSwDtmfDecoder::BlockDet::processEvent(void)
+{
+    // The first event for a detector that start later than the first one
+    // only mark the start of its first block
+  if (m_started)
+  {
+    m_dec->processBlock(*this);
+  }
+  m_started = true;
+  resetBins();
+  setEventDelay(BLOCK_SIZE);
+} /* SvxSwDtmfDecoder::BlockDet::processEvent */
+
+
 /*
  * This file has not been truncated
  */
@@ -57,6 +57,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "DtmfDecoder.h"
 #include "Goertzel.h"
+#include "GoertzelBank.h"
 
 
 /****************************************************************************
@@ -104,7 +105,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  * @date    2015-02-22
  *
  * This class implements a software DTMF decoder implemented using Goertzel's
- * algorithm.
+ * algorithm. The blocks are overlapping so one Goertzel bank subscriber is
+ * used for each block phase. The bank then run the eight tone bins of all
+ * phases in one pass over the samples.
  */   
 class SvxSwDtmfDecoder : public DtmfDecoder
 {
@@ -172,6 +175,19 @@ class SvxSwDtmfDecoder : public DtmfDecoder
 
       void initialize(float freq);
     };
+    class BlockDet : public GoertzelBank::Subscriber
+    {
+      public:
+        BlockDet(SvxSwDtmfDecoder *dec, size_t start_delay);
+        using GoertzelBank::Subscriber::magnitudeSquared;
+        using GoertzelBank::Subscriber::energy;
+
+      private:
+        SvxSwDtmfDecoder *m_dec;
+        bool              m_started;
+
+        virtual void processEvent(void);
+    };
     typedef enum
     {
       STATE_IDLE, STATE_DET_DELAY, STATE_DETECTED
@@ -215,9 +231,10 @@ class SvxSwDtmfDecoder : public DtmfDecoder
     size_t undet_thresh;
     bool debug;
     float win_pwr_comp;
+    GoertzelBank bank;
 
 
-    void processBlock(void);
+    void processBlock(const BlockDet &det);
 
 };  /* class SvxSwDtmfDecoder */
 
@@ -56,7 +56,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  ****************************************************************************/
 
 #include "ToneDetector.h"
-#include "Goertzel.h"
 
 
 
@@ -96,9 +95,6 @@ struct ToneDetector::DetectorParams
   float		      phase_mean_thresh;
   float		      phase_var_thresh;
   float		      phase_actual_fq;
-  Goertzel	      center;
-  Goertzel	      lower;
-  Goertzel	      upper;
   std::vector<float>  window_table;
   bool		      use_windowing;
   float		      peak_to_tot_pwr_thresh;
@@ -141,7 +137,7 @@ struct ToneDetector::DetectorParams
 ToneDetector::ToneDetector(float tone_hz, float width_hz, int det_delay_ms)
   : tone_fq(tone_hz), samples_left(0), is_activated(false),
     last_active(false), stable_count(0), phase_check_left(-1),
-    par(0), last_snr(0.0f)
+    par(0), last_snr(0.0f), event_delay(0)
 {
   det_par = new DetectorParams;
   det_par->bw = width_hz;
@@ -208,21 +204,7 @@ void ToneDetector::reset(void)
   setActivated(false);
   last_active = false;
   stable_count = 0;
-  samples_left = par->block_len;
-
-    // Point to the first windowing table entry
-  win = par->window_table.begin();
-
-    // Reset Goertzel filters
-  par->center.reset();
-  par->lower.reset();
-  par->upper.reset();
-
-    // Reset phase check state variables
-  phaseCheckReset();
-
-    // Reset the passband energy
-  passband_energy = 0.0f;
+  restartBlock();
 } /* ToneDetector::reset */
 
 
@@ -300,9 +282,10 @@ void ToneDetector::setDetectBw(float bw_hz)
     }
   }
 
-  det_par->center.initialize(tone_fq, INTERNAL_SAMPLE_RATE);
-  det_par->lower.initialize(tone_fq - 2 * bw_hz, INTERNAL_SAMPLE_RATE);
-  det_par->upper.initialize(tone_fq + 2 * bw_hz, INTERNAL_SAMPLE_RATE);
+  if (par == det_par)
+  {
+    restartBlock();
+  }
   
 } /* ToneDetector::setDetectBw */
 
@@ -326,9 +309,10 @@ void ToneDetector::setUndetectBw(float bw_hz)
     }
   }
 
-  undet_par->center.initialize(tone_fq, INTERNAL_SAMPLE_RATE);
-  undet_par->lower.initialize(tone_fq - 2 * bw_hz, INTERNAL_SAMPLE_RATE);
-  undet_par->upper.initialize(tone_fq + 2 * bw_hz, INTERNAL_SAMPLE_RATE);
+  if (par == undet_par)
+  {
+    restartBlock();
+  }
 
 } /* ToneDetector::setUndetectBw */
 
@@ -350,6 +334,10 @@ void ToneDetector::setDetectPeakThresh(float thresh)
   {
     det_par->peak_thresh = 0.0f;
   }
+  if (par == det_par)
+  {
+    restartBlock();
+  }
 } /* ToneDetector::setDetectPeakThresh */
 
 
@@ -363,6 +351,10 @@ void ToneDetector::setUndetectPeakThresh(float thresh)
   {
     undet_par->peak_thresh = 0.0f;
   }
+  if (par == undet_par)
+  {
+    restartBlock();
+  }
 } /* ToneDetector::setUndetectPeakThresh */
 
 
@@ -453,53 +445,75 @@ void ToneDetector::setUndetectUseWindowing(bool enable)
 } /* ToneDetector::setUndetectUseWindowing */
 
 
-int ToneDetector::writeSamples(const float *buf, int len)
+/****************************************************************************
+ *
+ * Private member functions
+ *
+ ****************************************************************************/
+
+void ToneDetector::processEvent(void)
 {
-  for (int i = 0;  i < len;  i++)
-  {
-    float famp = *(buf++);
+  samples_left -= event_delay;
 
-      // First apply the Hamming window, if enabled
-    if (par->use_windowing)
+  if (phase_check_left > 0)
+  {
+    phase_check_left -= event_delay;
+    if (phase_check_left == 0)
     {
-      famp *= *(win++);
+      phaseCheck();
+      phase_check_left = par->period_block_len;
     }
+  }
+
+  if (samples_left == 0)
+  {
+    postProcess();
+  }
+  else
+  {
+    scheduleEvent();
+  }
+} /* ToneDetector::processEvent */
 
-    passband_energy += famp * famp;
 
-      // Run the recursive Goertzel stage for the center frequency
-    par->center.calc(famp);
+void ToneDetector::restartBlock(void)
+{
+    // Set up the Goertzel bins for the center, lower and upper frequency.
+    // The lower and upper bins are only needed for the peak check.
+  const float fqs[] =
+  {
+    tone_fq, tone_fq - 2 * par->bw, tone_fq + 2 * par->bw
+  };
+  setBins(fqs, (par->peak_thresh > 0.0f) ? 3 : 1);
 
-    if (par->peak_thresh > 0.0f)
-    {
-        // Run the recursive Goertzel stage for the lower and upper frequency
-      par->lower.calc(famp);
-      par->upper.calc(famp);
-    }
+    // Start over from the first windowing table entry
+  setWindow(par->use_windowing ? &par->window_table[0] : 0);
 
-    if ((phase_check_left > 0) && (--phase_check_left == 0))
-    {
-      phaseCheck();
-      phase_check_left = par->period_block_len;
-    }
+    // Reset Goertzel filters and the passband energy
+  resetBins();
 
-    if (--samples_left == 0)
-    {
-      postProcess();
-    }
-  }
-    
-  return len;
-  
-} /* ToneDetector::writeSamples */
+    // Reload sample counter
+  samples_left = par->block_len;
 
+    // Reset phase check state variables
+  phaseCheckReset();
 
+  scheduleEvent();
+} /* ToneDetector::restartBlock */
+
+
+void ToneDetector::scheduleEvent(void)
+{
+    // Get called at the end of the block or at the next phase check,
+    // whichever comes first
+  event_delay = samples_left;
+  if ((phase_check_left > 0) && (phase_check_left < event_delay))
+  {
+    event_delay = phase_check_left;
+  }
+  setEventDelay(event_delay);
+} /* ToneDetector::scheduleEvent */
 
-/****************************************************************************
- *
- * Private member functions
- *
- ****************************************************************************/
 
 void ToneDetector::phaseCheckReset(void)
 {
@@ -518,7 +532,7 @@ void ToneDetector::phaseCheckReset(void)
 
 void ToneDetector::phaseCheck(void)
 {
-  float phase = par->center.phase();
+  float phase = arg(result(0));
   if (prev_phase < 2.0f * M_PI)
   {
     float diff = phase - prev_phase;
@@ -542,7 +556,7 @@ void ToneDetector::postProcess(void)
   bool active = true;
 
     // Calculate the magnitude for the center bin
-  float res_center = par->center.magnitudeSquared();
+  float res_center = magnitudeSquared(0);
 
     // Now determine if the tone is active or not. We start by checking
     // if the tone energy exceed the energy threshold. This check
@@ -554,12 +568,12 @@ void ToneDetector::postProcess(void)
   {
       // Check if the center fq is above the lower fq bin by the peak threshold.
       // This is part of the "neighbour bin SNR" check.
-    float res_lower = par->lower.magnitudeSquared();
+    float res_lower = magnitudeSquared(1);
     active = active && (res_center > (res_lower * par->peak_thresh));
 
       // Check if the center fq is above the upper fq bin by the peak threshold.
       // This is part of the "neighbour bin SNR" check.
-    float res_upper = par->upper.magnitudeSquared();
+    float res_upper = magnitudeSquared(2);
     active = active && (res_center > (res_upper * par->peak_thresh));
   }
 
@@ -573,10 +587,10 @@ void ToneDetector::postProcess(void)
       // are doing:
       //
       //    float Ptone = 2.0f * res_center / (par->block_len*par->block_len);
-      //    float Ppassband = passband_energy / par->block_len;
+      //    float Ppassband = energy() / par->block_len;
       //    float peak_to_tot_pwr = Ptone / Ppassband;
     float peak_to_tot_pwr =
-	2.0f * res_center / (par->block_len * passband_energy);
+	2.0f * res_center / (par->block_len * energy());
     active = active && (peak_to_tot_pwr < 1.5f) &&
 	(peak_to_tot_pwr > par->peak_to_tot_pwr_thresh);
   }
@@ -587,7 +601,7 @@ void ToneDetector::postProcess(void)
     float Ptone = 2.0f * res_center / (par->block_len*par->block_len);
     
       // Calculate mean passband power
-    float Ppassband = passband_energy / par->block_len;
+    float Ppassband = energy() / par->block_len;
     
       // Estimate the mean noise floor over the whole passband
     float Pnoise = (Ppassband - Ptone) / ((par->passband_bw-par->bw) / par->bw);
@@ -661,16 +675,8 @@ void ToneDetector::postProcess(void)
     }
   }
 
-    // Point to the first windowing table entry
-  win = par->window_table.begin();
-    // Reload sample counter
-  samples_left = par->block_len;
-
-  par->center.reset();
-  par->lower.reset();
-  par->upper.reset();
-  phaseCheckReset();
-  passband_energy = 0.0f;
+    // Start over with the next block
+  restartBlock();
 
 } /* ToneDetector::postProcess */
 
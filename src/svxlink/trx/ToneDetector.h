@@ -45,7 +45,6 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
-#include <AsyncAudioSink.h>
 #include <CppStdCompat.h>
 
 
@@ -55,6 +54,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  *
  ****************************************************************************/
 
+#include "GoertzelBank.h"
 
 
 /****************************************************************************
@@ -106,8 +106,13 @@ single frequency. For maximum detection reliability, the bandwidth will
 be adapted to place the tone frequency near the center of the DFT.
 As a side effect, the detection bandwidth is slightly narrowed, which
 however is acceptable for the current use cases (CTCSS, 1750Hz, etc..).
+
+The Goertzel calculations are done by a GoertzelBank that the detector must
+be added to. All tone detectors listening to the same audio stream should be
+added to the same bank so that the samples only are processed once for all of
+them.
 */
-class ToneDetector : public sigc::trackable, public Async::AudioSink
+class ToneDetector : public sigc::trackable, public GoertzelBank::Subscriber
 {
   public:
     /**
@@ -425,13 +430,6 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
      */
     void reset(void);
     
-    /**
-     * @brief Write samples into the tone detector
-     * @param buf The buffer containing the samples
-     * @param len The number of samples in the buffer
-     */
-    virtual int writeSamples(const float *buf, int len);
-
     /**
      * @brief  A signal that is emitted when the tone detector changes state
      * @param  is_active \em true when active and \em false if not
@@ -480,11 +478,12 @@ class ToneDetector : public sigc::trackable, public Async::AudioSink
     DetectorParams	*det_par;
     DetectorParams	*undet_par;
     DetectorParams	*par;
-    double		passband_energy;
     float               last_snr;
+    int                 event_delay;
 
-    std::vector<float>::const_iterator win;
-
+    virtual void processEvent(void);
+    void restartBlock(void);
+    void scheduleEvent(void);
     void phaseCheckReset(void);
     void phaseCheck(void);
     void postProcess(void);
@@ -57,6 +57,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "WbRxRtlSdr.h"
 #include "RtlTcp.h"
+#include "RtlFile.h"
+#include "PolyphaseChannelizer.h"
 #ifdef HAS_RTLSDR_SUPPORT
 #include "RtlUsb.h"
 #endif
@@ -136,7 +138,8 @@ WbRxRtlSdr *WbRxRtlSdr::instance(Async::Config &cfg, const string &name)
 
 
 WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
-  : auto_tune_enabled(true), m_name(name), xvrtr_offset(0)
+  : auto_tune_enabled(true), m_name(name), xvrtr_offset(0),
+    m_channelizer(0)
 {
   //cout << "### Initializing WBRX " << name << endl;
 
@@ -162,6 +165,20 @@ WbRxRtlSdr::WbRxRtlSdr(Async::Config &cfg, const string &name)
     rtl = new RtlUsb(dev_match);
   }
 #endif
+  else if (rtl_type == "RtlFile")
+  {
+    string filename;
+    if (!cfg.getValue(name, "FILENAME", filename))
+    {
+      cerr << "*** ERROR: Config variable " << name << "/FILENAME not set\n";
+      exit(1);
+    }
+    double speed = 1.0;
+    cfg.getValue(name, "SPEED", speed);
+    bool loop = true;
+    cfg.getValue(name, "LOOP", loop);
+    rtl = new RtlFile(filename, speed, loop);
+  }
   else
   {
     cerr << "*** ERROR: Unknown WbRx type: " << rtl_type << endl;
@@ -212,6 +229,8 @@ WbRxRtlSdr::~WbRxRtlSdr(void)
 {
   delete rtl;
   rtl = 0;
+  delete m_channelizer;
+  m_channelizer = 0;
 } /* WbRxRtlSdr::~WbRxRtlSdr */
 
 
@@ -285,6 +304,19 @@ bool WbRxRtlSdr::isReady(void) const
 } /* WbRxRtlSdr::isReady */
 
 
+PolyphaseChannelizer *WbRxRtlSdr::channelizer(void)
+{
+  if ((m_channelizer == 0) &&
+      PolyphaseChannelizer::isSupported(rtl->sampleRate()))
+  {
+    m_channelizer = new PolyphaseChannelizer(rtl->sampleRate());
+    iqReceived.connect(
+        mem_fun(*m_channelizer, &PolyphaseChannelizer::iqReceived));
+  }
+  return m_channelizer;
+} /* WbRxRtlSdr::channelizer */
+
+
 
 /****************************************************************************
  *
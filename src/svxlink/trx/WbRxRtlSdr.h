@@ -70,6 +70,7 @@ namespace Async
   class Config;
 };
 class RtlSdr;
+class PolyphaseChannelizer;
 class Ddr;
 
 
@@ -195,15 +196,26 @@ class WbRxRtlSdr : public sigc::trackable
      */
     bool isReady(void) const;
 
+    /**
+     * @brief   Get the channelizer shared by all DDRs on this tuner
+     * @returns Returns the channelizer or 0 if the sample rate is unsupported
+     *
+     * The channelizer is created on the first call. It is fed with all
+     * samples from the tuner and do the first decimation stages once for all
+     * narrowband channels. @see PolyphaseChannelizer
+     */
+    PolyphaseChannelizer *channelizer(void);
+
     /**
      * @brief   A signal that is emitted when new samples have been received
      * @param   samples A vector of received samples
      *
      * Connecting to this signal is the way to get samples from the DVB-T
      * dongle. The format is a vector of complex floats (I/Q) with a range from
-     * -1 to 1.
+     * -1 to 1. The same vector is reused for every block so a receiver that
+     * need to keep the samples after returning from the slot must copy them.
      */
-    sigc::signal<void, std::vector<Sample> > iqReceived;
+    sigc::signal<void, const std::vector<Sample>&> iqReceived;
     
     /**
      * @brief   A signal that is emitted when the ready state changes
@@ -223,6 +235,7 @@ class WbRxRtlSdr : public sigc::trackable
     bool auto_tune_enabled;
     std::string m_name;
     int xvrtr_offset;
+    PolyphaseChannelizer *m_channelizer;
 
     WbRxRtlSdr(const WbRxRtlSdr&);
     WbRxRtlSdr& operator=(const WbRxRtlSdr&);